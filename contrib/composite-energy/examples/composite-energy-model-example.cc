@@ -5,6 +5,11 @@
  * UAVs        : Li-Ion battery only, no harvesting.
  * Satellites  : Li-Ion battery + solar harvesting via CompositeEnergySource.
  *               The LEO cycle alternates SunlightSeconds / ShadowSeconds.
+ *
+ * The satellites' energy state is printed every 60 s. With
+ * --telemetry=<file> every node's state is instead sampled by an
+ * EnergyTelemetryCollector into a binary file, which
+ * utils/energy-telemetry-dump turns back into CSV.
  */
 
 #include "ns3/composite-energy-module.h"
@@ -44,6 +49,18 @@ main(int argc, char* argv[])
     // LogComponentEnable("CompositeEnergySource", LOG_LEVEL_INFO);
     // LogComponentEnable("SolarHarvesterDeviceModel", LOG_LEVEL_INFO);
 
+    bool profile = false;
+    std::string telemetry;
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("profile", "Profile the satellites' energy sources and dump at the end", profile);
+    cmd.AddValue("telemetry", "Write all nodes' energy state to this binary file", telemetry);
+    cmd.Parse(argc, argv);
+    if (profile)
+    {
+        Config::SetDefault("ns3::CompositeEnergySource::EnableProfiling", BooleanValue(true));
+        HotPathProfileRegistry::DumpAtDestroy();
+    }
+
     NodeContainer uavs;
     uavs.Create(10);
 
@@ -84,6 +101,7 @@ main(int argc, char* argv[])
         Ptr<Node> node = satellites.Get(i);
 
         Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetNode(node); // names the node in the profile dump
         // Start partially discharged, room to harvest up to 4000 J.
         source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
         source->SetAttribute("MaxEnergyJ", DoubleValue(4000.0));
@@ -114,13 +132,26 @@ main(int argc, char* argv[])
         node->AggregateObject(container);
     }
 
-    // --- Periodic energy-status printout (satellites) ----------------------
-    for (uint32_t i = 0; i < satellites.GetN(); ++i)
+    // --- Periodic energy-status printout (satellites) or telemetry ---------
+    Ptr<EnergyTelemetryCollector> collector;
+    if (!telemetry.empty())
     {
-        Ptr<Node> node = satellites.Get(i);
-        Ptr<EnergySourceContainer> container = node->GetObject<EnergySourceContainer>();
-        Ptr<LiIonEnergySource> source = container->Get(0)->GetObject<LiIonEnergySource>();
-        Simulator::Schedule(Seconds(0), &PrintEnergyStatus, source);
+        collector = CreateObject<EnergyTelemetryCollector>();
+        collector->SetAttribute("FileName", StringValue(telemetry));
+        collector->SetAttribute("Interval", TimeValue(Seconds(60)));
+        collector->Add(uavs);
+        collector->Add(satellites);
+        collector->Start();
+    }
+    else
+    {
+        for (uint32_t i = 0; i < satellites.GetN(); ++i)
+        {
+            Ptr<Node> node = satellites.Get(i);
+            Ptr<EnergySourceContainer> container = node->GetObject<EnergySourceContainer>();
+            Ptr<LiIonEnergySource> source = container->Get(0)->GetObject<LiIonEnergySource>();
+            Simulator::Schedule(Seconds(0), &PrintEnergyStatus, source);
+        }
     }
 
     // --- UAV traffic: constant moderate draw from t=10 to t=1701 -----------
@@ -154,6 +185,13 @@ main(int argc, char* argv[])
 
     Simulator::Stop(Seconds(2400));
     Simulator::Run();
+    if (collector)
+    {
+        collector->Stop();
+        std::cout << telemetry << ": " << collector->GetNSamples() << " samples of "
+                  << collector->GetN() << " sources, " << collector->GetNBytes() << " bytes"
+                  << std::endl;
+    }
     Simulator::Destroy();
 
     return 0;
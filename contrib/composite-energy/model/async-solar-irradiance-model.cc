@@ -0,0 +1,377 @@
+#include "async-solar-irradiance-model.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AsyncSolarIrradianceModel");
+
+NS_OBJECT_ENSURE_REGISTERED(AsyncSolarIrradianceModel);
+
+// ---- AsyncSolarIrradianceModel::BlockQueue ----
+
+AsyncSolarIrradianceModel::BlockQueue::BlockQueue()
+    : m_head(0),
+      m_tail(0),
+      m_waiters(0)
+{
+}
+
+void
+AsyncSolarIrradianceModel::BlockQueue::Reset(std::size_t capacity, std::size_t samples)
+{
+    m_slots.assign(capacity, Block{0, std::vector<double>(samples, 0.0)});
+    m_head.store(0);
+    m_tail.store(0);
+}
+
+template <typename P>
+void
+AsyncSolarIrradianceModel::BlockQueue::Wait(P ready)
+{
+    if (ready())
+    {
+        return;
+    }
+    // Registering as a waiter before the last check pairs with the
+    // counter update before Notify(), so one of the two sides sees the
+    // other and no wake-up is lost.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiters.fetch_add(1);
+    m_cv.wait(lock, ready);
+    m_waiters.fetch_sub(1);
+}
+
+void
+AsyncSolarIrradianceModel::BlockQueue::Notify()
+{
+    if (m_waiters.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cv.notify_all();
+    }
+}
+
+AsyncSolarIrradianceModel::Block*
+AsyncSolarIrradianceModel::BlockQueue::BeginPush(const std::atomic<bool>& stop)
+{
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    Wait([this, tail, &stop] { return stop.load() || tail - m_head.load() < m_slots.size(); });
+    if (stop.load())
+    {
+        return nullptr;
+    }
+    return &m_slots[tail % m_slots.size()];
+}
+
+void
+AsyncSolarIrradianceModel::BlockQueue::EndPush()
+{
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1);
+    Notify();
+}
+
+AsyncSolarIrradianceModel::Block&
+AsyncSolarIrradianceModel::BlockQueue::Front(bool& stalled)
+{
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    stalled = m_tail.load() == head;
+    Wait([this, head] { return m_tail.load() != head; });
+    return m_slots[head % m_slots.size()];
+}
+
+void
+AsyncSolarIrradianceModel::BlockQueue::Pop()
+{
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1);
+    Notify();
+}
+
+void
+AsyncSolarIrradianceModel::BlockQueue::Wake()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cv.notify_all();
+}
+
+// ---- AsyncSolarIrradianceModel ----
+
+TypeId
+AsyncSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AsyncSolarIrradianceModel")
+            .SetParent<SolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<AsyncSolarIrradianceModel>()
+            .AddAttribute("Samples",
+                          "Number of samples of the wrapped model per block.",
+                          UintegerValue(64),
+                          MakeUintegerAccessor(&AsyncSolarIrradianceModel::m_samples),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Step",
+                          "Spacing of the samples; the consumer's polling period.",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&AsyncSolarIrradianceModel::m_step),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("Threads",
+                          "Worker threads computing blocks ahead of the simulation. 0 uses "
+                          "one per hardware thread. Values do not depend on it.",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&AsyncSolarIrradianceModel::m_threads),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("Depth",
+                          "Blocks each worker may compute ahead of the simulation.",
+                          UintegerValue(4),
+                          MakeUintegerAccessor(&AsyncSolarIrradianceModel::m_depth),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+AsyncSolarIrradianceModel::AsyncSolarIrradianceModel()
+    : m_samples(64),
+      m_step(Seconds(1)),
+      m_threads(1),
+      m_depth(4),
+      m_plan{Seconds(0), Seconds(1), 0, 0, 0},
+      m_stop(false),
+      m_running(false),
+      m_next(0),
+      m_hits(0),
+      m_misses(0),
+      m_blocks(0),
+      m_stalls(0),
+      m_restarts(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+AsyncSolarIrradianceModel::~AsyncSolarIrradianceModel()
+{
+    Stop();
+}
+
+void
+AsyncSolarIrradianceModel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    m_model = nullptr;
+    SolarIrradianceModel::DoDispose();
+}
+
+void
+AsyncSolarIrradianceModel::SetModel(Ptr<const SolarIrradianceModel> model)
+{
+    NS_LOG_FUNCTION(this << model);
+    Stop();
+    m_model = model;
+}
+
+Ptr<const SolarIrradianceModel>
+AsyncSolarIrradianceModel::GetModel() const
+{
+    return m_model;
+}
+
+double
+AsyncSolarIrradianceModel::GetPowerDensityWm2(Time t) const
+{
+    return Lookup(t);
+}
+
+SolarIrradianceSegment
+AsyncSolarIrradianceModel::GetSegment(Time t) const
+{
+    return SolarIrradianceSegment{t, t, Lookup(t), 0.0};
+}
+
+uint64_t
+AsyncSolarIrradianceModel::GetHits() const
+{
+    return m_hits;
+}
+
+uint64_t
+AsyncSolarIrradianceModel::GetMisses() const
+{
+    return m_misses;
+}
+
+uint64_t
+AsyncSolarIrradianceModel::GetBlocks() const
+{
+    return m_blocks;
+}
+
+uint64_t
+AsyncSolarIrradianceModel::GetStalls() const
+{
+    return m_stalls;
+}
+
+uint64_t
+AsyncSolarIrradianceModel::GetRestarts() const
+{
+    return m_restarts;
+}
+
+void
+AsyncSolarIrradianceModel::Start(Time origin) const
+{
+    NS_LOG_FUNCTION(this << origin);
+    uint32_t workers = m_threads;
+    if (workers == 0)
+    {
+        workers = std::max(1U, std::thread::hardware_concurrency());
+    }
+    m_plan = Plan{origin, m_step, m_samples, workers, m_depth};
+    m_queues.reset(new BlockQueue[workers]);
+    for (uint32_t w = 0; w < workers; ++w)
+    {
+        m_queues[w].Reset(m_plan.depth, m_plan.samples);
+    }
+    for (auto& block : m_current)
+    {
+        block.index = std::numeric_limits<uint64_t>::max();
+        block.values.assign(m_plan.samples, 0.0);
+    }
+    m_next = 0;
+    m_stop.store(false);
+    for (uint32_t w = 0; w < workers; ++w)
+    {
+        m_workers.emplace_back(&AsyncSolarIrradianceModel::WorkerLoop, this, w);
+    }
+    m_running = true;
+}
+
+void
+AsyncSolarIrradianceModel::Stop() const
+{
+    if (!m_running)
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this);
+    m_stop.store(true);
+    for (uint32_t w = 0; w < m_plan.workers; ++w)
+    {
+        m_queues[w].Wake();
+    }
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+    m_running = false;
+}
+
+void
+AsyncSolarIrradianceModel::WorkerLoop(uint32_t worker) const
+{
+    // No logging here: it would read the simulator clock from this thread.
+    BlockQueue& queue = m_queues[worker];
+    std::vector<Time> times(m_plan.samples);
+    for (uint64_t index = worker;; index += m_plan.workers)
+    {
+        Block* block = queue.BeginPush(m_stop);
+        if (!block)
+        {
+            return;
+        }
+        uint64_t first = index * m_plan.samples;
+        for (uint32_t i = 0; i < m_plan.samples; ++i)
+        {
+            times[i] = m_plan.origin + m_plan.step * static_cast<int64_t>(first + i);
+        }
+        m_model->GetPowerDensitiesWm2(times.data(), block->values.data(), m_plan.samples);
+        block->index = index;
+        queue.EndPush();
+    }
+}
+
+void
+AsyncSolarIrradianceModel::PopBlock() const
+{
+    bool stalled = false;
+    Block& block = m_queues[m_next % m_plan.workers].Front(stalled);
+    NS_ABORT_MSG_IF(block.index != m_next, "Blocks out of order");
+    if (stalled)
+    {
+        ++m_stalls;
+    }
+    // Swap rather than copy; the worker refills whatever it gets back.
+    Block& current = m_current[m_next % 2];
+    current.index = block.index;
+    current.values.swap(block.values);
+    m_queues[m_next % m_plan.workers].Pop();
+    ++m_next;
+    ++m_blocks;
+}
+
+double
+AsyncSolarIrradianceModel::Lookup(Time t) const
+{
+    if (!m_model)
+    {
+        return 0.0;
+    }
+    if (!m_running)
+    {
+        Start(t);
+    }
+
+    int64_t offset = (t - m_plan.origin).GetTimeStep();
+    if (offset < 0)
+    {
+        ++m_misses;
+        return m_model->GetPowerDensityWm2(t);
+    }
+    int64_t step = m_plan.step.GetTimeStep();
+    uint64_t sample = static_cast<uint64_t>(offset / step);
+    uint64_t index = sample / m_plan.samples;
+    bool onGrid = (offset % step == 0);
+
+    // Off-grid queries within reach (Li-Ion update span starts, a tick
+    // moved by a clamp crossing) are answered directly. Beyond it the
+    // consumer polls on a new grid, or has jumped past the blocks in
+    // flight: move the workers there.
+    uint64_t inFlight = static_cast<uint64_t>(m_plan.workers) * m_plan.depth;
+    if ((!onGrid && index > m_next) || (onGrid && index >= m_next + inFlight))
+    {
+        NS_LOG_DEBUG("Restarting the workers at " << t);
+        ++m_restarts;
+        Stop();
+        Start(t);
+        sample = 0;
+        index = 0;
+        onGrid = true;
+    }
+    if (!onGrid)
+    {
+        ++m_misses;
+        return m_model->GetPowerDensityWm2(t);
+    }
+
+    while (index >= m_next)
+    {
+        PopBlock();
+    }
+    const Block& block = m_current[index % 2];
+    if (block.index != index)
+    {
+        ++m_misses;
+        return m_model->GetPowerDensityWm2(t);
+    }
+    ++m_hits;
+    return block.values[sample % m_plan.samples];
+}
+
+} // namespace ns3
@@ -0,0 +1,199 @@
+#ifndef NS3_ASYNC_SOLAR_IRRADIANCE_MODEL_H
+#define NS3_ASYNC_SOLAR_IRRADIANCE_MODEL_H
+
+#include "solar-irradiance-model.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Computes a polled irradiance model ahead of the simulation on
+ *        background threads.
+ *
+ * The LookaheadSolarIrradianceModel counterpart for models that are
+ * expensive per block, not only per call: instead of fetching the next
+ * block when the simulation reaches it, \c Threads worker threads compute
+ * blocks of \c Samples values at \c Step spacing ahead of the simulation
+ * while it runs, so the model's cost overlaps the rest of the simulation
+ * on a multi-core machine.
+ *
+ * The first query anchors the sample grid at its time. Worker \c w
+ * computes blocks \c w, \c w + Threads, ... through the wrapped model's
+ * GetPowerDensitiesWm2() and hands them to the simulation thread through
+ * its own bounded single-producer/single-consumer queue of \c Depth
+ * blocks, so the blocks arrive in order and neither side takes a lock
+ * while the other keeps up. A worker whose queue is full waits for the
+ * simulation to consume; if the simulation reaches a block that is not
+ * ready it waits for the worker (GetStalls() counts those waits).
+ *
+ * Queries on the grid at or after the last two blocks consumed are
+ * served from the blocks, other queries go straight to the wrapped model.
+ * A query off the grid more than a block past the blocks consumed, or on
+ * the grid past the blocks in flight, means the consumer has moved to a
+ * new grid: the workers are stopped and restarted from that time
+ * (GetRestarts()). Values are those the wrapped model returns for the
+ * same times, whatever the number of threads.
+ *
+ * The wrapped model is called from the worker threads, concurrently with
+ * each other and with the simulation thread, so it must be a function of
+ * time alone that is safe to call concurrently and must not call into
+ * the simulator: e.g. an InvocableSolarIrradianceModel or
+ * CallbackSolarIrradianceModel around a stateless, thread-safe
+ * propagator. An invocable with state of its own (a \c mutable lambda, a
+ * functor with a non-const call operator) is not, and must not be
+ * wrapped. The built-in models keep lookup caches and are not either;
+ * they describe their segments and gain nothing from the wrapper anyway.
+ *
+ * Attributes are read when the workers start: at the first query and
+ * after SetModel() or a restart.
+ */
+class AsyncSolarIrradianceModel : public SolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    AsyncSolarIrradianceModel();
+    ~AsyncSolarIrradianceModel() override;
+
+    /** Wrap \p model, stopping the workers and dropping their blocks. */
+    void SetModel(Ptr<const SolarIrradianceModel> model);
+
+    /** \return The wrapped model. */
+    Ptr<const SolarIrradianceModel> GetModel() const;
+
+    double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
+
+    /** \return Queries answered from precomputed blocks. */
+    uint64_t GetHits() const;
+
+    /** \return Queries passed to the wrapped model on the simulation thread. */
+    uint64_t GetMisses() const;
+
+    /** \return Blocks consumed from the workers. */
+    uint64_t GetBlocks() const;
+
+    /** \return Blocks the simulation thread had to wait for. */
+    uint64_t GetStalls() const;
+
+    /** \return Times the workers were restarted on a new grid. */
+    uint64_t GetRestarts() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /** Values of one block of samples. */
+    struct Block
+    {
+        uint64_t index;             //!< Position of the block on the grid
+        std::vector<double> values; //!< One value per sample
+    };
+
+    /**
+     * Bounded queue of blocks from one worker to the simulation thread.
+     * Each side only writes its own counter, so pushing and popping are
+     * lock-free; the mutex only serves a side that has to wait.
+     */
+    class BlockQueue
+    {
+      public:
+        BlockQueue();
+
+        /** Empty the queue and size it to \p capacity blocks of \p samples. */
+        void Reset(std::size_t capacity, std::size_t samples);
+
+        /** \return The slot to fill next, once one is free; null once \p stop is set. */
+        Block* BeginPush(const std::atomic<bool>& stop);
+
+        /** Publish the slot returned by BeginPush(). */
+        void EndPush();
+
+        /**
+         * \param [out] stalled Whether the block was not ready yet.
+         * \return The oldest block, once there is one.
+         */
+        Block& Front(bool& stalled);
+
+        /** Release the block returned by Front() to the producer. */
+        void Pop();
+
+        /** Wake a waiting producer to check its stop flag. */
+        void Wake();
+
+      private:
+        /** Wait until \p ready() holds. */
+        template <typename P>
+        void Wait(P ready);
+
+        /** Wake the other side if it waits. */
+        void Notify();
+
+        std::vector<Block> m_slots;
+        alignas(64) std::atomic<uint64_t> m_head; // blocks popped
+        alignas(64) std::atomic<uint64_t> m_tail; // blocks pushed
+        std::atomic<uint32_t> m_waiters;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+
+    /** Grid and partition of one run of the workers. */
+    struct Plan
+    {
+        Time origin;      //!< Time of sample 0
+        Time step;        //!< Spacing of the samples
+        uint32_t samples; //!< Samples per block
+        uint32_t workers; //!< Worker threads
+        uint32_t depth;   //!< Blocks queued per worker
+    };
+
+    /** Start the workers on the grid anchored at \p origin. */
+    void Start(Time origin) const;
+
+    /** Stop and join the workers, if running. */
+    void Stop() const;
+
+    /** Body of worker \p worker. */
+    void WorkerLoop(uint32_t worker) const;
+
+    /** \return The value at \p t, from the blocks when possible. */
+    double Lookup(Time t) const;
+
+    /** Consume the next block from its worker, waiting if needed. */
+    void PopBlock() const;
+
+    Ptr<const SolarIrradianceModel> m_model;
+    uint32_t m_samples; // block size
+    Time m_step;
+    uint32_t m_threads; // 0 => one per hardware thread
+    uint32_t m_depth;   // blocks queued per worker
+
+    // Workers of the current run; the plan is fixed while they run
+    mutable Plan m_plan;
+    mutable std::vector<std::thread> m_workers;
+    mutable std::unique_ptr<BlockQueue[]> m_queues; // one per worker
+    mutable std::atomic<bool> m_stop;
+    mutable bool m_running;
+
+    // Simulation-thread side
+    mutable uint64_t m_next;    // index of the next block to consume
+    mutable Block m_current[2]; // last two blocks consumed, by index parity
+    mutable uint64_t m_hits;
+    mutable uint64_t m_misses;
+    mutable uint64_t m_blocks;
+    mutable uint64_t m_stalls;
+    mutable uint64_t m_restarts;
+};
+
+} // namespace ns3
+
+#endif // NS3_ASYNC_SOLAR_IRRADIANCE_MODEL_H
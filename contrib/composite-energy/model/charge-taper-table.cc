@@ -0,0 +1,61 @@
+#include "charge-taper-table.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ChargeTaperTable");
+
+const ChargeTaperTable&
+ChargeTaperTable::Get(Chemistry chemistry)
+{
+    // Built on first use; initialization of function statics is thread-safe.
+    static const ChargeTaperTable nmc(0.05, 1.0);
+    static const ChargeTaperTable lfp(0.05, 0.5);
+    static const ChargeTaperTable lco(0.10, 1.5);
+    switch (chemistry)
+    {
+    case NMC:
+        return nmc;
+    case LFP:
+        return lfp;
+    case LCO:
+        return lco;
+    }
+    NS_ABORT_MSG("Unknown charge taper chemistry " << chemistry);
+    return nmc;
+}
+
+ChargeTaperTable::ChargeTaperTable(double termination, double shape)
+    : m_termination(termination)
+{
+    NS_LOG_FUNCTION(this << termination << shape);
+    double logTermination = std::log(termination);
+    for (std::size_t i = 0; i < TABLE_SIZE; ++i)
+    {
+        double progress = static_cast<double>(i) / (TABLE_SIZE - 1);
+        m_fraction[i] = std::exp(logTermination * std::pow(progress, shape));
+    }
+}
+
+double
+ChargeTaperTable::GetCurrentFraction(double progress) const
+{
+    double x = std::min(std::max(progress, 0.0), 1.0) * (TABLE_SIZE - 1);
+    auto i = std::min(static_cast<std::size_t>(x), TABLE_SIZE - 2);
+    double w = x - static_cast<double>(i);
+    return m_fraction[i] + w * (m_fraction[i + 1] - m_fraction[i]);
+}
+
+double
+ChargeTaperTable::GetTerminationFraction() const
+{
+    return m_termination;
+}
+
+} // namespace ns3
@@ -0,0 +1,78 @@
+#ifndef NS3_CHARGE_TAPER_TABLE_H
+#define NS3_CHARGE_TAPER_TABLE_H
+
+#include <array>
+#include <cstddef>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Constant-voltage charge taper of a Li-Ion chemistry, sampled
+ *        once into a lookup table.
+ *
+ * Once a cell reaches its charge voltage, a CC-CV charger holds that
+ * voltage and the charge current decays until it falls to a termination
+ * current. The table gives the current, as a fraction of the current the
+ * CV phase starts with, against the progress p of the charge through the
+ * CV phase (0 at its onset, 1 at full charge):
+ *
+ *   I(p) / I_0 = c ^ (p ^ g)
+ *
+ * where c is the termination fraction and g shapes the decay: below 1 the
+ * current falls early, as on the flat curve of LFP; above 1 it holds up
+ * longer, as for LCO. The shapes are generic rather than fitted to a
+ * particular cell:
+ *
+ *   chemistry   c      g
+ *   NMC         0.05   1.0
+ *   LFP         0.05   0.5
+ *   LCO         0.10   1.5
+ *
+ * Each chemistry's curve is sampled at TABLE_SIZE evenly spaced progress
+ * values on first use and shared from then on; lookups interpolate
+ * linearly, so evaluating the taper costs no exponential.
+ */
+class ChargeTaperTable
+{
+  public:
+    /** Chemistries with a built-in taper. */
+    enum Chemistry
+    {
+        NMC, //!< Nickel manganese cobalt oxide
+        LFP, //!< Lithium iron phosphate
+        LCO, //!< Lithium cobalt oxide
+    };
+
+    /** Samples per table, at progress i / (TABLE_SIZE - 1). */
+    static constexpr std::size_t TABLE_SIZE = 257;
+
+    /** \return The table of \p chemistry, built on the first call. */
+    static const ChargeTaperTable& Get(Chemistry chemistry);
+
+    /**
+     * \return Charge current as a fraction of the CV-phase initial
+     *         current at \p progress (clamped to [0, 1]).
+     */
+    double GetCurrentFraction(double progress) const;
+
+    /** \return Fraction at which the charge terminates, at progress 1. */
+    double GetTerminationFraction() const;
+
+  private:
+    /**
+     * Sample the taper.
+     *
+     * \param termination Termination fraction c.
+     * \param shape Shape exponent g.
+     */
+    ChargeTaperTable(double termination, double shape);
+
+    double m_termination;
+    std::array<double, TABLE_SIZE> m_fraction;
+};
+
+} // namespace ns3
+
+#endif // NS3_CHARGE_TAPER_TABLE_H
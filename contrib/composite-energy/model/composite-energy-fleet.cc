@@ -0,0 +1,521 @@
+#include "composite-energy-fleet.h"
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("CompositeEnergyFleet");
+NS_OBJECT_ENSURE_REGISTERED(CompositeEnergyFleet);
+
+TypeId
+CompositeEnergyFleet::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::CompositeEnergyFleet")
+            .SetParent<Object>()
+            .SetGroupName("Energy")
+            .AddConstructor<CompositeEnergyFleet>()
+            .AddAttribute("HarvestIntervalSeconds",
+                          "Period of the fleet tick that re-evaluates the clamps and the "
+                          "HarvestedPower trace of every member (s). The injected energy is "
+                          "integrated exactly whatever its value.",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&CompositeEnergyFleet::m_harvestIntervalSeconds),
+                          MakeDoubleChecker<double>(1e-6))
+            .AddAttribute("Threads",
+                          "Threads the tick runs on, the simulation thread included. 0 uses "
+                          "one per hardware thread. Results do not depend on it.",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&CompositeEnergyFleet::m_threads),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("ChunkSize",
+                          "Members per unit of work handed to a thread. Totals are reduced "
+                          "per chunk, so it determines their rounding; Threads does not.",
+                          UintegerValue(1024),
+                          MakeUintegerAccessor(&CompositeEnergyFleet::m_chunkSize),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+CompositeEnergyFleet::CompositeEnergyFleet()
+    : m_harvestIntervalSeconds(1.0),
+      m_threads(1),
+      m_chunkSize(1024),
+      m_tickCount(0),
+      m_harvestedPowerW(0.0),
+      m_tickEnergyJ(0.0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+CompositeEnergyFleet::~CompositeEnergyFleet()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+CompositeEnergyFleet::Add(Ptr<CompositeEnergySource> source)
+{
+    NS_LOG_FUNCTION(this << source);
+    NS_ABORT_MSG_IF(!source, "CompositeEnergyFleet: null source");
+    NS_ABORT_MSG_IF(source->IsInitialized(),
+                    "CompositeEnergyFleet: sources must be added before they are initialized");
+    NS_ABORT_MSG_IF(source->m_fleet, "CompositeEnergyFleet: source already belongs to a fleet");
+
+    auto i = static_cast<uint32_t>(m_sources.size());
+    m_sources.push_back(source);
+    m_models.push_back(nullptr);
+    m_peakW.push_back(0.0);
+    m_origin.push_back(0);
+    m_on.push_back(0);
+    m_period.push_back(1);
+    m_from.push_back(std::numeric_limits<int64_t>::min());
+    m_until.push_back(std::numeric_limits<int64_t>::max());
+    m_capJ.push_back(0.0);
+    m_maxVoltageV.push_back(0.0);
+    m_remainingJ.push_back(0.0);
+    m_voltageV.push_back(0.0);
+    m_headroomJ.push_back(0.0);
+    m_loadW.push_back(0.0);
+    m_lastUpdate.push_back(0);
+    m_active.push_back(0);
+    m_clamped.push_back(0);
+    m_enabled.push_back(0);
+    m_powerW.push_back(0.0);
+    m_pendingJ.push_back(0.0);
+    m_accruedJ.push_back(0.0);
+    m_lastAccrual.push_back(0);
+
+    source->m_fleet = this;
+    source->m_fleetIndex = i;
+    return i;
+}
+
+uint32_t
+CompositeEnergyFleet::GetN() const
+{
+    return static_cast<uint32_t>(m_sources.size());
+}
+
+Ptr<CompositeEnergySource>
+CompositeEnergyFleet::Get(uint32_t i) const
+{
+    NS_ABORT_MSG_IF(i >= m_sources.size(), "CompositeEnergyFleet: index " << i << " out of range");
+    return m_sources[i];
+}
+
+uint64_t
+CompositeEnergyFleet::GetTickCount() const
+{
+    return m_tickCount;
+}
+
+double
+CompositeEnergyFleet::GetTotalHarvestedEnergy() const
+{
+    double total = 0.0;
+    for (const auto& source : m_sources)
+    {
+        total += source->GetTotalHarvestedEnergy();
+    }
+    return total;
+}
+
+double
+CompositeEnergyFleet::GetHarvestedPower() const
+{
+    return m_harvestedPowerW;
+}
+
+double
+CompositeEnergyFleet::GetTickHarvestedEnergy() const
+{
+    return m_tickEnergyJ;
+}
+
+void
+CompositeEnergyFleet::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_tickEvent);
+    // Break the fleet <-> member reference cycle from this side.
+    for (auto& source : m_sources)
+    {
+        source->m_fleet = nullptr;
+    }
+    m_sources.clear();
+    m_models.clear();
+    m_pool.reset();
+    Object::DoDispose();
+}
+
+void
+CompositeEnergyFleet::Enroll(uint32_t i)
+{
+    NS_LOG_FUNCTION(this << i);
+    Ptr<CompositeEnergySource> source = m_sources[i];
+    int64_t now = Simulator::Now().GetTimeStep();
+
+    Ptr<const WindowSolarIrradianceModel> windows = source->m_windowProfile;
+    if (source->m_irradianceModel)
+    {
+        m_models[i] = source->m_irradianceModel;
+        m_modelMembers.push_back(i);
+        m_peakW[i] = source->GetHarvestProfileScale();
+    }
+    else if (!source->m_useLeoCycle && windows && windows->GetNWindows() > 1)
+    {
+        // A window schedule is no single pulse; it goes through its
+        // interval index like a model.
+        m_models[i] = windows;
+        m_modelMembers.push_back(i);
+        m_peakW[i] = source->GetHarvestProfileScale();
+    }
+    else if (source->m_useLeoCycle)
+    {
+        // The cycle starts in sunlight at the source's cycle origin (now,
+        // unless a state was restored). A cycle without shadow is a pulse
+        // that is always on, one without sunlight is never on.
+        int64_t sunlight = Seconds(source->m_sunlightSeconds).GetTimeStep();
+        int64_t shadow = Seconds(source->m_shadowSeconds).GetTimeStep();
+        m_peakW[i] = source->m_solarConstantWm2 * source->GetHarvestProfileScale();
+        m_origin[i] = source->m_cycleOrigin.GetTimeStep();
+        if (sunlight > 0 && shadow > 0)
+        {
+            m_on[i] = sunlight;
+            m_period[i] = sunlight + shadow;
+        }
+        else
+        {
+            m_on[i] = (sunlight > 0) ? 1 : 0;
+            m_period[i] = 1;
+        }
+    }
+    else
+    {
+        // A single pulse: on from the window start, clipped at its end. No
+        // window at all is a pulse that never turns on.
+        int64_t start = 0;
+        int64_t end = 0;
+        double powerW = 0.0;
+        if (windows && windows->GetNWindows() == 1)
+        {
+            const WindowSolarIrradianceModel::Window& window = windows->GetWindow(0);
+            start = window.start.GetTimeStep();
+            end = window.end.GetTimeStep();
+            powerW = window.value;
+        }
+        m_peakW[i] = powerW * source->GetHarvestProfileScale();
+        m_origin[i] = start;
+        m_on[i] = std::max<int64_t>(end - start, 0);
+        m_period[i] = std::numeric_limits<int64_t>::max();
+        m_from[i] = start;
+        m_until[i] = end;
+    }
+
+    m_capJ[i] = source->GetEnergyCap();
+    m_maxVoltageV[i] = source->m_maxChargeVoltageV;
+    m_remainingJ[i] = source->m_remainingJ;
+    m_voltageV[i] = source->GetSupplyVoltage();
+    m_lastUpdate[i] = now;
+    m_active[i] = 1;
+    m_enabled[i] = 0;
+    m_lastAccrual[i] = now;
+
+    // The first member to be initialized starts the tick. Members
+    // initialized at the same time are enrolled before it runs.
+    if (m_tickEvent.IsExpired())
+    {
+        m_tickEvent = Simulator::ScheduleNow(&CompositeEnergyFleet::Tick, this);
+    }
+}
+
+double
+CompositeEnergyFleet::Settle(uint32_t i, Time spanStart, double headroomJ, double loadW)
+{
+    Time now = Simulator::Now();
+    Time last = TimeStep(m_lastAccrual[i]);
+    double energyJ = 0.0;
+    if (m_enabled[i] && now > last)
+    {
+        // As in SolarHarvesterDeviceModel::Settle(): energy accrued earlier
+        // in this span counts against the headroom, as does the load.
+        Time from = Max(last, spanStart);
+        double netJ = m_pendingJ[i] - loadW * (from - spanStart).GetSeconds();
+        Time crossing;
+        energyJ = IntegrateHarvest([this, i](Time t) { return GetSegment(i, t); },
+                                   from,
+                                   now,
+                                   netJ,
+                                   headroomJ,
+                                   loadW,
+                                   crossing);
+        if (crossing != Time::Max())
+        {
+            NS_LOG_DEBUG("member " << i << " headroom used up at " << crossing.GetSeconds()
+                                   << " s");
+            m_enabled[i] = 0;
+            m_clamped[i] = 1;
+        }
+    }
+    m_lastAccrual[i] = now.GetTimeStep();
+    energyJ += m_pendingJ[i];
+    m_pendingJ[i] = 0.0;
+    return energyJ;
+}
+
+double
+CompositeEnergyFleet::GetPendingEnergy(uint32_t i)
+{
+    Accrue(i, Simulator::Now());
+    return m_pendingJ[i];
+}
+
+void
+CompositeEnergyFleet::Report(uint32_t i,
+                             double remainingJ,
+                             double voltageV,
+                             double headroomJ,
+                             double loadW)
+{
+    m_remainingJ[i] = remainingJ;
+    m_voltageV[i] = voltageV;
+    m_headroomJ[i] = headroomJ;
+    m_loadW[i] = loadW;
+    m_lastUpdate[i] = Simulator::Now().GetTimeStep();
+    m_clamped[i] = 0;
+}
+
+void
+CompositeEnergyFleet::WindowsChanged(uint32_t i)
+{
+    NS_LOG_FUNCTION(this << i);
+    Ptr<CompositeEnergySource> source = m_sources[i];
+    if (m_models[i] || source->m_useLeoCycle)
+    {
+        // Already reading its model or window index live, or ignoring its
+        // windows for the LEO cycle.
+        return;
+    }
+
+    // Energy up to now under the old pulse, then the window index. The
+    // model pass of the next tick sets its power and clamps.
+    Accrue(i, Simulator::Now());
+    m_models[i] = source->m_windowProfile;
+    m_modelMembers.push_back(i);
+    m_peakW[i] = source->GetHarvestProfileScale();
+    m_origin[i] = 0;
+    m_on[i] = 0;
+    m_period[i] = 1;
+    m_from[i] = std::numeric_limits<int64_t>::min();
+    m_until[i] = std::numeric_limits<int64_t>::max();
+}
+
+bool
+CompositeEnergyFleet::IsInSunlight(uint32_t i) const
+{
+    if (m_models[i])
+    {
+        return true;
+    }
+    return GetSegment(i, Simulator::Now()).startWm2 > 0.0;
+}
+
+void
+CompositeEnergyFleet::Tick()
+{
+    NS_LOG_FUNCTION(this);
+    ++m_tickCount;
+    Time now = Simulator::Now();
+    std::size_t n = m_sources.size();
+    std::size_t chunks = (n + m_chunkSize - 1) / m_chunkSize;
+    m_chunkPowerW.assign(chunks, 0.0);
+    m_chunkEnergyJ.assign(chunks, 0.0);
+
+    // Members with a model first, on this thread: models may keep lookup
+    // state and are not safe to call concurrently.
+    for (uint32_t i : m_modelMembers)
+    {
+        Accrue(i, now);
+        m_enabled[i] = IsBelowClamps(i);
+        m_powerW[i] = m_enabled[i] ? m_peakW[i] * m_models[i]->GetPowerDensityWm2(now) : 0.0;
+    }
+
+    // Then the pulse members, chunk by chunk, on as many threads as set.
+    int64_t t = now.GetTimeStep();
+    if (m_threads != 1 && !m_pool)
+    {
+        m_pool = std::make_unique<EnergyWorkerPool>(m_threads);
+    }
+    if (m_pool)
+    {
+        m_pool->Run(chunks, [this, t](std::size_t c) { TickChunk(c, t); });
+    }
+    else
+    {
+        for (std::size_t c = 0; c < chunks; ++c)
+        {
+            TickChunk(c, t);
+        }
+    }
+
+    // Reduce in chunk order, whichever thread computed each chunk.
+    m_harvestedPowerW = 0.0;
+    m_tickEnergyJ = 0.0;
+    for (std::size_t c = 0; c < chunks; ++c)
+    {
+        m_harvestedPowerW += m_chunkPowerW[c];
+        m_tickEnergyJ += m_chunkEnergyJ[c];
+    }
+
+    // Each member's traces, with the energy it harvested up to now: what
+    // its last update delivered plus what the fleet accrued since.
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        m_sources[i]->PublishHarvestedPower(
+            m_powerW[i],
+            m_sources[i]->GetTotalHarvestedEnergy() + m_pendingJ[i]);
+    }
+
+    m_tickEvent =
+        Simulator::Schedule(Seconds(m_harvestIntervalSeconds), &CompositeEnergyFleet::Tick, this);
+}
+
+void
+CompositeEnergyFleet::TickChunk(std::size_t c, int64_t t)
+{
+    std::size_t begin = c * m_chunkSize;
+    std::size_t end = std::min(begin + m_chunkSize, m_sources.size());
+    Time now = TimeStep(t);
+
+    // Energy up to now, under the state of the previous tick.
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        if (!m_models[i])
+        {
+            Accrue(i, now);
+        }
+    }
+
+    // Clamps and pulse power. These loops run over plain arrays without
+    // branches so that they vectorize; model members keep what the
+    // serial pass set.
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        m_enabled[i] = IsBelowClamps(i);
+    }
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        int64_t phase = (t - m_origin[i]) % m_period[i];
+        phase += (phase < 0) * m_period[i];
+        bool lit = (phase < m_on[i]) & (t >= m_from[i]) & (t < m_until[i]);
+        bool pulse = !m_models[i];
+        m_powerW[i] = pulse ? (m_enabled[i] & lit) * m_peakW[i] : m_powerW[i];
+    }
+
+    double powerW = 0.0;
+    double energyJ = 0.0;
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        powerW += m_powerW[i];
+        energyJ += m_accruedJ[i];
+    }
+    m_chunkPowerW[c] = powerW;
+    m_chunkEnergyJ[c] = energyJ;
+}
+
+void
+CompositeEnergyFleet::Accrue(uint32_t i, Time now)
+{
+    Time last = TimeStep(m_lastAccrual[i]);
+    double energyJ = 0.0;
+    if (m_enabled[i] && now > last)
+    {
+        // Same integral as Settle(), with the headroom and load the member
+        // reported at the start of its current span.
+        Time spanStart = TimeStep(m_lastUpdate[i]);
+        double netJ = m_pendingJ[i] - m_loadW[i] * (last - spanStart).GetSeconds();
+        Time crossing;
+        energyJ = IntegrateHarvest([this, i](Time t) { return GetSegment(i, t); },
+                                   last,
+                                   now,
+                                   netJ,
+                                   m_headroomJ[i],
+                                   m_loadW[i],
+                                   crossing);
+        if (crossing != Time::Max())
+        {
+            m_enabled[i] = 0;
+            m_clamped[i] = 1;
+        }
+    }
+    m_pendingJ[i] += energyJ;
+    m_accruedJ[i] = energyJ;
+    m_lastAccrual[i] = now.GetTimeStep();
+}
+
+bool
+CompositeEnergyFleet::IsBelowClamps(uint32_t i) const
+{
+    // From the member's last Li-Ion update; a crossing since then holds
+    // until the next one.
+    const double tolerance = 1.0 - CompositeEnergySource::CLAMP_TOLERANCE;
+    bool belowCap = m_remainingJ[i] < m_capJ[i] * tolerance;
+    bool belowVoltage =
+        (m_maxVoltageV[i] <= 0.0) | (m_voltageV[i] < m_maxVoltageV[i] * tolerance);
+    return m_active[i] & !m_clamped[i] & belowCap & belowVoltage;
+}
+
+SolarIrradianceSegment
+CompositeEnergyFleet::GetSegment(uint32_t i, Time t) const
+{
+    if (m_models[i])
+    {
+        SolarIrradianceSegment segment = m_models[i]->GetSegment(t);
+        segment.startWm2 *= m_peakW[i];
+        segment.slopeWm2PerS *= m_peakW[i];
+        return segment;
+    }
+
+    // Pulses are piecewise constant; segment ends are computed in time
+    // steps so that they agree exactly with the tick's phase test.
+    int64_t ts = t.GetTimeStep();
+    if (ts >= m_until[i] || m_on[i] <= 0)
+    {
+        return SolarIrradianceSegment{t, Time::Max(), 0.0, 0.0};
+    }
+    if (ts < m_from[i])
+    {
+        return SolarIrradianceSegment{t, TimeStep(m_from[i]), 0.0, 0.0};
+    }
+    if (m_on[i] >= m_period[i])
+    {
+        return SolarIrradianceSegment{t, TimeStep(m_until[i]), m_peakW[i], 0.0};
+    }
+    int64_t phase = (ts - m_origin[i]) % m_period[i];
+    if (phase < 0)
+    {
+        phase += m_period[i];
+    }
+    if (phase < m_on[i])
+    {
+        return SolarIrradianceSegment{t,
+                                      TimeStep(std::min(ts + (m_on[i] - phase), m_until[i])),
+                                      m_peakW[i],
+                                      0.0};
+    }
+    return SolarIrradianceSegment{t,
+                                  TimeStep(std::min(ts + (m_period[i] - phase), m_until[i])),
+                                  0.0,
+                                  0.0};
+}
+
+} // namespace ns3
@@ -0,0 +1,227 @@
+#ifndef NS3_COMPOSITE_ENERGY_FLEET_H
+#define NS3_COMPOSITE_ENERGY_FLEET_H
+
+#include "composite-energy-source.h"
+#include "energy-worker-pool.h"
+#include "solar-irradiance-model.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Batch harvest engine for many CompositeEnergySource instances.
+ *
+ * A stand-alone CompositeEnergySource runs its own harvest-update event
+ * and reaches its irradiance through virtual
+ * calls. Across a constellation of thousands of satellites these
+ * per-object events dominate the event queue. Sources added to a fleet
+ * hand their harvesting over to it instead:
+ *  - The fleet keeps the harvest state of every member in
+ *    structure-of-arrays form, and one scheduled tick every
+ *    HarvestIntervalSeconds re-evaluates the clamps and the harvest power
+ *    of all members in branch-free loops over contiguous arrays.
+ *  - The built-in LEO cycle and a single fixed window are both stored as a
+ *    clipped periodic pulse (on for \c on of every \c period time steps
+ *    from \c origin, within [from, until)), so members of either kind need
+ *    no virtual call. Members with an IrradianceModel or several windows
+ *    go through the model, as does a window member once a window is
+ *    added to it at run time.
+ *  - Each member remains an ordinary CompositeEnergySource: devices attach
+ *    to it unchanged and its Li-Ion updates run as before. At each of them
+ *    the member settles the energy harvested since the previous one from
+ *    the fleet, integrated exactly as a stand-alone source does and cut
+ *    off at the MaxEnergyJ / MaxChargeVoltageV crossing.
+ *  - The tick also accrues that energy up to the tick time, against the
+ *    headroom and load each member reported at its last Li-Ion update, so
+ *    the integration work is done in the batch rather than in the members'
+ *    updates.
+ *
+ * With Threads other than 1 the tick runs on an EnergyWorkerPool: members
+ * are split into chunks of ChunkSize, chunks are distributed over the
+ * threads with work stealing, and each chunk reduces its own totals.
+ * Members with an IrradianceModel are updated on the simulation thread
+ * first, since models may keep lookup state. Every member's arithmetic is
+ * independent of the others and the chunk totals are summed in chunk
+ * order, so results are bit-identical whatever the number of threads.
+ *
+ * The tick re-evaluates the clamps from each member's last Li-Ion update
+ * rather than forcing one, so a clamp may be released up to one
+ * PeriodicEnergyUpdateInterval later than in a stand-alone source; the
+ * crossing itself is as exact. Members ignore their own
+ * HarvestIntervalSeconds and HarvestScheduling.
+ *
+ * The fleet and its members hold counted references to each other. The
+ * cycle is broken by whichever is disposed first: a member drops its
+ * reference to the fleet in its DoDispose(), and the fleet drops its
+ * members and detaches them in its own. Simulator::Destroy() disposes the
+ * members through their nodes' energy source containers, after which the
+ * fleet is freed with the last reference the script holds. A member
+ * detached from a disposed fleet stops harvesting, so a fleet must not be
+ * disposed before the end of the run.
+ */
+class CompositeEnergyFleet : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    CompositeEnergyFleet();
+    ~CompositeEnergyFleet() override;
+
+    /**
+     * \brief Add a source to the fleet.
+     *
+     * Must be called before the source is initialized; its harvesting
+     * attributes are read when it is.
+     *
+     * \return Index of the source in the fleet.
+     */
+    uint32_t Add(Ptr<CompositeEnergySource> source);
+
+    /** \return Number of member sources. */
+    uint32_t GetN() const;
+
+    /** \return Member source \p i. */
+    Ptr<CompositeEnergySource> Get(uint32_t i) const;
+
+    /** \return Number of fleet ticks run so far. */
+    uint64_t GetTickCount() const;
+
+    /** \return Sum of GetTotalHarvestedEnergy() over the members (J). */
+    double GetTotalHarvestedEnergy() const;
+
+    /** \return Total harvest power of the members at the last tick (W). */
+    double GetHarvestedPower() const;
+
+    /** \return Energy the members accrued at the last tick (J). */
+    double GetTickHarvestedEnergy() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    friend class CompositeEnergySource;
+
+    /**
+     * \brief Start harvesting for member \p i from its attributes.
+     *
+     * Called by the member once it is initialized.
+     */
+    void Enroll(uint32_t i);
+
+    /**
+     * \brief Energy harvested by member \p i since \p spanStart.
+     *
+     * Called by the member just before each of its Li-Ion updates; the
+     * arguments are those of SolarHarvesterDeviceModel::Settle().
+     */
+    double Settle(uint32_t i, Time spanStart, double headroomJ, double loadW);
+
+    /**
+     * \brief Energy member \p i harvested since its last Li-Ion update.
+     *
+     * Accrues up to now first; the next Settle() still delivers it.
+     */
+    double GetPendingEnergy(uint32_t i);
+
+    /**
+     * \brief Record the state member \p i reached at a Li-Ion update.
+     *
+     * \param headroomJ Energy the member can take before a clamp.
+     * \param loadW Device load from now to its next update.
+     */
+    void Report(uint32_t i, double remainingJ, double voltageV, double headroomJ, double loadW);
+
+    /**
+     * \brief Follow the windows of member \p i, which changed at run time.
+     *
+     * A member enrolled with at most one window is a pulse copied from
+     * it; from now on it reads its window index like a schedule.
+     */
+    void WindowsChanged(uint32_t i);
+
+    /** \return Whether member \p i is in the lit part of its pulse. */
+    bool IsInSunlight(uint32_t i) const;
+
+    /** Re-evaluate every member and schedule the next tick. */
+    void Tick();
+
+    /**
+     * \brief Tick the pulse members of chunk \p c and reduce its totals.
+     *
+     * Runs on any thread of the pool: touches nothing but the arrays of
+     * the chunk's members and the chunk's entries of the totals.
+     */
+    void TickChunk(std::size_t c, int64_t t);
+
+    /**
+     * \brief Accrue the energy member \p i harvested up to \p now.
+     *
+     * Stops at the member's clamp crossing, as Settle() does.
+     */
+    void Accrue(uint32_t i, Time now);
+
+    /** \return Whether member \p i may harvest from its last update's state. */
+    bool IsBelowClamps(uint32_t i) const;
+
+    /** \return Harvest power segment (W) of member \p i from \p t on. */
+    SolarIrradianceSegment GetSegment(uint32_t i, Time t) const;
+
+    double m_harvestIntervalSeconds;
+    uint32_t m_threads;
+    uint32_t m_chunkSize;
+    EventId m_tickEvent;
+    uint64_t m_tickCount;
+    std::unique_ptr<EnergyWorkerPool> m_pool; // created at the first tick
+
+    // Per-chunk totals of the last tick, and their ordered sums
+    std::vector<double> m_chunkPowerW;
+    std::vector<double> m_chunkEnergyJ;
+    double m_harvestedPowerW;
+    double m_tickEnergyJ;
+
+    std::vector<Ptr<CompositeEnergySource>> m_sources;
+    std::vector<Ptr<const SolarIrradianceModel>> m_models; // null for pulse members
+    std::vector<uint32_t> m_modelMembers;                   // indices with a model
+
+    // Harvest profile: pulse power (W) or model scale (m^2), and the
+    // pulse in time steps.
+    std::vector<double> m_peakW;
+    std::vector<int64_t> m_origin;
+    std::vector<int64_t> m_on;
+    std::vector<int64_t> m_period;
+    std::vector<int64_t> m_from;
+    std::vector<int64_t> m_until;
+
+    // Clamps, and the state of each member's last Li-Ion update
+    std::vector<double> m_capJ;
+    std::vector<double> m_maxVoltageV; // 0 => no voltage clamp
+    std::vector<double> m_remainingJ;
+    std::vector<double> m_voltageV;
+    std::vector<double> m_headroomJ;
+    std::vector<double> m_loadW;
+    std::vector<int64_t> m_lastUpdate;
+
+    // Harvest state
+    std::vector<uint8_t> m_active;  // enrolled
+    std::vector<uint8_t> m_clamped; // crossed a clamp since the last update
+    std::vector<uint8_t> m_enabled; // harvesting since m_lastAccrual
+    std::vector<double> m_powerW;   // instantaneous power at the last tick
+    std::vector<double> m_pendingJ; // accrued, not yet settled
+    std::vector<double> m_accruedJ; // accrued at the last tick
+    std::vector<int64_t> m_lastAccrual;
+};
+
+} // namespace ns3
+
+#endif // NS3_COMPOSITE_ENERGY_FLEET_H
@@ -1,11 +1,20 @@
 #include "composite-energy-source.h"
 
+#include "composite-energy-fleet.h"
+
 #include "ns3/boolean.h"
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/log.h"
+#include "ns3/node.h"
 #include "ns3/nstime.h"
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ns3
 {
@@ -13,6 +22,43 @@ namespace ns3
 NS_LOG_COMPONENT_DEFINE("CompositeEnergySource");
 NS_OBJECT_ENSURE_REGISTERED(CompositeEnergySource);
 
+namespace
+{
+
+/**
+ * Convert a predicted delay in seconds into a Time, rounded up by one
+ * time step so the event never fires before the crossing it was planned
+ * for. Non-finite or non-positive predictions yield \p fallback.
+ */
+Time
+PredictedDelay(double seconds, Time fallback)
+{
+    if (!(seconds > 0.0) || !std::isfinite(seconds))
+    {
+        return fallback;
+    }
+    if (seconds >= Time::Max().GetSeconds() / 2)
+    {
+        return Time::Max();
+    }
+    return Seconds(seconds) + TimeStep(1);
+}
+
+/**
+ * Supply voltage of a cell at open-circuit voltage \p openCircuitV and
+ * internal resistance \p resistanceOhm, drawing \p loadA while
+ * \p harvestW is injected: the positive root of
+ * v = openCircuitV - R * (loadA - harvestW / v).
+ */
+double
+TerminalVoltage(double openCircuitV, double resistanceOhm, double loadA, double harvestW)
+{
+    double c = openCircuitV - resistanceOhm * loadA;
+    return 0.5 * (c + std::sqrt(std::max(c * c + 4.0 * resistanceOhm * harvestW, 0.0)));
+}
+
+} // namespace
+
 TypeId
 CompositeEnergySource::GetTypeId()
 {
@@ -43,12 +89,57 @@ CompositeEnergySource::GetTypeId()
                           MakeDoubleAccessor(&CompositeEnergySource::m_solarConstantWm2),
                           MakeDoubleChecker<double>(0.0))
             .AddAttribute("HarvestIntervalSeconds",
-                          "Period at which the harvest current is recomputed and re-applied "
-                          "to the internal harvester (s). Smaller values track state changes "
-                          "(sunlight toggle, full-charge clamp) more tightly at some cost.",
+                          "Period at which the harvest state is re-evaluated (s): clamp "
+                          "release, the HarvestedPower trace and models without known "
+                          "breakpoints. The injected energy is integrated exactly whatever "
+                          "its value.",
                           DoubleValue(1.0),
                           MakeDoubleAccessor(&CompositeEnergySource::m_harvestIntervalSeconds),
                           MakeDoubleChecker<double>(1e-6))
+            .AddAttribute("HarvestScheduling",
+                          "How the harvest current is rescheduled. FixedInterval recomputes "
+                          "it every HarvestIntervalSeconds. EventDriven recomputes it only at "
+                          "the next breakpoint of the active harvesting mode and at the "
+                          "predicted MaxEnergyJ / MaxChargeVoltageV crossings; "
+                          "HarvestIntervalSeconds is then the polling period for modes "
+                          "without known breakpoints and the re-arm delay after a clamp. "
+                          "FastForward schedules the harvest as EventDriven and also updates "
+                          "the Li-Ion state only at harvest updates, device current changes "
+                          "and the predicted low-battery and ThresholdVoltage crossings, "
+                          "overriding PeriodicEnergyUpdateInterval. Adaptive recomputes it "
+                          "periodically at a step that follows the rate of change of the "
+                          "harvest power and supply voltage (HarvestStepTolerance), also "
+                          "landing on breakpoints and predicted clamp crossings.",
+                          EnumValue(FIXED_INTERVAL),
+                          MakeEnumAccessor<HarvestSchedulingMode>(
+                              &CompositeEnergySource::m_harvestScheduling),
+                          MakeEnumChecker(FIXED_INTERVAL,
+                                          "FixedInterval",
+                                          EVENT_DRIVEN,
+                                          "EventDriven",
+                                          FAST_FORWARD,
+                                          "FastForward",
+                                          ADAPTIVE,
+                                          "Adaptive"))
+            .AddAttribute("MinHarvestIntervalSeconds",
+                          "Smallest step (s) of the Adaptive harvest scheduling.",
+                          DoubleValue(0.1),
+                          MakeDoubleAccessor(
+                              &CompositeEnergySource::m_minHarvestIntervalSeconds),
+                          MakeDoubleChecker<double>(1e-6))
+            .AddAttribute("MaxHarvestIntervalSeconds",
+                          "Largest step (s) of the Adaptive harvest scheduling.",
+                          DoubleValue(120.0),
+                          MakeDoubleAccessor(
+                              &CompositeEnergySource::m_maxHarvestIntervalSeconds),
+                          MakeDoubleChecker<double>(1e-6))
+            .AddAttribute("HarvestStepTolerance",
+                          "Largest relative change of the available harvest power and of "
+                          "the supply voltage over one step of the Adaptive harvest "
+                          "scheduling. The step starts at HarvestIntervalSeconds.",
+                          DoubleValue(0.01),
+                          MakeDoubleAccessor(&CompositeEnergySource::m_harvestStepTolerance),
+                          MakeDoubleChecker<double>(0.0))
             .AddAttribute("SunlightSeconds",
                           "Duration of sunlight per LEO cycle (s).",
                           DoubleValue(3900.0),
@@ -79,6 +170,24 @@ CompositeEnergySource::GetTypeId()
                           PointerValue(),
                           MakePointerAccessor(&CompositeEnergySource::m_irradianceModel),
                           MakePointerChecker<SolarIrradianceModel>())
+            .AddAttribute("IrradianceLookahead",
+                          "Number of IrradianceModel samples fetched ahead per block, at "
+                          "HarvestIntervalSeconds spacing, for a model that must be polled "
+                          "(one whose segments are unknown at initialization), under "
+                          "FixedInterval scheduling. The model then computes whole blocks "
+                          "through GetPowerDensitiesWm2(); the harvest is unchanged. 0 "
+                          "(default) queries it sample by sample, as do the other modes.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&CompositeEnergySource::m_irradianceLookahead),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("IrradianceWorkers",
+                          "Background threads computing the IrradianceLookahead blocks ahead "
+                          "of the simulation (AsyncSolarIrradianceModel). The IrradianceModel "
+                          "is then called from those threads and must be safe to call "
+                          "concurrently. 0 (default) fetches blocks on the simulation thread.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&CompositeEnergySource::m_irradianceWorkers),
+                          MakeUintegerChecker<uint32_t>())
             .AddAttribute("MaxChargeVoltageV",
                           "Per-cell voltage ceiling (V). Harvest current is clamped to zero "
                           "once GetSupplyVoltage() reaches this value. Approximates the "
@@ -88,6 +197,30 @@ CompositeEnergySource::GetTypeId()
                           DoubleValue(0.0),
                           MakeDoubleAccessor(&CompositeEnergySource::m_maxChargeVoltageV),
                           MakeDoubleChecker<double>(0.0))
+            .AddAttribute("ChargeTaper",
+                          "What happens once MaxChargeVoltageV is reached. HardClamp stops "
+                          "harvesting. Nmc, Lfp and Lco start a constant-voltage taper "
+                          "instead: the harvested current is capped by that chemistry's "
+                          "taper (ChargeTaperTable), from TaperCurrentA at the ceiling down "
+                          "to the termination current at full charge, where harvesting "
+                          "stops. Read when the source is initialized.",
+                          EnumValue(HARD_CLAMP),
+                          MakeEnumAccessor<ChargeTaperMode>(
+                              &CompositeEnergySource::m_chargeTaper),
+                          MakeEnumChecker(HARD_CLAMP,
+                                          "HardClamp",
+                                          TAPER_NMC,
+                                          "Nmc",
+                                          TAPER_LFP,
+                                          "Lfp",
+                                          TAPER_LCO,
+                                          "Lco"))
+            .AddAttribute("TaperCurrentA",
+                          "Charge current (A) at the start of the ChargeTaper. 0 (default) "
+                          "means 1C of the cell's rated capacity.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&CompositeEnergySource::m_taperCurrentA),
+                          MakeDoubleChecker<double>(0.0))
             .AddAttribute("ChargeEfficiency",
                           "Round-trip efficiency applied to harvested power before it is "
                           "injected into the battery. Use this to model MPPT/regulator "
@@ -99,15 +232,49 @@ CompositeEnergySource::GetTypeId()
                             "Instantaneous harvested power (W) injected into the battery, "
                             "after efficiency and CC-CV clamps.",
                             MakeTraceSourceAccessor(&CompositeEnergySource::m_harvestedPowerW),
-                            "ns3::TracedValueCallback::Double");
+                            "ns3::TracedValueCallback::Double")
+            .AddAttribute("HarvestedPowerDeadBandW",
+                          "Smallest change (W) of the harvested power reported by the "
+                          "HarvestedPower trace. Starts and stops of harvesting are always "
+                          "reported. 0 (default) reports every change.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&CompositeEnergySource::m_harvestedPowerDeadBandW),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("HarvestedPowerBin",
+                          "Length of the bins reported by HarvestedPowerBinned, aligned to "
+                          "multiples of it. 0 (default) disables the bins.",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&CompositeEnergySource::m_binWidth),
+                          MakeTimeChecker(Seconds(0)))
+            .AddTraceSource("HarvestedPowerBinned",
+                            "Minimum, mean and maximum harvested power and harvested energy "
+                            "of a HarvestedPowerBin, reported once it has ended.",
+                            MakeTraceSourceAccessor(&CompositeEnergySource::m_binTrace),
+                            "ns3::CompositeEnergySource::HarvestedPowerBinTracedCallback")
+            .AddAttribute("EnableProfiling",
+                          "Count the calls and wall time of UpdateEnergySource, "
+                          "GetRemainingEnergy and UpdateHarvestCurrent, and of the harvester's "
+                          "SetHarvestCurrentA and Settle, into profiles held by "
+                          "HotPathProfileRegistry. Read when the source is initialized.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&CompositeEnergySource::m_enableProfiling),
+                          MakeBooleanChecker())
+            .AddTraceSource("HotPath",
+                            "A profiled call returned, with its wall time. Only fires while "
+                            "EnableProfiling is true.",
+                            MakeTraceSourceAccessor(&CompositeEnergySource::m_hotPathTrace),
+                            "ns3::HotPathProfile::TracedCallback");
     return tid;
 }
 
 CompositeEnergySource::CompositeEnergySource()
     : m_harvester(CreateObject<SolarHarvesterDeviceModel>()),
-      m_windowPowerW(0.0),
-      m_windowStart(0.0),
-      m_windowEnd(0.0),
+      m_irradianceLookahead(0),
+      m_irradianceWorkers(0),
+      m_lookaheadProfile(nullptr),
+      m_lookaheadModel(nullptr),
+      m_leoProfile(nullptr),
+      m_windowProfile(nullptr),
       m_useLeoCycle(true),
       m_panelAreaM2(2.0),
       m_panelEfficiency(0.28),
@@ -118,8 +285,46 @@ CompositeEnergySource::CompositeEnergySource()
       m_maxEnergyJ(0.0),
       m_maxChargeVoltageV(0.0),
       m_chargeEfficiency(1.0),
-      m_inSunlight(true),
-      m_harvestedPowerW(0.0)
+      m_remainingJ(0.0),
+      m_drainedAh(0.0),
+      m_lastEnergyUpdate(Seconds(0)),
+      m_chargeLimitV(0.0),
+      m_chargeLimitAh(std::nan("")),
+      m_chargeTaper(HARD_CLAMP),
+      m_taperCurrentA(0.0),
+      m_taperTable(nullptr),
+      m_tapering(false),
+      m_harvestScheduling(FIXED_INTERVAL),
+      m_harvestEventCount(0),
+      m_plannedLoadA(0.0),
+      m_lowBatteryFraction(0.0),
+      m_thresholdVoltageV(0.0),
+      m_fastForwardLoadA(0.0),
+      m_fastForwardHarvestW(0.0),
+      m_fastForwardOffsetV(0.0),
+      m_fastForwardStale(false),
+      m_minHarvestIntervalSeconds(0.1),
+      m_maxHarvestIntervalSeconds(120.0),
+      m_harvestStepTolerance(0.01),
+      m_adaptiveStepSeconds(0.0),
+      m_adaptiveLastUpdate(Seconds(0)),
+      m_adaptiveLastW(0.0),
+      m_adaptiveLastV(0.0),
+      m_harvestedPowerW(0.0),
+      m_harvestedPowerDeadBandW(0.0),
+      m_binWidth(Seconds(0)),
+      m_binOpen(false),
+      m_bin{Seconds(0), Seconds(0), 0.0, 0.0, 0.0, 0.0},
+      m_binLastUpdate(Seconds(0)),
+      m_binLastJ(0.0),
+      m_binLastW(0.0),
+      m_hasEnergyState(false),
+      m_energyState{0.0, 0.0, Seconds(0)},
+      m_cycleOrigin(Seconds(0)),
+      m_fleet(nullptr),
+      m_fleetIndex(0),
+      m_enableProfiling(false),
+      m_hotPathProfile(nullptr)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -135,11 +340,52 @@ CompositeEnergySource::AddSolarPanelWindow(double powerJoulePerSecond,
                                            double endTime)
 {
     NS_LOG_FUNCTION(this << powerJoulePerSecond << startTime << endTime);
-    m_windowPowerW = powerJoulePerSecond;
-    m_windowStart = startTime;
-    m_windowEnd = endTime;
-    // The periodic UpdateHarvestCurrent() tick picks up the window
-    // boundaries automatically; no separate scheduling required.
+    // The windows form a power profile in W, picked up by the next
+    // UpdateHarvestCurrent().
+    if (!m_windowProfile)
+    {
+        m_windowProfile = CreateObject<WindowSolarIrradianceModel>();
+    }
+    m_windowProfile->AddWindow(powerJoulePerSecond, Seconds(startTime), Seconds(endTime));
+    WindowsChanged();
+}
+
+uint64_t
+CompositeEnergySource::LoadSolarPanelWindows(const std::string& fileName, double timeScale)
+{
+    NS_LOG_FUNCTION(this << fileName << timeScale);
+    if (!m_windowProfile)
+    {
+        m_windowProfile = CreateObject<WindowSolarIrradianceModel>();
+    }
+    uint64_t windows = m_windowProfile->LoadWindows(fileName, timeScale);
+    WindowsChanged();
+    return windows;
+}
+
+void
+CompositeEnergySource::WindowsChanged()
+{
+    // The pending harvest update was planned on the old profile: at the
+    // end of its segment, which is Time::Max() past the last window, in
+    // every mode but FixedInterval. Plan it again from the new one. A
+    // fleet member has no harvest update of its own; the fleet may have
+    // copied its one window instead of reading the index, so tell it.
+    if (!IsInitialized())
+    {
+        return;
+    }
+    if (m_fleet)
+    {
+        m_fleet->WindowsChanged(m_fleetIndex);
+        return;
+    }
+    if (GetHarvestProfile() != m_windowProfile)
+    {
+        return;
+    }
+    Simulator::Cancel(m_harvestEvent);
+    m_harvestEvent = Simulator::ScheduleNow(&CompositeEnergySource::UpdateHarvestCurrent, this);
 }
 
 void
@@ -162,7 +408,240 @@ CompositeEnergySource::GetTotalHarvestedEnergy() const
 bool
 CompositeEnergySource::IsInSunlight() const
 {
-    return m_useLeoCycle ? m_inSunlight : true;
+    if (!m_useLeoCycle || m_irradianceModel)
+    {
+        return true;
+    }
+    if (m_fleet)
+    {
+        return m_fleet->IsInSunlight(m_fleetIndex);
+    }
+    return !m_leoProfile || m_leoProfile->IsInSunlight(Simulator::Now());
+}
+
+uint64_t
+CompositeEnergySource::GetHarvestEventCount() const
+{
+    return m_harvestEventCount;
+}
+
+void
+CompositeEnergySource::FlushHarvestedPowerBin()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_binOpen)
+    {
+        return;
+    }
+    // Accrue the harvest up to now, as a harvest update would, so the bin
+    // ends here rather than at the last update.
+    Time now = Simulator::Now();
+    if (m_fleet)
+    {
+        PublishHarvestedPower(m_binLastW,
+                              GetTotalHarvestedEnergy() +
+                                  m_fleet->GetPendingEnergy(m_fleetIndex));
+    }
+    else
+    {
+        double v = GetSupplyVoltage();
+        m_harvester->Accrue(m_lastEnergyUpdate, GetHeadroomJ(v), GetDeviceLoadA() * v);
+        PublishHarvestedPower(m_harvester->GetHarvestPowerW(now),
+                              m_harvester->GetTotalHarvestedEnergy());
+    }
+    if (now > m_bin.start)
+    {
+        ReportHarvestedPowerBin(now);
+    }
+}
+
+double
+CompositeEnergySource::GetRemainingEnergy()
+{
+    HotPathTimer timer(m_hotPathProfile.get(),
+                       HotPathProfile::GET_REMAINING_ENERGY,
+                       m_hotPathTrace);
+    return LiIonEnergySource::GetRemainingEnergy();
+}
+
+CompositeEnergySource::EnergyState
+CompositeEnergySource::GetEnergyState()
+{
+    NS_LOG_FUNCTION(this);
+    EnergyState state;
+    state.remainingJ = GetRemainingEnergy();
+    state.harvestedJ = m_harvester->GetTotalHarvestedEnergy();
+    state.cyclePosition = Seconds(0);
+    int64_t period =
+        m_useLeoCycle ? Seconds(m_sunlightSeconds + m_shadowSeconds).GetTimeStep() : 0;
+    if (period > 0)
+    {
+        int64_t position = (Simulator::Now() - m_cycleOrigin).GetTimeStep() % period;
+        state.cyclePosition = TimeStep(position < 0 ? position + period : position);
+    }
+    return state;
+}
+
+void
+CompositeEnergySource::SetEnergyState(const EnergyState& state)
+{
+    NS_LOG_FUNCTION(this << state.remainingJ << state.harvestedJ << state.cyclePosition);
+    NS_ABORT_MSG_IF(IsInitialized(), "SetEnergyState() after the source was initialized");
+    NS_ABORT_MSG_IF(state.remainingJ < 0.0, "Negative remaining energy");
+    m_hasEnergyState = true;
+    m_energyState = state;
+}
+
+const HotPathProfile*
+CompositeEnergySource::GetProfile() const
+{
+    return m_hotPathProfile.get();
+}
+
+Ptr<const SolarHarvesterDeviceModel>
+CompositeEnergySource::GetHarvester() const
+{
+    return m_harvester;
+}
+
+void
+CompositeEnergySource::UpdateEnergySource()
+{
+    NS_LOG_FUNCTION(this);
+    HotPathTimer timer(m_hotPathProfile.get(),
+                       HotPathProfile::UPDATE_ENERGY_SOURCE,
+                       m_hotPathTrace);
+    if (Simulator::IsFinished())
+    {
+        LiIonEnergySource::UpdateEnergySource();
+        return;
+    }
+
+    // Deliver the energy harvested since the previous update. The base
+    // class integrates I * V * dt with the supply voltage of that update,
+    // so the harvester reports the average current that injects exactly the
+    // integral of the harvest power over the span, cut off at the instant
+    // a clamp is reached.
+    Time now = Simulator::Now();
+    double v = GetSupplyVoltage();
+    double loadA = GetDeviceLoadA();
+    if (m_fleet)
+    {
+        double energyJ =
+            m_fleet->Settle(m_fleetIndex, m_lastEnergyUpdate, GetHeadroomJ(v), loadA * v);
+        m_harvester->Deliver(energyJ, m_lastEnergyUpdate, v);
+    }
+    else if (now > m_lastEnergyUpdate)
+    {
+        m_harvester->Settle(m_lastEnergyUpdate, v, GetHeadroomJ(v), loadA * v);
+    }
+    else
+    {
+        // Nothing to deliver: the harvest current from now on is set at
+        // the voltage it will hold the cell at, found from the open-circuit
+        // voltage behind the last update. Reading the source again at the
+        // same time then leaves the voltage where it is.
+        double resistanceOhm = m_cellModel.GetResistance();
+        double openCircuitV = v + resistanceOhm * CalculateTotalCurrent();
+        double harvestW = m_harvester->GetHarvestPowerW(now);
+        m_harvester->Settle(m_lastEnergyUpdate,
+                            TerminalVoltage(openCircuitV, resistanceOhm, loadA, harvestW),
+                            GetHeadroomJ(v),
+                            loadA * v);
+    }
+
+    // Take the same integral the base class is about to take, so that the
+    // drained capacity behind its (private) Shepherd voltage is known.
+    double currentA = CalculateTotalCurrent();
+    double seconds = (now - m_lastEnergyUpdate).GetSeconds();
+    double drainedAh = m_drainedAh + currentA * seconds / 3600.0;
+
+    bool fastForward = (m_harvestScheduling == FAST_FORWARD && !m_fleet);
+    if (fastForward && loadA != 0.0 && seconds > 0.0)
+    {
+        // The base class charges the load at the voltage of its last
+        // update, which goes stale over a long span. The drained capacity
+        // moves linearly across the span, so charge the difference to the
+        // span's mean voltage.
+        double meanV = m_cellModel.GetMeanVoltage(m_drainedAh, drainedAh, currentA) +
+                       m_fastForwardOffsetV;
+        double extraJ = loadA * (meanV - v) * seconds;
+        if (extraJ > 0.0)
+        {
+            DecreaseRemainingEnergy(extraJ);
+        }
+        else if (extraJ < 0.0)
+        {
+            IncreaseRemainingEnergy(-extraJ);
+        }
+    }
+    m_drainedAh = drainedAh;
+    m_lastEnergyUpdate = now;
+
+    if (fastForward)
+    {
+        // The base class schedules its next update one interval on: make
+        // that the next crossing it would otherwise only see late.
+        double energyJ = std::max(m_remainingJ - currentA * v * seconds, 0.0);
+        m_fastForwardLoadA = loadA;
+        m_fastForwardHarvestW = m_harvester->GetHarvestPowerW(now);
+        SetEnergyUpdateInterval(PlanFastForward(energyJ, loadA, m_fastForwardHarvestW));
+        if (m_fastForwardCheck.IsExpired())
+        {
+            m_fastForwardCheck =
+                Simulator::ScheduleNow(&CompositeEnergySource::CheckFastForwardPlan, this);
+        }
+    }
+
+    LiIonEnergySource::UpdateEnergySource();
+    if (fastForward)
+    {
+        // The span was planned on the model's curve, at the current drawn
+        // from now on. Check where the update actually left the cell: off
+        // that curve, or at the voltage of the average current of the span
+        // just integrated rather than of the planned one. Either way the
+        // plan is redone from there, and a zero-length update sets the
+        // planned current.
+        double resistanceOhm = m_cellModel.GetResistance();
+        double vNow = GetSupplyVoltage();
+        double offsetV = vNow - m_cellModel.GetVoltage(m_drainedAh, currentA);
+        double plannedV = TerminalVoltage(m_cellModel.GetVoltage(m_drainedAh, 0.0) + offsetV,
+                                          resistanceOhm,
+                                          loadA,
+                                          m_fastForwardHarvestW);
+        double toleranceV = CLAMP_TOLERANCE * m_thresholdVoltageV;
+        if (std::abs(offsetV - m_fastForwardOffsetV) > toleranceV ||
+            std::abs(vNow - plannedV) > toleranceV)
+        {
+            NS_LOG_DEBUG("cell at " << vNow << " V, planned " << plannedV << " V, re-planning");
+            m_fastForwardOffsetV = offsetV;
+            m_fastForwardStale = true;
+        }
+    }
+    if (m_fleet)
+    {
+        double vNow = GetSupplyVoltage();
+        m_fleet->Report(m_fleetIndex,
+                        m_remainingJ,
+                        vNow,
+                        GetHeadroomJ(vNow),
+                        GetDeviceLoadA() * vNow);
+        return;
+    }
+
+    // A device changed its draw since the pending harvest update was
+    // planned, so the predicted clamp crossing is stale. Devices update the
+    // source before switching current, so the change is seen here at the
+    // latest one PeriodicEnergyUpdateInterval after it happened.
+    if (m_harvestScheduling != FIXED_INTERVAL && m_harvestEventCount > 0 &&
+        std::abs(loadA - m_plannedLoadA) > CLAMP_TOLERANCE * std::abs(m_plannedLoadA) &&
+        (m_harvestEvent.IsExpired() ||
+         Simulator::GetDelayLeft(m_harvestEvent).IsStrictlyPositive()))
+    {
+        Simulator::Cancel(m_harvestEvent);
+        m_harvestEvent =
+            Simulator::ScheduleNow(&CompositeEnergySource::UpdateHarvestCurrent, this);
+    }
 }
 
 void
@@ -174,23 +653,133 @@ CompositeEnergySource::DoInitialize()
     m_harvester->SetEnergySource(this);
     AppendDeviceEnergyModel(m_harvester);
 
-    // Base-class initialization schedules the periodic Li-Ion update.
-    LiIonEnergySource::DoInitialize();
+    if (m_enableProfiling)
+    {
+        uint32_t nodeId = GetNode() ? GetNode()->GetId() : std::numeric_limits<uint32_t>::max();
+        m_hotPathProfile = HotPathProfileRegistry::Create("CompositeEnergySource", nodeId);
+        m_harvester->SetProfile(
+            HotPathProfileRegistry::Create("SolarHarvesterDeviceModel", nodeId));
+    }
+
+    // Read the Shepherd parameters before the base class integrates
+    // anything: InitialCellVoltage reads back the live supply voltage.
+    m_cellModel.ConfigureFrom(this);
+    DoubleValue lowBattery;
+    DoubleValue thresholdVoltage;
+    GetAttribute("LiIonEnergyLowBatteryThreshold", lowBattery);
+    GetAttribute("ThresholdVoltage", thresholdVoltage);
+    m_lowBatteryFraction = lowBattery.Get();
+    m_thresholdVoltageV = thresholdVoltage.Get();
+    switch (m_chargeTaper)
+    {
+    case TAPER_NMC:
+        m_taperTable = &ChargeTaperTable::Get(ChargeTaperTable::NMC);
+        break;
+    case TAPER_LFP:
+        m_taperTable = &ChargeTaperTable::Get(ChargeTaperTable::LFP);
+        break;
+    case TAPER_LCO:
+        m_taperTable = &ChargeTaperTable::Get(ChargeTaperTable::LCO);
+        break;
+    default:
+        m_taperTable = nullptr;
+        break;
+    }
+    NS_ABORT_MSG_IF(m_harvestScheduling == ADAPTIVE &&
+                        m_minHarvestIntervalSeconds > m_maxHarvestIntervalSeconds,
+                    "MinHarvestIntervalSeconds exceeds MaxHarvestIntervalSeconds");
+    m_remainingJ = GetInitialEnergy();
+    TraceConnectWithoutContext(
+        "RemainingEnergy",
+        MakeCallback(&CompositeEnergySource::RemainingEnergyChanged, this));
+
+    // A restored state replaces the initial energy through the base
+    // class's own adjustments, which fire the RemainingEnergy trace.
+    m_cycleOrigin = Simulator::Now();
+    if (m_hasEnergyState)
+    {
+        double deltaJ = m_energyState.remainingJ - GetInitialEnergy();
+        if (deltaJ > 0.0)
+        {
+            IncreaseRemainingEnergy(deltaJ);
+        }
+        else if (deltaJ < 0.0)
+        {
+            DecreaseRemainingEnergy(-deltaJ);
+        }
+        m_harvester->RestoreTotalHarvestedEnergy(m_energyState.harvestedJ);
+        m_cycleOrigin -= m_energyState.cyclePosition;
+    }
+
+    // A fleet member is driven by the fleet's tick instead. Enrol before
+    // the base class starts: its first update schedules nothing if the
+    // event queue is still empty, and the enrolment schedules the tick.
+    if (m_fleet)
+    {
+        m_fleet->Enroll(m_fleetIndex);
+        LiIonEnergySource::DoInitialize();
+        return;
+    }
+
+    // A polled model is read through a block prefetch buffer at the tick
+    // spacing, filled in the background with IrradianceWorkers. Models
+    // that describe their segments are integrated over them instead and
+    // are left alone. Only FixedInterval keeps its ticks on that grid; the
+    // other modes also update at clamp crossings and re-arm delays, and
+    // Adaptive varies its step, so their queries would mostly miss the
+    // blocks while still paying for them.
+    if (m_irradianceModel && m_irradianceLookahead > 0 &&
+        m_harvestScheduling == FIXED_INTERVAL &&
+        !m_irradianceModel->GetSegment(Simulator::Now()).IsKnown())
+    {
+        if (m_irradianceWorkers > 0)
+        {
+            Ptr<AsyncSolarIrradianceModel> async = CreateObject<AsyncSolarIrradianceModel>();
+            async->SetAttribute("Threads", UintegerValue(m_irradianceWorkers));
+            async->SetModel(m_irradianceModel);
+            m_lookaheadProfile = async;
+        }
+        else
+        {
+            Ptr<LookaheadSolarIrradianceModel> lookahead =
+                CreateObject<LookaheadSolarIrradianceModel>();
+            lookahead->SetAttribute("Origin", TimeValue(Simulator::Now()));
+            lookahead->SetModel(m_irradianceModel);
+            m_lookaheadProfile = lookahead;
+        }
+        m_lookaheadProfile->SetAttribute("Samples", UintegerValue(m_irradianceLookahead));
+        m_lookaheadProfile->SetAttribute("Step", TimeValue(Seconds(m_harvestIntervalSeconds)));
+        m_lookaheadModel = m_irradianceModel;
+    }
 
     // Kick off the harvest-control loop. First tick at t=0 sets the initial
     // current; subsequent ticks track full-charge clamping and LEO/window
     // transitions.
     m_harvestEvent = Simulator::ScheduleNow(&CompositeEnergySource::UpdateHarvestCurrent, this);
 
-    // The built-in LEO toggle is only useful when the pluggable irradiance
-    // model is not in use; the model, if set, drives phase transitions
-    // itself through its GetPowerDensityWm2() output.
+    // Base-class initialization schedules the periodic Li-Ion update, which
+    // reconciles the harvest ticks' estimates with the cell. It schedules
+    // nothing while the event queue is empty, hence after the first tick.
+    LiIonEnergySource::DoInitialize();
+
+    // The built-in LEO cycle is only needed when the pluggable irradiance
+    // model is not in use. Its phase changes are segment ends of the
+    // profile like any other, so no event of its own is scheduled.
     if (m_useLeoCycle && !m_irradianceModel)
     {
-        m_inSunlight = true;
-        m_toggleEvent = Simulator::Schedule(Seconds(m_sunlightSeconds),
-                                            &CompositeEnergySource::ToggleSunlight,
-                                            this);
+        // The cycle's sunlight phase starts at m_cycleOrigin (now, unless
+        // a state was restored), wherever that falls in the profile's period.
+        double period = m_sunlightSeconds + m_shadowSeconds;
+        double phase = 0.0;
+        if (period > 0.0)
+        {
+            phase = std::fmod(period - std::fmod(m_cycleOrigin.GetSeconds(), period), period);
+        }
+        m_leoProfile = CreateObject<LeoCycleSolarIrradianceModel>();
+        m_leoProfile->SetAttribute("PeakWm2", DoubleValue(m_solarConstantWm2));
+        m_leoProfile->SetAttribute("SunlightSeconds", DoubleValue(m_sunlightSeconds));
+        m_leoProfile->SetAttribute("ShadowSeconds", DoubleValue(m_shadowSeconds));
+        m_leoProfile->SetAttribute("PhaseSeconds", DoubleValue(phase));
     }
 }
 
@@ -199,100 +788,549 @@ CompositeEnergySource::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     Simulator::Cancel(m_harvestEvent);
-    Simulator::Cancel(m_toggleEvent);
+    Simulator::Cancel(m_fastForwardCheck);
     if (m_harvester)
     {
         m_harvester->Dispose();
         m_harvester = nullptr;
     }
+    if (m_lookaheadProfile)
+    {
+        // Joins the workers of an asynchronous prefetch.
+        m_lookaheadProfile->Dispose();
+        m_lookaheadProfile = nullptr;
+    }
+    m_lookaheadModel = nullptr;
+    m_leoProfile = nullptr;
+    m_windowProfile = nullptr;
+    // Break the member -> fleet half of the reference cycle; the fleet
+    // still lists this source until it is disposed itself.
+    m_fleet = nullptr;
     LiIonEnergySource::DoDispose();
 }
 
+Ptr<const SolarIrradianceModel>
+CompositeEnergySource::GetHarvestProfile() const
+{
+    if (m_irradianceModel)
+    {
+        if (m_lookaheadProfile && m_lookaheadModel == m_irradianceModel)
+        {
+            return m_lookaheadProfile;
+        }
+        return m_irradianceModel;
+    }
+    if (m_useLeoCycle)
+    {
+        return m_leoProfile;
+    }
+    return m_windowProfile;
+}
+
+double
+CompositeEnergySource::GetHarvestProfileScale() const
+{
+    // Efficiency is a lumped loss covering MPPT / regulator / coulombic
+    // inefficiency. It attenuates the injected power, not the irradiance.
+    if (!m_irradianceModel && !m_useLeoCycle)
+    {
+        return m_chargeEfficiency;
+    }
+    return m_panelAreaM2 * m_panelEfficiency * m_chargeEfficiency;
+}
+
+double
+CompositeEnergySource::GetEnergyCap() const
+{
+    // MaxEnergyJ=0 (default) means the cap equals GetInitialEnergy().
+    return (m_maxEnergyJ > 0.0) ? m_maxEnergyJ : GetInitialEnergy();
+}
+
+double
+CompositeEnergySource::GetHeadroomJ(double v)
+{
+    double headroomJ = GetEnergyCap() - m_remainingJ;
+    double limitAh = GetChargeLimitAh();
+    if (!std::isnan(limitAh))
+    {
+        // Charge the cell can take before the voltage ceiling, or with a
+        // taper before full charge, as energy at the voltage the span is
+        // integrated with.
+        if (HasChargeTaper())
+        {
+            limitAh = 0.0;
+        }
+        headroomJ = std::min(headroomJ, (m_drainedAh - limitAh) * 3600.0 * v);
+    }
+    return headroomJ;
+}
+
+bool
+CompositeEnergySource::HasChargeTaper()
+{
+    // Past full charge the ceiling is never reached before the end of the
+    // charge, so there is nothing to taper.
+    return m_taperTable && !m_fleet && GetChargeLimitAh() > 0.0;
+}
+
+double
+CompositeEnergySource::GetChargeLimitAh()
+{
+    if (!(m_maxChargeVoltageV > 0.0))
+    {
+        return std::nan("");
+    }
+    // The ceiling is reached under the charge current, where the curve
+    // stands R * |i| below the supply voltage; the limit is cached on that
+    // open-circuit voltage.
+    double openCircuitV = m_maxChargeVoltageV + m_cellModel.GetResistance() *
+                                                    GetChargeCurrentA(GetSupplyVoltage());
+    if (openCircuitV != m_chargeLimitV)
+    {
+        m_chargeLimitV = openCircuitV;
+        m_chargeLimitAh = m_cellModel.GetDrainedCapacity(openCircuitV, 0.0);
+    }
+    return m_chargeLimitAh;
+}
+
+double
+CompositeEnergySource::GetChargeCurrentA(double v)
+{
+    // The full harvest power, whether or not a clamp or the taper holds it
+    // back, so that the clamp does not release as soon as it cuts the
+    // charge off.
+    double currentA = GetDeviceLoadA();
+    Ptr<const SolarIrradianceModel> profile = GetHarvestProfile();
+    if (profile && v > 0.0)
+    {
+        currentA -= GetHarvestProfileScale() * profile->GetPowerDensityWm2(Simulator::Now()) / v;
+    }
+    return currentA;
+}
+
+double
+CompositeEnergySource::GetDeviceLoadA()
+{
+    // The harvester reports its (negative) current like any other device.
+    return CalculateTotalCurrent() + m_harvester->GetHarvestCurrentA();
+}
+
 void
-CompositeEnergySource::ToggleSunlight()
+CompositeEnergySource::RemainingEnergyChanged(double /*oldValue*/, double newValue)
 {
-    NS_LOG_FUNCTION(this);
-    m_inSunlight = !m_inSunlight;
-    // We deliberately do NOT call UpdateHarvestCurrent() inline here: the
-    // periodic harvest tick (UID strictly greater than ours for same simtime)
-    // will pick up the new phase on its next firing. Calling it inline would
-    // reschedule m_harvestEvent in addition to the already-queued self-
-    // reschedule from the previous tick, producing duplicate events that
-    // compound each cycle.
-    double next = m_inSunlight ? m_sunlightSeconds : m_shadowSeconds;
-    m_toggleEvent =
-        Simulator::Schedule(Seconds(next), &CompositeEnergySource::ToggleSunlight, this);
+    m_remainingJ = newValue;
 }
 
 void
-CompositeEnergySource::UpdateHarvestCurrent()
+CompositeEnergySource::ScheduleNextHarvestUpdate(bool clamped, double netJ)
 {
-    NS_LOG_FUNCTION(this);
+    NS_LOG_FUNCTION(this << clamped << netJ);
+    Time interval = Seconds(m_harvestIntervalSeconds);
+    if (m_harvestScheduling == FIXED_INTERVAL)
+    {
+        // Even when harvestPowerW==0 we keep ticking so that a transition
+        // back into sunlight, or discharge below full, is picked up.
+        m_harvestEvent =
+            Simulator::Schedule(interval, &CompositeEnergySource::UpdateHarvestCurrent, this);
+        return;
+    }
 
-    // Clamp: when at (or above) the configured cap, stop injecting. This
-    // keeps the Li-Ion integrator from over-filling the cell in sustained
-    // sunlight. MaxEnergyJ=0 (default) means the cap equals GetInitialEnergy().
-    double cap = (m_maxEnergyJ > 0.0) ? m_maxEnergyJ : GetInitialEnergy();
-    bool full = GetRemainingEnergy() >= cap;
+    // Next breakpoint of the active mode: profiles are held until their
+    // current segment ends (for the LEO cycle, the next eclipse entry or
+    // exit); ramps are polled to keep the HarvestedPower trace current,
+    // and models that cannot describe their future are polled to notice
+    // changes at all. Adaptive polls at its step, and within a constant
+    // segment too.
+    Time now = Simulator::Now();
+    Time poll = (m_harvestScheduling == ADAPTIVE) ? Seconds(m_adaptiveStepSeconds) : interval;
+    Ptr<const SolarIrradianceModel> profile = GetHarvestProfile();
+    Time delay = Time::Max();
+    Time horizon = Time::Max();
+    if (profile)
+    {
+        SolarIrradianceSegment segment = profile->GetSegment(now);
+        if (!segment.IsKnown() || segment.end <= now)
+        {
+            horizon = now + poll;
+        }
+        else
+        {
+            horizon = segment.end;
+        }
+        if (!segment.IsKnown() || segment.end <= now)
+        {
+            delay = poll;
+        }
+        else if (segment.slopeWm2PerS != 0.0)
+        {
+            delay = Min(poll, segment.end - now);
+        }
+        else if (segment.end != Time::Max())
+        {
+            delay = segment.end - now;
+        }
+    }
+    if (m_harvestScheduling == ADAPTIVE)
+    {
+        delay = Min(delay, poll);
+    }
 
-    double harvestPowerW = 0.0;
-    if (!full)
+    // Clamp crossings, solved on the harvest profile up to its next
+    // breakpoint (after which this update is re-planned anyway) against
+    // the current device load.
+    double v = GetSupplyVoltage();
+    m_plannedLoadA = GetDeviceLoadA();
+    if (m_tapering)
+    {
+        // The taper cap follows the charge, so it is re-evaluated at least
+        // every interval, whatever the mode.
+        delay = Min(delay, interval);
+    }
+    if (clamped)
     {
-        if (m_irradianceModel)
+        // Harvesting is held at zero. Re-arm no sooner than one interval,
+        // as the fixed-interval path does, so a cell sitting on a clamp
+        // under load does not chatter faster than it would there. With no
+        // discharge nothing can release the clamp but a breakpoint.
+        if (m_plannedLoadA > 0.0)
         {
-            // Pluggable model wins over built-in modes; panel geometry and
-            // efficiency still apply as multipliers.
-            double density = m_irradianceModel->GetPowerDensityWm2(Simulator::Now());
-            harvestPowerW = density * m_panelAreaM2 * m_panelEfficiency;
+            delay = Min(delay, interval);
         }
-        else if (m_useLeoCycle)
+    }
+    else if (v > 0.0)
+    {
+        // The mirrors hold the state of the last Li-Ion update, netJ ago.
+        // Below a taper, its onset at the ceiling is the crossing to find.
+        double headroomJ = GetHeadroomJ(v);
+        if (!m_tapering && HasChargeTaper())
         {
-            if (m_inSunlight)
-            {
-                harvestPowerW = m_solarConstantWm2 * m_panelAreaM2 * m_panelEfficiency;
-            }
+            headroomJ = std::min(headroomJ, (m_drainedAh - GetChargeLimitAh()) * 3600.0 * v);
         }
-        else
+        Time crossing = m_harvester->PredictCrossing(now,
+                                                     horizon,
+                                                     headroomJ - netJ,
+                                                     m_plannedLoadA * v);
+        if (crossing != Time::Max())
         {
-            double t = Simulator::Now().GetSeconds();
-            if (t >= m_windowStart && t < m_windowEnd)
+            delay = Min(delay, PredictedDelay((crossing - now).GetSeconds(), poll));
+        }
+    }
+
+    if (delay == Time::Max())
+    {
+        NS_LOG_DEBUG("no further harvest update needed until a breakpoint or load change");
+        return;
+    }
+    m_harvestEvent =
+        Simulator::Schedule(delay, &CompositeEnergySource::UpdateHarvestCurrent, this);
+}
+
+Time
+CompositeEnergySource::PlanFastForward(double energyJ, double loadA, double harvestW)
+{
+    NS_LOG_FUNCTION(this << energyJ << loadA << harvestW);
+    Time never = Time::Max() - Simulator::Now();
+    // The base class's curve is the model's shifted by m_fastForwardOffsetV;
+    // the supply voltage drops by the resistance times the planned current,
+    // which itself depends on the voltage the harvest is injected at.
+    double q0 = m_drainedAh;
+    double offsetV = m_fastForwardOffsetV;
+    double v = TerminalVoltage(m_cellModel.GetVoltage(q0, 0.0) + offsetV,
+                               m_cellModel.GetResistance(),
+                               loadA,
+                               harvestW);
+    double netA = (v > 0.0) ? loadA - harvestW / v : 0.0;
+    if (!(netA > 0.0))
+    {
+        // Charging, or holding: the clamps are crossed at harvest updates.
+        return never;
+    }
+    double seconds = std::numeric_limits<double>::infinity();
+
+    // ThresholdVoltage: the drained capacity grows linearly.
+    double thresholdAh = m_cellModel.GetDrainedCapacity(m_thresholdVoltageV - offsetV, netA);
+    if (thresholdAh > q0)
+    {
+        seconds = (thresholdAh - q0) * 3600.0 / netA;
+    }
+
+    // Low battery: the energy after draining up to q,
+    //   E(q) = energyJ + t(q) * (harvestW - loadA * meanV(q0, q)),
+    // is convex in time (the load power falls with the voltage) and
+    // decreases until V reaches harvestW / loadA, so the threshold is
+    // bracketed there if at all.
+    double lowJ = m_lowBatteryFraction * GetInitialEnergy();
+    if (loadA > 0.0 && energyJ > lowJ)
+    {
+        auto energyAt = [&](double q) {
+            double t = (q - q0) * 3600.0 / netA;
+            double meanV = m_cellModel.GetMeanVoltage(q0, q, netA) + offsetV;
+            return energyJ + t * (harvestW - loadA * meanV);
+        };
+        double hi = m_cellModel.GetDrainedCapacity(harvestW / loadA - offsetV, netA);
+        if (hi > q0 && energyAt(hi) <= lowJ)
+        {
+            double lo = q0;
+            for (int i = 0; i < 200 && hi - lo > 1e-15 * std::max(1.0, std::abs(hi)); ++i)
             {
-                harvestPowerW = m_windowPowerW;
+                double mid = 0.5 * (lo + hi);
+                if (energyAt(mid) > lowJ)
+                {
+                    lo = mid;
+                }
+                else
+                {
+                    hi = mid;
+                }
             }
+            // hi is on the crossed side, so the update never comes early.
+            seconds = std::min(seconds, (hi - q0) * 3600.0 / netA);
         }
     }
+    return Min(PredictedDelay(seconds, never), never);
+}
+
+void
+CompositeEnergySource::CheckFastForwardPlan()
+{
+    double loadA = GetDeviceLoadA();
+    double harvestW = m_harvester->GetHarvestPowerW(Simulator::Now());
+    if (m_fastForwardStale ||
+        std::abs(loadA - m_fastForwardLoadA) > CLAMP_TOLERANCE * std::abs(m_fastForwardLoadA) ||
+        std::abs(harvestW - m_fastForwardHarvestW) >
+            CLAMP_TOLERANCE * std::abs(m_fastForwardHarvestW))
+    {
+        NS_LOG_DEBUG("re-planning the Li-Ion update: load " << loadA << " A, harvest "
+                                                             << harvestW << " W");
+        m_fastForwardStale = false;
+        UpdateEnergySource();
+    }
+}
+
+void
+CompositeEnergySource::UpdateHarvestCurrent()
+{
+    NS_LOG_FUNCTION(this);
+    HotPathTimer timer(m_hotPathProfile.get(),
+                       HotPathProfile::UPDATE_HARVEST_CURRENT,
+                       m_hotPathTrace);
+    ++m_harvestEventCount;
+
+    // No periodic Li-Ion update reconciles the estimate below in
+    // FastForward mode, so bring the cell up to date instead. This tick
+    // plans the next harvest update itself; the Li-Ion update must not.
+    if (m_harvestScheduling == FAST_FORWARD)
+    {
+        m_plannedLoadA = GetDeviceLoadA();
+        UpdateEnergySource();
+    }
 
+    // The state of the cell now, estimated from the mirrors of the last
+    // Li-Ion update plus what flowed since, rather than forced through a
+    // Li-Ion update (GetRemainingEnergy()), which would walk and notify
+    // every device model on each harvest tick. The base class integrates
+    // the span at the voltage of its last update, with the device load and
+    // the harvest (accrued here up to now, cut off at the clamps) constant
+    // in between, so this is the state its next update will reach; the
+    // mirrors are reset to its exact values there.
+    Time now = Simulator::Now();
     double v = GetSupplyVoltage();
+    double loadW = GetDeviceLoadA() * v;
+    m_harvester->Accrue(m_lastEnergyUpdate, GetHeadroomJ(v), loadW);
+    double netJ = m_harvester->GetPendingEnergy() - loadW * (now - m_lastEnergyUpdate).GetSeconds();
+
+    // Clamp: when at (or above) the configured cap, stop injecting. This
+    // keeps the Li-Ion integrator from over-filling the cell in sustained
+    // sunlight.
+    double cap = GetEnergyCap();
+    bool full = m_remainingJ + netJ >= cap * (1.0 - CLAMP_TOLERANCE);
 
     // CC-CV clamp: stop injecting once the cell voltage reaches the
-    // configured ceiling.
-    if (m_maxChargeVoltageV > 0.0 && v >= m_maxChargeVoltageV)
+    // configured ceiling. The supply voltage v is that of the last Li-Ion
+    // update, so the voltage now is estimated on the curve, at the charge
+    // the cell has reached and under the charge current.
+    double drainedAh = m_drainedAh;
+    if (netJ != 0.0 && v > 0.0)
     {
-        harvestPowerW = 0.0;
+        drainedAh -= netJ / (v * 3600.0);
     }
+    bool voltageClamped =
+        m_maxChargeVoltageV > 0.0 &&
+        m_cellModel.GetVoltage(drainedAh, GetChargeCurrentA(v)) >=
+            m_maxChargeVoltageV * (1.0 - CLAMP_TOLERANCE);
 
-    // Efficiency is a lumped loss covering MPPT / regulator / coulombic
-    // inefficiency. It attenuates the injected power, not the irradiance.
-    harvestPowerW *= m_chargeEfficiency;
+    // CV taper: past the ceiling, cap the charge current by the taper at
+    // the progress from the ceiling to full charge, which ends it.
+    double powerLimitW = std::numeric_limits<double>::infinity();
+    m_tapering = voltageClamped && drainedAh > 0.0 && HasChargeTaper();
+    if (m_tapering)
+    {
+        double progress = 1.0 - drainedAh / GetChargeLimitAh();
+        double currentA = (m_taperCurrentA > 0.0) ? m_taperCurrentA
+                                                  : m_cellModel.GetRatedCapacity();
+        powerLimitW = currentA * m_taperTable->GetCurrentFraction(progress) * v;
+        voltageClamped = false;
+    }
+
+    // The pluggable model wins over the built-in modes; panel geometry and
+    // efficiency apply as multipliers either way.
+    m_harvester->SetHarvestProfile(GetHarvestProfile(), GetHarvestProfileScale());
+    m_harvester->SetHarvestPowerLimit(powerLimitW);
+    m_harvester->SetHarvestEnabled(!full && !voltageClamped);
+    double harvestPowerW = m_harvester->GetHarvestPowerW(now);
+
+    PublishHarvestedPower(harvestPowerW, m_harvester->GetTotalHarvestedEnergy());
 
-    // TracedValue fires on every assignment; use '=' only on actual change.
-    if (harvestPowerW != m_harvestedPowerW)
+    if (m_harvestScheduling == ADAPTIVE)
     {
-        m_harvestedPowerW = harvestPowerW;
+        // The power available whether or not a clamp holds it, so that a
+        // clamp switching harvesting off and on does not read as a change.
+        double availableW = harvestPowerW;
+        Ptr<const SolarIrradianceModel> profile = GetHarvestProfile();
+        if (!m_harvester->IsHarvestEnabled() && profile)
+        {
+            availableW = GetHarvestProfileScale() * profile->GetPowerDensityWm2(now);
+        }
+        UpdateAdaptiveStep(availableW, v);
     }
 
-    double harvestCurrentA = (harvestPowerW > 0.0 && v > 0.0) ? (harvestPowerW / v) : 0.0;
-    m_harvester->SetHarvestCurrentA(harvestCurrentA);
+    NS_LOG_DEBUG("t=" << now.GetSeconds() << "s sunlight=" << (IsInSunlight() ? 1 : 0)
+                      << " P=" << harvestPowerW << "W V=" << v << "V full=" << full);
 
-    NS_LOG_DEBUG("t=" << Simulator::Now().GetSeconds()
-                      << "s sunlight=" << (m_inSunlight ? 1 : 0) << " P=" << harvestPowerW
-                      << "W V=" << v << "V I=" << harvestCurrentA << "A full=" << full);
+    ScheduleNextHarvestUpdate(full || voltageClamped, netJ);
+}
+
+void
+CompositeEnergySource::UpdateAdaptiveStep(double availableW, double v)
+{
+    NS_LOG_FUNCTION(this << availableW << v);
+    Time now = Simulator::Now();
+    double elapsed = (now - m_adaptiveLastUpdate).GetSeconds();
+    double step = m_adaptiveStepSeconds;
+    if (step <= 0.0)
+    {
+        step = m_harvestIntervalSeconds;
+    }
+    else if (elapsed > 0.0)
+    {
+        // The change over a step is first order in its length: scale the
+        // step to the tolerance, growing at most twofold per update.
+        double next = 2.0 * step;
+
+        // Harvest power: the slope of a segment the model describes, else
+        // the change seen since the previous update (a jump, such as an
+        // eclipse boundary the model did not announce, shrinks the step).
+        double powerRate = std::abs(availableW - m_adaptiveLastW) / elapsed;
+        Ptr<const SolarIrradianceModel> profile = GetHarvestProfile();
+        if (profile)
+        {
+            SolarIrradianceSegment segment = profile->GetSegment(now);
+            if (segment.IsKnown() && segment.end > now)
+            {
+                powerRate = std::abs(segment.slopeWm2PerS) * GetHarvestProfileScale();
+            }
+        }
+        double powerW = std::max(std::abs(availableW), std::abs(m_adaptiveLastW));
+        if (powerRate > 0.0)
+        {
+            next = std::min(next, m_harvestStepTolerance * powerW / powerRate);
+        }
+
+        // Supply voltage, which also sets the pace at which the cell nears
+        // MaxChargeVoltageV and MaxEnergyJ (whose crossings are predicted
+        // exactly either way).
+        double voltageRate = std::abs(v - m_adaptiveLastV) / elapsed;
+        if (voltageRate > 0.0)
+        {
+            next = std::min(next, m_harvestStepTolerance * v / voltageRate);
+        }
+        step = next;
+    }
+    m_adaptiveStepSeconds =
+        std::min(std::max(step, m_minHarvestIntervalSeconds), m_maxHarvestIntervalSeconds);
+    m_adaptiveLastUpdate = now;
+    m_adaptiveLastW = availableW;
+    m_adaptiveLastV = v;
+    NS_LOG_DEBUG("adaptive harvest step " << m_adaptiveStepSeconds << " s");
+}
+
+void
+CompositeEnergySource::PublishHarvestedPower(double powerW, double harvestedJ)
+{
+    // TracedValue fires on every assignment; use '=' only on a change
+    // outside the dead-band, or a start or stop of harvesting.
+    double reportedW = m_harvestedPowerW;
+    if (powerW != reportedW && (std::abs(powerW - reportedW) > m_harvestedPowerDeadBandW ||
+                                powerW == 0.0 || reportedW == 0.0))
+    {
+        m_harvestedPowerW = powerW;
+    }
+
+    if (!m_binWidth.IsStrictlyPositive())
+    {
+        return;
+    }
+    Time now = Simulator::Now();
+    if (!m_binOpen)
+    {
+        int64_t width = m_binWidth.GetTimeStep();
+        int64_t into = now.GetTimeStep() % width;
+        if (into < 0)
+        {
+            into += width;
+        }
+        Time start = now - TimeStep(into);
+        m_bin = HarvestedPowerBin{start, start + m_binWidth, powerW, 0.0, powerW, 0.0};
+        m_binOpen = true;
+    }
+    else
+    {
+        // The energy harvested since the last update is spread over the
+        // bins it spans in proportion to time, so the bins add up to the
+        // harvested total.
+        Time from = m_binLastUpdate;
+        double energyJ = harvestedJ - m_binLastJ;
+        while (now >= m_bin.end)
+        {
+            Time end = m_bin.end;
+            double shareJ = energyJ * (end - from).GetSeconds() / (now - from).GetSeconds();
+            m_bin.energyJ += shareJ;
+            energyJ -= shareJ;
+            from = end;
+            ReportHarvestedPowerBin(end);
+            m_bin.end = end + m_binWidth;
+        }
+        m_bin.energyJ += energyJ;
+        if (m_bin.start == now)
+        {
+            // The power held so far was not in force during this bin.
+            m_bin.minW = powerW;
+            m_bin.maxW = powerW;
+        }
+        else
+        {
+            m_bin.minW = std::min(m_bin.minW, powerW);
+            m_bin.maxW = std::max(m_bin.maxW, powerW);
+        }
+    }
+    m_binLastUpdate = now;
+    m_binLastJ = harvestedJ;
+    m_binLastW = powerW;
+}
+
+void
+CompositeEnergySource::ReportHarvestedPowerBin(Time end)
+{
+    HarvestedPowerBin bin = m_bin;
+    bin.end = end;
+    double seconds = (end - bin.start).GetSeconds();
+    bin.meanW = (seconds > 0.0) ? bin.energyJ / seconds : m_binLastW;
+    m_binTrace(bin);
 
-    // Reschedule. Even when harvestPowerW==0 we keep ticking so that a
-    // transition back into sunlight, or discharge below full, is picked up.
-    m_harvestEvent = Simulator::Schedule(Seconds(m_harvestIntervalSeconds),
-                                         &CompositeEnergySource::UpdateHarvestCurrent,
-                                         this);
+    m_bin.start = end;
+    m_bin.minW = m_binLastW;
+    m_bin.maxW = m_binLastW;
+    m_bin.energyJ = 0.0;
 }
 
 } // namespace ns3
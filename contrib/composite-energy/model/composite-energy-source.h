@@ -1,8 +1,14 @@
 #ifndef NS3_COMPOSITE_ENERGY_SOURCE_H
 #define NS3_COMPOSITE_ENERGY_SOURCE_H
 
+#include "async-solar-irradiance-model.h"
+#include "charge-taper-table.h"
+#include "hot-path-profile.h"
+#include "li-ion-cell-model.h"
+#include "lookahead-solar-irradiance-model.h"
 #include "solar-harvester-device-model.h"
 #include "solar-irradiance-model.h"
+#include "window-solar-irradiance-model.h"
 
 #include "ns3/event-id.h"
 #include "ns3/li-ion-energy-source.h"
@@ -11,6 +17,8 @@
 namespace ns3
 {
 
+class CompositeEnergyFleet;
+
 /**
  * \defgroup composite-energy Composite Energy Source
  * \brief Li-Ion battery with pluggable solar harvesting for ns-3.
@@ -42,31 +50,184 @@ namespace ns3
  * Harvesting modes
  *  - LEO cycle (UseLeoCycle=true, default): alternating
  *    SunlightSeconds / ShadowSeconds phases. Instantaneous solar input
- *    power P = SolarConstantWm2 * PanelAreaM2 * PanelEfficiency.
- *  - Fixed window (UseLeoCycle=false): constant P in [start, end)
- *    specified via AddSolarPanelWindow(P, start, end).
+ *    power P = SolarConstantWm2 * PanelAreaM2 * PanelEfficiency. The
+ *    cycle is a LeoCycleSolarIrradianceModel; no toggle event is
+ *    scheduled.
+ *  - Fixed windows (UseLeoCycle=false): constant P in [start, end)
+ *    for each window added with AddSolarPanelWindow(P, start, end) or
+ *    LoadSolarPanelWindows(). Overlapping windows add up.
+ *
+ *  - Both built-in modes are run as internal SolarIrradianceModel
+ *    profiles, so every mode goes through the same integration path.
+ *
+ * Energy accounting
+ *  - The harvester integrates the harvest power analytically over the
+ *    irradiance segments (constant and linear pieces) elapsed since the
+ *    previous Li-Ion update, and is settled just before every one of
+ *    them. The injected energy is therefore exact whatever
+ *    HarvestIntervalSeconds and PeriodicEnergyUpdateInterval are; only
+ *    models that cannot describe their future (plain callbacks) are
+ *    sampled, once per Li-Ion update.
+ *  - A harvest tick does not force a Li-Ion update: it estimates the
+ *    energy and voltage from the mirrors of the last update plus the
+ *    energy accrued since, and the next periodic update reconciles them.
  *
  * Clamping
  *  - When the remaining energy reaches InitialEnergyJ (full charge) the
  *    harvester current is driven to zero. This avoids unphysical
- *    over-filling of the cell in either harvesting mode.
+ *    over-filling of the cell in either harvesting mode. The instant at
+ *    which the energy (MaxEnergyJ) or voltage (MaxChargeVoltageV) clamp
+ *    is reached within an update span is solved in closed form, so
+ *    harvesting stops exactly there rather than at the next update.
+ *  - With ChargeTaper set to a chemistry, MaxChargeVoltageV starts the
+ *    constant-voltage phase instead of stopping the charge: from there
+ *    the harvested current is capped by the chemistry's taper
+ *    (ChargeTaperTable), scaled to TaperCurrentA and read at the progress
+ *    of the charge from the ceiling to full, and harvesting stops at full
+ *    charge. The cap is re-evaluated at every harvest update, at least
+ *    every HarvestIntervalSeconds while the taper lasts. Fleet members
+ *    keep the hard clamp.
+ *
+ * Scheduling
+ *  - FixedInterval (default): the harvest current is recomputed every
+ *    HarvestIntervalSeconds, whatever the mode.
+ *  - EventDriven: the source asks the active mode for its next
+ *    breakpoint (eclipse entry or exit, window start/end, end of the irradiance
+ *    model's current SolarIrradianceSegment) and predicts when the
+ *    MaxEnergyJ and MaxChargeVoltageV clamps will be crossed from the
+ *    net cell current, then schedules exactly one update for the
+ *    earliest of those instants. Irradiance ramps (for the
+ *    HarvestedPower trace) and models that cannot describe their future
+ *    fall back to polling at HarvestIntervalSeconds.
+ *  - FastForward: as EventDriven, and the Li-Ion state is only updated
+ *    at those harvest updates, at device current changes and at the
+ *    predicted instants the discharge crosses the low-battery energy or
+ *    ThresholdVoltage, instead of every PeriodicEnergyUpdateInterval
+ *    (which it overrides). Both crossings are solved on the closed-form
+ *    integral of the Shepherd curve (LiIonCellModel::GetMeanVoltage()),
+ *    and the load energy of each span is taken at the mean voltage of
+ *    the span rather than at the voltage of its start, so a long idle
+ *    period costs one update and loses no accuracy. Ignored by fleet
+ *    members.
+ *  - Adaptive: the harvest current is recomputed periodically, as in
+ *    FixedInterval, but at a step that grows (at most twofold per update)
+ *    while the available harvest power and the supply voltage change by
+ *    less than HarvestStepTolerance of their value per step, and shrinks
+ *    when they change faster, between MinHarvestIntervalSeconds and
+ *    MaxHarvestIntervalSeconds. Updates still land on the breakpoints and
+ *    predicted clamp crossings found as in EventDriven, and re-arm after
+ *    HarvestIntervalSeconds on a clamp under load, so a long steady
+ *    sunlight or eclipse costs a few updates instead of one per interval.
+ *  - With IrradianceLookahead > 0 under FixedInterval, a model that must
+ *    be polled is read through a LookaheadSolarIrradianceModel, which
+ *    fetches that many samples at HarvestIntervalSeconds spacing per
+ *    block, so the model can amortize its setup over the block. With
+ *    IrradianceWorkers > 0 an AsyncSolarIrradianceModel computes those
+ *    blocks ahead on that many background threads instead. Harvesting is
+ *    unchanged. The other modes leave that grid and poll the model
+ *    directly.
+ *
+ * Fleets
+ *  - A source added to a CompositeEnergyFleet hands its harvesting over
+ *    to the fleet's batch tick and schedules no harvest events of its own.
+ *
+ * Checkpoints
+ *  - GetEnergyState() and SetEnergyState() save and restore the remaining
+ *    and harvested energy and the position in the LEO cycle, so a run can
+ *    start from the state another run reached (see EnergyCheckpoint).
+ *
+ * Tracing
+ *  - HarvestedPower follows the injected power, or with
+ *    HarvestedPowerDeadBandW > 0 only changes larger than that (and
+ *    every start and stop of harvesting), so noisy irradiance does not
+ *    fire it on every update.
+ *  - With HarvestedPowerBin > 0, "HarvestedPowerBinned" reports the
+ *    minimum, mean and maximum harvested power and the harvested energy
+ *    of every bin of that length, aligned to multiples of it. No event
+ *    is scheduled at the bin ends: a bin is reported at the first
+ *    harvest update after it ends, late but complete.
+ *
+ * Profiling
+ *  - With EnableProfiling=true the source and its harvester count the
+ *    calls of their hot paths and their cumulative wall time into
+ *    profiles held by HotPathProfileRegistry, and fire the "HotPath"
+ *    trace source after each of them.
  */
 class CompositeEnergySource : public LiIonEnergySource
 {
   public:
+    /** How UpdateHarvestCurrent() reschedules itself. */
+    enum HarvestSchedulingMode
+    {
+        FIXED_INTERVAL, //!< Recompute every HarvestIntervalSeconds
+        EVENT_DRIVEN,   //!< Recompute only at breakpoints and clamp crossings
+        FAST_FORWARD,   //!< As EVENT_DRIVEN, and update the cell only at state changes
+        ADAPTIVE,       //!< Recompute at a step that follows the rate of change
+    };
+
+    /** What happens to the charge once MaxChargeVoltageV is reached. */
+    enum ChargeTaperMode
+    {
+        HARD_CLAMP, //!< Stop harvesting
+        TAPER_NMC,  //!< Constant-voltage taper of an NMC cell
+        TAPER_LFP,  //!< Constant-voltage taper of an LFP cell
+        TAPER_LCO,  //!< Constant-voltage taper of an LCO cell
+    };
+
+    /** Harvest statistics of one bin, reported by "HarvestedPowerBinned". */
+    struct HarvestedPowerBin
+    {
+        Time start;     //!< Start of the bin
+        Time end;       //!< End of the bin
+        double minW;    //!< Lowest harvested power in force during the bin (W)
+        double meanW;   //!< Harvested energy over the bin length (W)
+        double maxW;    //!< Highest harvested power in force during the bin (W)
+        double energyJ; //!< Energy harvested during the bin (J)
+    };
+
+    /**
+     * TracedCallback signature of "HarvestedPowerBinned".
+     *
+     * \param bin The bin just closed.
+     */
+    typedef void (*HarvestedPowerBinTracedCallback)(const HarvestedPowerBin& bin);
+
+    /** State a source carries from one run to another (see EnergyCheckpoint). */
+    struct EnergyState
+    {
+        double remainingJ;  //!< Remaining energy (J)
+        double harvestedJ;  //!< Energy harvested so far (J)
+        Time cyclePosition; //!< Time since the start of the LEO cycle's sunlight phase
+    };
+
     static TypeId GetTypeId();
 
     CompositeEnergySource();
     ~CompositeEnergySource() override;
 
     /**
-     * \brief Configure a fixed harvesting window.
+     * \brief Add a fixed harvesting window.
      *
      * Only effective when UseLeoCycle=false. The source injects energy at
-     * constant power \p powerJoulePerSecond (W) during [startTime, endTime).
+     * constant power \p powerJoulePerSecond (W) during [startTime, endTime),
+     * on top of any other window open at the same time. A window added
+     * while the simulation runs takes effect at once in every
+     * HarvestScheduling mode and in a CompositeEnergyFleet.
      */
     void AddSolarPanelWindow(double powerJoulePerSecond, double startTime, double endTime);
 
+    /**
+     * \brief Add the harvesting windows listed in a file.
+     *
+     * Same as calling AddSolarPanelWindow() for every "power, start, end"
+     * line; see WindowSolarIrradianceModel::LoadWindows() for the format.
+     *
+     * \param fileName Path of the mission plan.
+     * \param timeScale Seconds per time unit of the file.
+     * \return Number of windows read.
+     */
+    uint64_t LoadSolarPanelWindows(const std::string& fileName, double timeScale = 1.0);
+
     /**
      * \brief Configure the LEO solar harvester from panel geometry.
      *
@@ -84,18 +245,182 @@ class CompositeEnergySource : public LiIonEnergySource
      *           using a fixed window (no phase concept). */
     bool IsInSunlight() const;
 
+    /** \return Number of times the harvest current has been recomputed
+     *          since initialization. */
+    uint64_t GetHarvestEventCount() const;
+
+    /**
+     * \brief Report the bin in progress, up to now.
+     *
+     * A bin is reported at the first harvest update at or after its end,
+     * which in EventDriven or FastForward mode may come long after it;
+     * call this at the end of a run for the last, partial one. The
+     * harvest is accrued up to now first. The rest of the bin is reported
+     * when it ends. No-op without HarvestedPowerBin.
+     */
+    void FlushHarvestedPowerBin();
+
+    /**
+     * Settles the energy harvested since the previous update, mirrors the
+     * drained-capacity integral, runs the Li-Ion update and, in
+     * EventDriven and FastForward modes, re-plans the next harvest update
+     * when the device load has changed since it was last planned. In
+     * FastForward mode it also corrects the load energy of the span to
+     * the span's mean voltage and schedules the next Li-Ion update at the
+     * next predicted crossing.
+     */
+    void UpdateEnergySource() override;
+
+    /** Forces a Li-Ion update (see UpdateEnergySource()). */
+    double GetRemainingEnergy() override;
+
+    /**
+     * \brief Energy state now, after a Li-Ion update.
+     *
+     * The cycle position is zero when the source has no LEO cycle.
+     */
+    EnergyState GetEnergyState();
+
+    /**
+     * \brief Start from \p state rather than from InitialEnergyJ.
+     *
+     * Must be called before the source is initialized. At initialization
+     * the remaining energy is set to \p state.remainingJ, the harvested
+     * total to \p state.harvestedJ, and the LEO cycle resumes at
+     * \p state.cyclePosition instead of at the start of a sunlight phase.
+     * InitialEnergyJ keeps its meaning (the energy cap when MaxEnergyJ is
+     * 0). The drained capacity behind the Li-Ion base class's Shepherd
+     * voltage is private to it, so the supply voltage starts from
+     * InitialCellVoltage as for a new cell.
+     */
+    void SetEnergyState(const EnergyState& state);
+
+    /** \return The hot-path profile of this source, or null when
+     *          EnableProfiling is false. */
+    const HotPathProfile* GetProfile() const;
+
+    /** \return The internal harvester device model. */
+    Ptr<const SolarHarvesterDeviceModel> GetHarvester() const;
+
   protected:
     void DoInitialize() override;
     void DoDispose() override;
 
   private:
-    /** Recompute the harvest current from current mode/phase and apply it
-     *  to the internal harvester device model. Reschedules itself every
-     *  HarvestIntervalSeconds. */
+    friend class CompositeEnergyFleet;
+
+    /**
+     * Relative tolerance under which a clamp counts as reached. An exact
+     * crossing lands on the clamp only to within rounding of the Li-Ion
+     * integrator.
+     */
+    static constexpr double CLAMP_TOLERANCE = 1e-9;
+
+    /** Re-evaluate the clamps, hand the active profile to the internal
+     *  harvester device model and schedule the next evaluation. */
     void UpdateHarvestCurrent();
 
-    /** Flip the LEO sunlight/shadow phase and reschedule the next toggle. */
-    void ToggleSunlight();
+    /** Replan the harvest update of a running source whose windows
+     *  changed. */
+    void WindowsChanged();
+
+    /**
+     * Schedule the next UpdateHarvestCurrent() according to the
+     * HarvestScheduling mode.
+     *
+     * \param clamped Whether the current update drove harvesting to zero
+     *        because a clamp was reached.
+     * \param netJ Energy the cell gained since the last Li-Ion update.
+     */
+    void ScheduleNextHarvestUpdate(bool clamped, double netJ);
+
+    /** \return Whether the charge tapers past MaxChargeVoltageV. */
+    bool HasChargeTaper();
+
+    /**
+     * Set the step of the next Adaptive update from the rate at which the
+     * available harvest power \p availableW (clamped or not) and the supply
+     * voltage \p v changed since the previous one.
+     */
+    void UpdateAdaptiveStep(double availableW, double v);
+
+    /**
+     * \brief Delay to the next instant the cell must be updated in
+     *        FastForward mode.
+     *
+     * Over the next span the base class drains the cell at a constant
+     * current, the load less the harvest at the supply voltage that
+     * current holds the cell at; returns the time until that drain takes
+     * the supply voltage to ThresholdVoltage or the energy to the
+     * low-battery threshold, whichever comes first.
+     *
+     * \param energyJ Remaining energy after this update (J).
+     * \param loadA Device load from now on (A).
+     * \param harvestW Harvested power from now on (W).
+     * \return The delay, or one reaching Time::Max() if neither is crossed.
+     */
+    Time PlanFastForward(double energyJ, double loadA, double harvestW);
+
+    /**
+     * Re-plan the FastForward span with a Li-Ion update if the load or the
+     * harvest changed since it was planned, or if the last update found
+     * the cell off the curve it was planned on. Devices update the source
+     * before they switch their current, and a harvest update may start or
+     * stop harvesting after its own Li-Ion update, so this runs just after
+     * every update.
+     */
+    void CheckFastForwardPlan();
+
+    /**
+     * Publish the harvested power \p powerW in force from now on, and the
+     * energy \p harvestedJ harvested up to now: updates the HarvestedPower
+     * trace outside the dead-band and the bins.
+     */
+    void PublishHarvestedPower(double powerW, double harvestedJ);
+
+    /**
+     * Report the bin in progress as ending at \p end, and start the next
+     * one there with the power held since the last update.
+     */
+    void ReportHarvestedPowerBin(Time end);
+
+    /** \return Irradiance profile driving the harvester: the user's
+     *          IrradianceModel (through its lookahead buffer, if any),
+     *          else the built-in LEO or window profile. */
+    Ptr<const SolarIrradianceModel> GetHarvestProfile() const;
+
+    /** \return Factor turning the profile's W/m^2 into injected W. */
+    double GetHarvestProfileScale() const;
+
+    /** \return Energy cap in force (J). */
+    double GetEnergyCap() const;
+
+    /**
+     * \return Energy the cell can still take before the MaxEnergyJ or
+     *         MaxChargeVoltageV clamp is reached (J), from the state of the
+     *         previous Li-Ion update and the supply voltage \p v.
+     */
+    double GetHeadroomJ(double v);
+
+    /** \return Drained capacity (Ah) at which the cell reaches
+     *          MaxChargeVoltageV under the present charge current
+     *          (GetChargeCurrentA()), or NaN if the clamp is off or
+     *          unreachable. */
+    double GetChargeLimitAh();
+
+    /**
+     * \return Current drawn from the cell in the constant-current phase of
+     *         the charge (A, negative while charging): the device load less
+     *         the harvest power available now at the supply voltage \p v.
+     */
+    double GetChargeCurrentA(double v);
+
+    /** \return Current drawn by the attached devices other than the
+     *          harvester (A). */
+    double GetDeviceLoadA();
+
+    /** Mirror of the base class's RemainingEnergy trace. */
+    void RemainingEnergyChanged(double oldValue, double newValue);
 
     // Harvesting device model driven by this source (reports negative
     // current to the Li-Ion integrator).
@@ -107,10 +432,18 @@ class CompositeEnergySource : public LiIonEnergySource
     // continue to be applied as multipliers in both paths.
     Ptr<SolarIrradianceModel> m_irradianceModel;
 
-    // Fixed-window parameters
-    double m_windowPowerW;
-    double m_windowStart;
-    double m_windowEnd;
+    // Block prefetch of a polled IrradianceModel (IrradianceLookahead
+    // samples per block; 0 => off), on IrradianceWorkers background
+    // threads if non-zero. Bypassed once the model is replaced.
+    uint32_t m_irradianceLookahead;
+    uint32_t m_irradianceWorkers;
+    Ptr<SolarIrradianceModel> m_lookaheadProfile;
+    Ptr<const SolarIrradianceModel> m_lookaheadModel; // model it wraps
+
+    // Built-in modes as irradiance profiles: the LEO cycle in W/m^2, the
+    // windows directly in W (null until the first window is added).
+    Ptr<LeoCycleSolarIrradianceModel> m_leoProfile;
+    Ptr<WindowSolarIrradianceModel> m_windowProfile;
 
     // LEO / harvester attributes
     bool m_useLeoCycle;
@@ -123,14 +456,83 @@ class CompositeEnergySource : public LiIonEnergySource
     double m_maxEnergyJ;         // 0 => use GetInitialEnergy() as the cap
     double m_maxChargeVoltageV;  // 0 => disabled; else stop harvest when V >= this
     double m_chargeEfficiency;   // in [0,1], applied to harvested power
-    bool m_inSunlight;
 
-    // Instantaneous harvested power in W, after efficiency and CC-CV clamp.
-    // Exposed as the "HarvestedPower" trace source.
+    // The remaining energy and the drained-capacity integral of the Li-Ion
+    // base class are mirrored, so that the clamp headroom is known inside
+    // UpdateEnergySource() (where GetRemainingEnergy() would recurse) and
+    // MaxChargeVoltageV can be located through m_cellModel.
+    LiIonCellModel m_cellModel;
+    double m_remainingJ;
+    double m_drainedAh;
+    Time m_lastEnergyUpdate;
+    double m_chargeLimitV;  // open-circuit voltage m_chargeLimitAh was found for
+    double m_chargeLimitAh; // drained capacity at m_chargeLimitV
+
+    // CC-CV taper: the table of the ChargeTaper chemistry (null for a hard
+    // clamp), set at initialization, and whether the charge is in it
+    ChargeTaperMode m_chargeTaper;
+    double m_taperCurrentA; // 0 => 1C of the rated capacity
+    const ChargeTaperTable* m_taperTable;
+    bool m_tapering;
+
+    // Scheduling state
+    HarvestSchedulingMode m_harvestScheduling;
+    uint64_t m_harvestEventCount;
+    double m_plannedLoadA; // device load the pending update was planned for
+
+    // FastForward: the base class's thresholds, read at initialization,
+    // and the load and harvest the pending Li-Ion update was planned for
+    double m_lowBatteryFraction; // LiIonEnergyLowBatteryThreshold
+    double m_thresholdVoltageV;  // ThresholdVoltage
+    double m_fastForwardLoadA;
+    double m_fastForwardHarvestW;
+    double m_fastForwardOffsetV; // base class's voltage less the model's
+    bool m_fastForwardStale;     // the last jump landed off the plan
+    EventId m_fastForwardCheck;
+
+    // Adaptive: the step controller's bounds, tolerance and state
+    double m_minHarvestIntervalSeconds;
+    double m_maxHarvestIntervalSeconds;
+    double m_harvestStepTolerance;
+    double m_adaptiveStepSeconds; // 0 before the first update
+    Time m_adaptiveLastUpdate;
+    double m_adaptiveLastW;
+    double m_adaptiveLastV;
+
+    // Instantaneous harvested power in W, after efficiency and CC-CV clamp,
+    // as last reported outside HarvestedPowerDeadBandW. Exposed as the
+    // "HarvestedPower" trace source.
     TracedValue<double> m_harvestedPowerW;
+    double m_harvestedPowerDeadBandW;
+
+    // "HarvestedPowerBinned": the bin in progress (its end is the grid
+    // end, even after a flush) and the last update it has seen
+    Time m_binWidth; // 0 => off
+    bool m_binOpen;
+    HarvestedPowerBin m_bin;
+    Time m_binLastUpdate;
+    double m_binLastJ; // harvested energy at m_binLastUpdate
+    double m_binLastW; // power in force since m_binLastUpdate
+    TracedCallback<const HarvestedPowerBin&> m_binTrace;
 
     EventId m_harvestEvent;
-    EventId m_toggleEvent;
+
+    // Restored state, applied at initialization, and the instant the LEO
+    // cycle's sunlight phase started from there on
+    bool m_hasEnergyState;
+    EnergyState m_energyState;
+    Time m_cycleOrigin;
+
+    // Fleet this source belongs to, if any, and its index there. The fleet
+    // holds its members too; see CompositeEnergyFleet for how the cycle is
+    // broken.
+    Ptr<CompositeEnergyFleet> m_fleet;
+    uint32_t m_fleetIndex;
+
+    // Opt-in profiling, and the "HotPath" trace source
+    bool m_enableProfiling;
+    std::shared_ptr<HotPathProfile> m_hotPathProfile;
+    TracedCallback<HotPathProfile::Path, Time> m_hotPathTrace;
 };
 
 } // namespace ns3
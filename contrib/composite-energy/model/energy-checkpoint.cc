@@ -0,0 +1,189 @@
+#include "energy-checkpoint.h"
+
+#include "ns3/abort.h"
+#include "ns3/energy-source-container.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("EnergyCheckpoint");
+
+namespace
+{
+
+const char ENERGY_CHECKPOINT_MAGIC[8] = {'N', 'S', '3', 'E', 'N', 'C', 'K', '\0'};
+const uint32_t ENERGY_CHECKPOINT_VERSION = 1;
+
+static_assert(sizeof(EnergyCheckpointHeader) == 64, "checkpoint header must be 64 bytes");
+static_assert(sizeof(EnergyCheckpointRecord) == 40, "checkpoint record must be 40 bytes");
+
+} // namespace
+
+// -------------------------------------------------------------------------
+// EnergyCheckpointHeader
+// -------------------------------------------------------------------------
+
+bool
+EnergyCheckpointHeader::IsValid() const
+{
+    return std::memcmp(magic, ENERGY_CHECKPOINT_MAGIC, sizeof(magic)) == 0 &&
+           version == ENERGY_CHECKPOINT_VERSION;
+}
+
+// -------------------------------------------------------------------------
+// EnergyCheckpoint
+// -------------------------------------------------------------------------
+
+EnergyCheckpoint::EnergyCheckpoint()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+EnergyCheckpoint::Add(Ptr<LiIonEnergySource> source)
+{
+    NS_ABORT_MSG_IF(!source, "EnergyCheckpoint: null source");
+    Ptr<Node> node = source->GetNode();
+    return AddSource(source, node ? node->GetId() : std::numeric_limits<uint32_t>::max());
+}
+
+void
+EnergyCheckpoint::Add(NodeContainer nodes)
+{
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<Node> node = nodes.Get(i);
+        Ptr<EnergySourceContainer> container = node->GetObject<EnergySourceContainer>();
+        if (!container)
+        {
+            continue;
+        }
+        for (auto it = container->Begin(); it != container->End(); ++it)
+        {
+            Ptr<LiIonEnergySource> source = DynamicCast<LiIonEnergySource>(*it);
+            if (source)
+            {
+                AddSource(source, node->GetId());
+            }
+        }
+    }
+}
+
+uint32_t
+EnergyCheckpoint::AddSource(Ptr<LiIonEnergySource> source, uint32_t nodeId)
+{
+    NS_LOG_FUNCTION(this << source << nodeId);
+    auto i = static_cast<uint32_t>(m_sources.size());
+    m_sources.push_back(source);
+    m_composites.push_back(DynamicCast<CompositeEnergySource>(source));
+    m_nodeIds.push_back(nodeId);
+    return i;
+}
+
+uint32_t
+EnergyCheckpoint::GetN() const
+{
+    return static_cast<uint32_t>(m_sources.size());
+}
+
+void
+EnergyCheckpoint::Save(const std::string& path) const
+{
+    NS_LOG_FUNCTION(this << path);
+    EnergyCheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, ENERGY_CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = ENERGY_CHECKPOINT_VERSION;
+    header.sources = GetN();
+    header.time = Simulator::Now().GetNanoSeconds();
+
+    std::vector<EnergyCheckpointRecord> records(m_sources.size());
+    for (std::size_t s = 0; s < m_sources.size(); ++s)
+    {
+        EnergyCheckpointRecord& record = records[s];
+        std::memset(&record, 0, sizeof(record));
+        record.nodeId = m_nodeIds[s];
+        if (m_composites[s])
+        {
+            CompositeEnergySource::EnergyState state = m_composites[s]->GetEnergyState();
+            record.flags = EnergyCheckpointRecord::COMPOSITE;
+            record.remainingJ = state.remainingJ;
+            record.harvestedJ = state.harvestedJ;
+            record.cyclePosition = state.cyclePosition.GetNanoSeconds();
+        }
+        else
+        {
+            record.remainingJ = m_sources[s]->GetRemainingEnergy();
+        }
+        // After the remaining energy, which brings the source up to date
+        record.voltageV = m_sources[s]->GetSupplyVoltage();
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_IF(!out, "Cannot create energy checkpoint " << path);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()),
+              records.size() * sizeof(EnergyCheckpointRecord));
+    NS_ABORT_MSG_IF(!out, "Cannot write energy checkpoint " << path);
+    NS_LOG_DEBUG(path << ": " << header.sources << " sources at " << Simulator::Now());
+}
+
+Time
+EnergyCheckpoint::Restore(const std::string& path) const
+{
+    NS_LOG_FUNCTION(this << path);
+    std::ifstream in(path, std::ios::binary);
+    NS_ABORT_MSG_IF(!in, "Cannot open energy checkpoint " << path);
+    EnergyCheckpointHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    NS_ABORT_MSG_IF(!in || !header.IsValid(),
+                    path << " is not an energy checkpoint (version 1)");
+    NS_ABORT_MSG_IF(header.sources != GetN(),
+                    "Energy checkpoint " << path << " holds " << header.sources
+                                         << " sources, " << GetN() << " were added");
+    std::vector<EnergyCheckpointRecord> records(header.sources);
+    in.read(reinterpret_cast<char*>(records.data()),
+            records.size() * sizeof(EnergyCheckpointRecord));
+    NS_ABORT_MSG_IF(!in, "Energy checkpoint " << path << " is truncated");
+
+    for (std::size_t s = 0; s < m_sources.size(); ++s)
+    {
+        const EnergyCheckpointRecord& record = records[s];
+        bool composite = (record.flags & EnergyCheckpointRecord::COMPOSITE) != 0;
+        NS_ABORT_MSG_IF(record.nodeId != m_nodeIds[s],
+                        "Energy checkpoint " << path << ": source " << s << " belongs to node "
+                                             << record.nodeId << ", not " << m_nodeIds[s]);
+        NS_ABORT_MSG_IF(composite != bool(m_composites[s]),
+                        "Energy checkpoint " << path << ": source " << s
+                                             << " is not of the kind saved");
+        if (composite)
+        {
+            m_composites[s]->SetEnergyState(CompositeEnergySource::EnergyState{
+                record.remainingJ,
+                record.harvestedJ,
+                NanoSeconds(record.cyclePosition)});
+            continue;
+        }
+        double deltaJ = record.remainingJ - m_sources[s]->GetRemainingEnergy();
+        if (deltaJ > 0.0)
+        {
+            m_sources[s]->IncreaseRemainingEnergy(deltaJ);
+        }
+        else if (deltaJ < 0.0)
+        {
+            m_sources[s]->DecreaseRemainingEnergy(-deltaJ);
+        }
+    }
+    NS_LOG_DEBUG(path << ": " << header.sources << " sources saved at "
+                      << NanoSeconds(header.time));
+    return NanoSeconds(header.time);
+}
+
+} // namespace ns3
@@ -0,0 +1,125 @@
+#ifndef NS3_ENERGY_CHECKPOINT_H
+#define NS3_ENERGY_CHECKPOINT_H
+
+#include "composite-energy-source.h"
+
+#include "ns3/li-ion-energy-source.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief On-disk layout of a binary energy checkpoint.
+ *
+ * A checkpoint holds the state of \c sources energy sources at one
+ * instant, in the host byte order:
+ *
+ *   header   EnergyCheckpointHeader (64 bytes)
+ *   records  EnergyCheckpointRecord[sources] (40 bytes each)
+ */
+struct EnergyCheckpointHeader
+{
+    char magic[8];      //!< "NS3ENCK" followed by a NUL
+    uint32_t version;   //!< Format version, currently 1
+    uint32_t sources;   //!< Number of records
+    int64_t time;       //!< Simulation time of the snapshot (ns)
+    uint8_t unused[40]; //!< Zero
+
+    /** \return true if the magic and version are those of this format. */
+    bool IsValid() const;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief State of one energy source in a checkpoint.
+ */
+struct EnergyCheckpointRecord
+{
+    /** Bits of \c flags. */
+    enum Flags
+    {
+        COMPOSITE = 1, //!< The source is a CompositeEnergySource
+    };
+
+    uint32_t nodeId;       //!< Node id, UINT32_MAX if the source had no node
+    uint32_t flags;        //!< Flags values
+    double remainingJ;     //!< Remaining energy (J)
+    double voltageV;       //!< Supply voltage (V); informational, not restored
+    double harvestedJ;     //!< Energy harvested so far (J), 0 for a plain Li-Ion source
+    int64_t cyclePosition; //!< Position in the LEO cycle (ns), 0 without one
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Saves the energy state of many sources to a binary checkpoint
+ *        and restores it into a new run.
+ *
+ * A parameter sweep whose runs share a burn-in can simulate it once,
+ * Save() the state at its end, and start every run from there with
+ * Restore() at t0 instead of paying the burn-in again. Sources are
+ * added in the same order in both runs (Add(NodeContainer) walks each
+ * node's EnergySourceContainer in order) and are matched by position;
+ * Restore() aborts if the count, a node id or the kind of a source
+ * differs.
+ *
+ * A CompositeEnergySource carries over its remaining and harvested energy
+ * and its position in the LEO cycle (CompositeEnergySource::SetEnergyState),
+ * and must be restored before it is initialized. A plain LiIonEnergySource
+ * carries over its remaining energy. The Li-Ion base class keeps the
+ * drained capacity behind its voltage to itself, so in both cases the
+ * supply voltage starts from the cell's initial voltage; the saved
+ * voltage is for reference only.
+ */
+class EnergyCheckpoint
+{
+  public:
+    EnergyCheckpoint();
+
+    /**
+     * \brief Add a source; its node id is that of its node, if set.
+     *
+     * \return Position of the source in the checkpoint.
+     */
+    uint32_t Add(Ptr<LiIonEnergySource> source);
+
+    /** Add every LiIonEnergySource in the EnergySourceContainer of \p nodes. */
+    void Add(NodeContainer nodes);
+
+    /** \return Number of sources. */
+    uint32_t GetN() const;
+
+    /**
+     * \brief Write the state of every source now to \p path, replacing it.
+     *
+     * Call it from a scheduled event: once the simulator has stopped, the
+     * Li-Ion base class no longer brings a source up to date.
+     */
+    void Save(const std::string& path) const;
+
+    /**
+     * \brief Restore the state saved in \p path into the sources.
+     *
+     * \return Simulation time at which the checkpoint was saved.
+     */
+    Time Restore(const std::string& path) const;
+
+  private:
+    /** Add \p source as node \p nodeId. */
+    uint32_t AddSource(Ptr<LiIonEnergySource> source, uint32_t nodeId);
+
+    std::vector<Ptr<LiIonEnergySource>> m_sources;
+    std::vector<Ptr<CompositeEnergySource>> m_composites; // null for plain Li-Ion
+    std::vector<uint32_t> m_nodeIds;
+};
+
+} // namespace ns3
+
+#endif // NS3_ENERGY_CHECKPOINT_H
@@ -0,0 +1,676 @@
+#include "energy-telemetry.h"
+
+#include "ns3/abort.h"
+#include "ns3/energy-source-container.h"
+#include "ns3/enum.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("EnergyTelemetry");
+
+NS_OBJECT_ENSURE_REGISTERED(EnergyTelemetryCollector);
+
+namespace
+{
+
+const char ENERGY_TELEMETRY_MAGIC[8] = {'N', 'S', '3', 'E', 'N', 'T', 'L', '\0'};
+const uint32_t ENERGY_TELEMETRY_VERSION = 1;
+
+static_assert(sizeof(EnergyTelemetryHeader) == 64, "telemetry header must be 64 bytes");
+
+/** \return Bytes of the sunlight bitmap of one source in a block of \p rows. */
+std::size_t
+BitmapBytes(std::size_t rows)
+{
+    return (rows + 7) / 8;
+}
+
+void
+PutBytes(std::vector<uint8_t>& out, const void* data, std::size_t n)
+{
+    const auto* p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + n);
+}
+
+void
+PutVarint(std::vector<uint8_t>& out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+/**
+ * Append \p x as a control byte (leading zero bytes in the high nibble,
+ * trailing zero bytes in the low one) and the bytes in between, least
+ * significant first.
+ */
+void
+PutXor(std::vector<uint8_t>& out, uint64_t x)
+{
+    uint32_t lead = 0;
+    while (lead < 8 && ((x >> (56 - 8 * lead)) & 0xff) == 0)
+    {
+        ++lead;
+    }
+    uint32_t trail = 0;
+    while (lead + trail < 8 && ((x >> (8 * trail)) & 0xff) == 0)
+    {
+        ++trail;
+    }
+    out.push_back(static_cast<uint8_t>(lead << 4 | trail));
+    for (uint32_t b = trail; b < 8 - lead; ++b)
+    {
+        out.push_back(static_cast<uint8_t>(x >> (8 * b)));
+    }
+}
+
+bool
+GetBytes(const uint8_t*& p, const uint8_t* end, void* data, std::size_t n)
+{
+    if (static_cast<std::size_t>(end - p) < n)
+    {
+        return false;
+    }
+    std::memcpy(data, p, n);
+    p += n;
+    return true;
+}
+
+bool
+GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+{
+    v = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7)
+    {
+        if (p == end)
+        {
+            return false;
+        }
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+GetXor(const uint8_t*& p, const uint8_t* end, uint64_t& x)
+{
+    if (p == end)
+    {
+        return false;
+    }
+    uint32_t lead = *p >> 4;
+    uint32_t trail = *p & 0x0f;
+    ++p;
+    if (lead + trail > 8 || static_cast<uint32_t>(end - p) < 8 - lead - trail)
+    {
+        return false;
+    }
+    x = 0;
+    for (uint32_t b = trail; b < 8 - lead; ++b)
+    {
+        x |= static_cast<uint64_t>(*p++) << (8 * b);
+    }
+    return true;
+}
+
+/** Append \p n values of one column to \p out. */
+void
+EncodeColumn(std::vector<uint8_t>& out,
+             const double* values,
+             std::size_t n,
+             EnergyTelemetryHeader::Compression compression)
+{
+    if (compression == EnergyTelemetryHeader::NONE)
+    {
+        PutBytes(out, values, n * sizeof(double));
+        return;
+    }
+    uint64_t previous = 0;
+    for (std::size_t r = 0; r < n; ++r)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &values[r], sizeof(bits));
+        PutXor(out, bits ^ previous);
+        previous = bits;
+    }
+}
+
+/** Decode \p n values of one column; false if the data is truncated. */
+bool
+DecodeColumn(const uint8_t*& p,
+             const uint8_t* end,
+             double* values,
+             std::size_t n,
+             EnergyTelemetryHeader::Compression compression)
+{
+    if (compression == EnergyTelemetryHeader::NONE)
+    {
+        return GetBytes(p, end, values, n * sizeof(double));
+    }
+    uint64_t bits = 0;
+    for (std::size_t r = 0; r < n; ++r)
+    {
+        uint64_t x;
+        if (!GetXor(p, end, x))
+        {
+            return false;
+        }
+        bits ^= x;
+        std::memcpy(&values[r], &bits, sizeof(bits));
+    }
+    return true;
+}
+
+/**
+ * Abort unless \p header describes a well-formed telemetry file of
+ * \p fileSize bytes: right magic, version and compression, a block count
+ * matching the rows, and an index that ends the file.
+ */
+void
+CheckHeader(const EnergyTelemetryHeader& header, uint64_t fileSize, const std::string& path)
+{
+    NS_ABORT_MSG_IF(!header.IsValid(), path << " is not an energy telemetry file (version 1)");
+    NS_ABORT_MSG_IF(header.compression > EnergyTelemetryHeader::XOR_DELTA,
+                    "Energy telemetry " << path << " has an unknown compression");
+    NS_ABORT_MSG_IF(header.blockRows == 0 && header.rows > 0,
+                    "Energy telemetry " << path << " has a zero block size");
+    uint64_t blocks = (header.rows == 0) ? 0 : (header.rows - 1) / header.blockRows + 1;
+    uint64_t dataOffset =
+        sizeof(EnergyTelemetryHeader) + static_cast<uint64_t>(header.sources) * sizeof(uint32_t);
+    NS_ABORT_MSG_IF(header.blockCount != blocks || header.indexOffset < dataOffset ||
+                        header.indexOffset + header.blockCount * 2 * sizeof(uint64_t) !=
+                            fileSize,
+                    "Energy telemetry " << path << " is truncated or inconsistent");
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------
+// EnergyTelemetryHeader
+// -------------------------------------------------------------------------
+
+bool
+EnergyTelemetryHeader::IsValid() const
+{
+    return std::memcmp(magic, ENERGY_TELEMETRY_MAGIC, sizeof(magic)) == 0 &&
+           version == ENERGY_TELEMETRY_VERSION;
+}
+
+// -------------------------------------------------------------------------
+// EnergyTelemetryWriter
+// -------------------------------------------------------------------------
+
+EnergyTelemetryWriter::EnergyTelemetryWriter(const std::string& path,
+                                             const std::vector<uint32_t>& nodeIds,
+                                             uint32_t blockRows,
+                                             EnergyTelemetryHeader::Compression compression)
+    : m_out(path, std::ios::binary | std::ios::trunc),
+      m_header(),
+      m_pending(0),
+      m_closed(false)
+{
+    NS_LOG_FUNCTION(this << path << nodeIds.size() << blockRows << compression);
+    NS_ABORT_MSG_IF(!m_out, "Cannot create energy telemetry " << path);
+    NS_ABORT_MSG_IF(blockRows == 0, "blockRows must be positive");
+    std::memcpy(m_header.magic, ENERGY_TELEMETRY_MAGIC, sizeof(m_header.magic));
+    m_header.version = ENERGY_TELEMETRY_VERSION;
+    m_header.sources = static_cast<uint32_t>(nodeIds.size());
+    m_header.blockRows = blockRows;
+    m_header.compression = compression;
+    // Placeholder; the final header is written by Close().
+    m_out.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_out.write(reinterpret_cast<const char*>(nodeIds.data()), nodeIds.size() * sizeof(uint32_t));
+    m_header.indexOffset = sizeof(m_header) + nodeIds.size() * sizeof(uint32_t);
+
+    std::size_t entries = static_cast<std::size_t>(blockRows) * nodeIds.size();
+    m_times.resize(blockRows);
+    m_remainingJ.resize(entries);
+    m_voltageV.resize(entries);
+    m_harvestedJ.resize(entries);
+    m_sunlight.resize(entries);
+}
+
+EnergyTelemetryWriter::~EnergyTelemetryWriter()
+{
+    Close();
+}
+
+void
+EnergyTelemetryWriter::AddRow(Time t, const std::vector<EnergyTelemetrySample>& samples)
+{
+    NS_ABORT_MSG_IF(m_closed, "Energy telemetry already closed");
+    NS_ABORT_MSG_IF(samples.size() != m_header.sources,
+                    "Expected " << m_header.sources << " samples, got " << samples.size());
+    int64_t ns = t.GetNanoSeconds();
+    NS_ABORT_MSG_IF(m_header.rows > 0 && ns < m_header.lastTime,
+                    "Energy telemetry rows must be in non-decreasing time order");
+    if (m_header.rows == 0)
+    {
+        m_header.firstTime = ns;
+    }
+    m_header.lastTime = ns;
+    ++m_header.rows;
+
+    m_times[m_pending] = ns;
+    std::size_t entry = m_pending;
+    for (const auto& sample : samples)
+    {
+        m_remainingJ[entry] = sample.remainingJ;
+        m_voltageV[entry] = sample.voltageV;
+        m_harvestedJ[entry] = sample.harvestedJ;
+        m_sunlight[entry] = sample.sunlight ? 1 : 0;
+        entry += m_header.blockRows;
+    }
+    if (++m_pending == m_header.blockRows)
+    {
+        FlushBlock();
+    }
+}
+
+uint64_t
+EnergyTelemetryWriter::GetNRows() const
+{
+    return m_header.rows;
+}
+
+uint64_t
+EnergyTelemetryWriter::GetNBytes() const
+{
+    return m_header.indexOffset + (m_closed ? m_index.size() * 2 * sizeof(uint64_t) : 0);
+}
+
+void
+EnergyTelemetryWriter::FlushBlock()
+{
+    std::size_t n = m_pending;
+    if (n == 0)
+    {
+        return;
+    }
+    auto compression = static_cast<EnergyTelemetryHeader::Compression>(m_header.compression);
+    m_encoded.clear();
+    if (compression == EnergyTelemetryHeader::NONE)
+    {
+        PutBytes(m_encoded, m_times.data(), n * sizeof(int64_t));
+    }
+    else
+    {
+        PutBytes(m_encoded, &m_times[0], sizeof(int64_t));
+        for (std::size_t r = 1; r < n; ++r)
+        {
+            PutVarint(m_encoded, static_cast<uint64_t>(m_times[r] - m_times[r - 1]));
+        }
+    }
+    for (const auto* column : {&m_remainingJ, &m_voltageV, &m_harvestedJ})
+    {
+        for (uint32_t s = 0; s < m_header.sources; ++s)
+        {
+            EncodeColumn(m_encoded,
+                         column->data() + static_cast<std::size_t>(s) * m_header.blockRows,
+                         n,
+                         compression);
+        }
+    }
+    for (uint32_t s = 0; s < m_header.sources; ++s)
+    {
+        const uint8_t* flags = m_sunlight.data() + static_cast<std::size_t>(s) * m_header.blockRows;
+        for (std::size_t r = 0; r < n; r += 8)
+        {
+            uint8_t bits = 0;
+            for (std::size_t k = 0; k < 8 && r + k < n; ++k)
+            {
+                bits |= static_cast<uint8_t>(flags[r + k] << k);
+            }
+            m_encoded.push_back(bits);
+        }
+    }
+
+    m_index.push_back(m_times[0]);
+    m_offsets.push_back(m_header.indexOffset);
+    m_out.write(reinterpret_cast<const char*>(m_encoded.data()), m_encoded.size());
+    m_header.indexOffset += m_encoded.size();
+    ++m_header.blockCount;
+    m_pending = 0;
+}
+
+void
+EnergyTelemetryWriter::Close()
+{
+    if (m_closed)
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this);
+    FlushBlock();
+    m_out.write(reinterpret_cast<const char*>(m_index.data()), m_index.size() * sizeof(int64_t));
+    m_out.write(reinterpret_cast<const char*>(m_offsets.data()),
+                m_offsets.size() * sizeof(uint64_t));
+    m_out.seekp(0);
+    m_out.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_out.close();
+    NS_ABORT_MSG_IF(m_out.fail(), "Failed to write energy telemetry");
+    m_closed = true;
+}
+
+// -------------------------------------------------------------------------
+// EnergyTelemetryReader
+// -------------------------------------------------------------------------
+
+EnergyTelemetryReader::EnergyTelemetryReader(const std::string& path)
+    : m_path(path),
+      m_in(path, std::ios::binary),
+      m_block(std::numeric_limits<uint64_t>::max()),
+      m_rows(0)
+{
+    NS_LOG_FUNCTION(this << path);
+    NS_ABORT_MSG_IF(!m_in, "Cannot open energy telemetry " << path);
+    m_in.seekg(0, std::ios::end);
+    uint64_t size = static_cast<uint64_t>(m_in.tellg());
+    m_in.seekg(0);
+    NS_ABORT_MSG_IF(size < sizeof(EnergyTelemetryHeader),
+                    "Energy telemetry " << path << " is truncated");
+    m_in.read(reinterpret_cast<char*>(&m_header), sizeof(m_header));
+    CheckHeader(m_header, size, path);
+
+    m_nodeIds.resize(m_header.sources);
+    m_in.read(reinterpret_cast<char*>(m_nodeIds.data()), m_nodeIds.size() * sizeof(uint32_t));
+    m_offsets.resize(m_header.blockCount);
+    m_in.seekg(m_header.indexOffset + m_header.blockCount * sizeof(int64_t));
+    m_in.read(reinterpret_cast<char*>(m_offsets.data()), m_offsets.size() * sizeof(uint64_t));
+    NS_ABORT_MSG_IF(!m_in, "Cannot read the block index of " << path);
+    m_offsets.push_back(m_header.indexOffset);
+    uint64_t dataOffset = sizeof(EnergyTelemetryHeader) + m_nodeIds.size() * sizeof(uint32_t);
+    for (uint64_t b = 0; b < m_header.blockCount; ++b)
+    {
+        NS_ABORT_MSG_IF(m_offsets[b] < (b == 0 ? dataOffset : m_offsets[b - 1]) ||
+                            m_offsets[b] >= m_offsets[b + 1],
+                        "Energy telemetry " << path << " has an inconsistent block index");
+    }
+    NS_LOG_DEBUG(path << ": " << m_header.rows << " rows x " << m_header.sources << " sources in "
+                      << m_header.blockCount << " blocks");
+}
+
+uint32_t
+EnergyTelemetryReader::GetNSources() const
+{
+    return m_header.sources;
+}
+
+uint32_t
+EnergyTelemetryReader::GetNodeId(uint32_t source) const
+{
+    NS_ASSERT(source < m_header.sources);
+    return m_nodeIds[source];
+}
+
+uint64_t
+EnergyTelemetryReader::GetNRows() const
+{
+    return m_header.rows;
+}
+
+const EnergyTelemetryHeader&
+EnergyTelemetryReader::GetHeader() const
+{
+    return m_header;
+}
+
+void
+EnergyTelemetryReader::Load(uint64_t row) const
+{
+    NS_ASSERT(row < m_header.rows);
+    uint64_t index = row / m_header.blockRows;
+    if (index == m_block)
+    {
+        return;
+    }
+    m_encoded.resize(m_offsets[index + 1] - m_offsets[index]);
+    m_in.seekg(m_offsets[index]);
+    m_in.read(reinterpret_cast<char*>(m_encoded.data()), m_encoded.size());
+    NS_ABORT_MSG_IF(!m_in, "Cannot read block " << index << " of " << m_path);
+
+    m_block = std::numeric_limits<uint64_t>::max();
+    m_rows = static_cast<uint32_t>(std::min<uint64_t>(m_header.rows - index * m_header.blockRows,
+                                                      m_header.blockRows));
+    std::size_t n = m_rows;
+    std::size_t entries = n * m_header.sources;
+    m_times.resize(n);
+    m_remainingJ.resize(entries);
+    m_voltageV.resize(entries);
+    m_harvestedJ.resize(entries);
+    m_sunlight.resize(BitmapBytes(n) * m_header.sources);
+
+    auto compression = static_cast<EnergyTelemetryHeader::Compression>(m_header.compression);
+    const uint8_t* p = m_encoded.data();
+    const uint8_t* end = p + m_encoded.size();
+    bool ok = true;
+    if (compression == EnergyTelemetryHeader::NONE)
+    {
+        ok = GetBytes(p, end, m_times.data(), n * sizeof(int64_t));
+    }
+    else
+    {
+        ok = GetBytes(p, end, &m_times[0], sizeof(int64_t));
+        for (std::size_t r = 1; ok && r < n; ++r)
+        {
+            uint64_t delta;
+            ok = GetVarint(p, end, delta);
+            m_times[r] = m_times[r - 1] + static_cast<int64_t>(delta);
+        }
+    }
+    for (auto* column : {&m_remainingJ, &m_voltageV, &m_harvestedJ})
+    {
+        for (uint32_t s = 0; ok && s < m_header.sources; ++s)
+        {
+            ok = DecodeColumn(p, end, column->data() + s * n, n, compression);
+        }
+    }
+    ok = ok && GetBytes(p, end, m_sunlight.data(), m_sunlight.size()) && p == end;
+    NS_ABORT_MSG_IF(!ok, "Block " << index << " of " << m_path << " is corrupt");
+    m_block = index;
+}
+
+Time
+EnergyTelemetryReader::GetTime(uint64_t row) const
+{
+    Load(row);
+    return NanoSeconds(m_times[row % m_header.blockRows]);
+}
+
+EnergyTelemetrySample
+EnergyTelemetryReader::GetSample(uint64_t row, uint32_t source) const
+{
+    NS_ASSERT(source < m_header.sources);
+    Load(row);
+    std::size_t r = row % m_header.blockRows;
+    std::size_t entry = static_cast<std::size_t>(source) * m_rows + r;
+    uint8_t bits = m_sunlight[source * BitmapBytes(m_rows) + r / 8];
+    return EnergyTelemetrySample{m_remainingJ[entry],
+                                 m_voltageV[entry],
+                                 m_harvestedJ[entry],
+                                 ((bits >> (r % 8)) & 1) != 0};
+}
+
+// -------------------------------------------------------------------------
+// EnergyTelemetryCollector
+// -------------------------------------------------------------------------
+
+TypeId
+EnergyTelemetryCollector::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::EnergyTelemetryCollector")
+            .SetParent<Object>()
+            .SetGroupName("Energy")
+            .AddConstructor<EnergyTelemetryCollector>()
+            .AddAttribute("FileName",
+                          "Telemetry file written from Start() on.",
+                          StringValue("energy-telemetry.bin"),
+                          MakeStringAccessor(&EnergyTelemetryCollector::m_fileName),
+                          MakeStringChecker())
+            .AddAttribute("Interval",
+                          "Period of the samples.",
+                          TimeValue(Seconds(60)),
+                          MakeTimeAccessor(&EnergyTelemetryCollector::m_interval),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("BlockRows",
+                          "Samples buffered in memory and written as one block. A block "
+                          "holds about 25 bytes per source and row before compression.",
+                          UintegerValue(64),
+                          MakeUintegerAccessor(&EnergyTelemetryCollector::m_blockRows),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Compression",
+                          "Encoding of the blocks.",
+                          EnumValue(EnergyTelemetryHeader::XOR_DELTA),
+                          MakeEnumAccessor<EnergyTelemetryHeader::Compression>(
+                              &EnergyTelemetryCollector::m_compression),
+                          MakeEnumChecker(EnergyTelemetryHeader::NONE,
+                                          "None",
+                                          EnergyTelemetryHeader::XOR_DELTA,
+                                          "XorDelta"));
+    return tid;
+}
+
+EnergyTelemetryCollector::EnergyTelemetryCollector()
+    : m_fileName("energy-telemetry.bin"),
+      m_interval(Seconds(60)),
+      m_blockRows(64),
+      m_compression(EnergyTelemetryHeader::XOR_DELTA)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+EnergyTelemetryCollector::~EnergyTelemetryCollector()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+EnergyTelemetryCollector::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    m_sources.clear();
+    m_composites.clear();
+    Object::DoDispose();
+}
+
+uint32_t
+EnergyTelemetryCollector::Add(Ptr<LiIonEnergySource> source)
+{
+    NS_ABORT_MSG_IF(!source, "EnergyTelemetryCollector: null source");
+    Ptr<Node> node = source->GetNode();
+    return AddSource(source, node ? node->GetId() : std::numeric_limits<uint32_t>::max());
+}
+
+void
+EnergyTelemetryCollector::Add(NodeContainer nodes)
+{
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<Node> node = nodes.Get(i);
+        Ptr<EnergySourceContainer> container = node->GetObject<EnergySourceContainer>();
+        if (!container)
+        {
+            continue;
+        }
+        for (auto it = container->Begin(); it != container->End(); ++it)
+        {
+            Ptr<LiIonEnergySource> source = DynamicCast<LiIonEnergySource>(*it);
+            if (source)
+            {
+                AddSource(source, node->GetId());
+            }
+        }
+    }
+}
+
+uint32_t
+EnergyTelemetryCollector::AddSource(Ptr<LiIonEnergySource> source, uint32_t nodeId)
+{
+    NS_LOG_FUNCTION(this << source << nodeId);
+    NS_ABORT_MSG_IF(m_writer, "EnergyTelemetryCollector: sources must be added before Start()");
+    auto i = static_cast<uint32_t>(m_sources.size());
+    m_sources.push_back(source);
+    m_composites.push_back(DynamicCast<CompositeEnergySource>(source));
+    m_nodeIds.push_back(nodeId);
+    return i;
+}
+
+uint32_t
+EnergyTelemetryCollector::GetN() const
+{
+    return static_cast<uint32_t>(m_sources.size());
+}
+
+void
+EnergyTelemetryCollector::Start()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(m_writer, "EnergyTelemetryCollector: already started");
+    m_writer =
+        std::make_unique<EnergyTelemetryWriter>(m_fileName, m_nodeIds, m_blockRows, m_compression);
+    m_row.assign(m_sources.size(), EnergyTelemetrySample{0.0, 0.0, 0.0, false});
+    m_sampleEvent = Simulator::ScheduleNow(&EnergyTelemetryCollector::Sample, this);
+}
+
+void
+EnergyTelemetryCollector::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    m_sampleEvent.Cancel();
+    if (m_writer)
+    {
+        m_writer->Close();
+    }
+}
+
+uint64_t
+EnergyTelemetryCollector::GetNSamples() const
+{
+    return m_writer ? m_writer->GetNRows() : 0;
+}
+
+uint64_t
+EnergyTelemetryCollector::GetNBytes() const
+{
+    return m_writer ? m_writer->GetNBytes() : 0;
+}
+
+void
+EnergyTelemetryCollector::Sample()
+{
+    for (std::size_t i = 0; i < m_sources.size(); ++i)
+    {
+        EnergyTelemetrySample& sample = m_row[i];
+        // Brings the source up to date, so read it before the voltage.
+        sample.remainingJ = m_sources[i]->GetRemainingEnergy();
+        sample.voltageV = m_sources[i]->GetSupplyVoltage();
+        const Ptr<CompositeEnergySource>& composite = m_composites[i];
+        sample.harvestedJ = composite ? composite->GetTotalHarvestedEnergy() : 0.0;
+        sample.sunlight = composite && composite->IsInSunlight();
+    }
+    m_writer->AddRow(Simulator::Now(), m_row);
+    m_sampleEvent = Simulator::Schedule(m_interval, &EnergyTelemetryCollector::Sample, this);
+}
+
+} // namespace ns3
@@ -0,0 +1,280 @@
+#ifndef NS3_ENERGY_TELEMETRY_H
+#define NS3_ENERGY_TELEMETRY_H
+
+#include "composite-energy-source.h"
+
+#include "ns3/event-id.h"
+#include "ns3/li-ion-energy-source.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief On-disk layout of a binary energy telemetry file.
+ *
+ * A telemetry file holds one time column and, for each of \c sources
+ * energy sources, four state columns, all in the host byte order:
+ *
+ *   header   EnergyTelemetryHeader (64 bytes)
+ *   nodes    uint32 nodeId[sources]
+ *   block 0  time[n], then per source remainingJ[n], then per source
+ *            voltageV[n], then per source harvestedJ[n], then per source
+ *            a bitmap of ceil(n / 8) bytes of sunlight flags
+ *   block 1  ...
+ *   index    int64 firstTime[blockCount] (ns), uint64 offset[blockCount]
+ *
+ * Every block but the last holds exactly \c blockRows rows. Uncompressed
+ * (NONE), times are int64 ns and values float64. With XOR_DELTA, times
+ * are stored as varint deltas from the previous row of the block, and
+ * each value as its bit pattern XORed with the previous row's value of
+ * the same column: a control byte giving the count of leading (high
+ * nibble) and trailing (low nibble) zero bytes of the XOR, followed by
+ * the remaining bytes. Battery state moves slowly between samples, so
+ * most values shrink to a few bytes and unchanged ones to the control
+ * byte alone. Blocks then differ in size, hence the offsets in the index.
+ */
+struct EnergyTelemetryHeader
+{
+    /** Encoding of the blocks. */
+    enum Compression
+    {
+        NONE,      //!< Raw int64 times and float64 values
+        XOR_DELTA, //!< Varint time deltas, XOR-encoded values
+    };
+
+    char magic[8];        //!< "NS3ENTL" followed by a NUL
+    uint32_t version;     //!< Format version, currently 1
+    uint32_t sources;     //!< Energy sources per row
+    uint64_t rows;        //!< Total rows
+    uint32_t blockRows;   //!< Rows per block (all blocks but the last)
+    uint32_t compression; //!< A Compression value
+    uint64_t blockCount;  //!< Number of blocks
+    uint64_t indexOffset; //!< File offset of the block index
+    int64_t firstTime;    //!< Time of the first row (ns)
+    int64_t lastTime;     //!< Time of the last row (ns)
+
+    /** \return true if the magic and version are those of this format. */
+    bool IsValid() const;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief State of one energy source at one telemetry sample.
+ */
+struct EnergyTelemetrySample
+{
+    double remainingJ; //!< Remaining energy (J)
+    double voltageV;   //!< Supply voltage (V)
+    double harvestedJ; //!< Total harvested energy (J), 0 for a plain Li-Ion source
+    bool sunlight;     //!< Whether the source was in sunlight
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Writes a binary energy telemetry file (see EnergyTelemetryHeader).
+ *
+ * Rows are buffered column by column one block at a time, and each block
+ * is encoded into memory and written with a single call, so appending a
+ * row costs no formatting and no I/O. Close() (or the destructor)
+ * flushes the last block and writes the index.
+ */
+class EnergyTelemetryWriter
+{
+  public:
+    /**
+     * \param path Output file, truncated if it exists.
+     * \param nodeIds Node id of each source, in column order.
+     * \param blockRows Rows per block.
+     * \param compression Encoding of the blocks.
+     */
+    EnergyTelemetryWriter(const std::string& path,
+                          const std::vector<uint32_t>& nodeIds,
+                          uint32_t blockRows = 64,
+                          EnergyTelemetryHeader::Compression compression =
+                              EnergyTelemetryHeader::XOR_DELTA);
+    ~EnergyTelemetryWriter();
+
+    /**
+     * \brief Append a row.
+     *
+     * \param t Row time; must not precede the previous row.
+     * \param samples One sample per source, in column order.
+     */
+    void AddRow(Time t, const std::vector<EnergyTelemetrySample>& samples);
+
+    /** \return Rows written so far. */
+    uint64_t GetNRows() const;
+
+    /** \return Bytes written so far, header included. */
+    uint64_t GetNBytes() const;
+
+    /** Flush the pending block, write the index and close the file. */
+    void Close();
+
+  private:
+    /** Encode the buffered rows and write them as one block. */
+    void FlushBlock();
+
+    std::ofstream m_out;
+    EnergyTelemetryHeader m_header;
+    uint32_t m_pending; // rows buffered in the block
+
+    // Pending block, one run of blockRows entries per source
+    std::vector<int64_t> m_times;
+    std::vector<double> m_remainingJ;
+    std::vector<double> m_voltageV;
+    std::vector<double> m_harvestedJ;
+    std::vector<uint8_t> m_sunlight;
+
+    std::vector<uint8_t> m_encoded;  // scratch of FlushBlock()
+    std::vector<int64_t> m_index;    // first time of every written block
+    std::vector<uint64_t> m_offsets; // file offset of every written block
+    bool m_closed;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Block-cached reader of a binary energy telemetry file.
+ *
+ * Only the header, the node ids and the block index are read when the
+ * file is opened; a block is read and decoded on first access and kept
+ * until a row of another block is requested, so reading the rows in
+ * order reads every block once.
+ */
+class EnergyTelemetryReader
+{
+  public:
+    /**
+     * \brief Open the telemetry file at \p path.
+     *
+     * Aborts if the file cannot be read or is not a valid telemetry file.
+     */
+    EnergyTelemetryReader(const std::string& path);
+
+    /** \return Number of energy sources. */
+    uint32_t GetNSources() const;
+
+    /** \return Node id of source \p source. */
+    uint32_t GetNodeId(uint32_t source) const;
+
+    /** \return Number of rows. */
+    uint64_t GetNRows() const;
+
+    /** \return Time of row \p row. */
+    Time GetTime(uint64_t row) const;
+
+    /** \return State of source \p source at row \p row. */
+    EnergyTelemetrySample GetSample(uint64_t row, uint32_t source) const;
+
+    /** \return File header. */
+    const EnergyTelemetryHeader& GetHeader() const;
+
+  private:
+    /** Make the block holding \p row the current block. */
+    void Load(uint64_t row) const;
+
+    std::string m_path;
+    EnergyTelemetryHeader m_header;
+    std::vector<uint32_t> m_nodeIds;
+    std::vector<uint64_t> m_offsets; // file offset of every block, then the index's
+    mutable std::ifstream m_in;
+
+    // Current block, decoded
+    mutable uint64_t m_block; // UINT64_MAX before the first access
+    mutable uint32_t m_rows;
+    mutable std::vector<int64_t> m_times;
+    mutable std::vector<double> m_remainingJ;
+    mutable std::vector<double> m_voltageV;
+    mutable std::vector<double> m_harvestedJ;
+    mutable std::vector<uint8_t> m_sunlight;
+    mutable std::vector<uint8_t> m_encoded;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Samples the state of many energy sources into a telemetry file.
+ *
+ * Replaces a per-node printing event: one scheduled event every
+ * \c Interval samples the remaining energy, supply voltage, harvested
+ * energy and sunlight state of every added source and appends them as
+ * one row to an EnergyTelemetryWriter. Any LiIonEnergySource can be
+ * added; the harvest columns are those of a CompositeEnergySource and
+ * zero for other sources. Reading the remaining energy brings each
+ * source up to date, as GetRemainingEnergy() does.
+ *
+ * Sources are added before Start(), which creates the file and takes the
+ * first sample at once. Stop() (or disposing the collector) closes it.
+ * Read the file back with EnergyTelemetryReader or the
+ * energy-telemetry-dump utility.
+ */
+class EnergyTelemetryCollector : public Object
+{
+  public:
+    static TypeId GetTypeId();
+
+    EnergyTelemetryCollector();
+    ~EnergyTelemetryCollector() override;
+
+    /**
+     * \brief Add a source; its node id is that of its node, if set.
+     *
+     * \return Column of the source in the file.
+     */
+    uint32_t Add(Ptr<LiIonEnergySource> source);
+
+    /** Add every LiIonEnergySource in the EnergySourceContainer of \p nodes. */
+    void Add(NodeContainer nodes);
+
+    /** \return Number of sources. */
+    uint32_t GetN() const;
+
+    /** Create the file and start sampling. */
+    void Start();
+
+    /** Stop sampling and close the file. */
+    void Stop();
+
+    /** \return Rows sampled so far. */
+    uint64_t GetNSamples() const;
+
+    /** \return Bytes of the file written so far. */
+    uint64_t GetNBytes() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /** Add \p source as node \p nodeId. */
+    uint32_t AddSource(Ptr<LiIonEnergySource> source, uint32_t nodeId);
+
+    /** Sample every source and schedule the next sample. */
+    void Sample();
+
+    std::string m_fileName;
+    Time m_interval;
+    uint32_t m_blockRows;
+    EnergyTelemetryHeader::Compression m_compression;
+    EventId m_sampleEvent;
+
+    std::vector<Ptr<LiIonEnergySource>> m_sources;
+    std::vector<Ptr<CompositeEnergySource>> m_composites; // null for plain Li-Ion
+    std::vector<uint32_t> m_nodeIds;
+    std::vector<EnergyTelemetrySample> m_row;
+    std::unique_ptr<EnergyTelemetryWriter> m_writer;
+};
+
+} // namespace ns3
+
+#endif // NS3_ENERGY_TELEMETRY_H
@@ -0,0 +1,135 @@
+#include "energy-worker-pool.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("EnergyWorkerPool");
+
+EnergyWorkerPool::EnergyWorkerPool(uint32_t threads)
+    : m_nThreads(threads),
+      m_task(nullptr),
+      m_generation(0),
+      m_busy(0),
+      m_stop(false)
+{
+    NS_LOG_FUNCTION(this << threads);
+    if (m_nThreads == 0)
+    {
+        m_nThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    m_ranges.reset(new Range[m_nThreads]);
+    for (uint32_t w = 0; w < m_nThreads; ++w)
+    {
+        m_ranges[w].next.store(0);
+        m_ranges[w].end = 0;
+    }
+    // Thread 0 is whoever calls Run().
+    for (uint32_t w = 1; w < m_nThreads; ++w)
+    {
+        m_threads.emplace_back(&EnergyWorkerPool::WorkerLoop, this, w);
+    }
+}
+
+EnergyWorkerPool::~EnergyWorkerPool()
+{
+    NS_LOG_FUNCTION(this);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+uint32_t
+EnergyWorkerPool::GetNThreads() const
+{
+    return m_nThreads;
+}
+
+void
+EnergyWorkerPool::Run(std::size_t tasks, const std::function<void(std::size_t)>& task)
+{
+    if (m_nThreads == 1 || tasks <= 1)
+    {
+        for (std::size_t i = 0; i < tasks; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t w = 0; w < m_nThreads; ++w)
+        {
+            m_ranges[w].next.store(tasks * w / m_nThreads, std::memory_order_relaxed);
+            m_ranges[w].end = tasks * (w + 1) / m_nThreads;
+        }
+        m_task = &task;
+        m_busy = m_nThreads - 1;
+        ++m_generation;
+    }
+    m_start.notify_all();
+
+    Work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+void
+EnergyWorkerPool::WorkerLoop(uint32_t worker)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, seen] { return m_stop || m_generation != seen; });
+            if (m_stop)
+            {
+                return;
+            }
+            seen = m_generation;
+        }
+        Work(worker);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+}
+
+void
+EnergyWorkerPool::Work(uint32_t worker)
+{
+    // Own range first, then the others in turn. A claim past the end of a
+    // range only means that range is exhausted.
+    for (uint32_t k = 0; k < m_nThreads; ++k)
+    {
+        Range& range = m_ranges[(worker + k) % m_nThreads];
+        while (true)
+        {
+            std::size_t i = range.next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= range.end)
+            {
+                break;
+            }
+            (*m_task)(i);
+        }
+    }
+}
+
+} // namespace ns3
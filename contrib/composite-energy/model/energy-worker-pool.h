@@ -0,0 +1,79 @@
+#ifndef NS3_ENERGY_WORKER_POOL_H
+#define NS3_ENERGY_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Fixed pool of threads running indexed tasks with work stealing.
+ *
+ * Run() splits the task indices into one contiguous range per thread (the
+ * calling thread included). Every thread claims the tasks of its own range
+ * in order, then steals the remaining tasks of the other ranges, so a
+ * thread that finishes early keeps helping instead of idling. Run()
+ * returns once every task has run. Which thread runs a task is not
+ * deterministic; callers that need deterministic results make each task
+ * write only its own outputs and combine them afterwards in task order.
+ *
+ * Tasks must not call into the simulator (scheduling, logging or tracing).
+ */
+class EnergyWorkerPool
+{
+  public:
+    /**
+     * \param threads Threads to run tasks on, the caller of Run() included.
+     *        0 means one per hardware thread.
+     */
+    explicit EnergyWorkerPool(uint32_t threads);
+    ~EnergyWorkerPool();
+
+    EnergyWorkerPool(const EnergyWorkerPool&) = delete;
+    EnergyWorkerPool& operator=(const EnergyWorkerPool&) = delete;
+
+    /** \return Number of threads running tasks, the caller included. */
+    uint32_t GetNThreads() const;
+
+    /** Run \p task(i) for every i in [0, tasks) and wait for all of them. */
+    void Run(std::size_t tasks, const std::function<void(std::size_t)>& task);
+
+  private:
+    /** Range of task indices, claimed from the front. */
+    struct alignas(64) Range
+    {
+        std::atomic<std::size_t> next; //!< Next unclaimed index
+        std::size_t end;               //!< One past the last index
+    };
+
+    /** Body of the pool threads. */
+    void WorkerLoop(uint32_t worker);
+
+    /** Run the tasks of range \p worker, then steal from the others. */
+    void Work(uint32_t worker);
+
+    uint32_t m_nThreads;
+    std::unique_ptr<Range[]> m_ranges;
+    std::vector<std::thread> m_threads;
+    const std::function<void(std::size_t)>* m_task;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_generation; // incremented by every Run()
+    uint32_t m_busy;       // pool threads still working on this Run()
+    bool m_stop;
+};
+
+} // namespace ns3
+
+#endif // NS3_ENERGY_WORKER_POOL_H
@@ -0,0 +1,191 @@
+#include "hot-path-profile.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <utility>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HotPathProfile");
+
+HotPathProfile::HotPathProfile()
+{
+    std::fill(m_calls, m_calls + N_PATHS, 0);
+    std::fill(m_nanoseconds, m_nanoseconds + N_PATHS, 0);
+}
+
+std::string
+HotPathProfile::GetPathName(Path path)
+{
+    switch (path)
+    {
+    case UPDATE_ENERGY_SOURCE:
+        return "UpdateEnergySource";
+    case GET_REMAINING_ENERGY:
+        return "GetRemainingEnergy";
+    case UPDATE_HARVEST_CURRENT:
+        return "UpdateHarvestCurrent";
+    case SET_HARVEST_CURRENT:
+        return "SetHarvestCurrentA";
+    case SETTLE:
+        return "Settle";
+    default:
+        return "Unknown";
+    }
+}
+
+void
+HotPathProfile::Record(Path path, int64_t nanoseconds)
+{
+    ++m_calls[path];
+    m_nanoseconds[path] += nanoseconds;
+}
+
+uint64_t
+HotPathProfile::GetCalls(Path path) const
+{
+    return m_calls[path];
+}
+
+double
+HotPathProfile::GetSeconds(Path path) const
+{
+    return m_nanoseconds[path] * 1e-9;
+}
+
+void
+HotPathProfile::Merge(const HotPathProfile& other)
+{
+    for (int p = 0; p < N_PATHS; ++p)
+    {
+        m_calls[p] += other.m_calls[p];
+        m_nanoseconds[p] += other.m_nanoseconds[p];
+    }
+}
+
+// ------------------------------------------------------------------------
+// HotPathProfileRegistry
+// ------------------------------------------------------------------------
+
+std::vector<HotPathProfileRegistry::Entry>&
+HotPathProfileRegistry::GetEntries()
+{
+    static std::vector<Entry> entries;
+    return entries;
+}
+
+std::shared_ptr<HotPathProfile>
+HotPathProfileRegistry::Create(const std::string& owner, uint32_t nodeId)
+{
+    NS_LOG_FUNCTION(owner << nodeId);
+    auto profile = std::make_shared<HotPathProfile>();
+    GetEntries().push_back(Entry{owner, nodeId, profile});
+    return profile;
+}
+
+std::size_t
+HotPathProfileRegistry::GetN()
+{
+    return GetEntries().size();
+}
+
+HotPathProfile
+HotPathProfileRegistry::GetTotal()
+{
+    HotPathProfile total;
+    for (const auto& entry : GetEntries())
+    {
+        total.Merge(*entry.profile);
+    }
+    return total;
+}
+
+void
+HotPathProfileRegistry::Dump(std::ostream& os)
+{
+    // One profile per node and object type: a node rarely has more than
+    // one source, but nothing prevents it.
+    std::map<std::pair<uint32_t, std::string>, HotPathProfile> byNode;
+    for (const auto& entry : GetEntries())
+    {
+        byNode[{entry.nodeId, entry.owner}].Merge(*entry.profile);
+    }
+
+    // The stream may be the caller's (std::cout), so hand it back with the
+    // formatting it came with.
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    auto line = [&os](const std::string& node,
+                      const std::string& owner,
+                      HotPathProfile::Path path,
+                      const HotPathProfile& profile) {
+        uint64_t calls = profile.GetCalls(path);
+        if (calls == 0)
+        {
+            return;
+        }
+        double seconds = profile.GetSeconds(path);
+        os << std::left << std::setw(8) << node << std::setw(28) << owner << std::setw(22)
+           << HotPathProfile::GetPathName(path) << std::right << std::setw(12) << calls
+           << std::setw(14) << std::fixed << std::setprecision(6) << seconds << std::setw(12)
+           << std::setprecision(3) << seconds * 1e6 / calls << std::endl;
+    };
+
+    os << std::left << std::setw(8) << "node" << std::setw(28) << "object" << std::setw(22)
+       << "path" << std::right << std::setw(12) << "calls" << std::setw(14) << "total(s)"
+       << std::setw(12) << "mean(us)" << std::endl;
+    for (const auto& [key, profile] : byNode)
+    {
+        std::string node = key.first == std::numeric_limits<uint32_t>::max()
+                               ? std::string("-")
+                               : std::to_string(key.first);
+        for (int p = 0; p < HotPathProfile::N_PATHS; ++p)
+        {
+            line(node, key.second, static_cast<HotPathProfile::Path>(p), profile);
+        }
+    }
+    HotPathProfile total = GetTotal();
+    for (int p = 0; p < HotPathProfile::N_PATHS; ++p)
+    {
+        line("total", "", static_cast<HotPathProfile::Path>(p), total);
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void
+HotPathProfileRegistry::DumpAtDestroy(const std::string& fileName)
+{
+    NS_LOG_FUNCTION(fileName);
+    Simulator::ScheduleDestroy(&HotPathProfileRegistry::DumpToFile, fileName);
+}
+
+void
+HotPathProfileRegistry::DumpToFile(std::string fileName)
+{
+    if (fileName.empty())
+    {
+        Dump(std::cout);
+        return;
+    }
+    std::ofstream out(fileName);
+    NS_ABORT_MSG_IF(!out, "HotPathProfileRegistry: cannot write " << fileName);
+    Dump(out);
+}
+
+void
+HotPathProfileRegistry::Clear()
+{
+    GetEntries().clear();
+}
+
+} // namespace ns3
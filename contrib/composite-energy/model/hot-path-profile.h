@@ -0,0 +1,179 @@
+#ifndef NS3_HOT_PATH_PROFILE_H
+#define NS3_HOT_PATH_PROFILE_H
+
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Call counts and cumulative wall time of the harvesting hot paths
+ *        of one object.
+ *
+ * Profiling is opt-in (CompositeEnergySource::EnableProfiling). Objects
+ * that do not profile hold no profile and pay one null test per call.
+ * Times are inclusive: GetRemainingEnergy() contains the
+ * UpdateEnergySource() it forces, which contains Settle().
+ */
+class HotPathProfile
+{
+  public:
+    /** Profiled functions. */
+    enum Path
+    {
+        UPDATE_ENERGY_SOURCE,   //!< CompositeEnergySource::UpdateEnergySource()
+        GET_REMAINING_ENERGY,   //!< CompositeEnergySource::GetRemainingEnergy()
+        UPDATE_HARVEST_CURRENT, //!< CompositeEnergySource::UpdateHarvestCurrent()
+        SET_HARVEST_CURRENT,    //!< SolarHarvesterDeviceModel::SetHarvestCurrentA()
+        SETTLE,                 //!< SolarHarvesterDeviceModel::Settle() / Deliver()
+        N_PATHS,
+    };
+
+    /**
+     * TracedCallback signature for profiled calls.
+     *
+     * \param [in] path The function that returned.
+     * \param [in] elapsed Wall time it took.
+     */
+    typedef void (*TracedCallback)(Path path, Time elapsed);
+
+    HotPathProfile();
+
+    /** \return Name of \p path, e.g. "UpdateHarvestCurrent". */
+    static std::string GetPathName(Path path);
+
+    /** Count one call of \p path that took \p nanoseconds. */
+    void Record(Path path, int64_t nanoseconds);
+
+    /** \return Calls of \p path so far. */
+    uint64_t GetCalls(Path path) const;
+
+    /** \return Cumulative wall time of \p path (s). */
+    double GetSeconds(Path path) const;
+
+    /** Add the counts and times of \p other to this profile. */
+    void Merge(const HotPathProfile& other);
+
+  private:
+    uint64_t m_calls[N_PATHS];
+    int64_t m_nanoseconds[N_PATHS];
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Times the enclosing scope into a HotPathProfile.
+ *
+ * Does nothing, not even reading the clock, when the profile is null.
+ */
+class HotPathTimer
+{
+  public:
+    /**
+     * \param profile Profile to record into, or null.
+     * \param path Path being timed.
+     * \param trace Fired with the elapsed time when the scope ends.
+     */
+    HotPathTimer(HotPathProfile* profile,
+                 HotPathProfile::Path path,
+                 const ns3::TracedCallback<HotPathProfile::Path, Time>& trace)
+        : m_profile(profile),
+          m_path(path),
+          m_trace(trace)
+    {
+        if (m_profile)
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~HotPathTimer()
+    {
+        if (m_profile)
+        {
+            int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - m_start)
+                             .count();
+            m_profile->Record(m_path, ns);
+            m_trace(m_path, NanoSeconds(ns));
+        }
+    }
+
+    HotPathTimer(const HotPathTimer&) = delete;
+    HotPathTimer& operator=(const HotPathTimer&) = delete;
+
+  private:
+    HotPathProfile* m_profile;
+    HotPathProfile::Path m_path;
+    const ns3::TracedCallback<HotPathProfile::Path, Time>& m_trace;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Module-wide registry of the HotPathProfile of every profiling
+ *        object.
+ *
+ * Profiles are shared between their object and the registry, so they
+ * outlive the objects and can be dumped after the simulation has torn its
+ * nodes down, e.g. from DumpAtDestroy().
+ */
+class HotPathProfileRegistry
+{
+  public:
+    /**
+     * \brief Create and register a profile.
+     *
+     * \param owner Type of the profiled object, e.g. "CompositeEnergySource".
+     * \param nodeId Node the object belongs to (UINT32_MAX if none).
+     */
+    static std::shared_ptr<HotPathProfile> Create(const std::string& owner, uint32_t nodeId);
+
+    /** \return Number of registered profiles. */
+    static std::size_t GetN();
+
+    /** \return Sum of all registered profiles. */
+    static HotPathProfile GetTotal();
+
+    /**
+     * \brief Write one line per node, object type and path with calls,
+     *        total and mean wall time, followed by the module totals.
+     */
+    static void Dump(std::ostream& os);
+
+    /**
+     * \brief Dump() to \p fileName (standard output if empty) when the
+     *        simulator is destroyed.
+     */
+    static void DumpAtDestroy(const std::string& fileName = "");
+
+    /** Forget every registered profile. */
+    static void Clear();
+
+  private:
+    /** A registered profile. */
+    struct Entry
+    {
+        std::string owner;
+        uint32_t nodeId;
+        std::shared_ptr<HotPathProfile> profile;
+    };
+
+    /** Dump() to \p fileName, scheduled by DumpAtDestroy(). */
+    static void DumpToFile(std::string fileName);
+
+    /** \return The registered profiles. */
+    static std::vector<Entry>& GetEntries();
+};
+
+} // namespace ns3
+
+#endif // NS3_HOT_PATH_PROFILE_H
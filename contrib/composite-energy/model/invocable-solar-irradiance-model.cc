@@ -0,0 +1,67 @@
+#include "invocable-solar-irradiance-model.h"
+
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("InvocableSolarIrradianceModel");
+
+NS_OBJECT_ENSURE_REGISTERED(InvocableSolarIrradianceModelBase);
+
+TypeId
+InvocableSolarIrradianceModelBase::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::InvocableSolarIrradianceModelBase")
+            .SetParent<SolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddAttribute("HoldSeconds",
+                          "Period (s) over which the invocable's output is known to be "
+                          "constant, aligned to multiples of this value. 0 (default) means "
+                          "nothing is known and consumers must poll it.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&InvocableSolarIrradianceModelBase::SetHoldSeconds,
+                                             &InvocableSolarIrradianceModelBase::GetHoldSeconds),
+                          MakeDoubleChecker<double>(0.0));
+    return tid;
+}
+
+InvocableSolarIrradianceModelBase::InvocableSolarIrradianceModelBase()
+    : m_hold(Seconds(0))
+{
+    NS_LOG_FUNCTION(this);
+}
+
+InvocableSolarIrradianceModelBase::~InvocableSolarIrradianceModelBase() = default;
+
+SolarIrradianceSegment
+InvocableSolarIrradianceModelBase::Hold(Time t, double wm2) const
+{
+    int64_t hold = m_hold.GetTimeStep();
+    if (hold <= 0)
+    {
+        return SolarIrradianceSegment{t, t, wm2, 0.0};
+    }
+    int64_t into = t.GetTimeStep() % hold;
+    if (into < 0)
+    {
+        into += hold;
+    }
+    return SolarIrradianceSegment{t, t + TimeStep(hold - into), wm2, 0.0};
+}
+
+void
+InvocableSolarIrradianceModelBase::SetHoldSeconds(double seconds)
+{
+    m_hold = Seconds(seconds);
+}
+
+double
+InvocableSolarIrradianceModelBase::GetHoldSeconds() const
+{
+    return m_hold.GetSeconds();
+}
+
+} // namespace ns3
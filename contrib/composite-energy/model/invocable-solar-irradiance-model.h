@@ -0,0 +1,158 @@
+#ifndef NS3_INVOCABLE_SOLAR_IRRADIANCE_MODEL_H
+#define NS3_INVOCABLE_SOLAR_IRRADIANCE_MODEL_H
+
+#include "solar-irradiance-model.h"
+
+#include "ns3/object.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Attributes and segment logic shared by every
+ *        InvocableSolarIrradianceModel instantiation.
+ *
+ * \c HoldSeconds has the meaning of
+ * CallbackSolarIrradianceModel::HoldSeconds: if the invocable's output is
+ * known to change no faster than that period, segments report it held
+ * until the next multiple; with 0 (default) consumers poll.
+ */
+class InvocableSolarIrradianceModelBase : public SolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    InvocableSolarIrradianceModelBase();
+    ~InvocableSolarIrradianceModelBase() override;
+
+  protected:
+    /** \return The segment of \p wm2 from \p t on, held per HoldSeconds. */
+    SolarIrradianceSegment Hold(Time t, double wm2) const;
+
+  private:
+    void SetHoldSeconds(double seconds);
+    double GetHoldSeconds() const;
+
+    Time m_hold; // HoldSeconds as a Time, so segment ends are exact multiples
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Irradiance from any invocable (lambda, functor) held by value.
+ *
+ * The CallbackSolarIrradianceModel counterpart without an ns3::Callback:
+ * the invocable's type is a template parameter, so its call inlines into
+ * the model's GetPowerDensityWm2() and nothing is allocated per call.
+ * Consumers still reach the model through one virtual call.
+ *
+ * \p F may provide any of:
+ *  - <tt>double(Time t)</tt>, the power density at \c t (W/m^2);
+ *  - <tt>double(double seconds)</tt>, the same with \c t in seconds;
+ *  - <tt>void(const Time* times, double* wm2, std::size_t n)</tt>, a
+ *    whole block at once, e.g. from a propagator that steps through the
+ *    times in one call. GetPowerDensitiesWm2() passes blocks straight
+ *    through; without it the scalar form is called in an inlined loop.
+ *
+ * The scalar forms are preferred in that order, and a block-only
+ * invocable serves single queries as blocks of one. The invocable may be
+ * stateful (a \c mutable lambda or a functor with a non-const call
+ * operator) as long as it is only called from the simulation thread, as
+ * every model is unless wrapped. An AsyncSolarIrradianceModel calls the
+ * model it wraps from several worker threads at once, so only wrap an
+ * invocable that is a function of time alone and safe to call
+ * concurrently; a stateful one must not be wrapped.
+ *
+ * Create instances with CreateInvocableSolarIrradianceModel().
+ */
+template <typename F>
+class InvocableSolarIrradianceModel : public InvocableSolarIrradianceModelBase
+{
+  public:
+    /** Hold \p f, by value. */
+    explicit InvocableSolarIrradianceModel(F f)
+        : m_f(std::move(f))
+    {
+    }
+
+    double GetPowerDensityWm2(Time t) const override
+    {
+        return Evaluate(t);
+    }
+
+    SolarIrradianceSegment GetSegment(Time t) const override
+    {
+        return Hold(t, Evaluate(t));
+    }
+
+    void GetPowerDensitiesWm2(const Time* times, double* wm2, std::size_t n) const override
+    {
+        if constexpr (IS_BLOCK)
+        {
+            m_f(times, wm2, n);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                wm2[i] = Evaluate(times[i]);
+            }
+        }
+    }
+
+    /** \return The invocable, e.g. to reconfigure a functor's state. */
+    F& GetInvocable()
+    {
+        return m_f;
+    }
+
+  private:
+    static constexpr bool IS_TIME = std::is_invocable_r_v<double, F&, Time>;
+    static constexpr bool IS_SECONDS = std::is_invocable_r_v<double, F&, double>;
+    static constexpr bool IS_BLOCK =
+        std::is_invocable_v<F&, const Time*, double*, std::size_t>;
+    static_assert(IS_TIME || IS_SECONDS || IS_BLOCK,
+                  "The invocable must take a Time, seconds, or a block of times");
+
+    /** \return The power density at \p t, through the preferred form. */
+    double Evaluate(Time t) const
+    {
+        if constexpr (IS_TIME)
+        {
+            return m_f(t);
+        }
+        else if constexpr (IS_SECONDS)
+        {
+            return m_f(t.GetSeconds());
+        }
+        else
+        {
+            double wm2 = 0.0;
+            m_f(&t, &wm2, 1);
+            return wm2;
+        }
+    }
+
+    mutable F m_f;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Create an InvocableSolarIrradianceModel holding \p f.
+ *
+ * \param f Invocable, copied or moved into the model.
+ * \return The model.
+ */
+template <typename F>
+Ptr<InvocableSolarIrradianceModel<std::decay_t<F>>>
+CreateInvocableSolarIrradianceModel(F&& f)
+{
+    return CreateObject<InvocableSolarIrradianceModel<std::decay_t<F>>>(std::forward<F>(f));
+}
+
+} // namespace ns3
+
+#endif // NS3_INVOCABLE_SOLAR_IRRADIANCE_MODEL_H
@@ -0,0 +1,570 @@
+#include "irradiance-trace.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+
+#ifndef __WIN32__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("IrradianceTrace");
+
+namespace
+{
+
+const char IRRADIANCE_TRACE_MAGIC[8] = {'N', 'S', '3', 'I', 'R', 'R', 'T', '\0'};
+const uint32_t IRRADIANCE_TRACE_VERSION = 1;
+
+static_assert(sizeof(IrradianceTraceHeader) == 64, "trace header must be 64 bytes");
+
+/**
+ * Traces currently open, by path. Entries are not owning: a trace removes
+ * itself when its last reference goes away.
+ */
+std::map<std::string, IrradianceTrace*>&
+GetOpenTraces()
+{
+    static std::map<std::string, IrradianceTrace*> traces;
+    return traces;
+}
+
+/**
+ * Abort unless \p header describes a well-formed trace of \p fileSize
+ * bytes: right magic and version, a block count matching the rows, and
+ * blocks and index that exactly fill the file.
+ */
+void
+CheckHeader(const IrradianceTraceHeader& header, uint64_t fileSize, const std::string& path)
+{
+    NS_ABORT_MSG_IF(!header.IsValid(), path << " is not an irradiance trace (version 1)");
+    NS_ABORT_MSG_IF(header.blockRows == 0 && header.rows > 0,
+                    "Irradiance trace " << path << " has a zero block size");
+    uint64_t blocks = (header.rows == 0) ? 0 : (header.rows - 1) / header.blockRows + 1;
+    // Every row takes its time and its columns, whichever block it is in,
+    // so the blocks fill rows * rowBytes; bounding the rows by the file
+    // size first keeps that product from wrapping.
+    uint64_t rowBytes = sizeof(int64_t) + static_cast<uint64_t>(header.columns) * sizeof(float);
+    NS_ABORT_MSG_IF(header.blockCount != blocks || header.rows > fileSize / rowBytes ||
+                        header.indexOffset !=
+                            sizeof(IrradianceTraceHeader) + header.rows * rowBytes ||
+                        header.indexOffset > fileSize ||
+                        header.blockCount > (fileSize - header.indexOffset) / sizeof(int64_t),
+                    "Irradiance trace " << path << " is truncated or inconsistent");
+}
+
+/**
+ * Split \p line into numbers separated by commas, semicolons or
+ * whitespace.
+ *
+ * \return false if a field is not a number.
+ */
+bool
+ParseCsvLine(const std::string& line, std::vector<double>& fields)
+{
+    fields.clear();
+    const char* p = line.c_str();
+    while (true)
+    {
+        while (*p == ' ' || *p == '\t' || *p == '\r')
+        {
+            ++p;
+        }
+        if (*p == '\0')
+        {
+            return true;
+        }
+        char* end;
+        double v = std::strtod(p, &end);
+        if (end == p)
+        {
+            return false;
+        }
+        fields.push_back(v);
+        p = end;
+        while (*p == ' ' || *p == '\t' || *p == '\r')
+        {
+            ++p;
+        }
+        if (*p == ',' || *p == ';')
+        {
+            ++p;
+        }
+    }
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------
+// IrradianceTraceHeader
+// -------------------------------------------------------------------------
+
+uint64_t
+IrradianceTraceHeader::GetBlockBytes(uint32_t blockRows, uint32_t columns)
+{
+    return static_cast<uint64_t>(blockRows) *
+           (sizeof(int64_t) + static_cast<uint64_t>(columns) * sizeof(float));
+}
+
+bool
+IrradianceTraceHeader::IsValid() const
+{
+    return std::memcmp(magic, IRRADIANCE_TRACE_MAGIC, sizeof(magic)) == 0 &&
+           version == IRRADIANCE_TRACE_VERSION;
+}
+
+// -------------------------------------------------------------------------
+// IrradianceTrace
+// -------------------------------------------------------------------------
+
+Ptr<const IrradianceTrace>
+IrradianceTrace::Open(const std::string& path)
+{
+    NS_LOG_FUNCTION(path);
+    auto& traces = GetOpenTraces();
+    auto it = traces.find(path);
+    if (it != traces.end())
+    {
+        return Ptr<const IrradianceTrace>(it->second);
+    }
+    // Ptr takes the initial reference; the registry only observes it.
+    Ptr<IrradianceTrace> trace = Ptr<IrradianceTrace>(new IrradianceTrace(path), false);
+    traces[path] = PeekPointer(trace);
+    return trace;
+}
+
+IrradianceTrace::IrradianceTrace(const std::string& path)
+    : m_path(path),
+      m_data(nullptr),
+      m_size(0),
+      m_mapped(false)
+{
+    NS_LOG_FUNCTION(this << path);
+#ifndef __WIN32__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot open irradiance trace " << path);
+    struct stat st;
+    NS_ABORT_MSG_IF(::fstat(fd, &st) != 0, "Cannot stat irradiance trace " << path);
+    m_size = static_cast<std::size_t>(st.st_size);
+    if (m_size > 0)
+    {
+        void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        NS_ABORT_MSG_IF(addr == MAP_FAILED, "Cannot map irradiance trace " << path);
+        m_data = static_cast<const uint8_t*>(addr);
+        m_mapped = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    NS_ABORT_MSG_IF(!in, "Cannot open irradiance trace " << path);
+    m_buffer.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#endif
+
+    NS_ABORT_MSG_IF(m_size < sizeof(IrradianceTraceHeader),
+                    "Irradiance trace " << path << " is truncated");
+    std::memcpy(&m_header, m_data, sizeof(m_header));
+    CheckHeader(m_header, m_size, path);
+    NS_LOG_DEBUG(path << ": " << m_header.rows << " rows x " << m_header.columns << " columns in "
+                      << m_header.blockCount << " blocks");
+}
+
+IrradianceTrace::~IrradianceTrace()
+{
+    NS_LOG_FUNCTION(this);
+    GetOpenTraces().erase(m_path);
+#ifndef __WIN32__
+    if (m_mapped)
+    {
+        ::munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+#endif
+}
+
+const std::string&
+IrradianceTrace::GetPath() const
+{
+    return m_path;
+}
+
+uint32_t
+IrradianceTrace::GetNColumns() const
+{
+    return m_header.columns;
+}
+
+uint64_t
+IrradianceTrace::GetNRows() const
+{
+    return m_header.rows;
+}
+
+const IrradianceTraceHeader&
+IrradianceTrace::GetHeader() const
+{
+    return m_header;
+}
+
+const uint8_t*
+IrradianceTrace::GetBlock(uint64_t block) const
+{
+    NS_ASSERT(block < m_header.blockCount);
+    return m_data + sizeof(IrradianceTraceHeader) +
+           block * IrradianceTraceHeader::GetBlockBytes(m_header.blockRows, m_header.columns);
+}
+
+Time
+IrradianceTrace::GetTime(uint64_t row) const
+{
+    NS_ASSERT(row < m_header.rows);
+    uint64_t block = row / m_header.blockRows;
+    uint64_t offset = row % m_header.blockRows;
+    int64_t ns;
+    std::memcpy(&ns, GetBlock(block) + offset * sizeof(int64_t), sizeof(ns));
+    return NanoSeconds(ns);
+}
+
+double
+IrradianceTrace::GetValue(uint64_t row, uint32_t column) const
+{
+    NS_ASSERT(row < m_header.rows && column < m_header.columns);
+    uint64_t block = row / m_header.blockRows;
+    uint64_t offset = row % m_header.blockRows;
+    uint64_t blockRows = (block + 1 == m_header.blockCount)
+                             ? m_header.rows - block * m_header.blockRows
+                             : m_header.blockRows;
+    const uint8_t* values = GetBlock(block) + blockRows * sizeof(int64_t);
+    float wm2;
+    std::memcpy(&wm2, values + (column * blockRows + offset) * sizeof(float), sizeof(wm2));
+    return wm2;
+}
+
+// -------------------------------------------------------------------------
+// IrradianceTraceStream
+// -------------------------------------------------------------------------
+
+namespace
+{
+
+std::map<std::string, IrradianceTraceStream*>&
+GetOpenStreams()
+{
+    static std::map<std::string, IrradianceTraceStream*> streams;
+    return streams;
+}
+
+} // namespace
+
+Ptr<const IrradianceTraceStream>
+IrradianceTraceStream::Open(const std::string& path)
+{
+    NS_LOG_FUNCTION(path);
+    auto& streams = GetOpenStreams();
+    auto it = streams.find(path);
+    if (it != streams.end())
+    {
+        return Ptr<const IrradianceTraceStream>(it->second);
+    }
+    Ptr<IrradianceTraceStream> stream =
+        Ptr<IrradianceTraceStream>(new IrradianceTraceStream(path), false);
+    streams[path] = PeekPointer(stream);
+    return stream;
+}
+
+IrradianceTraceStream::IrradianceTraceStream(const std::string& path)
+    : m_path(path),
+      m_in(path, std::ios::binary),
+      m_cache(CACHED_BLOCKS),
+      m_lastHit(0),
+      m_nextVictim(0),
+      m_reads(0)
+{
+    NS_LOG_FUNCTION(this << path);
+    NS_ABORT_MSG_IF(!m_in, "Cannot open irradiance trace " << path);
+    m_in.seekg(0, std::ios::end);
+    uint64_t size = static_cast<uint64_t>(m_in.tellg());
+    m_in.seekg(0);
+    NS_ABORT_MSG_IF(size < sizeof(IrradianceTraceHeader),
+                    "Irradiance trace " << path << " is truncated");
+    m_in.read(reinterpret_cast<char*>(&m_header), sizeof(m_header));
+    CheckHeader(m_header, size, path);
+
+    m_index.resize(m_header.blockCount);
+    m_in.seekg(m_header.indexOffset);
+    m_in.read(reinterpret_cast<char*>(m_index.data()), m_index.size() * sizeof(int64_t));
+    NS_ABORT_MSG_IF(!m_in, "Cannot read the block index of " << path);
+    for (auto& block : m_cache)
+    {
+        block.index = UINT64_MAX;
+        block.rows = 0;
+    }
+}
+
+IrradianceTraceStream::~IrradianceTraceStream()
+{
+    NS_LOG_FUNCTION(this);
+    GetOpenStreams().erase(m_path);
+}
+
+const std::string&
+IrradianceTraceStream::GetPath() const
+{
+    return m_path;
+}
+
+uint32_t
+IrradianceTraceStream::GetNColumns() const
+{
+    return m_header.columns;
+}
+
+uint64_t
+IrradianceTraceStream::GetNRows() const
+{
+    return m_header.rows;
+}
+
+const IrradianceTraceHeader&
+IrradianceTraceStream::GetHeader() const
+{
+    return m_header;
+}
+
+uint64_t
+IrradianceTraceStream::FindBlock(Time t) const
+{
+    auto it = std::upper_bound(m_index.begin(), m_index.end(), t.GetNanoSeconds());
+    return (it == m_index.begin()) ? 0 : static_cast<uint64_t>(it - m_index.begin()) - 1;
+}
+
+uint64_t
+IrradianceTraceStream::GetNBlockReads() const
+{
+    return m_reads;
+}
+
+const IrradianceTraceStream::Block&
+IrradianceTraceStream::GetBlock(uint64_t row) const
+{
+    NS_ASSERT(row < m_header.rows);
+    uint64_t index = row / m_header.blockRows;
+    NS_ASSERT(index < m_header.blockCount);
+    if (m_cache[m_lastHit].index == index)
+    {
+        return m_cache[m_lastHit];
+    }
+    for (std::size_t slot = 0; slot < m_cache.size(); ++slot)
+    {
+        if (m_cache[slot].index == index)
+        {
+            m_lastHit = slot;
+            return m_cache[slot];
+        }
+    }
+
+    Block& block = m_cache[m_nextVictim];
+    m_lastHit = m_nextVictim;
+    m_nextVictim = (m_nextVictim + 1) % m_cache.size();
+    block.index = index;
+    block.rows = (index + 1 == m_header.blockCount) ? m_header.rows - index * m_header.blockRows
+                                                    : m_header.blockRows;
+    block.times.resize(block.rows);
+    block.values.resize(block.rows * m_header.columns);
+    m_in.seekg(sizeof(IrradianceTraceHeader) +
+               index * IrradianceTraceHeader::GetBlockBytes(m_header.blockRows, m_header.columns));
+    m_in.read(reinterpret_cast<char*>(block.times.data()), block.rows * sizeof(int64_t));
+    m_in.read(reinterpret_cast<char*>(block.values.data()), block.values.size() * sizeof(float));
+    NS_ABORT_MSG_IF(!m_in, "Cannot read block " << index << " of " << m_path);
+    ++m_reads;
+    NS_LOG_DEBUG(m_path << ": read block " << index);
+    return block;
+}
+
+Time
+IrradianceTraceStream::GetTime(uint64_t row) const
+{
+    const Block& block = GetBlock(row);
+    return NanoSeconds(block.times[row % m_header.blockRows]);
+}
+
+double
+IrradianceTraceStream::GetValue(uint64_t row, uint32_t column) const
+{
+    NS_ASSERT(column < m_header.columns);
+    const Block& block = GetBlock(row);
+    return block.values[column * block.rows + row % m_header.blockRows];
+}
+
+// -------------------------------------------------------------------------
+// IrradianceTraceWriter
+// -------------------------------------------------------------------------
+
+IrradianceTraceWriter::IrradianceTraceWriter(const std::string& path,
+                                             uint32_t columns,
+                                             uint32_t blockRows)
+    : m_out(path, std::ios::binary | std::ios::trunc),
+      m_header(),
+      m_closed(false)
+{
+    NS_LOG_FUNCTION(this << path << columns << blockRows);
+    NS_ABORT_MSG_IF(!m_out, "Cannot create irradiance trace " << path);
+    NS_ABORT_MSG_IF(blockRows == 0, "blockRows must be positive");
+    std::memcpy(m_header.magic, IRRADIANCE_TRACE_MAGIC, sizeof(m_header.magic));
+    m_header.version = IRRADIANCE_TRACE_VERSION;
+    m_header.columns = columns;
+    m_header.blockRows = blockRows;
+    m_header.indexOffset = sizeof(IrradianceTraceHeader);
+    // Placeholder; the final header is written by Close().
+    m_out.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_times.reserve(blockRows);
+    m_values.reserve(static_cast<std::size_t>(blockRows) * columns);
+}
+
+IrradianceTraceWriter::~IrradianceTraceWriter()
+{
+    Close();
+}
+
+void
+IrradianceTraceWriter::AddRow(Time t, const std::vector<double>& values)
+{
+    NS_ABORT_MSG_IF(m_closed, "Irradiance trace already closed");
+    NS_ABORT_MSG_IF(values.size() != m_header.columns,
+                    "Expected " << m_header.columns << " values, got " << values.size());
+    int64_t ns = t.GetNanoSeconds();
+    NS_ABORT_MSG_IF(m_header.rows > 0 && ns < m_header.lastTime,
+                    "Irradiance trace rows must be in non-decreasing time order");
+    if (m_header.rows == 0)
+    {
+        m_header.firstTime = ns;
+    }
+    m_header.lastTime = ns;
+    ++m_header.rows;
+    m_times.push_back(ns);
+    for (double v : values)
+    {
+        m_values.push_back(static_cast<float>(v));
+    }
+    if (m_times.size() == m_header.blockRows)
+    {
+        FlushBlock();
+    }
+}
+
+uint64_t
+IrradianceTraceWriter::GetNRows() const
+{
+    return m_header.rows;
+}
+
+void
+IrradianceTraceWriter::FlushBlock()
+{
+    std::size_t n = m_times.size();
+    if (n == 0)
+    {
+        return;
+    }
+    m_index.push_back(m_times.front());
+    m_out.write(reinterpret_cast<const char*>(m_times.data()), n * sizeof(int64_t));
+    // Transpose the row-major buffer into one contiguous run per column.
+    std::vector<float> column(n);
+    for (uint32_t c = 0; c < m_header.columns; ++c)
+    {
+        for (std::size_t r = 0; r < n; ++r)
+        {
+            column[r] = m_values[r * m_header.columns + c];
+        }
+        m_out.write(reinterpret_cast<const char*>(column.data()), n * sizeof(float));
+    }
+    m_header.indexOffset += IrradianceTraceHeader::GetBlockBytes(n, m_header.columns);
+    ++m_header.blockCount;
+    m_times.clear();
+    m_values.clear();
+}
+
+void
+IrradianceTraceWriter::Close()
+{
+    if (m_closed)
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this);
+    FlushBlock();
+    m_out.write(reinterpret_cast<const char*>(m_index.data()), m_index.size() * sizeof(int64_t));
+    m_out.seekp(0);
+    m_out.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_out.close();
+    NS_ABORT_MSG_IF(m_out.fail(), "Failed to write irradiance trace");
+    m_closed = true;
+}
+
+uint64_t
+IrradianceTraceWriter::ConvertCsv(const std::string& csvPath,
+                                  const std::string& tracePath,
+                                  uint32_t blockRows,
+                                  double timeScale)
+{
+    NS_LOG_FUNCTION(csvPath << tracePath << blockRows << timeScale);
+    std::ifstream in(csvPath);
+    NS_ABORT_MSG_IF(!in, "Cannot open CSV irradiance trace " << csvPath);
+
+    // The writer needs the column count, which is only known once the
+    // first data row has been read.
+    std::unique_ptr<IrradianceTraceWriter> writer;
+    std::size_t columns = 0;
+    std::string line;
+    std::vector<double> fields;
+    std::vector<double> values;
+    uint64_t lineNo = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNo;
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        if (!ParseCsvLine(line, fields))
+        {
+            // A header row is tolerated before the first data row.
+            NS_ABORT_MSG_IF(writer,
+                            csvPath << ":" << lineNo << ": non-numeric field in data row");
+            continue;
+        }
+        NS_ABORT_MSG_IF(fields.size() < 2,
+                        csvPath << ":" << lineNo << ": expected a time and at least one value");
+        if (!writer)
+        {
+            columns = fields.size() - 1;
+            writer = std::make_unique<IrradianceTraceWriter>(tracePath,
+                                                             static_cast<uint32_t>(columns),
+                                                             blockRows);
+        }
+        NS_ABORT_MSG_IF(fields.size() - 1 != columns,
+                        csvPath << ":" << lineNo << ": expected " << columns << " values, got "
+                                << fields.size() - 1);
+        values.assign(fields.begin() + 1, fields.end());
+        writer->AddRow(Seconds(fields[0] * timeScale), values);
+    }
+    NS_ABORT_MSG_IF(!writer, csvPath << " contains no data rows");
+    writer->Close();
+    return writer->GetNRows();
+}
+
+} // namespace ns3
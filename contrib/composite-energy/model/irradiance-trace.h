@@ -0,0 +1,262 @@
+#ifndef NS3_IRRADIANCE_TRACE_H
+#define NS3_IRRADIANCE_TRACE_H
+
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief On-disk layout of a binary irradiance trace.
+ *
+ * A trace holds one time column and \c columns irradiance columns (one
+ * per satellite, say), all in the host byte order:
+ *
+ *   header   IrradianceTraceHeader (64 bytes)
+ *   block 0  int64 time[n] (ns), then float32 value[columns][n] (W/m^2)
+ *   block 1  ...
+ *   index    int64 firstTime[blockCount] (ns)
+ *
+ * Every block but the last holds exactly \c blockRows rows, so block b
+ * starts at a computable offset. Within a block each column is
+ * contiguous, so a reader following one column touches consecutive
+ * memory, and a block is the natural unit for reading a trace in chunks.
+ * The index lets such a reader locate the block holding a given time
+ * without touching the blocks themselves.
+ */
+struct IrradianceTraceHeader
+{
+    char magic[8];        //!< "NS3IRRT" followed by a NUL
+    uint32_t version;     //!< Format version, currently 1
+    uint32_t columns;     //!< Irradiance columns per row
+    uint64_t rows;        //!< Total rows
+    uint32_t blockRows;   //!< Rows per block (all blocks but the last)
+    uint32_t reserved;    //!< Zero
+    uint64_t blockCount;  //!< Number of blocks
+    uint64_t indexOffset; //!< File offset of the block index
+    int64_t firstTime;    //!< Time of the first row (ns)
+    int64_t lastTime;     //!< Time of the last row (ns)
+
+    /** \return Size in bytes of a full block of a \p columns-wide trace. */
+    static uint64_t GetBlockBytes(uint32_t blockRows, uint32_t columns);
+
+    /** \return true if the magic and version are those of this format. */
+    bool IsValid() const;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Read-only, shared view of a binary irradiance trace file.
+ *
+ * The file is memory-mapped where the platform allows it (and read into
+ * memory otherwise), so pages are loaded lazily by the operating system
+ * and shared between all readers. Open() returns the same object for
+ * every request for the same path while any reference to it is alive:
+ * hundreds of TraceSolarIrradianceModel instances reading different
+ * columns of one file cost one mapping.
+ *
+ * Row times are non-decreasing; two rows with equal times encode a step.
+ */
+class IrradianceTrace : public SimpleRefCount<IrradianceTrace>
+{
+  public:
+    /**
+     * \brief Open (or share) the trace stored at \p path.
+     *
+     * Aborts if the file cannot be read or is not a valid trace.
+     */
+    static Ptr<const IrradianceTrace> Open(const std::string& path);
+
+    ~IrradianceTrace();
+
+    /** \return Path the trace was opened from. */
+    const std::string& GetPath() const;
+
+    /** \return Number of irradiance columns. */
+    uint32_t GetNColumns() const;
+
+    /** \return Number of rows. */
+    uint64_t GetNRows() const;
+
+    /** \return Time of row \p row. */
+    Time GetTime(uint64_t row) const;
+
+    /** \return Irradiance (W/m^2) of column \p column at row \p row. */
+    double GetValue(uint64_t row, uint32_t column) const;
+
+    /** \return File header. */
+    const IrradianceTraceHeader& GetHeader() const;
+
+  private:
+    IrradianceTrace(const std::string& path);
+
+    /** \return Start of block \p block in the mapped file. */
+    const uint8_t* GetBlock(uint64_t block) const;
+
+    std::string m_path;
+    IrradianceTraceHeader m_header;
+    const uint8_t* m_data;         // start of the mapping (or of m_buffer)
+    std::size_t m_size;            // mapped length in bytes
+    bool m_mapped;                 // m_data is an mmap() region
+    std::vector<uint8_t> m_buffer; // storage when mmap is unavailable
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Shared, block-cached streaming reader of a binary irradiance
+ *        trace.
+ *
+ * The alternative to IrradianceTrace when the trace should not be
+ * mapped: resident memory is bounded by a few blocks whatever the trace
+ * length. Only the header and the block index are read when the file is
+ * opened; blocks are read on first access and kept in a small cache that
+ * evicts the least recently loaded block, so as the simulation clock
+ * advances the reader pages forward through the file one block at a
+ * time. As with IrradianceTrace, Open() shares one reader (and one
+ * cache) between all users of a path, and since satellites following
+ * different columns advance together they hit the same cached blocks.
+ */
+class IrradianceTraceStream : public SimpleRefCount<IrradianceTraceStream>
+{
+  public:
+    /** Number of blocks kept in memory. */
+    static constexpr std::size_t CACHED_BLOCKS = 4;
+
+    /**
+     * \brief Open (or share) the trace stored at \p path.
+     *
+     * Aborts if the file cannot be read or is not a valid trace.
+     */
+    static Ptr<const IrradianceTraceStream> Open(const std::string& path);
+
+    ~IrradianceTraceStream();
+
+    /** \return Path the trace was opened from. */
+    const std::string& GetPath() const;
+
+    /** \return Number of irradiance columns. */
+    uint32_t GetNColumns() const;
+
+    /** \return Number of rows. */
+    uint64_t GetNRows() const;
+
+    /** \return Time of row \p row. */
+    Time GetTime(uint64_t row) const;
+
+    /** \return Irradiance (W/m^2) of column \p column at row \p row. */
+    double GetValue(uint64_t row, uint32_t column) const;
+
+    /** \return File header. */
+    const IrradianceTraceHeader& GetHeader() const;
+
+    /**
+     * \return Index of the last block starting at or before \p t (0 if
+     *         \p t precedes the trace), found from the in-memory index.
+     */
+    uint64_t FindBlock(Time t) const;
+
+    /** \return Number of blocks read from disk so far. */
+    uint64_t GetNBlockReads() const;
+
+  private:
+    IrradianceTraceStream(const std::string& path);
+
+    /** One cached block, all columns. */
+    struct Block
+    {
+        uint64_t index;             //!< Block number, or UINT64_MAX if empty
+        uint64_t rows;              //!< Rows in the block
+        std::vector<int64_t> times; //!< Row times (ns)
+        std::vector<float> values;  //!< Values, column by column
+    };
+
+    /** \return The cached block holding \p row, reading it if needed. */
+    const Block& GetBlock(uint64_t row) const;
+
+    std::string m_path;
+    IrradianceTraceHeader m_header;
+    std::vector<int64_t> m_index; // first time of every block
+    mutable std::ifstream m_in;
+    mutable std::vector<Block> m_cache;
+    mutable std::size_t m_lastHit;    // slot of the last block accessed
+    mutable std::size_t m_nextVictim; // slot the next read replaces
+    mutable uint64_t m_reads;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Writes a binary irradiance trace (see IrradianceTraceHeader).
+ *
+ * Rows are appended in time order and buffered one block at a time, so
+ * arbitrarily long traces can be written in constant memory. Close()
+ * (or the destructor) flushes the last block and writes the index.
+ */
+class IrradianceTraceWriter
+{
+  public:
+    /**
+     * \param path Output file, truncated if it exists.
+     * \param columns Irradiance columns per row.
+     * \param blockRows Rows per block.
+     */
+    IrradianceTraceWriter(const std::string& path, uint32_t columns, uint32_t blockRows = 4096);
+    ~IrradianceTraceWriter();
+
+    /**
+     * \brief Append a row.
+     *
+     * \param t Row time; must not precede the previous row.
+     * \param values One irradiance value (W/m^2) per column.
+     */
+    void AddRow(Time t, const std::vector<double>& values);
+
+    /** \return Rows written so far. */
+    uint64_t GetNRows() const;
+
+    /** Flush the pending block, write the index and close the file. */
+    void Close();
+
+    /**
+     * \brief Convert a CSV irradiance trace into the binary format.
+     *
+     * Each data row holds a time followed by one value per column,
+     * separated by commas, semicolons or whitespace. Blank lines, lines
+     * starting with '#' and a header row before the first data row are
+     * skipped. The CSV is streamed, so memory use does not depend on its
+     * length. Aborts on malformed input.
+     *
+     * \param csvPath Input CSV file.
+     * \param tracePath Output binary trace.
+     * \param blockRows Rows per block of the output.
+     * \param timeScale Factor converting the CSV time column to seconds.
+     * \return Number of rows converted.
+     */
+    static uint64_t ConvertCsv(const std::string& csvPath,
+                               const std::string& tracePath,
+                               uint32_t blockRows = 4096,
+                               double timeScale = 1.0);
+
+  private:
+    /** Write the buffered rows as one block. */
+    void FlushBlock();
+
+    std::ofstream m_out;
+    IrradianceTraceHeader m_header;
+    std::vector<int64_t> m_times; // pending block times
+    std::vector<float> m_values;  // pending block values, row-major
+    std::vector<int64_t> m_index; // first time of every written block
+    bool m_closed;
+};
+
+} // namespace ns3
+
+#endif // NS3_IRRADIANCE_TRACE_H
@@ -0,0 +1,147 @@
+#include "li-ion-cell-model.h"
+
+#include "ns3/double.h"
+#include "ns3/li-ion-energy-source.h"
+#include "ns3/log.h"
+
+#include <cmath>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LiIonCellModel");
+
+LiIonCellModel::LiIonCellModel()
+{
+    // Defaults mirror the LiIonEnergySource attribute defaults.
+    Configure(4.05, 3.6, 3.6, 2.45, 1.1, 1.2, 0.083, 2.33);
+}
+
+void
+LiIonCellModel::Configure(double eFull,
+                          double eNom,
+                          double eExp,
+                          double qRated,
+                          double qNom,
+                          double qExp,
+                          double resistanceOhm,
+                          double typCurrentA)
+{
+    NS_LOG_FUNCTION(this << eFull << eNom << eExp << qRated << qNom << qExp << resistanceOhm
+                         << typCurrentA);
+    m_qRated = qRated;
+    m_a = eFull - eExp;
+    m_b = 3.0 / qExp;
+    m_k = std::abs((eFull - eNom + m_a * (std::exp(-m_b * qNom) - 1.0)) * (qRated - qNom) / qNom);
+    m_r = resistanceOhm;
+    m_e0 = eFull + m_k + resistanceOhm * typCurrentA - m_a;
+}
+
+void
+LiIonCellModel::ConfigureFrom(Ptr<const LiIonEnergySource> source)
+{
+    NS_LOG_FUNCTION(this << source);
+    DoubleValue eFull;
+    DoubleValue eNom;
+    DoubleValue eExp;
+    DoubleValue qRated;
+    DoubleValue qNom;
+    DoubleValue qExp;
+    DoubleValue resistance;
+    DoubleValue typCurrent;
+    source->GetAttribute("InitialCellVoltage", eFull);
+    source->GetAttribute("NominalCellVoltage", eNom);
+    source->GetAttribute("ExpCellVoltage", eExp);
+    source->GetAttribute("RatedCapacity", qRated);
+    source->GetAttribute("NomCapacity", qNom);
+    source->GetAttribute("ExpCapacity", qExp);
+    source->GetAttribute("InternalResistance", resistance);
+    source->GetAttribute("TypCurrent", typCurrent);
+    Configure(eFull.Get(),
+              eNom.Get(),
+              eExp.Get(),
+              qRated.Get(),
+              qNom.Get(),
+              qExp.Get(),
+              resistance.Get(),
+              typCurrent.Get());
+}
+
+double
+LiIonCellModel::GetRatedCapacity() const
+{
+    return m_qRated;
+}
+
+double
+LiIonCellModel::GetResistance() const
+{
+    return m_r;
+}
+
+double
+LiIonCellModel::GetVoltage(double drainedAh, double currentA) const
+{
+    return m_e0 - m_k * m_qRated / (m_qRated - drainedAh) + m_a * std::exp(-m_b * drainedAh) -
+           m_r * currentA;
+}
+
+double
+LiIonCellModel::GetMeanVoltage(double fromAh, double toAh, double currentA) const
+{
+    double dq = toAh - fromAh;
+    if (dq == 0.0)
+    {
+        return GetVoltage(fromAh, currentA);
+    }
+    double integral = m_e0 * dq +
+                      m_k * m_qRated * std::log1p(-dq / (m_qRated - fromAh)) -
+                      m_a / m_b * std::exp(-m_b * fromAh) * std::expm1(-m_b * dq);
+    return integral / dq - m_r * currentA;
+}
+
+double
+LiIonCellModel::GetDrainedCapacity(double voltageV, double currentA) const
+{
+    // At a constant current V(q) is strictly decreasing on (-inf, Q_rated)
+    // and diverges to -inf at Q_rated, so an upper bracket is always
+    // available. The lower bracket is found by expanding into the
+    // over-charged region; with E_exp == E_full the curve saturates and
+    // very high voltages are unreachable.
+    auto voltageAt = [this, currentA](double q) { return GetVoltage(q, currentA); };
+    double hi = m_qRated * (1.0 - 1e-9);
+    if (voltageAt(hi) >= voltageV)
+    {
+        return hi;
+    }
+    double lo = std::min(0.0, hi);
+    double step = (m_qRated > 0.0) ? m_qRated : 1.0;
+    for (int i = 0; voltageAt(lo) < voltageV; ++i)
+    {
+        if (i == 64)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        hi = lo;
+        lo -= step;
+        step *= 2.0;
+    }
+    for (int i = 0; i < 200 && hi - lo > 1e-15 * std::max(1.0, std::abs(lo)); ++i)
+    {
+        double mid = 0.5 * (lo + hi);
+        if (voltageAt(mid) >= voltageV)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    // Return the bracket end on the "voltage reached" side so that a
+    // prediction built on it never fires before the crossing.
+    return lo;
+}
+
+} // namespace ns3
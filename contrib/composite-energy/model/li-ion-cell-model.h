@@ -0,0 +1,117 @@
+#ifndef NS3_LI_ION_CELL_MODEL_H
+#define NS3_LI_ION_CELL_MODEL_H
+
+#include "ns3/ptr.h"
+
+namespace ns3
+{
+
+class LiIonEnergySource;
+
+/**
+ * \ingroup composite-energy
+ * \brief Replica of the Shepherd voltage curve used by LiIonEnergySource.
+ *
+ * LiIonEnergySource keeps both its drained-capacity integral and its
+ * voltage function private. CompositeEnergySource mirrors the integral
+ * (it sees every UpdateEnergySource() call) and uses this helper to
+ * answer questions the base class cannot: what the cell voltage will be
+ * after a given charge has flowed, and how much charge must flow before
+ * a given voltage is reached.
+ *
+ * The curve is the one implemented by LiIonEnergySource::GetVoltage():
+ *
+ *   E(q)    = E_full + K + R * I_typ - A - K * Q_rated / (Q_rated - q) + A * exp(-B * q)
+ *   V(q, i) = E(q) - R * i
+ *
+ * with A = E_full - E_exp, B = 3 / Q_exp, K the polarization slope, R the
+ * internal resistance, I_typ the typical current and i the total current
+ * drawn from the cell (negative while charging). The base class reads V
+ * at each update with the current of the span it has just integrated.
+ * E is strictly decreasing in the drained capacity q (Ah). Results are
+ * only used as scheduling hints; callers always re-check the real supply
+ * voltage when the predicted instant arrives.
+ */
+class LiIonCellModel
+{
+  public:
+    LiIonCellModel();
+
+    /**
+     * \brief Set the Shepherd parameters explicitly.
+     *
+     * \param eFull Fully-charged cell voltage (V).
+     * \param eNom Nominal cell voltage (V).
+     * \param eExp Voltage at the end of the exponential zone (V).
+     * \param qRated Rated capacity (Ah).
+     * \param qNom Capacity at the end of the nominal zone (Ah).
+     * \param qExp Capacity at the end of the exponential zone (Ah).
+     * \param resistanceOhm Internal resistance (Ohm).
+     * \param typCurrentA Typical discharge current (A).
+     */
+    void Configure(double eFull,
+                   double eNom,
+                   double eExp,
+                   double qRated,
+                   double qNom,
+                   double qExp,
+                   double resistanceOhm,
+                   double typCurrentA);
+
+    /**
+     * \brief Read the Shepherd parameters from a LiIonEnergySource's
+     *        attributes.
+     *
+     * Must be called before the source has integrated any current, since
+     * the InitialCellVoltage attribute reads back the live supply voltage.
+     */
+    void ConfigureFrom(Ptr<const LiIonEnergySource> source);
+
+    /** \return Rated capacity (Ah). */
+    double GetRatedCapacity() const;
+
+    /** \return Internal resistance (Ohm). */
+    double GetResistance() const;
+
+    /**
+     * \return Cell voltage (V) after \p drainedAh has been drawn, while a
+     *         total current \p currentA flows.
+     */
+    double GetVoltage(double drainedAh, double currentA) const;
+
+    /**
+     * \return Drained capacity (Ah) at which the cell voltage equals
+     *         \p voltageV while a total current \p currentA flows, or NaN
+     *         if the curve never reaches it.
+     */
+    double GetDrainedCapacity(double voltageV, double currentA) const;
+
+    /**
+     * \brief Mean cell voltage while the drained capacity moves from
+     *        \p fromAh to \p toAh at the constant current \p currentA.
+     *
+     * Taken from the closed-form integral of the curve,
+     *
+     *   int E dq = (E_full + K + R I_typ - A) q + K Q_rated ln(Q_rated - q) - A/B exp(-B q),
+     *
+     * with every term written in the difference \p toAh - \p fromAh
+     * (log1p, expm1), so short spans keep full precision, less the
+     * constant drop R * \p currentA.
+     *
+     * \return Mean voltage (V); V(\p fromAh, \p currentA) when the two
+     *         are equal.
+     */
+    double GetMeanVoltage(double fromAh, double toAh, double currentA) const;
+
+  private:
+    double m_qRated;
+    double m_a;  // E_full - E_exp
+    double m_b;  // 3 / Q_exp
+    double m_k;  // polarization slope
+    double m_r;  // internal resistance
+    double m_e0; // E_full + K + R * I_typ - A
+};
+
+} // namespace ns3
+
+#endif // NS3_LI_ION_CELL_MODEL_H
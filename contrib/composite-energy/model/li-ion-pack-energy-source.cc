@@ -0,0 +1,570 @@
+#include "li-ion-pack-energy-source.h"
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LiIonPackEnergySource");
+NS_OBJECT_ENSURE_REGISTERED(LiIonPackEnergySource);
+
+TypeId
+LiIonPackEnergySource::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::LiIonPackEnergySource")
+            .SetParent<EnergySource>()
+            .SetGroupName("Energy")
+            .AddConstructor<LiIonPackEnergySource>()
+            .AddAttribute("SeriesCells",
+                          "Number of cell groups in series.",
+                          UintegerValue(4),
+                          MakeUintegerAccessor(&LiIonPackEnergySource::m_seriesCells),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("ParallelCells",
+                          "Number of cells in parallel in each group.",
+                          UintegerValue(2),
+                          MakeUintegerAccessor(&LiIonPackEnergySource::m_parallelCells),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("CellCapacityAh",
+                          "Capacity (Ah) the cells are laid out with.",
+                          DoubleValue(2.45),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_cellCapacityAh),
+                          MakeDoubleChecker<double>(1e-9))
+            .AddAttribute("CellResistanceOhm",
+                          "Internal resistance (Ohm) at ReferenceTemperatureC the cells are "
+                          "laid out with.",
+                          DoubleValue(0.05),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_cellResistanceOhm),
+                          MakeDoubleChecker<double>(1e-9))
+            .AddAttribute("InitialSoc",
+                          "State of charge, in [0,1], the cells are laid out with.",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_initialSoc),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("NominalCellVoltageV",
+                          "Cell voltage (V) the remaining energy is counted at.",
+                          DoubleValue(3.6),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_nominalCellVoltageV),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("CellCutoffVoltageV",
+                          "Cell terminal voltage (V) at which the pack is drained.",
+                          DoubleValue(3.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_cutoffVoltageV),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("AmbientTemperatureC",
+                          "Temperature (degrees C) the cells start at and cool to.",
+                          DoubleValue(25.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_ambientTemperatureC),
+                          MakeDoubleChecker<double>(-273.15))
+            .AddAttribute("ReferenceTemperatureC",
+                          "Temperature (degrees C) at which the cell resistances are given.",
+                          DoubleValue(25.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_referenceTemperatureC),
+                          MakeDoubleChecker<double>(-273.15))
+            .AddAttribute("ResistanceTemperatureCoefficient",
+                          "Relative rise of a cell's resistance per kelvin below "
+                          "ReferenceTemperatureC (1/K). The resistance never falls below "
+                          "half its reference value.",
+                          DoubleValue(0.01),
+                          MakeDoubleAccessor(
+                              &LiIonPackEnergySource::m_resistanceTemperatureCoefficient),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("ThermalResistanceKPerW",
+                          "Thermal resistance (K/W) from a cell to the ambient.",
+                          DoubleValue(5.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_thermalResistanceKPerW),
+                          MakeDoubleChecker<double>(1e-9))
+            .AddAttribute("ThermalCapacitanceJPerK",
+                          "Heat capacity (J/K) of a cell.",
+                          DoubleValue(40.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_thermalCapacitanceJPerK),
+                          MakeDoubleChecker<double>(1e-9))
+            .AddAttribute("Balancing",
+                          "Cell balancing policy. Passive bleeds the cells more than "
+                          "BalanceThreshold above the emptiest one; Active moves charge from "
+                          "the cells above the mean state of charge to those below it.",
+                          EnumValue(LiIonPackEnergySource::NO_BALANCING),
+                          MakeEnumAccessor<BalancingPolicy>(&LiIonPackEnergySource::m_balancing),
+                          MakeEnumChecker(LiIonPackEnergySource::NO_BALANCING,
+                                          "None",
+                                          LiIonPackEnergySource::PASSIVE,
+                                          "Passive",
+                                          LiIonPackEnergySource::ACTIVE,
+                                          "Active"))
+            .AddAttribute("BalanceThreshold",
+                          "State-of-charge spread above which the cells are balanced.",
+                          DoubleValue(0.01),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_balanceThreshold),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("BalanceCurrentA",
+                          "Largest balancing current (A) of a cell.",
+                          DoubleValue(0.1),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_balanceCurrentA),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("BalanceEfficiency",
+                          "Fraction, in [0,1], of the charge moved by Active balancing that "
+                          "reaches the receiving cells.",
+                          DoubleValue(0.9),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_balanceEfficiency),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("PeriodicEnergyUpdateInterval",
+                          "Time between two updates of the cells.",
+                          TimeValue(Seconds(1.0)),
+                          MakeTimeAccessor(&LiIonPackEnergySource::m_energyUpdateInterval),
+                          MakeTimeChecker())
+            .AddAttribute("IrradianceModel",
+                          "Optional SolarIrradianceModel charging the pack. Leave unset for "
+                          "a pack without a panel.",
+                          PointerValue(),
+                          MakePointerAccessor(&LiIonPackEnergySource::m_irradianceModel),
+                          MakePointerChecker<SolarIrradianceModel>())
+            .AddAttribute("PanelAreaM2",
+                          "Solar panel area (m^2).",
+                          DoubleValue(2.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_panelAreaM2),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("PanelEfficiency",
+                          "Panel conversion efficiency, in [0,1].",
+                          DoubleValue(0.28),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_panelEfficiency),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("ChargeEfficiency",
+                          "Fraction, in [0,1], of the panel power that reaches the cells.",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&LiIonPackEnergySource::m_chargeEfficiency),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddTraceSource("RemainingEnergy",
+                            "Remaining energy of the pack (J).",
+                            MakeTraceSourceAccessor(&LiIonPackEnergySource::m_remainingEnergyJ),
+                            "ns3::TracedValueCallback::Double");
+    return tid;
+}
+
+LiIonPackEnergySource::LiIonPackEnergySource()
+    : m_seriesCells(4),
+      m_parallelCells(2),
+      m_cellCapacityAh(2.45),
+      m_cellResistanceOhm(0.05),
+      m_initialSoc(1.0),
+      m_nominalCellVoltageV(3.6),
+      m_cutoffVoltageV(3.0),
+      m_ambientTemperatureC(25.0),
+      m_referenceTemperatureC(25.0),
+      m_resistanceTemperatureCoefficient(0.01),
+      m_thermalResistanceKPerW(5.0),
+      m_thermalCapacitanceJPerK(40.0),
+      m_balancing(NO_BALANCING),
+      m_balanceThreshold(0.01),
+      m_balanceCurrentA(0.1),
+      m_balanceEfficiency(0.9),
+      m_energyUpdateInterval(Seconds(1.0)),
+      m_panelAreaM2(2.0),
+      m_panelEfficiency(0.28),
+      m_chargeEfficiency(1.0),
+      m_initialEnergyJ(0.0),
+      m_packVoltageV(0.0),
+      m_headroomAh(0.0),
+      m_balancedAh(0.0),
+      m_drained(false),
+      m_lastUpdate(Seconds(0)),
+      m_harvester(CreateObject<SolarHarvesterDeviceModel>()),
+      m_remainingEnergyJ(0.0)
+{
+    NS_LOG_FUNCTION(this);
+    m_cellModel.Configure(4.05, 3.6, 3.6, 2.45, 1.1, 1.2, 0.0, 0.0);
+}
+
+LiIonPackEnergySource::~LiIonPackEnergySource()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+double
+LiIonPackEnergySource::GetInitialEnergy() const
+{
+    if (m_capacityAh.empty())
+    {
+        return m_seriesCells * m_parallelCells * m_cellCapacityAh * 3600.0 *
+               m_nominalCellVoltageV;
+    }
+    return m_initialEnergyJ;
+}
+
+double
+LiIonPackEnergySource::GetSupplyVoltage() const
+{
+    return m_packVoltageV;
+}
+
+double
+LiIonPackEnergySource::GetRemainingEnergy()
+{
+    NS_LOG_FUNCTION(this);
+    UpdateEnergySource();
+    return m_remainingEnergyJ;
+}
+
+double
+LiIonPackEnergySource::GetEnergyFraction()
+{
+    NS_LOG_FUNCTION(this);
+    double initialJ = GetInitialEnergy();
+    return initialJ > 0.0 ? GetRemainingEnergy() / initialJ : 0.0;
+}
+
+void
+LiIonPackEnergySource::UpdateEnergySource()
+{
+    NS_LOG_FUNCTION(this);
+    if (Simulator::IsFinished())
+    {
+        return;
+    }
+    Simulator::Cancel(m_energyUpdateEvent);
+    LayOutCells();
+
+    Time now = Simulator::Now();
+    double seconds = (now - m_lastUpdate).GetSeconds();
+    if (seconds > 0.0)
+    {
+        // Deliver the energy harvested since the previous update, at the
+        // pack voltage and headroom of that update, then carry the cells
+        // over the span at the resulting pack current.
+        double v = m_packVoltageV;
+        double loadA = CalculateTotalCurrent() + m_harvester->GetHarvestCurrentA();
+        m_harvester->Settle(m_lastUpdate, v, m_headroomAh * 3600.0 * v, loadA * v);
+        Step(seconds, CalculateTotalCurrent());
+        m_lastUpdate = now;
+    }
+    if (m_irradianceModel)
+    {
+        // Settle() stops at a full cell; resume once every cell has room.
+        m_harvester->SetHarvestEnabled(m_headroomAh > 0.0);
+    }
+
+    double remainingJ = 0.0;
+    for (std::size_t i = 0; i < m_soc.size(); ++i)
+    {
+        remainingJ += m_soc[i] * m_capacityAh[i];
+    }
+    m_remainingEnergyJ = remainingJ * 3600.0 * m_nominalCellVoltageV;
+    CheckDrained();
+
+    m_energyUpdateEvent = Simulator::Schedule(m_energyUpdateInterval,
+                                              &LiIonPackEnergySource::UpdateEnergySource,
+                                              this);
+}
+
+uint32_t
+LiIonPackEnergySource::GetNCells() const
+{
+    return m_seriesCells * m_parallelCells;
+}
+
+void
+LiIonPackEnergySource::SetCellState(uint32_t i, double soc, double capacityAh, double resistanceOhm)
+{
+    NS_LOG_FUNCTION(this << i << soc << capacityAh << resistanceOhm);
+    LayOutCells();
+    NS_ABORT_MSG_IF(i >= m_soc.size(), "No cell " << i << " in a pack of " << m_soc.size());
+    NS_ABORT_MSG_IF(soc < 0.0 || soc > 1.0, "State of charge " << soc << " not in [0,1]");
+    NS_ABORT_MSG_IF(!(capacityAh > 0.0) || !(resistanceOhm > 0.0),
+                    "Cell capacity and resistance must be positive");
+    m_initialEnergyJ += (capacityAh - m_capacityAh[i]) * 3600.0 * m_nominalCellVoltageV;
+    m_soc[i] = soc;
+    m_capacityAh[i] = capacityAh;
+    m_resistanceOhm[i] = resistanceOhm;
+    SolveCurrents(0.0);
+}
+
+LiIonPackEnergySource::CellState
+LiIonPackEnergySource::GetCellState(uint32_t i) const
+{
+    NS_ABORT_MSG_IF(i >= m_soc.size(), "No cell " << i << " in a pack of " << m_soc.size());
+    CellState cell;
+    cell.soc = m_soc[i];
+    cell.capacityAh = m_capacityAh[i];
+    cell.resistanceOhm = m_resistanceOhm[i];
+    cell.temperatureC = m_temperatureC[i];
+    cell.currentA = m_currentA[i];
+    cell.voltageV = m_groupV[i / m_parallelCells];
+    return cell;
+}
+
+double
+LiIonPackEnergySource::GetSocSpread() const
+{
+    if (m_soc.empty())
+    {
+        return 0.0;
+    }
+    auto range = std::minmax_element(m_soc.begin(), m_soc.end());
+    return *range.second - *range.first;
+}
+
+double
+LiIonPackEnergySource::GetTotalHarvestedEnergy() const
+{
+    return m_harvester ? m_harvester->GetTotalHarvestedEnergy() : 0.0;
+}
+
+double
+LiIonPackEnergySource::GetBalancedCharge() const
+{
+    return m_balancedAh;
+}
+
+void
+LiIonPackEnergySource::DoInitialize()
+{
+    NS_LOG_FUNCTION(this);
+    LayOutCells();
+    if (m_irradianceModel)
+    {
+        // Attach the harvester as a device so that its (negative) current
+        // is part of the pack current.
+        m_harvester->SetEnergySource(this);
+        AppendDeviceEnergyModel(m_harvester);
+        m_harvester->SetHarvestProfile(m_irradianceModel,
+                                       m_panelAreaM2 * m_panelEfficiency * m_chargeEfficiency);
+        m_harvester->SetHarvestEnabled(m_headroomAh > 0.0);
+    }
+    // Scheduled here rather than by UpdateEnergySource(), which does
+    // nothing while the event queue is still empty.
+    m_lastUpdate = Simulator::Now();
+    m_energyUpdateEvent = Simulator::Schedule(m_energyUpdateInterval,
+                                              &LiIonPackEnergySource::UpdateEnergySource,
+                                              this);
+    EnergySource::DoInitialize();
+}
+
+void
+LiIonPackEnergySource::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_energyUpdateEvent);
+    if (m_harvester)
+    {
+        m_harvester->Dispose();
+        m_harvester = nullptr;
+    }
+    m_irradianceModel = nullptr;
+    EnergySource::DoDispose();
+}
+
+void
+LiIonPackEnergySource::LayOutCells()
+{
+    if (!m_soc.empty())
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this);
+    std::size_t n = GetNCells();
+    m_soc.assign(n, m_initialSoc);
+    m_capacityAh.assign(n, m_cellCapacityAh);
+    m_resistanceOhm.assign(n, m_cellResistanceOhm);
+    m_temperatureC.assign(n, m_ambientTemperatureC);
+    m_currentA.assign(n, 0.0);
+    m_openCircuitV.assign(n, 0.0);
+    m_conductanceS.assign(n, 0.0);
+    m_groupV.assign(m_seriesCells, 0.0);
+    m_initialEnergyJ = n * m_cellCapacityAh * 3600.0 * m_nominalCellVoltageV;
+    SolveCurrents(0.0);
+    m_remainingEnergyJ = m_initialSoc * m_initialEnergyJ;
+}
+
+// ---------------------------------------------------------------------------
+// Cell update
+// ---------------------------------------------------------------------------
+
+void
+LiIonPackEnergySource::SolveCurrents(double packA)
+{
+    std::size_t n = m_soc.size();
+    const double* soc = m_soc.data();
+    const double* capacityAh = m_capacityAh.data();
+    const double* resistanceOhm = m_resistanceOhm.data();
+    const double* temperatureC = m_temperatureC.data();
+    double* currentA = m_currentA.data();
+    double* openCircuitV = m_openCircuitV.data();
+    double* conductanceS = m_conductanceS.data();
+
+    // Every cell follows the default Shepherd curve, read at its drained
+    // fraction; the curve diverges at the rated capacity, so an empty cell
+    // is read just short of it. The model carries no resistance: the
+    // cells' own resistances apply below.
+    double ratedAh = m_cellModel.GetRatedCapacity();
+    double lastAh = ratedAh * (1.0 - 1e-9);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double drainedAh = std::min((1.0 - soc[i]) * ratedAh, lastAh);
+        openCircuitV[i] = m_cellModel.GetVoltage(drainedAh, 0.0);
+    }
+
+    // These loops run over plain arrays without branches so that they
+    // vectorize.
+    double alpha = m_resistanceTemperatureCoefficient;
+    double referenceC = m_referenceTemperatureC;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double factor = std::max(0.5, 1.0 + alpha * (referenceC - temperatureC[i]));
+        conductanceS[i] = 1.0 / (resistanceOhm[i] * factor);
+    }
+
+    // Each group: the common terminal voltage, the cell currents, and the
+    // charge the group takes before its first cell is full, each cell
+    // taking its conductance's share of a charge.
+    uint32_t p = m_parallelCells;
+    double packV = 0.0;
+    double headroomAh = std::numeric_limits<double>::infinity();
+    for (uint32_t s = 0; s < m_seriesCells; ++s)
+    {
+        std::size_t first = static_cast<std::size_t>(s) * p;
+        double sumS = 0.0;
+        double sumA = 0.0;
+        for (std::size_t i = first; i < first + p; ++i)
+        {
+            sumS += conductanceS[i];
+            sumA += conductanceS[i] * openCircuitV[i];
+        }
+        double groupV = (sumA - packA) / sumS;
+        for (std::size_t i = first; i < first + p; ++i)
+        {
+            currentA[i] = (openCircuitV[i] - groupV) * conductanceS[i];
+            headroomAh = std::min(headroomAh,
+                                  (1.0 - soc[i]) * capacityAh[i] * sumS / conductanceS[i]);
+        }
+        m_groupV[s] = groupV;
+        packV += groupV;
+    }
+    m_packVoltageV = packV;
+    m_headroomAh = headroomAh;
+}
+
+void
+LiIonPackEnergySource::Step(double seconds, double packA)
+{
+    NS_LOG_FUNCTION(this << seconds << packA);
+    SolveCurrents(packA);
+
+    std::size_t n = m_soc.size();
+    double* soc = m_soc.data();
+    double* temperatureC = m_temperatureC.data();
+    const double* capacityAh = m_capacityAh.data();
+    const double* currentA = m_currentA.data();
+    const double* conductanceS = m_conductanceS.data();
+
+    // Charge, and the exact first-order response of the temperature to
+    // the I^2 R heat over the span; all cells share the time constant.
+    double hours = seconds / 3600.0;
+    double ambientC = m_ambientTemperatureC;
+    double thermalR = m_thermalResistanceKPerW;
+    double decay = std::exp(-seconds / (thermalR * m_thermalCapacitanceJPerK));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        soc[i] = std::min(1.0, std::max(0.0, soc[i] - currentA[i] * hours / capacityAh[i]));
+        double steadyC = ambientC + currentA[i] * currentA[i] / conductanceS[i] * thermalR;
+        temperatureC[i] = steadyC + (temperatureC[i] - steadyC) * decay;
+    }
+
+    Balance(seconds);
+    SolveCurrents(packA);
+}
+
+void
+LiIonPackEnergySource::Balance(double seconds)
+{
+    std::size_t n = m_soc.size();
+    if (m_balancing == NO_BALANCING || n < 2)
+    {
+        return;
+    }
+    double* soc = m_soc.data();
+    const double* capacityAh = m_capacityAh.data();
+    double lowest = soc[0];
+    double highest = soc[0];
+    double chargeAh = 0.0;
+    double totalAh = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        lowest = std::min(lowest, soc[i]);
+        highest = std::max(highest, soc[i]);
+        chargeAh += soc[i] * capacityAh[i];
+        totalAh += capacityAh[i];
+    }
+    double threshold = m_balanceThreshold;
+    if (highest - lowest <= threshold)
+    {
+        return;
+    }
+
+    double limitAh = m_balanceCurrentA * seconds / 3600.0;
+    double movedAh = 0.0;
+    if (m_balancing == PASSIVE)
+    {
+        // Bleed each cell above the band, down to the emptiest at most.
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            double excess = soc[i] - lowest;
+            double bledAh = (excess > threshold) * std::min(limitAh, excess * capacityAh[i]);
+            soc[i] -= bledAh / capacityAh[i];
+            movedAh += bledAh;
+        }
+    }
+    else
+    {
+        // Move every cell toward the capacity-weighted mean, so that the
+        // donors give exactly what the receivers are owed; the cell
+        // furthest from it runs at the balancing current.
+        double meanSoc = chargeAh / totalAh;
+        double furthestAh = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            furthestAh = std::max(furthestAh, std::abs(soc[i] - meanSoc) * capacityAh[i]);
+        }
+        double share = std::min(1.0, limitAh / furthestAh);
+        double efficiency = m_balanceEfficiency;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            double givenAh = share * (soc[i] - meanSoc) * capacityAh[i];
+            soc[i] -= givenAh * (givenAh > 0.0 ? 1.0 : efficiency) / capacityAh[i];
+            movedAh += std::max(givenAh, 0.0);
+        }
+    }
+    m_balancedAh += movedAh;
+}
+
+void
+LiIonPackEnergySource::CheckDrained()
+{
+    auto lowestSoc = std::min_element(m_soc.begin(), m_soc.end());
+    auto lowestV = std::min_element(m_groupV.begin(), m_groupV.end());
+    bool empty = *lowestSoc <= 0.0 || *lowestV <= m_cutoffVoltageV;
+    if (!m_drained && empty)
+    {
+        NS_LOG_DEBUG("Pack drained at " << m_packVoltageV << " V");
+        m_drained = true;
+        NotifyEnergyDrained();
+    }
+    else if (m_drained && *lowestSoc > 0.0 && CalculateTotalCurrent() < 0.0 &&
+             *std::min_element(m_openCircuitV.begin(), m_openCircuitV.end()) > m_cutoffVoltageV)
+    {
+        NS_LOG_DEBUG("Pack recharged at " << m_packVoltageV << " V");
+        m_drained = false;
+        NotifyEnergyRecharged();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,207 @@
+#ifndef NS3_LI_ION_PACK_ENERGY_SOURCE_H
+#define NS3_LI_ION_PACK_ENERGY_SOURCE_H
+
+#include "li-ion-cell-model.h"
+#include "solar-harvester-device-model.h"
+#include "solar-irradiance-model.h"
+
+#include "ns3/energy-source.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-value.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Energy source modelling a Li-Ion pack of SeriesCells groups of
+ *        ParallelCells cells, with the state of every cell.
+ *
+ * A LiIonEnergySource (and so a CompositeEnergySource) is a single cell,
+ * so a 4S2P pack can only be modelled as one scaled cell and cell
+ * imbalance cannot be studied. This source keeps the state of each cell
+ * (state of charge, capacity, internal resistance, temperature) in
+ * structure-of-arrays form, cell s * ParallelCells + p being cell p of
+ * series group s, and advances all of them in one pass per update over
+ * contiguous arrays, with no object per cell, so packs can be simulated
+ * at fleet scale.
+ *
+ * Electrical model
+ *  - The open-circuit voltage of a cell is the Shepherd curve of the
+ *    default LiIonEnergySource cell (LiIonCellModel), read at the cell's
+ *    drained fraction of its own capacity.
+ *  - The cells of a group share its terminal voltage, so the group
+ *    current (the pack current, positive when discharging) splits by
+ *    conductance and open-circuit voltage:
+ *      V_g = (sum OCV_j / R_j - I) / sum 1 / R_j,  I_j = (OCV_j - V_g) / R_j.
+ *    A stronger or fuller cell therefore takes more of a discharge and
+ *    less of a charge. The pack voltage is the sum of the group voltages.
+ *  - The resistance of a cell rises by ResistanceTemperatureCoefficient
+ *    per kelvin below ReferenceTemperatureC. Each cell heats by I_j^2 R_j
+ *    and cools to AmbientTemperatureC through ThermalResistanceKPerW; the
+ *    first-order response is applied exactly over each update span.
+ *  - The remaining energy is the charge of the cells at
+ *    NominalCellVoltageV. The devices are notified that the pack is
+ *    drained when a cell reaches CellCutoffVoltageV or is empty, and that
+ *    it is recharged once it is being charged with every cell's
+ *    open-circuit voltage back above CellCutoffVoltageV.
+ *
+ * Harvesting
+ *  - With an IrradianceModel, an internal SolarHarvesterDeviceModel
+ *    injects PanelAreaM2 * PanelEfficiency * ChargeEfficiency times its
+ *    power density as a negative device current, integrated exactly over
+ *    each update span like in CompositeEnergySource. The charge is
+ *    distributed across the cells by the group equations above, and it
+ *    is cut off at the instant the first cell would be full (to first
+ *    order in the current split), as a battery management system does;
+ *    the next update re-enables it once that cell has room again.
+ *
+ * Balancing
+ *  - Passive: while the state-of-charge spread exceeds BalanceThreshold,
+ *    every cell more than that above the emptiest cell is bled at
+ *    BalanceCurrentA, the energy being lost.
+ *  - Active: while it exceeds BalanceThreshold, charge is moved from the
+ *    cells above the capacity-weighted mean state of charge to those
+ *    below it, at most BalanceCurrentA per cell, and reaches them with
+ *    BalanceEfficiency.
+ *  - Balancing never carries a cell past the level it balances to.
+ */
+class LiIonPackEnergySource : public EnergySource
+{
+  public:
+    /** Cell balancing policy. */
+    enum BalancingPolicy
+    {
+        NO_BALANCING, //!< Cells drift apart
+        PASSIVE,      //!< Bleed the fuller cells through resistors
+        ACTIVE,       //!< Shuttle charge from fuller to emptier cells
+    };
+
+    /** State of one cell. */
+    struct CellState
+    {
+        double soc;           //!< State of charge, in [0, 1]
+        double capacityAh;    //!< Capacity (Ah)
+        double resistanceOhm; //!< Internal resistance at ReferenceTemperatureC (Ohm)
+        double temperatureC;  //!< Temperature (degrees C)
+        double currentA;      //!< Current over the last update, positive discharging (A)
+        double voltageV;      //!< Terminal voltage at the last update (V)
+    };
+
+    static TypeId GetTypeId();
+
+    LiIonPackEnergySource();
+    ~LiIonPackEnergySource() override;
+
+    // EnergySource API
+    double GetInitialEnergy() const override;
+    double GetSupplyVoltage() const override;
+    double GetRemainingEnergy() override;
+    double GetEnergyFraction() override;
+    void UpdateEnergySource() override;
+
+    /** \return Number of cells, SeriesCells * ParallelCells. */
+    uint32_t GetNCells() const;
+
+    /**
+     * \brief Set the state of charge, capacity and resistance of cell \p i.
+     *
+     * The cells are laid out from SeriesCells and ParallelCells, all with
+     * InitialSoc, CellCapacityAh and CellResistanceOhm, on the first call
+     * or at initialization, whichever comes first. Use this before the
+     * source is initialized to start from an imbalanced pack.
+     */
+    void SetCellState(uint32_t i, double soc, double capacityAh, double resistanceOhm);
+
+    /** \return The state of cell \p i as of the last update. */
+    CellState GetCellState(uint32_t i) const;
+
+    /** \return Largest less smallest state of charge of the cells. */
+    double GetSocSpread() const;
+
+    /** \return Total energy harvested (J). */
+    double GetTotalHarvestedEnergy() const;
+
+    /** \return Charge moved (Active) or bled (Passive) by balancing (Ah). */
+    double GetBalancedCharge() const;
+
+  protected:
+    void DoInitialize() override;
+    void DoDispose() override;
+
+  private:
+    /** Lay the cells out, unless done already. */
+    void LayOutCells();
+
+    /**
+     * Advance every cell by \p seconds at pack current \p packA (positive
+     * discharging), then balance and refresh the voltages and headroom.
+     */
+    void Step(double seconds, double packA);
+
+    /**
+     * Solve the group equations at pack current \p packA: the cell
+     * currents, the cell and pack voltages and the charge headroom.
+     */
+    void SolveCurrents(double packA);
+
+    /** Move or bleed charge between cells over \p seconds. */
+    void Balance(double seconds);
+
+    /** Notify the devices when the pack is drained or recharged. */
+    void CheckDrained();
+
+    // Attributes
+    uint32_t m_seriesCells;
+    uint32_t m_parallelCells;
+    double m_cellCapacityAh;
+    double m_cellResistanceOhm;
+    double m_initialSoc;
+    double m_nominalCellVoltageV;
+    double m_cutoffVoltageV;
+    double m_ambientTemperatureC;
+    double m_referenceTemperatureC;
+    double m_resistanceTemperatureCoefficient;
+    double m_thermalResistanceKPerW;
+    double m_thermalCapacitanceJPerK;
+    BalancingPolicy m_balancing;
+    double m_balanceThreshold;
+    double m_balanceCurrentA;
+    double m_balanceEfficiency;
+    Time m_energyUpdateInterval;
+    Ptr<SolarIrradianceModel> m_irradianceModel;
+    double m_panelAreaM2;
+    double m_panelEfficiency;
+    double m_chargeEfficiency;
+
+    // Cells, in structure-of-arrays form, indexed s * m_parallelCells + p
+    std::vector<double> m_soc;
+    std::vector<double> m_capacityAh;
+    std::vector<double> m_resistanceOhm; // at the reference temperature
+    std::vector<double> m_temperatureC;
+    std::vector<double> m_currentA;
+    std::vector<double> m_openCircuitV;
+    std::vector<double> m_conductanceS; // scratch of SolveCurrents()
+    std::vector<double> m_groupV;       // terminal voltage of each group
+
+    LiIonCellModel m_cellModel;
+    double m_initialEnergyJ;
+    double m_packVoltageV;
+    double m_headroomAh; // pack charge until the first cell is full
+    double m_balancedAh;
+    bool m_drained;
+    Time m_lastUpdate;
+    EventId m_energyUpdateEvent;
+    Ptr<SolarHarvesterDeviceModel> m_harvester;
+
+    TracedValue<double> m_remainingEnergyJ;
+};
+
+} // namespace ns3
+
+#endif // NS3_LI_ION_PACK_ENERGY_SOURCE_H
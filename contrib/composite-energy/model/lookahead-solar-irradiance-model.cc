@@ -0,0 +1,219 @@
+#include "lookahead-solar-irradiance-model.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LookaheadSolarIrradianceModel");
+
+NS_OBJECT_ENSURE_REGISTERED(LookaheadSolarIrradianceModel);
+
+TypeId
+LookaheadSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::LookaheadSolarIrradianceModel")
+            .SetParent<SolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<LookaheadSolarIrradianceModel>()
+            .AddAttribute("Samples",
+                          "Number of samples fetched from the wrapped model per block.",
+                          UintegerValue(64),
+                          MakeUintegerAccessor(&LookaheadSolarIrradianceModel::SetSamples,
+                                               &LookaheadSolarIrradianceModel::GetSamples),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Step",
+                          "Spacing of the samples of a block; the consumer's polling period.",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&LookaheadSolarIrradianceModel::m_step),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("Origin",
+                          "A time on the sample grid; the consumer's first poll.",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&LookaheadSolarIrradianceModel::m_origin),
+                          MakeTimeChecker());
+    return tid;
+}
+
+LookaheadSolarIrradianceModel::LookaheadSolarIrradianceModel()
+    : m_samples(0),
+      m_step(Seconds(1)),
+      m_origin(Seconds(0)),
+      m_head(0),
+      m_count(0),
+      m_cursor(0),
+      m_hits(0),
+      m_misses(0),
+      m_blocks(0)
+{
+    NS_LOG_FUNCTION(this);
+    SetSamples(64);
+}
+
+LookaheadSolarIrradianceModel::~LookaheadSolarIrradianceModel() = default;
+
+void
+LookaheadSolarIrradianceModel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_model = nullptr;
+    SolarIrradianceModel::DoDispose();
+}
+
+void
+LookaheadSolarIrradianceModel::SetModel(Ptr<const SolarIrradianceModel> model)
+{
+    NS_LOG_FUNCTION(this << model);
+    m_model = model;
+    m_count = 0;
+    m_cursor = 0;
+}
+
+Ptr<const SolarIrradianceModel>
+LookaheadSolarIrradianceModel::GetModel() const
+{
+    return m_model;
+}
+
+void
+LookaheadSolarIrradianceModel::SetSamples(uint32_t samples)
+{
+    m_samples = samples;
+    m_times.assign(2 * static_cast<std::size_t>(samples), Time(0));
+    m_values.assign(2 * static_cast<std::size_t>(samples), 0.0);
+    m_head = 0;
+    m_count = 0;
+    m_cursor = 0;
+}
+
+uint32_t
+LookaheadSolarIrradianceModel::GetSamples() const
+{
+    return m_samples;
+}
+
+double
+LookaheadSolarIrradianceModel::GetPowerDensityWm2(Time t) const
+{
+    return Lookup(t);
+}
+
+SolarIrradianceSegment
+LookaheadSolarIrradianceModel::GetSegment(Time t) const
+{
+    return SolarIrradianceSegment{t, t, Lookup(t), 0.0};
+}
+
+uint64_t
+LookaheadSolarIrradianceModel::GetHits() const
+{
+    return m_hits;
+}
+
+uint64_t
+LookaheadSolarIrradianceModel::GetMisses() const
+{
+    return m_misses;
+}
+
+uint64_t
+LookaheadSolarIrradianceModel::GetBlocks() const
+{
+    return m_blocks;
+}
+
+std::size_t
+LookaheadSolarIrradianceModel::Slot(std::size_t i) const
+{
+    return (m_head + i) % m_times.size();
+}
+
+double
+LookaheadSolarIrradianceModel::Lookup(Time t) const
+{
+    if (!m_model)
+    {
+        return 0.0;
+    }
+    if (m_count == 0 || t > m_times[Slot(m_count - 1)])
+    {
+        Fetch(t);
+    }
+    else if (t < m_times[m_head])
+    {
+        ++m_misses;
+        return m_model->GetPowerDensityWm2(t);
+    }
+
+    // Polling advances one sample at a time, so the sample is normally at
+    // the cursor or just past it.
+    std::size_t i = std::min(m_cursor, m_count - 1);
+    if (m_times[Slot(i)] > t)
+    {
+        i = 0;
+    }
+    while (i + 1 < m_count && m_times[Slot(i + 1)] <= t)
+    {
+        ++i;
+    }
+    if (m_times[Slot(i)] != t)
+    {
+        ++m_misses;
+        return m_model->GetPowerDensityWm2(t);
+    }
+    m_cursor = i;
+    ++m_hits;
+    return m_values[Slot(i)];
+}
+
+void
+LookaheadSolarIrradianceModel::Fetch(Time t) const
+{
+    NS_LOG_FUNCTION(this << t);
+    // Blocks start on the grid Origin + k * Step, where the ticks fall, so
+    // a query off that grid does not shift the samples of the ticks after
+    // it; past the buffer means past its last grid point too.
+    int64_t step = m_step.GetTimeStep();
+    int64_t into = (t - m_origin).GetTimeStep() % step;
+    if (into < 0)
+    {
+        into += step;
+    }
+    Time start = t - TimeStep(into);
+    if (m_count > 0)
+    {
+        start = Max(start, m_times[Slot(m_count - 1)] + m_step);
+    }
+    m_blockTimes.resize(m_samples);
+    m_blockValues.resize(m_samples);
+    for (uint32_t k = 0; k < m_samples; ++k)
+    {
+        m_blockTimes[k] = start + m_step * static_cast<int64_t>(k);
+    }
+    m_model->GetPowerDensitiesWm2(m_blockTimes.data(), m_blockValues.data(), m_samples);
+    ++m_blocks;
+
+    // Append, evicting the oldest samples beyond two blocks.
+    std::size_t capacity = m_times.size();
+    for (uint32_t k = 0; k < m_samples; ++k)
+    {
+        if (m_count == capacity)
+        {
+            m_head = (m_head + 1) % capacity;
+            --m_count;
+            m_cursor = (m_cursor > 0) ? m_cursor - 1 : 0;
+        }
+        std::size_t slot = Slot(m_count);
+        m_times[slot] = m_blockTimes[k];
+        m_values[slot] = m_blockValues[k];
+        ++m_count;
+    }
+}
+
+} // namespace ns3
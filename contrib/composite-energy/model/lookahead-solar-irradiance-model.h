@@ -0,0 +1,106 @@
+#ifndef NS3_LOOKAHEAD_SOLAR_IRRADIANCE_MODEL_H
+#define NS3_LOOKAHEAD_SOLAR_IRRADIANCE_MODEL_H
+
+#include "solar-irradiance-model.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Serves a polled irradiance model from a ring buffer of samples
+ *        fetched ahead in blocks.
+ *
+ * A model that cannot describe its future (a propagator behind a
+ * callback, ray-traced shading) is polled once per harvest tick, which
+ * pays its setup cost on every sample. This wrapper instead fetches the
+ * next \c Samples values at \c Step spacing in one
+ * GetPowerDensitiesWm2() call on the wrapped model, so a block-capable
+ * model (e.g. an InvocableSolarIrradianceModel with a block invocable)
+ * amortizes that cost over the block.
+ *
+ * Samples are taken on the grid \c Origin + k * \c Step, the consumer's
+ * polling ticks. A query at a buffered time is answered from the buffer.
+ * A query past the newest buffered time fetches the next block from the
+ * grid point at or before it (after the buffer), evicting the oldest
+ * samples, so a query off the grid does not shift the samples of the
+ * ticks that follow; the ring keeps two blocks, so the samples
+ * just passed stay available to integration spans that end on them. Any
+ * other query goes straight to the wrapped model. Values are those the
+ * wrapped model returns for the same times, so a source reading through
+ * the wrapper harvests exactly as without it, provided the wrapped model
+ * is a function of time alone.
+ *
+ * Like the model it wraps, the wrapper reports no knowledge of the future
+ * (GetSegment() asks to be polled). Models that describe their segments
+ * gain nothing from it and should not be wrapped.
+ */
+class LookaheadSolarIrradianceModel : public SolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    LookaheadSolarIrradianceModel();
+    ~LookaheadSolarIrradianceModel() override;
+
+    /** Wrap \p model, dropping anything buffered. */
+    void SetModel(Ptr<const SolarIrradianceModel> model);
+
+    /** \return The wrapped model. */
+    Ptr<const SolarIrradianceModel> GetModel() const;
+
+    double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
+
+    /** \return Queries answered from the buffer. */
+    uint64_t GetHits() const;
+
+    /** \return Queries passed to the wrapped model one by one. */
+    uint64_t GetMisses() const;
+
+    /** \return Blocks fetched from the wrapped model. */
+    uint64_t GetBlocks() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    void SetSamples(uint32_t samples);
+    uint32_t GetSamples() const;
+
+    /** \return The value at \p t, from the buffer when possible. */
+    double Lookup(Time t) const;
+
+    /** Fetch the block from the grid point at or before \p t into the ring. */
+    void Fetch(Time t) const;
+
+    /** \return Ring slot of the \p i-th oldest buffered sample. */
+    std::size_t Slot(std::size_t i) const;
+
+    Ptr<const SolarIrradianceModel> m_model;
+    uint32_t m_samples; // block size
+    Time m_step;
+    Time m_origin; // a point of the sample grid
+
+    // Ring of two blocks, oldest at m_head
+    mutable std::vector<Time> m_times;
+    mutable std::vector<double> m_values;
+    mutable std::size_t m_head;
+    mutable std::size_t m_count;
+    mutable std::size_t m_cursor; // age of the last sample found
+
+    // Scratch of Fetch()
+    mutable std::vector<Time> m_blockTimes;
+    mutable std::vector<double> m_blockValues;
+
+    mutable uint64_t m_hits;
+    mutable uint64_t m_misses;
+    mutable uint64_t m_blocks;
+};
+
+} // namespace ns3
+
+#endif // NS3_LOOKAHEAD_SOLAR_IRRADIANCE_MODEL_H
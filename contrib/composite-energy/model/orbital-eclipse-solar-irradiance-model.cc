@@ -0,0 +1,614 @@
+#include "orbital-eclipse-solar-irradiance-model.h"
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("OrbitalEclipseSolarIrradianceModel");
+
+namespace
+{
+
+constexpr double EARTH_MU_KM3_S2 = 398600.4418;     // gravitational parameter
+constexpr double EARTH_RADIUS_KM = 6378.137;        // equatorial radius
+constexpr double EARTH_J2 = 1.08262668e-3;          // second zonal harmonic
+constexpr double OBLIQUITY_RAD = 0.409092804;       // 23.4393 deg
+constexpr double SUN_RATE_RAD_S = 1.99098659e-7;    // 2 pi per 365.2422 days
+constexpr double YEAR_SECONDS = 365.2422 * 86400.0; // search horizon
+constexpr double PI = 3.14159265358979323846;
+constexpr double DEG = PI / 180.0;
+
+/** \return \p a wrapped into (-pi, pi]. */
+double
+WrapPi(double a)
+{
+    a = std::fmod(a, 2.0 * PI);
+    if (a > PI)
+    {
+        a -= 2.0 * PI;
+    }
+    else if (a <= -PI)
+    {
+        a += 2.0 * PI;
+    }
+    return a;
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------
+// OrbitalEclipseSolarIrradianceModel
+// -------------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED(OrbitalEclipseSolarIrradianceModel);
+
+TypeId
+OrbitalEclipseSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::OrbitalEclipseSolarIrradianceModel")
+            .SetParent<SolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<OrbitalEclipseSolarIrradianceModel>()
+            .AddAttribute("PeakWm2",
+                          "Solar power density outside the umbra (W/m^2).",
+                          DoubleValue(1361.0),
+                          MakeDoubleAccessor(&OrbitalEclipseSolarIrradianceModel::m_peakWm2),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("SemiMajorAxisKm",
+                          "Radius of the circular orbit (km).",
+                          DoubleValue(EARTH_RADIUS_KM + 550.0),
+                          MakeDoubleAccessor(
+                              &OrbitalEclipseSolarIrradianceModel::m_semiMajorAxisKm),
+                          MakeDoubleChecker<double>(EARTH_RADIUS_KM))
+            .AddAttribute("InclinationDegrees",
+                          "Orbit inclination (degrees).",
+                          DoubleValue(53.0),
+                          MakeDoubleAccessor(
+                              &OrbitalEclipseSolarIrradianceModel::m_inclinationDegrees),
+                          MakeDoubleChecker<double>(0.0, 180.0))
+            .AddAttribute("RaanDegrees",
+                          "Right ascension of the ascending node at time zero (degrees).",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&OrbitalEclipseSolarIrradianceModel::m_raanDegrees),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("ArgumentOfLatitudeDegrees",
+                          "Angle from the ascending node to the satellite at time zero "
+                          "(degrees).",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(
+                              &OrbitalEclipseSolarIrradianceModel::m_argumentOfLatitudeDegrees),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("SunLongitudeDegrees",
+                          "Ecliptic longitude of the Sun at time zero (degrees); 0 is the "
+                          "March equinox.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(
+                              &OrbitalEclipseSolarIrradianceModel::m_sunLongitudeDegrees),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("EnableJ2",
+                          "Apply the secular J2 drift of the node and of the argument of "
+                          "latitude.",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&OrbitalEclipseSolarIrradianceModel::m_enableJ2),
+                          MakeBooleanChecker());
+    return tid;
+}
+
+OrbitalEclipseSolarIrradianceModel::OrbitalEclipseSolarIrradianceModel()
+    : m_peakWm2(1361.0),
+      m_semiMajorAxisKm(EARTH_RADIUS_KM + 550.0),
+      m_inclinationDegrees(53.0),
+      m_raanDegrees(0.0),
+      m_argumentOfLatitudeDegrees(0.0),
+      m_sunLongitudeDegrees(0.0),
+      m_enableJ2(true),
+      m_prepared(false),
+      m_cosAlphaScale(0.0),
+      m_uRate(0.0),
+      m_raanRate(0.0),
+      m_cache{Time(0), Time(0), 0.0, 0.0}
+{
+    NS_LOG_FUNCTION(this);
+}
+
+OrbitalEclipseSolarIrradianceModel::~OrbitalEclipseSolarIrradianceModel() = default;
+
+void
+OrbitalEclipseSolarIrradianceModel::Prepare() const
+{
+    if (m_prepared)
+    {
+        return;
+    }
+    double a = m_semiMajorAxisKm;
+    double n = std::sqrt(EARTH_MU_KM3_S2 / (a * a * a));
+    double ratio = EARTH_RADIUS_KM / a;
+    double cosI = std::cos(m_inclinationDegrees * DEG);
+    m_cosAlphaScale = std::sqrt(std::max(0.0, 1.0 - ratio * ratio));
+    m_uRate = n;
+    m_raanRate = 0.0;
+    if (m_enableJ2)
+    {
+        // Secular rates of a circular orbit: the node regresses, and the
+        // argument of latitude gains the perigee and mean anomaly drifts.
+        double k = EARTH_J2 * ratio * ratio;
+        m_raanRate = -1.5 * n * k * cosI;
+        m_uRate = n * (1.0 + 0.75 * k * (8.0 * cosI * cosI - 2.0));
+    }
+    m_prepared = true;
+    NS_LOG_DEBUG("nodal period " << 2.0 * PI / m_uRate << " s, node drift "
+                                 << m_raanRate / DEG * 86400.0 << " deg/day");
+}
+
+OrbitalEclipseSolarIrradianceModel::Geometry
+OrbitalEclipseSolarIrradianceModel::GetGeometry(Time t) const
+{
+    Prepare();
+    double s = t.GetSeconds();
+    double raan = m_raanDegrees * DEG + m_raanRate * s;
+    double inc = m_inclinationDegrees * DEG;
+    double lambda = m_sunLongitudeDegrees * DEG + SUN_RATE_RAD_S * s;
+
+    // Sun direction in the equatorial frame, projected on the in-plane
+    // axes P (towards the node) and Q (90 degrees ahead of it).
+    double sx = std::cos(lambda);
+    double sy = std::sin(lambda) * std::cos(OBLIQUITY_RAD);
+    double sz = std::sin(lambda) * std::sin(OBLIQUITY_RAD);
+    double sP = sx * std::cos(raan) + sy * std::sin(raan);
+    double sQ = -sx * std::sin(raan) * std::cos(inc) + sy * std::cos(raan) * std::cos(inc) +
+                sz * std::sin(inc);
+
+    Geometry g;
+    g.u = WrapPi(m_argumentOfLatitudeDegrees * DEG + m_uRate * s);
+    g.x = WrapPi(g.u - std::atan2(sQ, sP) - PI);
+    double cosBeta = std::hypot(sP, sQ);
+    g.alpha = (cosBeta > m_cosAlphaScale) ? std::acos(m_cosAlphaScale / cosBeta) : -1.0;
+    return g;
+}
+
+bool
+OrbitalEclipseSolarIrradianceModel::IsInUmbra(const Geometry& g)
+{
+    // Entry instants are dark and exit instants lit, as segments are
+    // half-open.
+    return g.alpha > 0.0 && g.x >= -g.alpha && g.x < g.alpha;
+}
+
+Time
+OrbitalEclipseSolarIrradianceModel::SolveEdge(Time t, bool exit) const
+{
+    // Closed form against the geometry at the current estimate, refined
+    // for the drift of the node and the Sun meanwhile. The drift is about
+    // a thousandth of the orbital rate, so each pass gains three digits.
+    bool dark = IsInUmbra(GetGeometry(t));
+    double s = t.GetSeconds();
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        Geometry g = GetGeometry(Seconds(s));
+        if (g.alpha < 0.0)
+        {
+            // The umbra vanished on the way: an exit happens about here,
+            // an entry not in this orbit.
+            return exit ? Max(Seconds(s), t + TimeStep(1)) : Time::Max();
+        }
+        double d = (exit ? g.alpha : -g.alpha) - g.x;
+        d = (pass == 0) ? std::fmod(d + 2.0 * PI, 2.0 * PI) : WrapPi(d);
+        double step = d / m_uRate;
+        s += step;
+        if (std::abs(step) < 1e-10)
+        {
+            break;
+        }
+    }
+
+    // Land on the first time step past the edge.
+    Time edge = Max(Seconds(s), t + TimeStep(1));
+    for (int nudge = 0; nudge < 64 && IsInUmbra(GetGeometry(edge)) == dark; ++nudge)
+    {
+        edge += TimeStep(1);
+    }
+    return edge;
+}
+
+Time
+OrbitalEclipseSolarIrradianceModel::FindNextTransition(Time t, Time horizon) const
+{
+    if (IsInUmbra(GetGeometry(t)))
+    {
+        return SolveEdge(t, true);
+    }
+    // Outside an eclipse season there is no edge to solve for; look one
+    // orbit further each time.
+    Time period = GetNodalPeriod();
+    for (Time from = t; from - t < horizon; from += period)
+    {
+        Time entry = SolveEdge(from, false);
+        if (entry != Time::Max())
+        {
+            return entry;
+        }
+    }
+    return Time::Max();
+}
+
+double
+OrbitalEclipseSolarIrradianceModel::GetPowerDensityWm2(Time t) const
+{
+    return GetSegment(t).startWm2;
+}
+
+SolarIrradianceSegment
+OrbitalEclipseSolarIrradianceModel::GetSegment(Time t) const
+{
+    if (t >= m_cache.start && t < m_cache.end)
+    {
+        return m_cache;
+    }
+    Geometry g = GetGeometry(t);
+    bool dark = IsInUmbra(g);
+    Time end;
+    if (dark)
+    {
+        end = SolveEdge(t, true);
+    }
+    else
+    {
+        // Without an umbra this orbit, sunlight is held for one orbit and
+        // the geometry looked at again.
+        end = (g.alpha < 0.0) ? Time::Max() : SolveEdge(t, false);
+        end = Min(end, t + GetNodalPeriod());
+    }
+    m_cache = SolarIrradianceSegment{t, end, dark ? 0.0 : m_peakWm2, 0.0};
+    return m_cache;
+}
+
+bool
+OrbitalEclipseSolarIrradianceModel::IsInSunlight(Time t) const
+{
+    return !IsInUmbra(GetGeometry(t));
+}
+
+Time
+OrbitalEclipseSolarIrradianceModel::GetNextEclipseEntry(Time t) const
+{
+    Time from = t;
+    if (IsInUmbra(GetGeometry(t)))
+    {
+        from = SolveEdge(t, true);
+    }
+    return FindNextTransition(from, Seconds(YEAR_SECONDS));
+}
+
+Time
+OrbitalEclipseSolarIrradianceModel::GetNextEclipseExit(Time t) const
+{
+    if (IsInUmbra(GetGeometry(t)))
+    {
+        return SolveEdge(t, true);
+    }
+    Time entry = FindNextTransition(t, Seconds(YEAR_SECONDS));
+    return (entry == Time::Max()) ? Time::Max() : SolveEdge(entry, true);
+}
+
+std::vector<Time>
+OrbitalEclipseSolarIrradianceModel::GetTransitions(Time from, Time until) const
+{
+    NS_LOG_FUNCTION(this << from << until);
+    std::vector<Time> transitions;
+    Time t = from;
+    while (t < until)
+    {
+        t = FindNextTransition(t, until - t);
+        if (t >= until)
+        {
+            break;
+        }
+        transitions.push_back(t);
+    }
+    return transitions;
+}
+
+double
+OrbitalEclipseSolarIrradianceModel::GetBetaAngleDegrees(Time t) const
+{
+    Prepare();
+    double s = t.GetSeconds();
+    double raan = m_raanDegrees * DEG + m_raanRate * s;
+    double inc = m_inclinationDegrees * DEG;
+    double lambda = m_sunLongitudeDegrees * DEG + SUN_RATE_RAD_S * s;
+    // Sun direction against the orbit normal.
+    double sx = std::cos(lambda);
+    double sy = std::sin(lambda) * std::cos(OBLIQUITY_RAD);
+    double sz = std::sin(lambda) * std::sin(OBLIQUITY_RAD);
+    double sinBeta = sx * std::sin(raan) * std::sin(inc) - sy * std::cos(raan) * std::sin(inc) +
+                     sz * std::cos(inc);
+    return std::asin(std::max(-1.0, std::min(1.0, sinBeta))) / DEG;
+}
+
+Time
+OrbitalEclipseSolarIrradianceModel::GetNodalPeriod() const
+{
+    Prepare();
+    return Seconds(2.0 * PI / m_uRate);
+}
+
+// -------------------------------------------------------------------------
+// EclipseSchedule
+// -------------------------------------------------------------------------
+
+std::map<EclipseSchedule::PlaneKey, EclipseSchedule*>&
+EclipseSchedule::GetPlanes()
+{
+    static std::map<PlaneKey, EclipseSchedule*> planes;
+    return planes;
+}
+
+Ptr<const EclipseSchedule>
+EclipseSchedule::ForPlane(double semiMajorAxisKm,
+                          double inclinationDegrees,
+                          double raanDegrees,
+                          double sunLongitudeDegrees,
+                          bool enableJ2,
+                          Time until)
+{
+    NS_LOG_FUNCTION(semiMajorAxisKm << inclinationDegrees << raanDegrees << sunLongitudeDegrees
+                                    << enableJ2 << until);
+    PlaneKey key{semiMajorAxisKm,
+                 inclinationDegrees,
+                 raanDegrees,
+                 sunLongitudeDegrees,
+                 enableJ2,
+                 until.GetTimeStep()};
+    auto& planes = GetPlanes();
+    auto it = planes.find(key);
+    if (it != planes.end())
+    {
+        return Ptr<const EclipseSchedule>(it->second);
+    }
+
+    Ptr<OrbitalEclipseSolarIrradianceModel> reference =
+        CreateObject<OrbitalEclipseSolarIrradianceModel>();
+    reference->SetAttribute("SemiMajorAxisKm", DoubleValue(semiMajorAxisKm));
+    reference->SetAttribute("InclinationDegrees", DoubleValue(inclinationDegrees));
+    reference->SetAttribute("RaanDegrees", DoubleValue(raanDegrees));
+    reference->SetAttribute("ArgumentOfLatitudeDegrees", DoubleValue(0.0));
+    reference->SetAttribute("SunLongitudeDegrees", DoubleValue(sunLongitudeDegrees));
+    reference->SetAttribute("EnableJ2", BooleanValue(enableJ2));
+    Time period = reference->GetNodalPeriod();
+    Time start = Time(0) - period;
+    Time end = until + period;
+
+    // Ptr takes the initial reference; the registry only observes it.
+    Ptr<EclipseSchedule> schedule =
+        Ptr<EclipseSchedule>(new EclipseSchedule(start,
+                                                 end,
+                                                 reference->IsInSunlight(start),
+                                                 reference->GetTransitions(start, end),
+                                                 period),
+                             false);
+    reference->Dispose();
+    schedule->m_registered = true;
+    schedule->m_key = key;
+    planes[key] = PeekPointer(schedule);
+    NS_LOG_DEBUG("plane schedule with " << schedule->GetNTransitions() << " transitions");
+    return schedule;
+}
+
+Ptr<const EclipseSchedule>
+EclipseSchedule::Create(Time start,
+                        Time end,
+                        bool litAtStart,
+                        std::vector<Time> transitions,
+                        Time nodalPeriod)
+{
+    NS_LOG_FUNCTION(start << end << litAtStart << transitions.size() << nodalPeriod);
+    NS_ABORT_MSG_IF(end < start, "Eclipse schedule ends before it starts");
+    for (std::size_t i = 0; i < transitions.size(); ++i)
+    {
+        NS_ABORT_MSG_IF(transitions[i] <= start || transitions[i] >= end ||
+                            (i > 0 && transitions[i] <= transitions[i - 1]),
+                        "Eclipse transitions must be increasing and inside (start, end)");
+    }
+    return Ptr<EclipseSchedule>(
+        new EclipseSchedule(start, end, litAtStart, std::move(transitions), nodalPeriod),
+        false);
+}
+
+EclipseSchedule::EclipseSchedule(Time start,
+                                 Time end,
+                                 bool litAtStart,
+                                 std::vector<Time> transitions,
+                                 Time nodalPeriod)
+    : m_start(start),
+      m_end(end),
+      m_litAtStart(litAtStart),
+      m_transitions(std::move(transitions)),
+      m_nodalPeriod(nodalPeriod),
+      m_registered(false),
+      m_key{}
+{
+    NS_LOG_FUNCTION(this);
+}
+
+EclipseSchedule::~EclipseSchedule()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_registered)
+    {
+        GetPlanes().erase(m_key);
+    }
+}
+
+Time
+EclipseSchedule::GetStart() const
+{
+    return m_start;
+}
+
+Time
+EclipseSchedule::GetEnd() const
+{
+    return m_end;
+}
+
+bool
+EclipseSchedule::IsLitAtStart() const
+{
+    return m_litAtStart;
+}
+
+std::size_t
+EclipseSchedule::GetNTransitions() const
+{
+    return m_transitions.size();
+}
+
+Time
+EclipseSchedule::GetTransition(std::size_t i) const
+{
+    return m_transitions[i];
+}
+
+Time
+EclipseSchedule::GetNodalPeriod() const
+{
+    return m_nodalPeriod;
+}
+
+Time
+EclipseSchedule::GetPhaseOffset(double argumentOfLatitudeDegrees) const
+{
+    double ahead = std::fmod(argumentOfLatitudeDegrees, 360.0);
+    if (ahead > 180.0)
+    {
+        ahead -= 360.0;
+    }
+    else if (ahead <= -180.0)
+    {
+        ahead += 360.0;
+    }
+    return Seconds(m_nodalPeriod.GetSeconds() * ahead / 360.0);
+}
+
+// -------------------------------------------------------------------------
+// ScheduledEclipseSolarIrradianceModel
+// -------------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED(ScheduledEclipseSolarIrradianceModel);
+
+TypeId
+ScheduledEclipseSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::ScheduledEclipseSolarIrradianceModel")
+            .SetParent<SampledSolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<ScheduledEclipseSolarIrradianceModel>()
+            .AddAttribute("PeakWm2",
+                          "Solar power density outside the umbra (W/m^2).",
+                          DoubleValue(1361.0),
+                          MakeDoubleAccessor(&ScheduledEclipseSolarIrradianceModel::SetPeakWm2,
+                                             &ScheduledEclipseSolarIrradianceModel::GetPeakWm2),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("Phase",
+                          "Time by which this satellite leads the schedule's reference "
+                          "satellite; see EclipseSchedule::GetPhaseOffset().",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&ScheduledEclipseSolarIrradianceModel::SetPhase,
+                                           &ScheduledEclipseSolarIrradianceModel::GetPhase),
+                          MakeTimeChecker());
+    return tid;
+}
+
+ScheduledEclipseSolarIrradianceModel::ScheduledEclipseSolarIrradianceModel()
+    : m_peakWm2(1361.0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+ScheduledEclipseSolarIrradianceModel::~ScheduledEclipseSolarIrradianceModel() = default;
+
+void
+ScheduledEclipseSolarIrradianceModel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_schedule = nullptr;
+    SampledSolarIrradianceModel::DoDispose();
+}
+
+void
+ScheduledEclipseSolarIrradianceModel::SetSchedule(Ptr<const EclipseSchedule> schedule)
+{
+    NS_LOG_FUNCTION(this << schedule);
+    m_schedule = schedule;
+    ResetSampleCache();
+}
+
+Ptr<const EclipseSchedule>
+ScheduledEclipseSolarIrradianceModel::GetSchedule() const
+{
+    return m_schedule;
+}
+
+void
+ScheduledEclipseSolarIrradianceModel::SetPeakWm2(double wm2)
+{
+    m_peakWm2 = wm2;
+    ResetSampleCache();
+}
+
+double
+ScheduledEclipseSolarIrradianceModel::GetPeakWm2() const
+{
+    return m_peakWm2;
+}
+
+void
+ScheduledEclipseSolarIrradianceModel::SetPhase(Time phase)
+{
+    m_phase = phase;
+    ResetSampleCache();
+}
+
+Time
+ScheduledEclipseSolarIrradianceModel::GetPhase() const
+{
+    return m_phase;
+}
+
+void
+ScheduledEclipseSolarIrradianceModel::AddSample(Time /*t*/, double /*wm2*/)
+{
+    NS_ABORT_MSG("ScheduledEclipseSolarIrradianceModel is read-only; build an EclipseSchedule");
+}
+
+std::size_t
+ScheduledEclipseSolarIrradianceModel::GetNSamples() const
+{
+    // The state at the start of the span, then one sample per transition.
+    return m_schedule ? m_schedule->GetNTransitions() + 1 : 0;
+}
+
+Time
+ScheduledEclipseSolarIrradianceModel::GetSampleTime(std::size_t i) const
+{
+    Time t = (i == 0) ? m_schedule->GetStart() : m_schedule->GetTransition(i - 1);
+    return t - m_phase;
+}
+
+double
+ScheduledEclipseSolarIrradianceModel::GetSampleValue(std::size_t i) const
+{
+    bool lit = m_schedule->IsLitAtStart() == (i % 2 == 0);
+    return lit ? m_peakWm2 : 0.0;
+}
+
+} // namespace ns3
@@ -0,0 +1,290 @@
+#ifndef NS3_ORBITAL_ECLIPSE_SOLAR_IRRADIANCE_MODEL_H
+#define NS3_ORBITAL_ECLIPSE_SOLAR_IRRADIANCE_MODEL_H
+
+#include "solar-irradiance-model.h"
+
+#include "ns3/simple-ref-count.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Sunlight/umbra irradiance of a circular orbit, from its
+ *        Keplerian elements and the direction of the Sun.
+ *
+ * The satellite is in umbra when it is behind the Earth and within the
+ * Earth's radius of the Earth-Sun line (cylindrical shadow, no
+ * penumbra). The orbit is circular, given by \c SemiMajorAxisKm,
+ * \c InclinationDegrees, \c RaanDegrees and \c ArgumentOfLatitudeDegrees
+ * at simulation time zero. With \c EnableJ2 the node regresses and the
+ * argument of latitude advances at their secular J2 rates. The Sun moves
+ * along the ecliptic at its mean rate from \c SunLongitudeDegrees at time
+ * zero. The eclipse length and the beta angle therefore drift over a
+ * season, unlike in LeoCycleSolarIrradianceModel.
+ *
+ * On a circular orbit the shadow condition reduces to the argument of
+ * latitude u lying within alpha of the anti-Sun direction phi, where
+ * cos(alpha) = sqrt(1 - (R/a)^2) / cos(beta). The next entry or exit is
+ * therefore solved in closed form. The slow drift of phi and alpha
+ * during the solved interval is removed by a few fixed-point iterations.
+ * No eclipse happens while cos(beta) < sqrt(1 - (R/a)^2). GetSegment()
+ * then reports sunlight held for one orbit, and GetNextEclipseEntry()
+ * searches orbit by orbit for the next eclipse season.
+ *
+ * The segment containing the last query is cached, so queries at
+ * advancing simulation time within a phase cost a comparison.
+ * Attributes are read at the first query.
+ */
+class OrbitalEclipseSolarIrradianceModel : public SolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    OrbitalEclipseSolarIrradianceModel();
+    ~OrbitalEclipseSolarIrradianceModel() override;
+
+    double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
+
+    /** \return true if the satellite is outside the umbra at \p t. */
+    bool IsInSunlight(Time t) const;
+
+    /** \return The first instant after \p t at which an eclipse starts,
+     *          or Time::Max() if none within a year. */
+    Time GetNextEclipseEntry(Time t) const;
+
+    /** \return The first instant after \p t at which an eclipse ends,
+     *          or Time::Max() if none within a year. */
+    Time GetNextEclipseExit(Time t) const;
+
+    /**
+     * \return Every eclipse entry and exit in (\p from, \p until), in
+     *         order. Entries and exits alternate, starting with an exit
+     *         if \p from lies in umbra.
+     */
+    std::vector<Time> GetTransitions(Time from, Time until) const;
+
+    /** \return Angle between the orbit plane and the Sun direction at
+     *          \p t (degrees). */
+    double GetBetaAngleDegrees(Time t) const;
+
+    /** \return Period of the argument of latitude (nodal period). */
+    Time GetNodalPeriod() const;
+
+  private:
+    /** Shadow geometry of the orbit at one instant. */
+    struct Geometry
+    {
+        double u;     //!< Argument of latitude (rad)
+        double x;     //!< u relative to the anti-Sun direction, in (-pi, pi]
+        double alpha; //!< Half-width of the umbra arc (rad); negative if none
+    };
+
+    /** Derive the rates and constants from the attributes, once. */
+    void Prepare() const;
+
+    /** \return The shadow geometry at \p t. */
+    Geometry GetGeometry(Time t) const;
+
+    /** \return Whether \p g lies in umbra. */
+    static bool IsInUmbra(const Geometry& g);
+
+    /**
+     * \return The first transition after \p t, or Time::Max() if none
+     *         within \p horizon of it.
+     * \param t Query time.
+     * \param horizon Longest time to search.
+     */
+    Time FindNextTransition(Time t, Time horizon) const;
+
+    /**
+     * \return The transition solved from \p t towards the edge \p exit,
+     *         or Time::Max() if the umbra vanishes on the way.
+     */
+    Time SolveEdge(Time t, bool exit) const;
+
+    double m_peakWm2;
+    double m_semiMajorAxisKm;
+    double m_inclinationDegrees;
+    double m_raanDegrees;
+    double m_argumentOfLatitudeDegrees;
+    double m_sunLongitudeDegrees;
+    bool m_enableJ2;
+
+    // Derived at the first query
+    mutable bool m_prepared;
+    mutable double m_cosAlphaScale; // sqrt(1 - (R/a)^2)
+    mutable double m_uRate;         // rad/s
+    mutable double m_raanRate;      // rad/s
+
+    // Segment holding the last query
+    mutable SolarIrradianceSegment m_cache;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Immutable eclipse transitions of one reference orbit, shared by
+ *        every satellite of its orbital plane.
+ *
+ * Satellites of one plane see the eclipses of a reference satellite of
+ * that plane shifted by their angular distance to it along the orbit,
+ * divided by the rate of the argument of latitude (GetPhaseOffset()).
+ * The Sun and the node drift meanwhile, so the shifted edges are off by
+ * about a millisecond per second of shift in low Earth orbit; offsets
+ * are therefore taken within half an orbit either way. A
+ * schedule holds the sorted eclipse entries and exits of the reference
+ * orbit over a span once, and every ScheduledEclipseSolarIrradianceModel
+ * of the plane reads it with its own phase offset. Memory and precompute
+ * cost therefore scale with the number of planes, not of satellites.
+ *
+ * ForPlane() computes a schedule with OrbitalEclipseSolarIrradianceModel
+ * and shares it: planes with the same elements get the same schedule
+ * while any model still refers to it. Schedules from other sources, such
+ * as an external propagator, are built with Create().
+ */
+class EclipseSchedule : public SimpleRefCount<EclipseSchedule>
+{
+  public:
+    /**
+     * \brief Get the schedule of an orbital plane, computing it unless an
+     *        identical one is in use.
+     *
+     * The reference satellite is at argument of latitude zero at time
+     * zero. The schedule covers [0, \p until) widened by one nodal period
+     * on both sides, so that any phase offset within half an orbit stays
+     * inside it.
+     *
+     * \param semiMajorAxisKm Radius of the circular orbit (km).
+     * \param inclinationDegrees Inclination (degrees).
+     * \param raanDegrees Right ascension of the node at time zero (degrees).
+     * \param sunLongitudeDegrees Ecliptic longitude of the Sun at time zero.
+     * \param enableJ2 Whether the node and the argument of latitude drift.
+     * \param until End of the simulation span to cover.
+     */
+    static Ptr<const EclipseSchedule> ForPlane(double semiMajorAxisKm,
+                                               double inclinationDegrees,
+                                               double raanDegrees,
+                                               double sunLongitudeDegrees,
+                                               bool enableJ2,
+                                               Time until);
+
+    /**
+     * \brief Build a schedule from precomputed transitions.
+     *
+     * \param start Start of the span covered.
+     * \param end End of the span covered.
+     * \param litAtStart Whether the reference satellite is lit at \p start.
+     * \param transitions Sorted entries and exits in (start, end),
+     *        alternating from the state at \p start.
+     * \param nodalPeriod Period of the argument of latitude of the orbit.
+     */
+    static Ptr<const EclipseSchedule> Create(Time start,
+                                             Time end,
+                                             bool litAtStart,
+                                             std::vector<Time> transitions,
+                                             Time nodalPeriod);
+
+    ~EclipseSchedule();
+
+    /** \return Start of the span covered. */
+    Time GetStart() const;
+
+    /** \return End of the span covered. */
+    Time GetEnd() const;
+
+    /** \return Whether the reference satellite is lit at GetStart(). */
+    bool IsLitAtStart() const;
+
+    /** \return Number of entries and exits in the span. */
+    std::size_t GetNTransitions() const;
+
+    /** \return Transition \p i, with i < GetNTransitions(). */
+    Time GetTransition(std::size_t i) const;
+
+    /** \return Period of the argument of latitude of the orbit. */
+    Time GetNodalPeriod() const;
+
+    /**
+     * \return Time by which a satellite \p argumentOfLatitudeDegrees
+     *         ahead of the reference satellite leads its eclipses, to be
+     *         used as ScheduledEclipseSolarIrradianceModel::Phase.
+     *         The angle is wrapped into (-180, 180] degrees first.
+     */
+    Time GetPhaseOffset(double argumentOfLatitudeDegrees) const;
+
+  private:
+    /** Key of a schedule computed by ForPlane(). */
+    using PlaneKey = std::tuple<double, double, double, double, bool, int64_t>;
+
+    EclipseSchedule(Time start,
+                    Time end,
+                    bool litAtStart,
+                    std::vector<Time> transitions,
+                    Time nodalPeriod);
+
+    /** \return Schedules from ForPlane() still referenced, by plane. */
+    static std::map<PlaneKey, EclipseSchedule*>& GetPlanes();
+
+    Time m_start;
+    Time m_end;
+    bool m_litAtStart;
+    std::vector<Time> m_transitions;
+    Time m_nodalPeriod;
+    bool m_registered; // listed in GetPlanes() under m_key
+    PlaneKey m_key;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Sunlight/umbra irradiance read from a shared EclipseSchedule,
+ *        shifted by a per-satellite phase.
+ *
+ * The output at \c t is \c PeakWm2 if the schedule's reference satellite
+ * is lit at t + \c Phase, zero otherwise, like
+ * LeoCycleSolarIrradianceModel::PhaseSeconds for a fixed cycle. \c Phase
+ * is a Time, as EclipseSchedule::GetPhaseOffset() returns it. Each
+ * instance only keeps its phase and a lookup cursor. Segment merging and
+ * the forward-moving O(1) cursor are those of SampledSolarIrradianceModel.
+ * Outside the schedule's span the state at its nearest end is held.
+ */
+class ScheduledEclipseSolarIrradianceModel : public SampledSolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    ScheduledEclipseSolarIrradianceModel();
+    ~ScheduledEclipseSolarIrradianceModel() override;
+
+    /** Follow \p schedule. */
+    void SetSchedule(Ptr<const EclipseSchedule> schedule);
+
+    /** \return The schedule in use, or null if none is set. */
+    Ptr<const EclipseSchedule> GetSchedule() const;
+
+    /** Schedules are read-only; aborts. */
+    void AddSample(Time t, double wm2) override;
+
+    std::size_t GetNSamples() const override;
+
+  protected:
+    void DoDispose() override;
+    Time GetSampleTime(std::size_t i) const override;
+    double GetSampleValue(std::size_t i) const override;
+
+  private:
+    void SetPeakWm2(double wm2);
+    double GetPeakWm2() const;
+    void SetPhase(Time phase);
+    Time GetPhase() const;
+
+    Ptr<const EclipseSchedule> m_schedule;
+    double m_peakWm2;
+    Time m_phase;
+};
+
+} // namespace ns3
+
+#endif // NS3_ORBITAL_ECLIPSE_SOLAR_IRRADIANCE_MODEL_H
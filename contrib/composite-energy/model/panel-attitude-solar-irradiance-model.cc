@@ -0,0 +1,373 @@
+#include "panel-attitude-solar-irradiance-model.h"
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PanelAttitudeSolarIrradianceModel");
+
+namespace
+{
+
+/** \return \p v scaled to unit length, or \p v itself if it is zero. */
+Vector
+Normalize(const Vector& v)
+{
+    double length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    return length > 0.0 ? Vector(v.x / length, v.y / length, v.z / length) : v;
+}
+
+/** \return The dot product of \p a and \p b. */
+double
+Dot(const Vector& a, const Vector& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+/** \return The cross product of \p a and \p b. */
+Vector
+Cross(const Vector& a, const Vector& b)
+{
+    return Vector(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+/**
+ * \brief Lit projected area of panels [0, n): a_k * max(0, n_k . s_k).
+ *
+ * No branches and no reduction, so the loop vectorizes as it stands.
+ */
+void
+ProjectPanels(const double* nx,
+              const double* ny,
+              const double* nz,
+              const double* area,
+              const double* sx,
+              const double* sy,
+              const double* sz,
+              double* lit,
+              std::size_t n)
+{
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        double c = nx[k] * sx[k] + ny[k] * sy[k] + nz[k] * sz[k];
+        lit[k] = area[k] * std::max(c, 0.0);
+    }
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------
+// PanelAttitudeSolarIrradianceModel
+// -------------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED(PanelAttitudeSolarIrradianceModel);
+
+TypeId
+PanelAttitudeSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::PanelAttitudeSolarIrradianceModel")
+            .SetParent<SolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<PanelAttitudeSolarIrradianceModel>()
+            .AddAttribute("PeakWm2",
+                          "Solar power density when no source model is set (W/m^2).",
+                          DoubleValue(1361.0),
+                          MakeDoubleAccessor(&PanelAttitudeSolarIrradianceModel::m_peakWm2),
+                          MakeDoubleChecker<double>(0.0));
+    return tid;
+}
+
+PanelAttitudeSolarIrradianceModel::PanelAttitudeSolarIrradianceModel()
+    : m_peakWm2(1361.0),
+      m_sunDirection(1.0, 0.0, 0.0),
+      m_totalAreaM2(0.0),
+      m_attitudeCursor(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+PanelAttitudeSolarIrradianceModel::~PanelAttitudeSolarIrradianceModel() = default;
+
+void
+PanelAttitudeSolarIrradianceModel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_source = nullptr;
+    m_mobility = nullptr;
+    SolarIrradianceModel::DoDispose();
+}
+
+void
+PanelAttitudeSolarIrradianceModel::AddPanel(const Vector& normal, double areaM2)
+{
+    NS_LOG_FUNCTION(this << normal << areaM2);
+    Vector n = Normalize(normal);
+    NS_ABORT_MSG_IF(Dot(n, n) == 0.0, "Panel normal must not be zero");
+    NS_ABORT_MSG_IF(areaM2 < 0.0, "Panel area must not be negative");
+    m_nx.push_back(n.x);
+    m_ny.push_back(n.y);
+    m_nz.push_back(n.z);
+    m_area.push_back(areaM2);
+    m_totalAreaM2 += areaM2;
+}
+
+void
+PanelAttitudeSolarIrradianceModel::AddBoxPanels(double xAreaM2, double yAreaM2, double zAreaM2)
+{
+    NS_LOG_FUNCTION(this << xAreaM2 << yAreaM2 << zAreaM2);
+    AddPanel(Vector(1.0, 0.0, 0.0), xAreaM2);
+    AddPanel(Vector(-1.0, 0.0, 0.0), xAreaM2);
+    AddPanel(Vector(0.0, 1.0, 0.0), yAreaM2);
+    AddPanel(Vector(0.0, -1.0, 0.0), yAreaM2);
+    AddPanel(Vector(0.0, 0.0, 1.0), zAreaM2);
+    AddPanel(Vector(0.0, 0.0, -1.0), zAreaM2);
+}
+
+std::size_t
+PanelAttitudeSolarIrradianceModel::GetNPanels() const
+{
+    return m_area.size();
+}
+
+double
+PanelAttitudeSolarIrradianceModel::GetTotalAreaM2() const
+{
+    return m_totalAreaM2;
+}
+
+void
+PanelAttitudeSolarIrradianceModel::SetSource(Ptr<const SolarIrradianceModel> source)
+{
+    NS_LOG_FUNCTION(this << source);
+    m_source = source;
+}
+
+void
+PanelAttitudeSolarIrradianceModel::SetMobilityModel(Ptr<const MobilityModel> mobility)
+{
+    NS_LOG_FUNCTION(this << mobility);
+    m_mobility = mobility;
+}
+
+void
+PanelAttitudeSolarIrradianceModel::SetSunDirection(const Vector& direction)
+{
+    NS_LOG_FUNCTION(this << direction);
+    m_sunDirection = Normalize(direction);
+}
+
+void
+PanelAttitudeSolarIrradianceModel::AddAttitude(Time t, const Vector& sunBody)
+{
+    NS_LOG_FUNCTION(this << t << sunBody);
+    NS_ABORT_MSG_IF(!m_attitudeTimes.empty() && t < m_attitudeTimes.back(),
+                    "Attitude samples must be added in time order");
+    m_attitudeTimes.push_back(t);
+    m_attitudeSun.push_back(Normalize(sunBody));
+}
+
+std::ptrdiff_t
+PanelAttitudeSolarIrradianceModel::FindAttitude(Time t) const
+{
+    std::size_t n = m_attitudeTimes.size();
+    if (n == 0 || t < m_attitudeTimes[0])
+    {
+        return -1;
+    }
+    // Forward from the cursor as simulation time advances, else search.
+    std::size_t c = m_attitudeCursor;
+    if (c >= n || m_attitudeTimes[c] > t)
+    {
+        c = std::upper_bound(m_attitudeTimes.begin(), m_attitudeTimes.end(), t) -
+            m_attitudeTimes.begin() - 1;
+    }
+    while (c + 1 < n && m_attitudeTimes[c + 1] <= t)
+    {
+        ++c;
+    }
+    m_attitudeCursor = c;
+    return static_cast<std::ptrdiff_t>(c);
+}
+
+Vector
+PanelAttitudeSolarIrradianceModel::GetSunDirectionBody(Time t) const
+{
+    if (!m_attitudeTimes.empty())
+    {
+        // The first sample is held before it.
+        std::ptrdiff_t i = FindAttitude(t);
+        return m_attitudeSun[i < 0 ? 0 : static_cast<std::size_t>(i)];
+    }
+    if (!m_mobility)
+    {
+        return m_sunDirection;
+    }
+
+    // Nadir-pointing frame: z towards the centre, y against the orbit
+    // normal, x completing it (along the velocity on a circular orbit).
+    Vector r = m_mobility->GetPosition();
+    Vector z = Normalize(Vector(-r.x, -r.y, -r.z));
+    Vector h = Cross(r, m_mobility->GetVelocity());
+    if (Dot(h, h) == 0.0)
+    {
+        // No motion across the radius: any yaw will do.
+        h = Cross(r, std::abs(z.z) < 0.9 ? Vector(0.0, 0.0, 1.0) : Vector(1.0, 0.0, 0.0));
+    }
+    Vector y = Normalize(Vector(-h.x, -h.y, -h.z));
+    Vector x = Cross(y, z);
+    return Vector(Dot(m_sunDirection, x), Dot(m_sunDirection, y), Dot(m_sunDirection, z));
+}
+
+double
+PanelAttitudeSolarIrradianceModel::GetSourceWm2(Time t) const
+{
+    return m_source ? m_source->GetPowerDensityWm2(t) : m_peakWm2;
+}
+
+double
+PanelAttitudeSolarIrradianceModel::GetIncidenceFactor(Time t) const
+{
+    std::size_t n = m_area.size();
+    if (n == 0 || m_totalAreaM2 <= 0.0)
+    {
+        return 0.0;
+    }
+    Vector s = GetSunDirectionBody(t);
+    double litM2 = 0.0;
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        double c = m_nx[k] * s.x + m_ny[k] * s.y + m_nz[k] * s.z;
+        litM2 += m_area[k] * std::max(c, 0.0);
+    }
+    return litM2 / m_totalAreaM2;
+}
+
+double
+PanelAttitudeSolarIrradianceModel::GetPowerDensityWm2(Time t) const
+{
+    return GetSourceWm2(t) * GetIncidenceFactor(t);
+}
+
+SolarIrradianceSegment
+PanelAttitudeSolarIrradianceModel::GetSegment(Time t) const
+{
+    double factor = GetIncidenceFactor(t);
+    SolarIrradianceSegment source =
+        m_source ? m_source->GetSegment(t) : SolarIrradianceSegment{t, Time::Max(), m_peakWm2, 0.0};
+    if (m_attitudeTimes.empty() && m_mobility)
+    {
+        // The attitude follows the mobility model and cannot be foreseen.
+        return SolarIrradianceSegment{t, t, source.GetPowerDensityWm2(t) * factor, 0.0};
+    }
+
+    // The incidence holds until the next attitude sample, so the source
+    // segment, cut there, is only scaled.
+    Time start = source.start;
+    Time end = source.end;
+    if (!m_attitudeTimes.empty())
+    {
+        std::ptrdiff_t i = FindAttitude(t);
+        if (i >= 0)
+        {
+            start = std::max(start, m_attitudeTimes[i]);
+        }
+        if (static_cast<std::size_t>(i + 1) < m_attitudeTimes.size())
+        {
+            end = std::min(end, m_attitudeTimes[i + 1]);
+        }
+    }
+    if (end <= t)
+    {
+        return SolarIrradianceSegment{t, t, source.GetPowerDensityWm2(t) * factor, 0.0};
+    }
+    return SolarIrradianceSegment{start,
+                                  end,
+                                  source.GetPowerDensityWm2(start) * factor,
+                                  source.slopeWm2PerS * factor};
+}
+
+// -------------------------------------------------------------------------
+// PanelIncidenceBatch
+// -------------------------------------------------------------------------
+
+uint32_t
+PanelIncidenceBatch::Add(Ptr<const PanelAttitudeSolarIrradianceModel> model)
+{
+    NS_LOG_FUNCTION(this << model);
+    NS_ABORT_MSG_IF(!model, "PanelIncidenceBatch needs a model");
+    if (m_firstPanel.empty())
+    {
+        m_firstPanel.push_back(0);
+    }
+    m_models.push_back(model);
+    m_nx.insert(m_nx.end(), model->m_nx.begin(), model->m_nx.end());
+    m_ny.insert(m_ny.end(), model->m_ny.begin(), model->m_ny.end());
+    m_nz.insert(m_nz.end(), model->m_nz.begin(), model->m_nz.end());
+    m_area.insert(m_area.end(), model->m_area.begin(), model->m_area.end());
+    m_firstPanel.push_back(m_area.size());
+    m_totalAreaM2.push_back(model->m_totalAreaM2);
+    return static_cast<uint32_t>(m_models.size() - 1);
+}
+
+uint32_t
+PanelIncidenceBatch::GetN() const
+{
+    return static_cast<uint32_t>(m_models.size());
+}
+
+void
+PanelIncidenceBatch::Evaluate(Time t, std::vector<double>& wm2)
+{
+    NS_LOG_FUNCTION(this << t);
+    std::size_t panels = m_area.size();
+    m_sx.resize(panels);
+    m_sy.resize(panels);
+    m_sz.resize(panels);
+    m_lit.resize(panels);
+    wm2.assign(m_models.size(), 0.0);
+
+    // Spread each satellite's Sun direction over its panels ...
+    for (std::size_t i = 0; i < m_models.size(); ++i)
+    {
+        Vector s = m_models[i]->GetSunDirectionBody(t);
+        std::fill(m_sx.begin() + m_firstPanel[i], m_sx.begin() + m_firstPanel[i + 1], s.x);
+        std::fill(m_sy.begin() + m_firstPanel[i], m_sy.begin() + m_firstPanel[i + 1], s.y);
+        std::fill(m_sz.begin() + m_firstPanel[i], m_sz.begin() + m_firstPanel[i + 1], s.z);
+    }
+
+    // ... project every panel of every satellite in one pass ...
+    ProjectPanels(m_nx.data(),
+                  m_ny.data(),
+                  m_nz.data(),
+                  m_area.data(),
+                  m_sx.data(),
+                  m_sy.data(),
+                  m_sz.data(),
+                  m_lit.data(),
+                  panels);
+
+    // ... and sum each satellite's panels in the order of its own loop.
+    for (std::size_t i = 0; i < m_models.size(); ++i)
+    {
+        double totalM2 = m_totalAreaM2[i];
+        if (m_firstPanel[i] == m_firstPanel[i + 1] || totalM2 <= 0.0)
+        {
+            continue;
+        }
+        double litM2 = 0.0;
+        for (std::size_t k = m_firstPanel[i]; k < m_firstPanel[i + 1]; ++k)
+        {
+            litM2 += m_lit[k];
+        }
+        wm2[i] = m_models[i]->GetSourceWm2(t) * (litM2 / totalM2);
+    }
+}
+
+} // namespace ns3
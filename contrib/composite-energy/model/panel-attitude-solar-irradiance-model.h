@@ -0,0 +1,202 @@
+#ifndef NS3_PANEL_ATTITUDE_SOLAR_IRRADIANCE_MODEL_H
+#define NS3_PANEL_ATTITUDE_SOLAR_IRRADIANCE_MODEL_H
+
+#include "solar-irradiance-model.h"
+
+#include "ns3/mobility-model.h"
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Irradiance on a set of flat panels, from the attitude of the
+ *        spacecraft and the direction of the Sun.
+ *
+ * Each panel has an outward normal in the body frame and an area; body
+ * mounted faces and deployable wings are both added with AddPanel(). A
+ * panel collects the Sun's power density times the cosine of its
+ * incidence angle, and nothing when the Sun is behind it. The output is
+ * the area-weighted mean over all panels,
+ *
+ *   source(t) * sum_k(a_k * max(0, n_k . s(t))) / sum_k(a_k),
+ *
+ * so with CompositeEnergySource::PanelAreaM2 set to the total panel area
+ * the harvested power is the source density times the projected lit
+ * area. Panels do not shadow each other.
+ *
+ * The source density is that of SetSource() (e.g. an orbital eclipse
+ * model, which then also sets the eclipses), or \c PeakWm2 without one.
+ * The Sun direction s in the body frame comes from, in order of
+ * precedence:
+ *  - an attitude schedule of body-frame Sun directions added with
+ *    AddAttitude(), each held until the next one;
+ *  - a MobilityModel (SetMobilityModel()), flying nadir-pointing: body z
+ *    towards the centre of the frame, body y against the orbit normal
+ *    and body x along the velocity of a circular orbit. The Sun
+ *    direction set with SetSunDirection() is then in the mobility frame,
+ *    which must be centred on the Earth. A mobility model only knows the
+ *    current position, so queries must be at Simulator::Now() and
+ *    GetSegment() asks to be polled;
+ *  - otherwise a fixed attitude, with SetSunDirection() in the body frame.
+ *
+ * The incidence of all panels is one branch-free loop over contiguous
+ * arrays of normal components. PanelIncidenceBatch runs the same loop
+ * over the panels of many satellites at once.
+ */
+class PanelAttitudeSolarIrradianceModel : public SolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    PanelAttitudeSolarIrradianceModel();
+    ~PanelAttitudeSolarIrradianceModel() override;
+
+    /**
+     * \brief Add a panel.
+     *
+     * \param normal Outward normal in the body frame; need not be a unit
+     *        vector.
+     * \param areaM2 Panel area (m^2).
+     */
+    void AddPanel(const Vector& normal, double areaM2);
+
+    /**
+     * \brief Add the six faces of a body-mounted box, e.g. a CubeSat.
+     *
+     * \param xAreaM2 Area of each of the +x and -x faces (m^2).
+     * \param yAreaM2 Area of each of the +y and -y faces (m^2).
+     * \param zAreaM2 Area of each of the +z and -z faces (m^2).
+     */
+    void AddBoxPanels(double xAreaM2, double yAreaM2, double zAreaM2);
+
+    /** \return Number of panels. */
+    std::size_t GetNPanels() const;
+
+    /** \return Sum of the panel areas (m^2). */
+    double GetTotalAreaM2() const;
+
+    /** Take the source power density from \p source; null for \c PeakWm2. */
+    void SetSource(Ptr<const SolarIrradianceModel> source);
+
+    /** Fly nadir-pointing along \p mobility; null for a fixed attitude. */
+    void SetMobilityModel(Ptr<const MobilityModel> mobility);
+
+    /**
+     * \brief Set the direction of the Sun, in the mobility frame with a
+     *        MobilityModel and in the body frame otherwise.
+     *
+     * \param direction Direction to the Sun; need not be a unit vector.
+     */
+    void SetSunDirection(const Vector& direction);
+
+    /**
+     * \brief Append an attitude sample.
+     *
+     * \param t Sample time; must not precede the previous sample.
+     * \param sunBody Direction to the Sun in the body frame from \p t on.
+     */
+    void AddAttitude(Time t, const Vector& sunBody);
+
+    /** \return Unit direction to the Sun in the body frame at \p t. */
+    Vector GetSunDirectionBody(Time t) const;
+
+    /** \return Source power density at \p t (W/m^2), before incidence. */
+    double GetSourceWm2(Time t) const;
+
+    /**
+     * \return Area-weighted mean cosine of incidence over the panels at
+     *         \p t, in [0, 1]; zero without panels.
+     */
+    double GetIncidenceFactor(Time t) const;
+
+    double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    friend class PanelIncidenceBatch;
+
+    /** \return Index of the last attitude sample at or before \p t, or -1. */
+    std::ptrdiff_t FindAttitude(Time t) const;
+
+    double m_peakWm2;
+    Ptr<const SolarIrradianceModel> m_source;
+    Ptr<const MobilityModel> m_mobility;
+    Vector m_sunDirection; // unit
+
+    // Panels, structure-of-arrays
+    std::vector<double> m_nx;
+    std::vector<double> m_ny;
+    std::vector<double> m_nz;
+    std::vector<double> m_area;
+    double m_totalAreaM2;
+
+    // Attitude schedule of unit Sun directions
+    std::vector<Time> m_attitudeTimes;
+    std::vector<Vector> m_attitudeSun;
+    mutable std::size_t m_attitudeCursor; // last index returned by FindAttitude()
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Evaluates the panel irradiance of many satellites in one pass.
+ *
+ * The panels of every model added are copied into flat arrays once.
+ * Evaluate() asks each model for its body-frame Sun direction and source
+ * density, spreads the direction over that model's panels, computes the
+ * incidence of all panels of all satellites in one branch-free loop the
+ * compiler can vectorize, and sums each satellite's panels. The result
+ * matches each model's own GetPowerDensityWm2() to rounding.
+ *
+ * Panels added to a model after it joined the batch are not seen.
+ */
+class PanelIncidenceBatch
+{
+  public:
+    /**
+     * \brief Add a model.
+     *
+     * \return Index of the model's entry in the results of Evaluate().
+     */
+    uint32_t Add(Ptr<const PanelAttitudeSolarIrradianceModel> model);
+
+    /** \return Number of models. */
+    uint32_t GetN() const;
+
+    /**
+     * \brief Power density of every model at \p t.
+     *
+     * \param t Query time.
+     * \param wm2 Resized to GetN() and filled with each model's W/m^2.
+     */
+    void Evaluate(Time t, std::vector<double>& wm2);
+
+  private:
+    std::vector<Ptr<const PanelAttitudeSolarIrradianceModel>> m_models;
+    std::vector<std::size_t> m_firstPanel; // per model, plus the end
+    std::vector<double> m_totalAreaM2;     // per model
+
+    // Panels of all models, structure-of-arrays
+    std::vector<double> m_nx;
+    std::vector<double> m_ny;
+    std::vector<double> m_nz;
+    std::vector<double> m_area;
+
+    // Per-panel scratch of Evaluate()
+    std::vector<double> m_sx;
+    std::vector<double> m_sy;
+    std::vector<double> m_sz;
+    std::vector<double> m_lit;
+};
+
+} // namespace ns3
+
+#endif // NS3_PANEL_ATTITUDE_SOLAR_IRRADIANCE_MODEL_H
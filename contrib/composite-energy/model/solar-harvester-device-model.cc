@@ -5,6 +5,10 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace ns3
 {
 
@@ -14,10 +18,17 @@ NS_OBJECT_ENSURE_REGISTERED(SolarHarvesterDeviceModel);
 TypeId
 SolarHarvesterDeviceModel::GetTypeId()
 {
-    static TypeId tid = TypeId("ns3::SolarHarvesterDeviceModel")
-                            .SetParent<DeviceEnergyModel>()
-                            .SetGroupName("Energy")
-                            .AddConstructor<SolarHarvesterDeviceModel>();
+    static TypeId tid =
+        TypeId("ns3::SolarHarvesterDeviceModel")
+            .SetParent<DeviceEnergyModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<SolarHarvesterDeviceModel>()
+            .AddTraceSource("HotPath",
+                            "A profiled call returned, with its wall time. Only fires while "
+                            "profiling (see CompositeEnergySource::EnableProfiling).",
+                            MakeTraceSourceAccessor(
+                                &SolarHarvesterDeviceModel::m_hotPathTrace),
+                            "ns3::HotPathProfile::TracedCallback");
     return tid;
 }
 
@@ -26,7 +37,13 @@ SolarHarvesterDeviceModel::SolarHarvesterDeviceModel()
       m_harvestCurrentA(0.0),
       m_harvestPowerW(0.0),
       m_totalHarvestedJ(0.0),
-      m_lastUpdate(Seconds(0))
+      m_lastUpdate(Seconds(0)),
+      m_profile(nullptr),
+      m_profileScale(0.0),
+      m_powerLimitW(std::numeric_limits<double>::infinity()),
+      m_enabled(false),
+      m_pendingJ(0.0),
+      m_hotPathProfile(nullptr)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -71,6 +88,11 @@ SolarHarvesterDeviceModel::HandleEnergyDepletion()
     NS_LOG_FUNCTION(this);
     // Battery flat: stop reporting charge current so the source does not
     // immediately re-hydrate itself from a depleted state via us.
+    if (m_profile)
+    {
+        SetHarvestEnabled(false);
+        return;
+    }
     SetHarvestCurrentA(0.0);
 }
 
@@ -91,6 +113,7 @@ void
 SolarHarvesterDeviceModel::SetHarvestCurrentA(double a)
 {
     NS_LOG_FUNCTION(this << a);
+    HotPathTimer timer(m_hotPathProfile.get(), HotPathProfile::SET_HARVEST_CURRENT, m_hotPathTrace);
     if (a < 0.0)
     {
         a = 0.0;
@@ -117,11 +140,191 @@ SolarHarvesterDeviceModel::GetTotalHarvestedEnergy() const
     return m_totalHarvestedJ;
 }
 
+void
+SolarHarvesterDeviceModel::RestoreTotalHarvestedEnergy(double energyJ)
+{
+    NS_LOG_FUNCTION(this << energyJ);
+    m_totalHarvestedJ = energyJ;
+}
+
+void
+SolarHarvesterDeviceModel::Deliver(double energyJ, Time spanStart, double voltageV)
+{
+    NS_LOG_FUNCTION(this << energyJ << spanStart << voltageV);
+    HotPathTimer timer(m_hotPathProfile.get(), HotPathProfile::SETTLE, m_hotPathTrace);
+    Time now = Simulator::Now();
+    double span = (now - spanStart).GetSeconds();
+    if (span > 0.0)
+    {
+        m_harvestCurrentA = voltageV > 0.0 ? energyJ / (voltageV * span) : 0.0;
+    }
+    m_harvestPowerW = 0.0;
+    m_totalHarvestedJ += energyJ;
+    m_lastUpdate = now;
+}
+
+void
+SolarHarvesterDeviceModel::SetHarvestProfile(Ptr<const SolarIrradianceModel> model, double scale)
+{
+    NS_LOG_FUNCTION(this << model << scale);
+    if (model == m_profile && scale == m_profileScale)
+    {
+        return;
+    }
+    SetHarvestEnabled(m_enabled);
+    m_profile = model;
+    m_profileScale = scale;
+}
+
+void
+SolarHarvesterDeviceModel::SetHarvestEnabled(bool enabled)
+{
+    NS_LOG_FUNCTION(this << enabled);
+    Time now = Simulator::Now();
+    if (m_profile && m_enabled && now > m_lastUpdate)
+    {
+        Time crossing;
+        double energy = Integrate(m_lastUpdate,
+                                  now,
+                                  0.0,
+                                  std::numeric_limits<double>::infinity(),
+                                  0.0,
+                                  crossing);
+        m_pendingJ += energy;
+        m_totalHarvestedJ += energy;
+    }
+    m_lastUpdate = now;
+    m_enabled = enabled;
+}
+
+bool
+SolarHarvesterDeviceModel::IsHarvestEnabled() const
+{
+    return m_profile && m_enabled;
+}
+
+void
+SolarHarvesterDeviceModel::SetHarvestPowerLimit(double limitW)
+{
+    NS_LOG_FUNCTION(this << limitW);
+    if (limitW == m_powerLimitW)
+    {
+        return;
+    }
+    SetHarvestEnabled(m_enabled);
+    m_powerLimitW = limitW;
+}
+
+double
+SolarHarvesterDeviceModel::GetHarvestPowerLimit() const
+{
+    return m_powerLimitW;
+}
+
+double
+SolarHarvesterDeviceModel::GetHarvestPowerW(Time t) const
+{
+    return IsHarvestEnabled()
+               ? std::min(m_profileScale * m_profile->GetPowerDensityWm2(t), m_powerLimitW)
+               : 0.0;
+}
+
+double
+SolarHarvesterDeviceModel::Settle(Time spanStart,
+                                  double voltageV,
+                                  double headroomJ,
+                                  double loadW)
+{
+    NS_LOG_FUNCTION(this << spanStart << voltageV << headroomJ << loadW);
+    HotPathTimer timer(m_hotPathProfile.get(), HotPathProfile::SETTLE, m_hotPathTrace);
+    if (!m_profile)
+    {
+        double before = m_totalHarvestedJ;
+        AccrueSinceLastUpdate();
+        return m_totalHarvestedJ - before;
+    }
+
+    Accrue(spanStart, headroomJ, loadW);
+    Time now = Simulator::Now();
+    double delivered = m_pendingJ;
+    m_pendingJ = 0.0;
+    double span = (now - spanStart).GetSeconds();
+    // A zero span delivers nothing, so the current is the one in force
+    // from now on, at the voltage the source expects to hold.
+    double powerW = (span > 0.0) ? delivered / span : GetHarvestPowerW(now);
+    m_harvestCurrentA = (voltageV > 0.0) ? powerW / voltageV : 0.0;
+    return delivered;
+}
+
+void
+SolarHarvesterDeviceModel::Accrue(Time spanStart, double headroomJ, double loadW)
+{
+    NS_LOG_FUNCTION(this << spanStart << headroomJ << loadW);
+    Time now = Simulator::Now();
+    if (!m_profile)
+    {
+        return;
+    }
+    if (m_enabled && now > m_lastUpdate)
+    {
+        // Energy accrued earlier in this span already counts against the
+        // headroom, as does the load drawn meanwhile.
+        Time from = Max(m_lastUpdate, spanStart);
+        double netJ = m_pendingJ - loadW * (from - spanStart).GetSeconds();
+        Time crossing;
+        double energy = Integrate(from, now, netJ, headroomJ, loadW, crossing);
+        m_pendingJ += energy;
+        m_totalHarvestedJ += energy;
+        if (crossing != Time::Max())
+        {
+            NS_LOG_DEBUG("headroom of " << headroomJ << " J used up at "
+                                        << crossing.GetSeconds() << " s");
+            m_enabled = false;
+        }
+    }
+    m_lastUpdate = now;
+}
+
+double
+SolarHarvesterDeviceModel::GetPendingEnergy() const
+{
+    return m_pendingJ;
+}
+
+Time
+SolarHarvesterDeviceModel::PredictCrossing(Time from,
+                                           Time until,
+                                           double headroomJ,
+                                           double loadW) const
+{
+    if (!IsHarvestEnabled() || until <= from)
+    {
+        return Time::Max();
+    }
+    Time crossing;
+    Integrate(from, until, 0.0, headroomJ, loadW, crossing);
+    return crossing;
+}
+
+void
+SolarHarvesterDeviceModel::SetProfile(std::shared_ptr<HotPathProfile> profile)
+{
+    NS_LOG_FUNCTION(this);
+    m_hotPathProfile = profile;
+}
+
+const HotPathProfile*
+SolarHarvesterDeviceModel::GetProfile() const
+{
+    return m_hotPathProfile.get();
+}
+
 void
 SolarHarvesterDeviceModel::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     m_source = nullptr;
+    m_profile = nullptr;
     DeviceEnergyModel::DoDispose();
 }
 
@@ -145,4 +348,91 @@ SolarHarvesterDeviceModel::AccrueSinceLastUpdate()
     m_lastUpdate = now;
 }
 
+double
+SolarHarvesterDeviceModel::Integrate(Time from,
+                                     Time to,
+                                     double netJ,
+                                     double headroomJ,
+                                     double loadW,
+                                     Time& crossing) const
+{
+    auto segmentAt = [this](Time t) {
+        SolarIrradianceSegment segment = m_profile->GetSegment(t);
+        segment.startWm2 *= m_profileScale;
+        segment.slopeWm2PerS *= m_profileScale;
+        return ClipHarvestSegment(segment, t, m_powerLimitW);
+    };
+    return IntegrateHarvest(segmentAt, from, to, netJ, headroomJ, loadW, crossing);
+}
+
+// -------------------------------------------------------------------------
+// Free functions
+// -------------------------------------------------------------------------
+
+SolarIrradianceSegment
+ClipHarvestSegment(const SolarIrradianceSegment& segment, Time t, double limitW)
+{
+    if (!(limitW < std::numeric_limits<double>::infinity()))
+    {
+        return segment;
+    }
+    double powerW = segment.GetPowerDensityWm2(t);
+    if (!segment.IsKnown() || segment.end <= t)
+    {
+        // Held at its value: hold the clipped value instead.
+        return SolarIrradianceSegment{t, segment.end, std::min(powerW, limitW), 0.0};
+    }
+    // Instant at which a ramp meets the limit; at least one step on, so
+    // that the walk over the pieces always advances.
+    double slope = segment.slopeWm2PerS;
+    auto meets = [&](double seconds) { return Max(t + Seconds(seconds), t + TimeStep(1)); };
+    if (powerW >= limitW)
+    {
+        Time end = (slope < 0.0) ? Min(segment.end, meets((powerW - limitW) / -slope))
+                                 : segment.end;
+        return SolarIrradianceSegment{t, end, limitW, 0.0};
+    }
+    if (slope > 0.0)
+    {
+        return SolarIrradianceSegment{segment.start,
+                                      Min(segment.end, meets((limitW - powerW) / slope)),
+                                      segment.startWm2,
+                                      slope};
+    }
+    return segment;
+}
+
+double
+SolveHarvestCrossing(double netJ, double headroomJ, double powerW, double slopeWPerS, double loadW)
+{
+    // Written as c2 tau^2 + c1 tau + c0 = 0, with c0 < 0 unless the
+    // headroom is already used up.
+    double c0 = netJ - headroomJ;
+    double c1 = powerW - loadW;
+    double c2 = 0.5 * slopeWPerS;
+    if (c0 >= 0.0)
+    {
+        return 0.0;
+    }
+    if (c2 == 0.0)
+    {
+        return (c1 > 0.0) ? -c0 / c1 : -1.0;
+    }
+    double disc = c1 * c1 - 4.0 * c2 * c0;
+    if (disc < 0.0)
+    {
+        return -1.0;
+    }
+    // Numerically stable roots; with c0 < 0 a positive root is unique when
+    // c2 > 0, and the smaller of two when c2 < 0.
+    double q = -0.5 * (c1 + std::copysign(std::sqrt(disc), c1));
+    double r1 = q / c2;
+    double r2 = (q != 0.0) ? c0 / q : -1.0;
+    if (r1 >= 0.0 && r2 >= 0.0)
+    {
+        return std::min(r1, r2);
+    }
+    return std::max(r1, r2);
+}
+
 } // namespace ns3
@@ -1,6 +1,9 @@
 #ifndef NS3_SOLAR_HARVESTER_DEVICE_MODEL_H
 #define NS3_SOLAR_HARVESTER_DEVICE_MODEL_H
 
+#include "hot-path-profile.h"
+#include "solar-irradiance-model.h"
+
 #include "ns3/device-energy-model.h"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
@@ -10,6 +13,88 @@ namespace ns3
 
 class EnergySource;
 
+/**
+ * \ingroup composite-energy
+ * \brief First instant at which a harvest piece uses up a headroom.
+ *
+ * Over a piece whose harvest power is \p powerW + \p slopeWPerS * tau, the
+ * net energy netJ + (powerW - loadW) tau + slopeWPerS tau^2 / 2 is a
+ * quadratic in tau.
+ *
+ * \return The smallest tau >= 0 at which it reaches \p headroomJ, or a
+ *         negative value if it never does.
+ */
+double SolveHarvestCrossing(double netJ,
+                            double headroomJ,
+                            double powerW,
+                            double slopeWPerS,
+                            double loadW);
+
+/**
+ * \ingroup composite-energy
+ * \brief Clip a harvest power segment to a power limit.
+ *
+ * \param segment Segment of the harvest power (W) holding at \p t.
+ * \param t Query time.
+ * \param limitW Largest power (W); infinity leaves \p segment unchanged.
+ * \return The segment of min(power, \p limitW) from \p t on: the limit
+ *         itself while the power is above it, and the power otherwise,
+ *         each ending where a ramp meets the limit.
+ */
+SolarIrradianceSegment ClipHarvestSegment(const SolarIrradianceSegment& segment,
+                                          Time t,
+                                          double limitW);
+
+/**
+ * \ingroup composite-energy
+ * \brief Integrate a harvest power profile over [from, to], stopping where
+ *        a headroom is used up.
+ *
+ * Walks the segments returned by \p segmentAt; a segment that is not
+ * known is held at its value. The running net energy starts at \p netJ
+ * and grows by the harvest power less \p loadW; the walk stops at the
+ * first instant it reaches \p headroomJ (see SolveHarvestCrossing()).
+ *
+ * \tparam SegmentAt Callable returning the SolarIrradianceSegment of the
+ *         harvest power (in W rather than W/m^2) from a given Time on.
+ * \param crossing Set to the crossing time, or Time::Max() if none.
+ * \return Energy harvested up to \p to or to the crossing (J).
+ */
+template <class SegmentAt>
+double
+IntegrateHarvest(SegmentAt segmentAt,
+                 Time from,
+                 Time to,
+                 double netJ,
+                 double headroomJ,
+                 double loadW,
+                 Time& crossing)
+{
+    crossing = Time::Max();
+    double energy = 0.0;
+    Time t = from;
+    while (t < to)
+    {
+        SolarIrradianceSegment segment = segmentAt(t);
+        bool known = segment.IsKnown() && segment.end > t;
+        Time end = known ? Min(segment.end, to) : to;
+        double length = (end - t).GetSeconds();
+        double a = segment.GetPowerDensityWm2(t);
+        double b = known ? segment.slopeWm2PerS : 0.0;
+        double tau = SolveHarvestCrossing(netJ, headroomJ, a, b, loadW);
+        if (tau >= 0.0 && tau <= length)
+        {
+            crossing = Min(t + Seconds(tau), end);
+            return energy + a * tau + 0.5 * b * tau * tau;
+        }
+        double piece = a * length + 0.5 * b * length * length;
+        energy += piece;
+        netJ += piece - loadW * length;
+        t = end;
+    }
+    return energy;
+}
+
 /**
  * \ingroup composite-energy
  * \brief DeviceEnergyModel that injects solar-harvested energy into an
@@ -25,9 +110,20 @@ class EnergySource;
  * derive I = P / V, so the injected energy equals P * dt irrespective of
  * any voltage drift inside the battery model.
  *
- * The public API is intentionally minimal: one setter, SetHarvestCurrentA,
- * which accepts the (non-negative) magnitude of the charge current the
- * caller wants to inject. The model reports -magnitude to the source.
+ * The model runs in one of two modes:
+ *  - Current mode (default): SetHarvestCurrentA accepts the
+ *    (non-negative) magnitude of the charge current the caller wants to
+ *    inject, and the model reports -magnitude to the source until the
+ *    next call.
+ *  - Profile mode: SetHarvestProfile hands the model a
+ *    SolarIrradianceModel and a scale, so that the harvested power is
+ *    P(t) = scale * GetPowerDensityWm2(t). The owning source calls
+ *    Settle() just before each of its updates; the model integrates P(t)
+ *    in closed form over the irradiance segments of the elapsed span and
+ *    reports the average current that injects exactly that energy. The
+ *    span can therefore be arbitrarily long without loss of accuracy, and
+ *    an energy headroom passed to Settle() is honoured to the instant at
+ *    which it is used up rather than to the next update.
  */
 class SolarHarvesterDeviceModel : public DeviceEnergyModel
 {
@@ -58,6 +154,114 @@ class SolarHarvesterDeviceModel : public DeviceEnergyModel
     /** \return Total harvested energy in Joules since construction. */
     double GetTotalHarvestedEnergy() const;
 
+    /**
+     * \brief Carry on the harvested total of an earlier run.
+     *
+     * \param energyJ Total the model starts from instead of 0 (J).
+     */
+    void RestoreTotalHarvestedEnergy(double energyJ);
+
+    /**
+     * \brief Deliver energy harvested elsewhere (current mode).
+     *
+     * Sets the reported current to the value which, held at \p voltageV
+     * since \p spanStart, injects exactly \p energyJ, and adds it to the
+     * harvested total. Used when the harvest power is integrated by a
+     * CompositeEnergyFleet rather than by this model.
+     */
+    void Deliver(double energyJ, Time spanStart, double voltageV);
+
+    /**
+     * \brief Switch to profile mode (or back to current mode).
+     *
+     * Energy harvested under the previous profile is accrued first.
+     *
+     * \param model Irradiance profile, or nullptr for current mode.
+     * \param scale Factor (m^2) turning W/m^2 into injected W.
+     */
+    void SetHarvestProfile(Ptr<const SolarIrradianceModel> model, double scale);
+
+    /**
+     * \brief Start or stop harvesting in profile mode.
+     *
+     * Energy harvested up to now is accrued first. Settle() disables
+     * harvesting itself when its headroom is used up.
+     */
+    void SetHarvestEnabled(bool enabled);
+
+    /** \return Whether the profile is currently being harvested. */
+    bool IsHarvestEnabled() const;
+
+    /**
+     * \brief Cap the harvested power in profile mode.
+     *
+     * Energy harvested up to now is accrued first. The profile is clipped
+     * to \p limitW from now on, exactly over its segments.
+     *
+     * \param limitW Largest power injected (W); infinity (default) for none.
+     */
+    void SetHarvestPowerLimit(double limitW);
+
+    /** \return The cap on the harvested power (W). */
+    double GetHarvestPowerLimit() const;
+
+    /**
+     * \return Profile power (W) at \p t, capped by the power limit; 0 when
+     *         disabled or in current mode.
+     */
+    double GetHarvestPowerW(Time t) const;
+
+    /**
+     * \brief Deliver the energy harvested since \p spanStart.
+     *
+     * Integrates the profile up to now and sets the reported current to
+     * the value which, held at \p voltageV over [spanStart, now], injects
+     * exactly that energy. Harvesting stops (and the model disables
+     * itself) at the instant the harvested energy net of the load \p loadW
+     * reaches \p headroomJ. Over an empty span the current is the power
+     * in force from now on at \p voltageV. In current mode this only
+     * accrues.
+     *
+     * \param spanStart Time of the source's previous update.
+     * \param voltageV Voltage the source integrates the span with, or
+     *        will hold from now on if the span is empty.
+     * \param headroomJ Energy the source can still take (J).
+     * \param loadW Power drawn by the other devices over the span (W).
+     * \return Energy delivered over the span (J).
+     */
+    double Settle(Time spanStart, double voltageV, double headroomJ, double loadW);
+
+    /**
+     * \brief Accrue the energy harvested up to now without delivering it.
+     *
+     * Same integral as Settle(), with the same arguments, so the source
+     * can learn its state between two of its updates; the energy is
+     * delivered by the next Settle(). No-op outside profile mode.
+     */
+    void Accrue(Time spanStart, double headroomJ, double loadW);
+
+    /** \return Energy accrued since the last Settle(), not yet delivered (J). */
+    double GetPendingEnergy() const;
+
+    /**
+     * \return The first instant in [from, until) at which the energy
+     *         harvested from \p from on, net of the load \p loadW, reaches
+     *         \p headroomJ, or Time::Max() if there is none. Always
+     *         Time::Max() when harvesting is disabled.
+     */
+    Time PredictCrossing(Time from, Time until, double headroomJ, double loadW) const;
+
+    /**
+     * \brief Profile SetHarvestCurrentA(), Settle() and Deliver() into
+     *        \p profile (null stops profiling).
+     *
+     * Set by the owning source when its EnableProfiling attribute is true.
+     */
+    void SetProfile(std::shared_ptr<HotPathProfile> profile);
+
+    /** \return The hot-path profile, or null when not profiling. */
+    const HotPathProfile* GetProfile() const;
+
   protected:
     void DoDispose() override;
     double DoGetCurrentA() const override;
@@ -72,11 +276,30 @@ class SolarHarvesterDeviceModel : public DeviceEnergyModel
      */
     void AccrueSinceLastUpdate();
 
+    /** IntegrateHarvest() over the scaled profile. */
+    double Integrate(Time from,
+                     Time to,
+                     double netJ,
+                     double headroomJ,
+                     double loadW,
+                     Time& crossing) const;
+
     Ptr<EnergySource> m_source;
     double m_harvestCurrentA; // magnitude; reported as -m_harvestCurrentA
     double m_harvestPowerW;   // = m_harvestCurrentA * V at time of setter
     double m_totalHarvestedJ;
     Time m_lastUpdate;
+
+    // Profile mode
+    Ptr<const SolarIrradianceModel> m_profile;
+    double m_profileScale;
+    double m_powerLimitW;
+    bool m_enabled;
+    double m_pendingJ; // accrued since the last Settle(), not yet delivered
+
+    // Opt-in profiling, and the "HotPath" trace source
+    std::shared_ptr<HotPathProfile> m_hotPathProfile;
+    TracedCallback<HotPathProfile::Path, Time> m_hotPathTrace;
 };
 
 } // namespace ns3
@@ -1,8 +1,11 @@
 #include "solar-irradiance-model.h"
 
+#include "ns3/abort.h"
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/log.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace ns3
@@ -10,6 +13,34 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("SolarIrradianceModel");
 
+// -------------------------------------------------------------------------
+// SolarIrradianceSegment
+// -------------------------------------------------------------------------
+
+double
+SolarIrradianceSegment::GetPowerDensityWm2(Time t) const
+{
+    if (slopeWm2PerS == 0.0)
+    {
+        return startWm2;
+    }
+    return startWm2 + slopeWm2PerS * (t - start).GetSeconds();
+}
+
+double
+SolarIrradianceSegment::Integrate(Time from, Time to) const
+{
+    // Trapezoid rule, exact for a linear segment.
+    double dt = (to - from).GetSeconds();
+    return 0.5 * (GetPowerDensityWm2(from) + GetPowerDensityWm2(to)) * dt;
+}
+
+bool
+SolarIrradianceSegment::IsKnown() const
+{
+    return end > start;
+}
+
 // -------------------------------------------------------------------------
 // SolarIrradianceModel (abstract base)
 // -------------------------------------------------------------------------
@@ -26,6 +57,27 @@ SolarIrradianceModel::GetTypeId()
 
 SolarIrradianceModel::~SolarIrradianceModel() = default;
 
+SolarIrradianceSegment
+SolarIrradianceModel::GetSegment(Time t) const
+{
+    return SolarIrradianceSegment{t, t, GetPowerDensityWm2(t), 0.0};
+}
+
+void
+SolarIrradianceModel::GetPowerDensitiesWm2(const Time* times, double* wm2, std::size_t n) const
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        wm2[i] = GetPowerDensityWm2(times[i]);
+    }
+}
+
+Time
+SolarIrradianceModel::GetNextChangeTime(Time t) const
+{
+    return GetSegment(t).end;
+}
+
 // -------------------------------------------------------------------------
 // ConstantSolarIrradianceModel
 // -------------------------------------------------------------------------
@@ -60,6 +112,12 @@ ConstantSolarIrradianceModel::GetPowerDensityWm2(Time /*t*/) const
     return m_wm2;
 }
 
+SolarIrradianceSegment
+ConstantSolarIrradianceModel::GetSegment(Time t) const
+{
+    return SolarIrradianceSegment{t, Time::Max(), m_wm2, 0.0};
+}
+
 // -------------------------------------------------------------------------
 // LeoCycleSolarIrradianceModel
 // -------------------------------------------------------------------------
@@ -82,46 +140,181 @@ LeoCycleSolarIrradianceModel::GetTypeId()
             .AddAttribute("SunlightSeconds",
                           "Sunlight duration per cycle (s).",
                           DoubleValue(3900.0),
-                          MakeDoubleAccessor(&LeoCycleSolarIrradianceModel::m_sunlightSeconds),
+                          MakeDoubleAccessor(&LeoCycleSolarIrradianceModel::SetSunlightSeconds,
+                                             &LeoCycleSolarIrradianceModel::GetSunlightSeconds),
                           MakeDoubleChecker<double>(0.0))
             .AddAttribute("ShadowSeconds",
                           "Shadow (umbra) duration per cycle (s).",
                           DoubleValue(1800.0),
-                          MakeDoubleAccessor(&LeoCycleSolarIrradianceModel::m_shadowSeconds),
+                          MakeDoubleAccessor(&LeoCycleSolarIrradianceModel::SetShadowSeconds,
+                                             &LeoCycleSolarIrradianceModel::GetShadowSeconds),
                           MakeDoubleChecker<double>(0.0))
             .AddAttribute("PhaseSeconds",
                           "Phase offset into the cycle at simulation start (s). 0 means "
                           "start at the beginning of the sunlight phase.",
                           DoubleValue(0.0),
-                          MakeDoubleAccessor(&LeoCycleSolarIrradianceModel::m_phaseSeconds),
+                          MakeDoubleAccessor(&LeoCycleSolarIrradianceModel::SetPhaseSeconds,
+                                             &LeoCycleSolarIrradianceModel::GetPhaseSeconds),
                           MakeDoubleChecker<double>(0.0));
     return tid;
 }
 
 LeoCycleSolarIrradianceModel::LeoCycleSolarIrradianceModel()
     : m_peakWm2(1361.0),
-      m_sunlightSeconds(3900.0),
-      m_shadowSeconds(1800.0),
-      m_phaseSeconds(0.0)
+      m_sunlightSeconds(0.0),
+      m_shadowSeconds(0.0),
+      m_phaseSeconds(0.0),
+      m_sunlight(0),
+      m_period(0),
+      m_offset(0),
+      m_cycleStart(0),
+      m_cached(false)
 {
+    SetSunlightSeconds(3900.0);
+    SetShadowSeconds(1800.0);
 }
 
 LeoCycleSolarIrradianceModel::~LeoCycleSolarIrradianceModel() = default;
 
+void
+LeoCycleSolarIrradianceModel::SetSunlightSeconds(double seconds)
+{
+    int64_t shadow = m_period - m_sunlight;
+    m_sunlightSeconds = seconds;
+    m_sunlight = Seconds(seconds).GetTimeStep();
+    m_period = m_sunlight + shadow;
+    m_cached = false;
+}
+
+double
+LeoCycleSolarIrradianceModel::GetSunlightSeconds() const
+{
+    return m_sunlightSeconds;
+}
+
+void
+LeoCycleSolarIrradianceModel::SetShadowSeconds(double seconds)
+{
+    m_shadowSeconds = seconds;
+    m_period = m_sunlight + Seconds(seconds).GetTimeStep();
+    m_cached = false;
+}
+
+double
+LeoCycleSolarIrradianceModel::GetShadowSeconds() const
+{
+    return m_shadowSeconds;
+}
+
+void
+LeoCycleSolarIrradianceModel::SetPhaseSeconds(double seconds)
+{
+    m_phaseSeconds = seconds;
+    m_offset = Seconds(seconds).GetTimeStep();
+    m_cached = false;
+}
+
+double
+LeoCycleSolarIrradianceModel::GetPhaseSeconds() const
+{
+    return m_phaseSeconds;
+}
+
+bool
+LeoCycleSolarIrradianceModel::IsPeriodic() const
+{
+    return m_sunlight > 0 && m_period > m_sunlight;
+}
+
+int64_t
+LeoCycleSolarIrradianceModel::GetPhase(Time t) const
+{
+    // The phase is computed in whole time steps rather than with fmod() on
+    // seconds, so that the value and the reported boundaries agree exactly:
+    // a consumer woken at a segment end always sees the new phase.
+    int64_t ts = t.GetTimeStep();
+    if (m_cached && ts >= m_cycleStart)
+    {
+        int64_t phase = ts - m_cycleStart;
+        if (phase < m_period)
+        {
+            return phase;
+        }
+        if (phase - m_period < m_period)
+        {
+            m_cycleStart += m_period;
+            return phase - m_period;
+        }
+    }
+    int64_t phase = (ts + m_offset) % m_period;
+    if (phase < 0)
+    {
+        phase += m_period;
+    }
+    m_cycleStart = ts - phase;
+    m_cached = true;
+    return phase;
+}
+
 double
 LeoCycleSolarIrradianceModel::GetPowerDensityWm2(Time t) const
 {
-    double period = m_sunlightSeconds + m_shadowSeconds;
-    if (period <= 0.0)
+    return IsInSunlight(t) ? m_peakWm2 : 0.0;
+}
+
+SolarIrradianceSegment
+LeoCycleSolarIrradianceModel::GetSegment(Time t) const
+{
+    if (!IsPeriodic())
     {
-        return m_sunlightSeconds > 0.0 ? m_peakWm2 : 0.0;
+        // Degenerate cycle: permanently lit or permanently dark.
+        return SolarIrradianceSegment{t, Time::Max(), m_sunlight > 0 ? m_peakWm2 : 0.0, 0.0};
     }
-    double phase = std::fmod(t.GetSeconds() + m_phaseSeconds, period);
-    if (phase < 0.0)
+    int64_t phase = GetPhase(t);
+    if (phase < m_sunlight)
     {
-        phase += period;
+        return SolarIrradianceSegment{t - TimeStep(phase),
+                                      t + TimeStep(m_sunlight - phase),
+                                      m_peakWm2,
+                                      0.0};
     }
-    return (phase < m_sunlightSeconds) ? m_peakWm2 : 0.0;
+    return SolarIrradianceSegment{t - TimeStep(phase - m_sunlight),
+                                  t + TimeStep(m_period - phase),
+                                  0.0,
+                                  0.0};
+}
+
+bool
+LeoCycleSolarIrradianceModel::IsInSunlight(Time t) const
+{
+    if (!IsPeriodic())
+    {
+        return m_sunlight > 0;
+    }
+    return GetPhase(t) < m_sunlight;
+}
+
+Time
+LeoCycleSolarIrradianceModel::GetNextEclipseEntry(Time t) const
+{
+    if (!IsPeriodic())
+    {
+        return Time::Max();
+    }
+    int64_t phase = GetPhase(t);
+    int64_t entry = m_sunlight - phase;
+    return t + TimeStep(entry > 0 ? entry : entry + m_period);
+}
+
+Time
+LeoCycleSolarIrradianceModel::GetNextEclipseExit(Time t) const
+{
+    if (!IsPeriodic())
+    {
+        return Time::Max();
+    }
+    // Every cycle ends with its shadow phase.
+    return t + TimeStep(m_period - GetPhase(t));
 }
 
 // -------------------------------------------------------------------------
@@ -133,14 +326,27 @@ NS_OBJECT_ENSURE_REGISTERED(CallbackSolarIrradianceModel);
 TypeId
 CallbackSolarIrradianceModel::GetTypeId()
 {
-    static TypeId tid = TypeId("ns3::CallbackSolarIrradianceModel")
-                            .SetParent<SolarIrradianceModel>()
-                            .SetGroupName("Energy")
-                            .AddConstructor<CallbackSolarIrradianceModel>();
+    static TypeId tid =
+        TypeId("ns3::CallbackSolarIrradianceModel")
+            .SetParent<SolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<CallbackSolarIrradianceModel>()
+            .AddAttribute("HoldSeconds",
+                          "Period (s) over which the callback output is known to be "
+                          "constant, aligned to multiples of this value. 0 (default) means "
+                          "nothing is known and consumers must poll the callback.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&CallbackSolarIrradianceModel::SetHoldSeconds,
+                                             &CallbackSolarIrradianceModel::GetHoldSeconds),
+                          MakeDoubleChecker<double>(0.0));
     return tid;
 }
 
-CallbackSolarIrradianceModel::CallbackSolarIrradianceModel() = default;
+CallbackSolarIrradianceModel::CallbackSolarIrradianceModel()
+    : m_hold(Seconds(0))
+{
+}
+
 CallbackSolarIrradianceModel::~CallbackSolarIrradianceModel() = default;
 
 void
@@ -159,4 +365,238 @@ CallbackSolarIrradianceModel::GetPowerDensityWm2(Time t) const
     return m_cb(t);
 }
 
+SolarIrradianceSegment
+CallbackSolarIrradianceModel::GetSegment(Time t) const
+{
+    double wm2 = GetPowerDensityWm2(t);
+    if (m_cb.IsNull())
+    {
+        return SolarIrradianceSegment{t, Time::Max(), wm2, 0.0};
+    }
+    int64_t hold = m_hold.GetTimeStep();
+    if (hold <= 0)
+    {
+        return SolarIrradianceSegment{t, t, wm2, 0.0};
+    }
+    int64_t into = t.GetTimeStep() % hold;
+    if (into < 0)
+    {
+        into += hold;
+    }
+    return SolarIrradianceSegment{t, t + TimeStep(hold - into), wm2, 0.0};
+}
+
+void
+CallbackSolarIrradianceModel::SetHoldSeconds(double seconds)
+{
+    m_hold = Seconds(seconds);
+}
+
+double
+CallbackSolarIrradianceModel::GetHoldSeconds() const
+{
+    return m_hold.GetSeconds();
+}
+
+// -------------------------------------------------------------------------
+// SampledSolarIrradianceModel
+// -------------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED(SampledSolarIrradianceModel);
+
+TypeId
+SampledSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::SampledSolarIrradianceModel")
+            .SetParent<SolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<SampledSolarIrradianceModel>()
+            .AddAttribute("Interpolation",
+                          "How the output is reconstructed between samples: Hold keeps "
+                          "each sample until the next one, Linear ramps between them.",
+                          EnumValue(HOLD),
+                          MakeEnumAccessor<Interpolation>(
+                              &SampledSolarIrradianceModel::m_interpolation),
+                          MakeEnumChecker(HOLD, "Hold", LINEAR, "Linear"));
+    return tid;
+}
+
+SampledSolarIrradianceModel::SampledSolarIrradianceModel()
+    : m_interpolation(HOLD),
+      m_cursor(0),
+      m_run{Time(0), Time(0), 0.0, 0.0},
+      m_runInterpolation(HOLD)
+{
+}
+
+SampledSolarIrradianceModel::~SampledSolarIrradianceModel() = default;
+
+void
+SampledSolarIrradianceModel::AddSample(Time t, double wm2)
+{
+    NS_LOG_FUNCTION(this << t << wm2);
+    NS_ABORT_MSG_IF(!m_times.empty() && t < m_times.back(),
+                    "Samples must be added in non-decreasing time order");
+    m_times.push_back(t);
+    m_values.push_back(wm2);
+    // The new sample may extend the cached run.
+    ResetSampleCache();
+}
+
+std::size_t
+SampledSolarIrradianceModel::GetNSamples() const
+{
+    return m_times.size();
+}
+
+Time
+SampledSolarIrradianceModel::GetSampleTime(std::size_t i) const
+{
+    return m_times[i];
+}
+
+double
+SampledSolarIrradianceModel::GetSampleValue(std::size_t i) const
+{
+    return m_values[i];
+}
+
+void
+SampledSolarIrradianceModel::NarrowSearch(Time /*t*/,
+                                          std::size_t& /*lo*/,
+                                          std::size_t& /*hi*/) const
+{
+}
+
+void
+SampledSolarIrradianceModel::ResetSampleCache()
+{
+    m_cursor = 0;
+    m_run.end = m_run.start;
+}
+
+std::ptrdiff_t
+SampledSolarIrradianceModel::FindSample(Time t) const
+{
+    // Last sample at or before t; with duplicate times this is the last of
+    // them, so a pair of equal-time samples encodes a step.
+    std::size_t n = GetNSamples();
+    if (n == 0)
+    {
+        return -1;
+    }
+
+    // Fast path: the clock has not moved, or has moved a few samples on.
+    std::size_t c = m_cursor;
+    if (c < n && GetSampleTime(c) <= t)
+    {
+        for (int step = 0; step < 4; ++step)
+        {
+            if (c + 1 == n || GetSampleTime(c + 1) > t)
+            {
+                m_cursor = c;
+                return static_cast<std::ptrdiff_t>(c);
+            }
+            ++c;
+        }
+    }
+
+    std::size_t lo = 0;
+    std::size_t hi = n;
+    NarrowSearch(t, lo, hi);
+    while (lo < hi)
+    {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (GetSampleTime(mid) <= t)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo == 0)
+    {
+        return -1;
+    }
+    m_cursor = lo - 1;
+    return static_cast<std::ptrdiff_t>(m_cursor);
+}
+
+double
+SampledSolarIrradianceModel::GetPowerDensityWm2(Time t) const
+{
+    std::size_t n = GetNSamples();
+    if (n == 0)
+    {
+        return 0.0;
+    }
+    std::ptrdiff_t i = FindSample(t);
+    if (i < 0)
+    {
+        return GetSampleValue(0);
+    }
+    std::size_t k = static_cast<std::size_t>(i);
+    if (m_interpolation == HOLD || k + 1 == n)
+    {
+        return GetSampleValue(k);
+    }
+    Time t0 = GetSampleTime(k);
+    double v0 = GetSampleValue(k);
+    double f = (t - t0).GetSeconds() / (GetSampleTime(k + 1) - t0).GetSeconds();
+    return v0 + f * (GetSampleValue(k + 1) - v0);
+}
+
+SolarIrradianceSegment
+SampledSolarIrradianceModel::GetSegment(Time t) const
+{
+    std::size_t n = GetNSamples();
+    if (n == 0)
+    {
+        return SolarIrradianceSegment{t, Time::Max(), 0.0, 0.0};
+    }
+    if (m_runInterpolation == m_interpolation && m_run.start <= t && t < m_run.end)
+    {
+        return m_run;
+    }
+    std::ptrdiff_t i = FindSample(t);
+    std::size_t k = (i < 0) ? 0 : static_cast<std::size_t>(i);
+    Time start = (i < 0) ? t : GetSampleTime(k);
+    double value = GetSampleValue(k);
+
+    if (m_interpolation == LINEAR && i >= 0 && k + 1 < n && GetSampleValue(k + 1) != value)
+    {
+        Time next = GetSampleTime(k + 1);
+        double slope = (GetSampleValue(k + 1) - value) / (next - start).GetSeconds();
+        return SolarIrradianceSegment{start, next, value, slope};
+    }
+
+    // Flat: extend over the run of samples sharing this value. When
+    // holding, the run lasts until the next sample that differs; when
+    // interpolating, the ramp towards it starts at the last equal sample.
+    // The segment is cached, so that the run of a long flat stretch (a
+    // night or an eclipse in a fine trace) is walked once, not per query.
+    std::size_t j = k;
+    while (j + 1 < n && GetSampleValue(j + 1) == value)
+    {
+        ++j;
+    }
+    Time end = Time::Max();
+    if (m_interpolation == HOLD && j + 1 < n)
+    {
+        end = GetSampleTime(j + 1);
+    }
+    else if (m_interpolation == LINEAR && j + 1 < n)
+    {
+        end = (i < 0 && j == 0) ? GetSampleTime(0) : GetSampleTime(j);
+    }
+    // Time moves forward, so the next search starts past the run.
+    m_cursor = j;
+    m_run = SolarIrradianceSegment{start, end, value, 0.0};
+    m_runInterpolation = m_interpolation;
+    return m_run;
+}
+
 } // namespace ns3
@@ -5,9 +5,39 @@
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 
+#include <cstddef>
+#include <vector>
+
 namespace ns3
 {
 
+/**
+ * \ingroup composite-energy
+ * \brief Analytic description of an irradiance profile over a time span.
+ *
+ * Over [start, end) the power density is
+ * startWm2 + slopeWm2PerS * (t - start), i.e. constant when the slope is
+ * zero. An \c end of Time::Max() means the value never changes again;
+ * an \c end equal to the query time means the model has no knowledge of
+ * its own future and must be polled.
+ */
+struct SolarIrradianceSegment
+{
+    Time start;          //!< Segment start (at or before the query time)
+    Time end;            //!< First instant at which the description may no longer hold
+    double startWm2;     //!< Power density at \c start (W/m^2)
+    double slopeWm2PerS; //!< Rate of change over the segment (W/m^2/s)
+
+    /** \return Power density at \p t, which must lie in [start, end). */
+    double GetPowerDensityWm2(Time t) const;
+
+    /** \return Irradiation (J/m^2) over [from, to], both within the segment. */
+    double Integrate(Time from, Time to) const;
+
+    /** \return true if the value is known to hold beyond the query time. */
+    bool IsKnown() const;
+};
+
 /**
  * \ingroup composite-energy
  * \brief Abstract source of instantaneous solar power density (W/m^2)
@@ -17,9 +47,11 @@ namespace ns3
  * consuming CompositeEnergySource multiplies by PanelAreaM2 and
  * PanelEfficiency to obtain the net harvested electrical power in Watts.
  *
- * Three ready-to-use implementations ship with this module:
+ * Four ready-to-use implementations ship with this module:
  *  - \c ConstantSolarIrradianceModel     — time-invariant irradiance.
  *  - \c LeoCycleSolarIrradianceModel     — periodic sunlight/shadow cycle.
+ *  - \c SampledSolarIrradianceModel      — in-memory trace of
+ *                                          (time, W/m^2) samples.
  *  - \c CallbackSolarIrradianceModel     — arbitrary user-supplied
  *                                          function of simulation time,
  *                                          suitable for orbital propagation
@@ -29,7 +61,10 @@ namespace ns3
  *                                          irradiance profiles.
  *
  * Derived classes implementing their own physics simply override
- * \c GetPowerDensityWm2.
+ * \c GetPowerDensityWm2. Models that know how their output evolves
+ * should also override \c GetSegment, which lets consumers schedule an
+ * update only when the value actually changes (and integrate linear
+ * ramps exactly) instead of polling at a fixed period.
  */
 class SolarIrradianceModel : public Object
 {
@@ -40,6 +75,38 @@ class SolarIrradianceModel : public Object
     /** \return Instantaneous solar power density at the panel, in W/m^2,
      *          at the given simulation time. */
     virtual double GetPowerDensityWm2(Time t) const = 0;
+
+    /**
+     * \brief Describe the irradiance from \p t onwards.
+     *
+     * The default implementation knows nothing about the future: it
+     * returns the value at \p t in a segment that ends at \p t, which
+     * tells the caller to keep polling.
+     *
+     * \param t Query time.
+     * \return Segment containing \p t.
+     */
+    virtual SolarIrradianceSegment GetSegment(Time t) const;
+
+    /**
+     * \brief Power density at each of \p n times.
+     *
+     * Fills wm2[i] with GetPowerDensityWm2(times[i]). The default loops
+     * over the times; models that produce a block of samples more cheaply
+     * in one call override it.
+     *
+     * \param times Query times.
+     * \param wm2 Receives the \p n power densities (W/m^2).
+     * \param n Number of times.
+     */
+    virtual void GetPowerDensitiesWm2(const Time* times, double* wm2, std::size_t n) const;
+
+    /**
+     * \return The first instant after \p t at which the output may
+     *         differ from the segment containing \p t, Time::Max() if it
+     *         never changes again, or \p t itself if unknown.
+     */
+    Time GetNextChangeTime(Time t) const;
 };
 
 /**
@@ -54,6 +121,7 @@ class ConstantSolarIrradianceModel : public SolarIrradianceModel
     ~ConstantSolarIrradianceModel() override;
 
     double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
 
   private:
     double m_wm2;
@@ -68,6 +136,12 @@ class ConstantSolarIrradianceModel : public SolarIrradianceModel
  * the remaining \c ShadowSeconds it is zero. \c PhaseSeconds shifts the
  * cycle by a constant amount, letting the user start in a different
  * phase of the orbit.
+ *
+ * This is the only implementation of the LEO cycle: the built-in
+ * UseLeoCycle mode of CompositeEnergySource runs one. The start of the
+ * cycle containing the last query is cached, so a query in the same
+ * cycle is a compare and a subtraction, and a query in the next one
+ * advances the cache by one period; only a jump further away divides.
  */
 class LeoCycleSolarIrradianceModel : public SolarIrradianceModel
 {
@@ -77,12 +151,51 @@ class LeoCycleSolarIrradianceModel : public SolarIrradianceModel
     ~LeoCycleSolarIrradianceModel() override;
 
     double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
+
+    /** \return true if \p t falls in a sunlight phase. */
+    bool IsInSunlight(Time t) const;
+
+    /** \return The first instant after \p t at which a shadow phase
+     *          starts, or Time::Max() if the cycle has no shadow. */
+    Time GetNextEclipseEntry(Time t) const;
+
+    /** \return The first instant after \p t at which a shadow phase
+     *          ends, or Time::Max() if the cycle has no shadow. */
+    Time GetNextEclipseExit(Time t) const;
 
   private:
+    void SetSunlightSeconds(double seconds);
+    double GetSunlightSeconds() const;
+    void SetShadowSeconds(double seconds);
+    double GetShadowSeconds() const;
+    void SetPhaseSeconds(double seconds);
+    double GetPhaseSeconds() const;
+
+    /** \return true if the cycle has both a sunlight and a shadow phase. */
+    bool IsPeriodic() const;
+
+    /**
+     * \return Position of \p t in its cycle (time steps), from the start
+     *         of the sunlight phase. Requires IsPeriodic().
+     */
+    int64_t GetPhase(Time t) const;
+
     double m_peakWm2;
     double m_sunlightSeconds;
     double m_shadowSeconds;
     double m_phaseSeconds;
+
+    // The attributes in time steps, so that values and reported
+    // boundaries agree exactly.
+    int64_t m_sunlight;
+    int64_t m_period;
+    int64_t m_offset;
+
+    // Start (time step) of the cycle holding the last query; valid when
+    // m_cached is true.
+    mutable int64_t m_cycleStart;
+    mutable bool m_cached;
 };
 
 /**
@@ -94,6 +207,12 @@ class LeoCycleSolarIrradianceModel : public SolarIrradianceModel
  * Use this to integrate an external orbit propagator, a trace-driven
  * profile (e.g. a CSV of W/m^2 vs. time), a pointing-error model, or
  * any other user code that computes irradiance as a function of time.
+ *
+ * A callback is opaque, so by default GetSegment() reports no knowledge
+ * of the future and consumers poll it. If the profile is known to change
+ * no faster than some period (e.g. a 1 Hz trace), set \c HoldSeconds to
+ * that period: the value at \c t is then reported as held until the
+ * next multiple of \c HoldSeconds.
  */
 class CallbackSolarIrradianceModel : public SolarIrradianceModel
 {
@@ -108,9 +227,103 @@ class CallbackSolarIrradianceModel : public SolarIrradianceModel
     void SetCallback(IrradianceCallback cb);
 
     double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
 
   private:
+    void SetHoldSeconds(double seconds);
+    double GetHoldSeconds() const;
+
     IrradianceCallback m_cb;
+    Time m_hold; // HoldSeconds as a Time, so segment ends are exact multiples
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Irradiance from an in-memory trace of (time, W/m^2) samples.
+ *
+ * Samples are added in non-decreasing time order with AddSample(). With
+ * \c Interpolation=Hold (default) each sample is held until the next
+ * one; with \c Linear the output ramps between consecutive samples.
+ * Before the first sample the first value is held, after the last sample
+ * the last value is held forever. An empty trace yields zero.
+ *
+ * GetSegment() merges runs of equal values, so a trace that sits at zero
+ * through an eclipse reports a single segment for the whole eclipse. The
+ * last flat segment is kept, so each run is walked once however often it
+ * is queried.
+ *
+ * Lookups keep a cursor on the last sample found. Simulation time only
+ * moves forward, so a query normally resolves at the cursor or a few
+ * samples past it in O(1); any other query falls back to a binary
+ * search. Subclasses backed by other storage override GetNSamples(),
+ * GetSampleTime() and GetSampleValue() and inherit the reconstruction.
+ */
+class SampledSolarIrradianceModel : public SolarIrradianceModel
+{
+  public:
+    /** How the output is reconstructed between samples. */
+    enum Interpolation
+    {
+        HOLD,   //!< Sample-and-hold (piecewise constant)
+        LINEAR, //!< Linear between consecutive samples
+    };
+
+    static TypeId GetTypeId();
+    SampledSolarIrradianceModel();
+    ~SampledSolarIrradianceModel() override;
+
+    /**
+     * \brief Append a sample.
+     *
+     * \param t Sample time; must not precede the previous sample.
+     * \param wm2 Power density at \p t (W/m^2).
+     */
+    virtual void AddSample(Time t, double wm2);
+
+    /** \return Number of samples in the trace. */
+    virtual std::size_t GetNSamples() const;
+
+    double GetPowerDensityWm2(Time t) const override;
+    SolarIrradianceSegment GetSegment(Time t) const override;
+
+  protected:
+    /** \return Time of sample \p i, with i < GetNSamples(). */
+    virtual Time GetSampleTime(std::size_t i) const;
+
+    /** \return Value (W/m^2) of sample \p i, with i < GetNSamples(). */
+    virtual double GetSampleValue(std::size_t i) const;
+
+    /**
+     * \brief Narrow the binary search for the last sample at or before
+     *        \p t to indices [lo, hi).
+     *
+     * Called only when the cursor misses. The default leaves the full
+     * range; storage with an index of its own can avoid touching samples
+     * far from \p t.
+     */
+    virtual void NarrowSearch(Time t, std::size_t& lo, std::size_t& hi) const;
+
+    /**
+     * \brief Forget the cached search position and flat segment.
+     *
+     * Subclasses that keep their own samples call this whenever those
+     * samples change, such as on another trace, column or schedule.
+     */
+    void ResetSampleCache();
+
+  private:
+    /** \return Index of the last sample at or before \p t, or -1. */
+    std::ptrdiff_t FindSample(Time t) const;
+
+    std::vector<Time> m_times;
+    std::vector<double> m_values;
+    Interpolation m_interpolation;
+    mutable std::size_t m_cursor; // last sample found, where searches start
+    // Flat segment last found by GetSegment() (empty if end <= start) and
+    // the interpolation it was found under, so that later queries inside a
+    // long run of equal values neither search nor walk the run again
+    mutable SolarIrradianceSegment m_run;
+    mutable Interpolation m_runInterpolation;
 };
 
 } // namespace ns3
@@ -0,0 +1,263 @@
+#include "trace-solar-irradiance-model.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("TraceSolarIrradianceModel");
+
+// -------------------------------------------------------------------------
+// TraceSolarIrradianceModel
+// -------------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED(TraceSolarIrradianceModel);
+
+TypeId
+TraceSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::TraceSolarIrradianceModel")
+            .SetParent<SampledSolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<TraceSolarIrradianceModel>()
+            .AddAttribute("FileName",
+                          "Binary irradiance trace to read. Instances naming the same file "
+                          "share one read-only mapping of it.",
+                          StringValue(""),
+                          MakeStringAccessor(&TraceSolarIrradianceModel::SetFileName,
+                                             &TraceSolarIrradianceModel::GetFileName),
+                          MakeStringChecker())
+            .AddAttribute("Column",
+                          "Zero-based irradiance column of the trace to follow (e.g. the "
+                          "satellite index).",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&TraceSolarIrradianceModel::SetColumn,
+                                               &TraceSolarIrradianceModel::GetColumn),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+TraceSolarIrradianceModel::TraceSolarIrradianceModel()
+    : m_column(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+TraceSolarIrradianceModel::~TraceSolarIrradianceModel() = default;
+
+void
+TraceSolarIrradianceModel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_trace = nullptr;
+    SampledSolarIrradianceModel::DoDispose();
+}
+
+void
+TraceSolarIrradianceModel::SetTrace(Ptr<const IrradianceTrace> trace, uint32_t column)
+{
+    NS_LOG_FUNCTION(this << trace << column);
+    NS_ABORT_MSG_IF(trace && column >= trace->GetNColumns(),
+                    "Column " << column << " out of range for " << trace->GetPath());
+    m_trace = trace;
+    m_column = column;
+    ResetSampleCache();
+}
+
+Ptr<const IrradianceTrace>
+TraceSolarIrradianceModel::GetTrace() const
+{
+    return m_trace;
+}
+
+void
+TraceSolarIrradianceModel::AddSample(Time /*t*/, double /*wm2*/)
+{
+    NS_ABORT_MSG("TraceSolarIrradianceModel is read-only; write traces with "
+                 "IrradianceTraceWriter");
+}
+
+std::size_t
+TraceSolarIrradianceModel::GetNSamples() const
+{
+    return m_trace ? static_cast<std::size_t>(m_trace->GetNRows()) : 0;
+}
+
+Time
+TraceSolarIrradianceModel::GetSampleTime(std::size_t i) const
+{
+    return m_trace->GetTime(i);
+}
+
+double
+TraceSolarIrradianceModel::GetSampleValue(std::size_t i) const
+{
+    return m_trace->GetValue(i, m_column);
+}
+
+void
+TraceSolarIrradianceModel::SetFileName(std::string fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    SetTrace(fileName.empty() ? Ptr<const IrradianceTrace>() : IrradianceTrace::Open(fileName),
+             m_column);
+}
+
+std::string
+TraceSolarIrradianceModel::GetFileName() const
+{
+    return m_trace ? m_trace->GetPath() : std::string();
+}
+
+void
+TraceSolarIrradianceModel::SetColumn(uint32_t column)
+{
+    NS_LOG_FUNCTION(this << column);
+    SetTrace(m_trace, column);
+}
+
+uint32_t
+TraceSolarIrradianceModel::GetColumn() const
+{
+    return m_column;
+}
+
+// -------------------------------------------------------------------------
+// StreamingTraceSolarIrradianceModel
+// -------------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED(StreamingTraceSolarIrradianceModel);
+
+TypeId
+StreamingTraceSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::StreamingTraceSolarIrradianceModel")
+            .SetParent<SampledSolarIrradianceModel>()
+            .SetGroupName("Energy")
+            .AddConstructor<StreamingTraceSolarIrradianceModel>()
+            .AddAttribute("FileName",
+                          "Binary irradiance trace to stream. Instances naming the same file "
+                          "share one reader and its block cache.",
+                          StringValue(""),
+                          MakeStringAccessor(&StreamingTraceSolarIrradianceModel::SetFileName,
+                                             &StreamingTraceSolarIrradianceModel::GetFileName),
+                          MakeStringChecker())
+            .AddAttribute("Column",
+                          "Zero-based irradiance column of the trace to follow (e.g. the "
+                          "satellite index).",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&StreamingTraceSolarIrradianceModel::SetColumn,
+                                               &StreamingTraceSolarIrradianceModel::GetColumn),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+StreamingTraceSolarIrradianceModel::StreamingTraceSolarIrradianceModel()
+    : m_column(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+StreamingTraceSolarIrradianceModel::~StreamingTraceSolarIrradianceModel() = default;
+
+void
+StreamingTraceSolarIrradianceModel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_trace = nullptr;
+    SampledSolarIrradianceModel::DoDispose();
+}
+
+void
+StreamingTraceSolarIrradianceModel::SetTrace(Ptr<const IrradianceTraceStream> trace,
+                                             uint32_t column)
+{
+    NS_LOG_FUNCTION(this << trace << column);
+    NS_ABORT_MSG_IF(trace && column >= trace->GetNColumns(),
+                    "Column " << column << " out of range for " << trace->GetPath());
+    m_trace = trace;
+    m_column = column;
+    ResetSampleCache();
+}
+
+Ptr<const IrradianceTraceStream>
+StreamingTraceSolarIrradianceModel::GetTrace() const
+{
+    return m_trace;
+}
+
+void
+StreamingTraceSolarIrradianceModel::AddSample(Time /*t*/, double /*wm2*/)
+{
+    NS_ABORT_MSG("StreamingTraceSolarIrradianceModel is read-only; write traces with "
+                 "IrradianceTraceWriter");
+}
+
+std::size_t
+StreamingTraceSolarIrradianceModel::GetNSamples() const
+{
+    return m_trace ? static_cast<std::size_t>(m_trace->GetNRows()) : 0;
+}
+
+Time
+StreamingTraceSolarIrradianceModel::GetSampleTime(std::size_t i) const
+{
+    return m_trace->GetTime(i);
+}
+
+double
+StreamingTraceSolarIrradianceModel::GetSampleValue(std::size_t i) const
+{
+    return m_trace->GetValue(i, m_column);
+}
+
+void
+StreamingTraceSolarIrradianceModel::NarrowSearch(Time t,
+                                                 std::size_t& lo,
+                                                 std::size_t& hi) const
+{
+    // Every row of later blocks is after t, and the first row of this
+    // block is not (unless t precedes the whole trace), so the answer
+    // lies in this block.
+    uint64_t blockRows = m_trace->GetHeader().blockRows;
+    uint64_t block = m_trace->FindBlock(t);
+    lo = static_cast<std::size_t>(block * blockRows);
+    hi = static_cast<std::size_t>(std::min<uint64_t>(hi, (block + 1) * blockRows));
+}
+
+void
+StreamingTraceSolarIrradianceModel::SetFileName(std::string fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    SetTrace(fileName.empty() ? Ptr<const IrradianceTraceStream>()
+                              : IrradianceTraceStream::Open(fileName),
+             m_column);
+}
+
+std::string
+StreamingTraceSolarIrradianceModel::GetFileName() const
+{
+    return m_trace ? m_trace->GetPath() : std::string();
+}
+
+void
+StreamingTraceSolarIrradianceModel::SetColumn(uint32_t column)
+{
+    NS_LOG_FUNCTION(this << column);
+    SetTrace(m_trace, column);
+}
+
+uint32_t
+StreamingTraceSolarIrradianceModel::GetColumn() const
+{
+    return m_column;
+}
+
+} // namespace ns3
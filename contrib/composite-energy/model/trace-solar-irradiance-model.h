@@ -0,0 +1,121 @@
+#ifndef NS3_TRACE_SOLAR_IRRADIANCE_MODEL_H
+#define NS3_TRACE_SOLAR_IRRADIANCE_MODEL_H
+
+#include "irradiance-trace.h"
+#include "solar-irradiance-model.h"
+
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Irradiance read from one column of a binary IrradianceTrace.
+ *
+ * Intended for long, many-satellite runs: every instance reading the same
+ * \c FileName shares one read-only memory mapping (see
+ * IrradianceTrace::Open()), and each instance only keeps its column
+ * number and a lookup cursor. Startup cost is one mmap() regardless of
+ * the trace length, and resident memory is limited to the pages the
+ * simulation actually touches.
+ *
+ * Reconstruction (Hold or Linear via the inherited \c Interpolation
+ * attribute), segment merging and the forward-moving O(1) cursor are
+ * those of SampledSolarIrradianceModel. Values are stored as float32 in
+ * the file. Trace files are produced from CSV by the
+ * \c irradiance-trace-convert utility, or directly with
+ * IrradianceTraceWriter.
+ */
+class TraceSolarIrradianceModel : public SampledSolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    TraceSolarIrradianceModel();
+    ~TraceSolarIrradianceModel() override;
+
+    /**
+     * \brief Read column \p column of an already opened trace.
+     *
+     * Equivalent to setting the FileName and Column attributes.
+     */
+    void SetTrace(Ptr<const IrradianceTrace> trace, uint32_t column);
+
+    /** \return The trace in use, or null if none is set. */
+    Ptr<const IrradianceTrace> GetTrace() const;
+
+    /** Traces are read-only; aborts. */
+    void AddSample(Time t, double wm2) override;
+
+    std::size_t GetNSamples() const override;
+
+  protected:
+    void DoDispose() override;
+    Time GetSampleTime(std::size_t i) const override;
+    double GetSampleValue(std::size_t i) const override;
+
+  private:
+    void SetFileName(std::string fileName);
+    std::string GetFileName() const;
+    void SetColumn(uint32_t column);
+    uint32_t GetColumn() const;
+
+    Ptr<const IrradianceTrace> m_trace;
+    uint32_t m_column;
+};
+
+/**
+ * \ingroup composite-energy
+ * \brief Irradiance read from one column of a binary trace, streamed
+ *        from disk in blocks.
+ *
+ * Same attributes and reconstruction as TraceSolarIrradianceModel, but
+ * backed by an IrradianceTraceStream instead of a memory mapping: only
+ * the block index is read at startup, and blocks are paged in as the
+ * simulation clock advances and evicted behind it, so resident memory
+ * stays at IrradianceTraceStream::CACHED_BLOCKS blocks however long the
+ * trace is. Use it when traces do not fit in memory, or live on file
+ * systems where mapping them is undesirable. Cursor misses are resolved
+ * through the block index and read at most one block.
+ */
+class StreamingTraceSolarIrradianceModel : public SampledSolarIrradianceModel
+{
+  public:
+    static TypeId GetTypeId();
+    StreamingTraceSolarIrradianceModel();
+    ~StreamingTraceSolarIrradianceModel() override;
+
+    /**
+     * \brief Read column \p column of an already opened trace.
+     *
+     * Equivalent to setting the FileName and Column attributes.
+     */
+    void SetTrace(Ptr<const IrradianceTraceStream> trace, uint32_t column);
+
+    /** \return The trace in use, or null if none is set. */
+    Ptr<const IrradianceTraceStream> GetTrace() const;
+
+    /** Traces are read-only; aborts. */
+    void AddSample(Time t, double wm2) override;
+
+    std::size_t GetNSamples() const override;
+
+  protected:
+    void DoDispose() override;
+    Time GetSampleTime(std::size_t i) const override;
+    double GetSampleValue(std::size_t i) const override;
+    void NarrowSearch(Time t, std::size_t& lo, std::size_t& hi) const override;
+
+  private:
+    void SetFileName(std::string fileName);
+    std::string GetFileName() const;
+    void SetColumn(uint32_t column);
+    uint32_t GetColumn() const;
+
+    Ptr<const IrradianceTraceStream> m_trace;
+    uint32_t m_column;
+};
+
+} // namespace ns3
+
+#endif // NS3_TRACE_SOLAR_IRRADIANCE_MODEL_H
@@ -0,0 +1,186 @@
+#include "window-solar-irradiance-model.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("WindowSolarIrradianceModel");
+
+NS_OBJECT_ENSURE_REGISTERED(WindowSolarIrradianceModel);
+
+TypeId
+WindowSolarIrradianceModel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::WindowSolarIrradianceModel")
+                            .SetParent<SampledSolarIrradianceModel>()
+                            .SetGroupName("Energy")
+                            .AddConstructor<WindowSolarIrradianceModel>();
+    return tid;
+}
+
+WindowSolarIrradianceModel::WindowSolarIrradianceModel()
+    : m_indexed(true)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+WindowSolarIrradianceModel::~WindowSolarIrradianceModel() = default;
+
+void
+WindowSolarIrradianceModel::AddWindow(double value, Time start, Time end)
+{
+    NS_LOG_FUNCTION(this << value << start << end);
+    NS_ABORT_MSG_IF(end < start, "Window ends before it starts");
+    if (end == start)
+    {
+        return;
+    }
+    m_windows.push_back(Window{start, end, value});
+    m_indexed = false;
+    ResetSampleCache();
+}
+
+uint64_t
+WindowSolarIrradianceModel::LoadWindows(const std::string& fileName, double timeScale)
+{
+    NS_LOG_FUNCTION(this << fileName << timeScale);
+    std::ifstream in(fileName);
+    NS_ABORT_MSG_IF(!in, "Cannot open window schedule " << fileName);
+
+    uint64_t windows = 0;
+    uint64_t lineNo = 0;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        ++lineNo;
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::replace(line.begin(), line.end(), ';', ' ');
+        std::istringstream fields(line);
+        double value;
+        double start;
+        double end;
+        std::string extra;
+        if (!(fields >> value >> start >> end))
+        {
+            // A header row is tolerated before the first window.
+            NS_ABORT_MSG_IF(windows > 0,
+                            fileName << ":" << lineNo << ": expected value, start, end");
+            continue;
+        }
+        NS_ABORT_MSG_IF(fields >> extra,
+                        fileName << ":" << lineNo << ": expected value, start, end");
+        NS_ABORT_MSG_IF(end < start, fileName << ":" << lineNo << ": window ends before it starts");
+        AddWindow(value, Seconds(start * timeScale), Seconds(end * timeScale));
+        ++windows;
+    }
+    NS_LOG_DEBUG(fileName << ": " << windows << " windows");
+    return windows;
+}
+
+std::size_t
+WindowSolarIrradianceModel::GetNWindows() const
+{
+    return m_windows.size();
+}
+
+const WindowSolarIrradianceModel::Window&
+WindowSolarIrradianceModel::GetWindow(std::size_t i) const
+{
+    return m_windows[i];
+}
+
+void
+WindowSolarIrradianceModel::AddSample(Time /*t*/, double /*wm2*/)
+{
+    NS_ABORT_MSG("WindowSolarIrradianceModel is built from windows; use AddWindow()");
+}
+
+std::size_t
+WindowSolarIrradianceModel::GetNSamples() const
+{
+    BuildIndex();
+    return m_times.size();
+}
+
+Time
+WindowSolarIrradianceModel::GetSampleTime(std::size_t i) const
+{
+    return m_times[i];
+}
+
+double
+WindowSolarIrradianceModel::GetSampleValue(std::size_t i) const
+{
+    return m_values[i];
+}
+
+void
+WindowSolarIrradianceModel::BuildIndex() const
+{
+    if (m_indexed)
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this << m_windows.size());
+
+    // Every window opens at its start and closes at its end; sweeping the
+    // sorted boundaries yields the total from each one on.
+    std::vector<std::tuple<Time, double, int>> edges;
+    edges.reserve(2 * m_windows.size());
+    for (const auto& w : m_windows)
+    {
+        edges.emplace_back(w.start, w.value, 1);
+        edges.emplace_back(w.end, -w.value, -1);
+    }
+    std::sort(edges.begin(), edges.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) < std::get<0>(b);
+    });
+
+    m_times.clear();
+    m_values.clear();
+    double total = 0.0;
+    int open = 0;
+    for (std::size_t k = 0; k < edges.size();)
+    {
+        Time t = std::get<0>(edges[k]);
+        for (; k < edges.size() && std::get<0>(edges[k]) == t; ++k)
+        {
+            total += std::get<1>(edges[k]);
+            open += std::get<2>(edges[k]);
+        }
+        // Reset the running sum whenever no window is open, so rounding
+        // cannot accumulate across the schedule and gaps are exactly zero.
+        if (open == 0)
+        {
+            total = 0.0;
+        }
+        double previous = m_values.empty() ? 0.0 : m_values.back();
+        if (total == previous)
+        {
+            continue;
+        }
+        if (m_times.empty())
+        {
+            // The first value is held before the first sample.
+            m_times.push_back(t);
+            m_values.push_back(0.0);
+        }
+        m_times.push_back(t);
+        m_values.push_back(total);
+    }
+    m_indexed = true;
+}
+
+} // namespace ns3
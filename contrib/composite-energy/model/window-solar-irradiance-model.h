@@ -0,0 +1,101 @@
+#ifndef NS3_WINDOW_SOLAR_IRRADIANCE_MODEL_H
+#define NS3_WINDOW_SOLAR_IRRADIANCE_MODEL_H
+
+#include "solar-irradiance-model.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup composite-energy
+ * \brief Irradiance from a schedule of possibly overlapping windows.
+ *
+ * Each window contributes a constant value over [start, end); where
+ * windows overlap their values add up, and outside every window the
+ * output is zero. Windows may be added in any order, one at a time with
+ * AddWindow() or in bulk from a mission plan with LoadWindows(). This
+ * covers ground-station passes, HAP beam schedules and other plans with
+ * hundreds of windows a day without writing a callback.
+ *
+ * The windows are kept as an interval index: on the first query after a
+ * change, their boundaries are sorted and swept once into the step
+ * function they sum to, one sample per distinct boundary. Lookups then
+ * use the forward-moving cursor of SampledSolarIrradianceModel, so a
+ * query at monotonically advancing simulation time costs amortized O(1),
+ * and GetSegment() reports the next boundary at which the total changes,
+ * for event-driven scheduling.
+ *
+ * Values are in W/m^2 like any other irradiance model; the built-in
+ * window mode of CompositeEnergySource stores watts in one. The
+ * inherited \c Interpolation attribute should be left at Hold.
+ */
+class WindowSolarIrradianceModel : public SampledSolarIrradianceModel
+{
+  public:
+    /** A window as added. */
+    struct Window
+    {
+        Time start;   //!< First instant of the window
+        Time end;     //!< First instant after the window
+        double value; //!< Value over the window (W/m^2)
+    };
+
+    static TypeId GetTypeId();
+    WindowSolarIrradianceModel();
+    ~WindowSolarIrradianceModel() override;
+
+    /**
+     * \brief Add a window.
+     *
+     * \param value Value over the window (W/m^2).
+     * \param start Window start.
+     * \param end Window end (excluded); an empty window is ignored.
+     */
+    void AddWindow(double value, Time start, Time end);
+
+    /**
+     * \brief Add every window listed in a text file.
+     *
+     * One window per line as "value, start, end", with start and end in
+     * seconds times \p timeScale. Fields are separated by commas,
+     * semicolons or blanks. Blank lines and lines starting with '#' are
+     * skipped, and a header row is tolerated before the first window.
+     *
+     * \param fileName Path of the file.
+     * \param timeScale Seconds per time unit of the file.
+     * \return Number of windows read.
+     */
+    uint64_t LoadWindows(const std::string& fileName, double timeScale = 1.0);
+
+    /** \return Number of non-empty windows added. */
+    std::size_t GetNWindows() const;
+
+    /** \return Window \p i in the order added, with i < GetNWindows(). */
+    const Window& GetWindow(std::size_t i) const;
+
+    /** Windows are added with AddWindow(); aborts. */
+    void AddSample(Time t, double wm2) override;
+
+    std::size_t GetNSamples() const override;
+
+  protected:
+    Time GetSampleTime(std::size_t i) const override;
+    double GetSampleValue(std::size_t i) const override;
+
+  private:
+    /** Sweep the windows into m_times / m_values if they changed. */
+    void BuildIndex() const;
+
+    std::vector<Window> m_windows;
+    mutable std::vector<Time> m_times;    // boundaries, sorted
+    mutable std::vector<double> m_values; // total from each boundary on
+    mutable bool m_indexed;               // m_times / m_values match m_windows
+};
+
+} // namespace ns3
+
+#endif // NS3_WINDOW_SOLAR_IRRADIANCE_MODEL_H
@@ -0,0 +1,488 @@
+#include "ns3/boolean.h"
+#include "ns3/composite-energy-fleet.h"
+#include "ns3/composite-energy-source.h"
+#include "ns3/double.h"
+#include "ns3/energy-telemetry.h"
+#include "ns3/enum.h"
+#include "ns3/li-ion-energy-source.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-device-energy-model.h"
+#include "ns3/simulator.h"
+#include "ns3/solar-irradiance-model.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Fleet equivalence test: the same six sources (two LEO cycles, one of
+ * them under a constant device load, a fixed window reaching its energy
+ * cap, a sampled irradiance trace and a schedule of overlapping windows)
+ * are run stand-alone and as members
+ * of a CompositeEnergyFleet. Every member must end with the energy its
+ * stand-alone twin has, while the fleet replaces the members' harvest and
+ * toggle events with a single tick.
+ */
+class CompositeEnergyFleetEquivalenceTest : public TestCase
+{
+  public:
+    CompositeEnergyFleetEquivalenceTest()
+        : TestCase("CompositeEnergyFleet members match stand-alone sources")
+    {
+    }
+
+    void DoRun() override
+    {
+        Outcome alone = Run(false);
+        Outcome fleet = Run(true);
+
+        for (std::size_t i = 0; i < alone.remaining.size(); ++i)
+        {
+            NS_TEST_ASSERT_MSG_EQ_TOL(fleet.harvested[i],
+                                      alone.harvested[i],
+                                      1e-6,
+                                      "harvested energy differs from the stand-alone source");
+            NS_TEST_ASSERT_MSG_EQ_TOL(fleet.remaining[i],
+                                      alone.remaining[i],
+                                      1e-6,
+                                      "remaining energy differs from the stand-alone source");
+        }
+        // 500 W from 3000 J up to the 4000 J cap.
+        NS_TEST_ASSERT_MSG_EQ_TOL(fleet.harvested[2], 1000.0, 1e-6, "window member cap");
+        // 100 W over [1, 9) plus 50 W over [4, 20.5).
+        NS_TEST_ASSERT_MSG_EQ_TOL(fleet.harvested[5], 1625.0, 1e-6, "window schedule member");
+        // One tick per second for 30 s, against one update per second per
+        // stand-alone source.
+        NS_TEST_ASSERT_MSG_EQ(fleet.ticks, 30, "fleet tick count");
+        NS_TEST_ASSERT_MSG_LT(fleet.events, alone.events, "fleet should schedule fewer events");
+    }
+
+  private:
+    struct Outcome
+    {
+        std::vector<double> remaining;
+        std::vector<double> harvested;
+        uint64_t ticks;
+        uint64_t events;
+    };
+
+    static Outcome Run(bool useFleet)
+    {
+        std::vector<Ptr<CompositeEnergySource>> sources;
+        for (int i = 0; i < 6; ++i)
+        {
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(3000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+            source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+            source->SetAttribute("PanelEfficiency", DoubleValue(0.25));
+            source->SetAttribute("SunlightSeconds", DoubleValue(10.0 + i));
+            source->SetAttribute("ShadowSeconds", DoubleValue(5.0));
+            sources.push_back(source);
+        }
+        sources[2]->SetAttribute("UseLeoCycle", BooleanValue(false));
+        sources[2]->SetAttribute("MaxEnergyJ", DoubleValue(4000.0));
+        sources[2]->AddSolarPanelWindow(500.0, 2.5, 12.0);
+
+        Ptr<SampledSolarIrradianceModel> model = CreateObject<SampledSolarIrradianceModel>();
+        model->SetAttribute("Interpolation", EnumValue(SampledSolarIrradianceModel::LINEAR));
+        model->AddSample(Seconds(0.0), 0.0);
+        model->AddSample(Seconds(10.0), 1000.0);
+        model->AddSample(Seconds(20.0), 0.0);
+        sources[3]->SetAttribute("IrradianceModel", PointerValue(model));
+        sources[5]->SetAttribute("UseLeoCycle", BooleanValue(false));
+        sources[5]->AddSolarPanelWindow(100.0, 1.0, 9.0);
+        sources[5]->AddSolarPanelWindow(50.0, 4.0, 20.5);
+
+        Ptr<CompositeEnergyFleet> fleet;
+        if (useFleet)
+        {
+            fleet = CreateObject<CompositeEnergyFleet>();
+            for (const auto& source : sources)
+            {
+                fleet->Add(source);
+            }
+        }
+        for (const auto& source : sources)
+        {
+            source->Initialize();
+        }
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(sources[4]);
+        sources[4]->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(0.5);
+
+        Simulator::Stop(Seconds(30.0));
+        Simulator::Run();
+        Outcome outcome;
+        for (const auto& source : sources)
+        {
+            outcome.remaining.push_back(source->GetRemainingEnergy());
+            outcome.harvested.push_back(source->GetTotalHarvestedEnergy());
+        }
+        outcome.ticks = fleet ? fleet->GetTickCount() : 0;
+        outcome.events = Simulator::GetEventCount();
+        load->Dispose();
+        if (fleet)
+        {
+            fleet->Dispose();
+        }
+        for (const auto& source : sources)
+        {
+            source->Dispose();
+        }
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * Run-time window test: a fleet member enrolled with one window (a pulse)
+ * and one enrolled with none are given windows while the simulation runs.
+ * Both must harvest them, as their stand-alone twins do.
+ */
+class CompositeEnergyFleetRunTimeWindowTest : public TestCase
+{
+  public:
+    CompositeEnergyFleetRunTimeWindowTest()
+        : TestCase("CompositeEnergyFleet members follow windows added at run time")
+    {
+    }
+
+    void DoRun() override
+    {
+        std::vector<double> alone = Run(false);
+        std::vector<double> fleet = Run(true);
+        // 100 W over [1, 5) and 200 W over [12, 16).
+        NS_TEST_ASSERT_MSG_EQ_TOL(fleet[0], 1200.0, 1e-6, "window added to a pulse member");
+        // 50 W over [12, 20).
+        NS_TEST_ASSERT_MSG_EQ_TOL(fleet[1], 400.0, 1e-6, "window added to an empty member");
+        for (std::size_t i = 0; i < alone.size(); ++i)
+        {
+            NS_TEST_ASSERT_MSG_EQ_TOL(fleet[i],
+                                      alone[i],
+                                      1e-6,
+                                      "harvested energy differs from the stand-alone source");
+        }
+    }
+
+  private:
+    static std::vector<double> Run(bool useFleet)
+    {
+        std::vector<Ptr<CompositeEnergySource>> sources;
+        for (int i = 0; i < 2; ++i)
+        {
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(3000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+            source->SetAttribute("UseLeoCycle", BooleanValue(false));
+            sources.push_back(source);
+        }
+        sources[0]->AddSolarPanelWindow(100.0, 1.0, 5.0);
+
+        Ptr<CompositeEnergyFleet> fleet;
+        if (useFleet)
+        {
+            fleet = CreateObject<CompositeEnergyFleet>();
+            for (const auto& source : sources)
+            {
+                fleet->Add(source);
+            }
+        }
+        for (const auto& source : sources)
+        {
+            source->Initialize();
+        }
+        Simulator::Schedule(Seconds(10.0),
+                            &CompositeEnergySource::AddSolarPanelWindow,
+                            sources[0],
+                            200.0,
+                            12.0,
+                            16.0);
+        Simulator::Schedule(Seconds(10.0),
+                            &CompositeEnergySource::AddSolarPanelWindow,
+                            sources[1],
+                            50.0,
+                            12.0,
+                            20.0);
+
+        Simulator::Stop(Seconds(30.0));
+        Simulator::Run();
+        std::vector<double> harvested;
+        for (const auto& source : sources)
+        {
+            source->GetRemainingEnergy();
+            harvested.push_back(source->GetTotalHarvestedEnergy());
+        }
+        if (fleet)
+        {
+            fleet->Dispose();
+        }
+        for (const auto& source : sources)
+        {
+            source->Dispose();
+        }
+        Simulator::Destroy();
+        return harvested;
+    }
+};
+
+/**
+ * Thread-count independence test: a fleet of LEO members with staggered
+ * cycles, loads and energy caps (some of them reaching it) is run on one
+ * thread and on four, with chunks small enough that every thread gets
+ * several and steals some. Every member's energy and the fleet totals must
+ * be bit-identical.
+ */
+class CompositeEnergyFleetThreadsTest : public TestCase
+{
+  public:
+    CompositeEnergyFleetThreadsTest()
+        : TestCase("CompositeEnergyFleet results do not depend on Threads")
+    {
+    }
+
+    void DoRun() override
+    {
+        Outcome serial = Run(1);
+        Outcome parallel = Run(4);
+
+        for (std::size_t i = 0; i < serial.remaining.size(); ++i)
+        {
+            NS_TEST_ASSERT_MSG_EQ(parallel.remaining[i],
+                                  serial.remaining[i],
+                                  "remaining energy differs between thread counts");
+            NS_TEST_ASSERT_MSG_EQ(parallel.harvested[i],
+                                  serial.harvested[i],
+                                  "harvested energy differs between thread counts");
+        }
+        NS_TEST_ASSERT_MSG_EQ(parallel.powerW, serial.powerW, "fleet power differs");
+        NS_TEST_ASSERT_MSG_EQ(parallel.tickJ, serial.tickJ, "fleet tick energy differs");
+        NS_TEST_ASSERT_MSG_GT(serial.powerW, 0.0, "fleet should be harvesting at the end");
+    }
+
+  private:
+    struct Outcome
+    {
+        std::vector<double> remaining;
+        std::vector<double> harvested;
+        double powerW;
+        double tickJ;
+    };
+
+    static Outcome Run(uint32_t threads)
+    {
+        Ptr<CompositeEnergyFleet> fleet = CreateObject<CompositeEnergyFleet>();
+        fleet->SetAttribute("Threads", UintegerValue(threads));
+        fleet->SetAttribute("ChunkSize", UintegerValue(7));
+        fleet->SetAttribute("HarvestIntervalSeconds", DoubleValue(0.7));
+
+        std::vector<Ptr<CompositeEnergySource>> sources;
+        std::vector<Ptr<SimpleDeviceEnergyModel>> loads;
+        for (int i = 0; i < 100; ++i)
+        {
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(3000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(3050.0 + 10.0 * (i % 13)));
+            source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+            source->SetAttribute("PanelEfficiency", DoubleValue(0.25));
+            source->SetAttribute("SunlightSeconds", DoubleValue(5.0 + 0.1 * i));
+            source->SetAttribute("ShadowSeconds", DoubleValue(3.0 + (i % 5)));
+            fleet->Add(source);
+            sources.push_back(source);
+        }
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            sources[i]->Initialize();
+            Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+            load->SetEnergySource(sources[i]);
+            sources[i]->AppendDeviceEnergyModel(load);
+            load->SetCurrentA(0.01 * (i % 7));
+            loads.push_back(load);
+        }
+
+        Simulator::Stop(Seconds(40.0));
+        Simulator::Run();
+        Outcome outcome;
+        for (const auto& source : sources)
+        {
+            outcome.remaining.push_back(source->GetRemainingEnergy());
+            outcome.harvested.push_back(source->GetTotalHarvestedEnergy());
+        }
+        outcome.powerW = fleet->GetHarvestedPower();
+        outcome.tickJ = fleet->GetTickHarvestedEnergy();
+        for (const auto& load : loads)
+        {
+            load->Dispose();
+        }
+        fleet->Dispose();
+        for (const auto& source : sources)
+        {
+            source->Dispose();
+        }
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * Telemetry test: three fleet members on LEO cycles and a plain Li-Ion
+ * source under a load are sampled every 10 s by an
+ * EnergyTelemetryCollector writing blocks of four rows, raw and
+ * XOR-compressed. Reading either file back must give, row for row, the
+ * state the sources report at the sample times, and the compressed file
+ * must be the smaller.
+ */
+class CompositeEnergyFleetTelemetryTest : public TestCase
+{
+  public:
+    CompositeEnergyFleetTelemetryTest()
+        : TestCase("Energy telemetry collector writes and reads back source state")
+    {
+    }
+
+    void DoRun() override
+    {
+        uint64_t bytes[2];
+        for (int compressed = 0; compressed < 2; ++compressed)
+        {
+            std::string path = CreateTempDirFilename("energy-telemetry-test.bin");
+            std::vector<std::vector<EnergyTelemetrySample>> expected;
+            bytes[compressed] = Run(path, compressed == 1, expected);
+
+            EnergyTelemetryReader reader(path);
+            NS_TEST_ASSERT_MSG_EQ(reader.GetNSources(), 4, "source count");
+            NS_TEST_ASSERT_MSG_EQ(reader.GetNodeId(0), UINT32_MAX, "sources without a node");
+            NS_TEST_ASSERT_MSG_EQ(reader.GetNRows(), 11, "one row every 10 s up to 100 s");
+            NS_TEST_ASSERT_MSG_EQ(reader.GetHeader().blockCount, 3, "blocks of four rows");
+            for (uint64_t row = 0; row < reader.GetNRows(); ++row)
+            {
+                NS_TEST_ASSERT_MSG_EQ(reader.GetTime(row), Seconds(10.0 * row), "row time");
+                for (uint32_t s = 0; s < reader.GetNSources(); ++s)
+                {
+                    EnergyTelemetrySample sample = reader.GetSample(row, s);
+                    const EnergyTelemetrySample& want = expected[row][s];
+                    NS_TEST_ASSERT_MSG_EQ(sample.remainingJ, want.remainingJ, "remaining");
+                    // A second update at the same time may round the
+                    // voltage's current differently.
+                    NS_TEST_ASSERT_MSG_EQ_TOL(sample.voltageV, want.voltageV, 1e-9, "voltage");
+                    NS_TEST_ASSERT_MSG_EQ(sample.harvestedJ, want.harvestedJ, "harvested");
+                    NS_TEST_ASSERT_MSG_EQ(sample.sunlight, want.sunlight, "sunlight");
+                }
+            }
+            // 30 s of sunlight in every 50 s.
+            NS_TEST_ASSERT_MSG_EQ(reader.GetSample(2, 0).sunlight, true, "lit at 20 s");
+            NS_TEST_ASSERT_MSG_EQ(reader.GetSample(4, 0).sunlight, false, "shadow at 40 s");
+            NS_TEST_ASSERT_MSG_EQ(reader.GetSample(10, 3).harvestedJ, 0.0, "plain Li-Ion");
+            NS_TEST_ASSERT_MSG_LT(reader.GetSample(10, 3).remainingJ,
+                                  reader.GetSample(0, 3).remainingJ,
+                                  "plain Li-Ion drains");
+            std::remove(path.c_str());
+        }
+        NS_TEST_ASSERT_MSG_LT(bytes[1], bytes[0], "compression should shrink the file");
+    }
+
+  private:
+    /** Record the state of \p sources into \p expected, as the collector reads it. */
+    static void Probe(std::vector<Ptr<LiIonEnergySource>> sources,
+                      std::vector<std::vector<EnergyTelemetrySample>>* expected)
+    {
+        std::vector<EnergyTelemetrySample> row;
+        for (const auto& source : sources)
+        {
+            EnergyTelemetrySample sample{source->GetRemainingEnergy(), 0.0, 0.0, false};
+            sample.voltageV = source->GetSupplyVoltage();
+            Ptr<CompositeEnergySource> composite = DynamicCast<CompositeEnergySource>(source);
+            if (composite)
+            {
+                sample.harvestedJ = composite->GetTotalHarvestedEnergy();
+                sample.sunlight = composite->IsInSunlight();
+            }
+            row.push_back(sample);
+        }
+        expected->push_back(row);
+    }
+
+    /** \return Size of the file written. */
+    static uint64_t Run(const std::string& path,
+                        bool compressed,
+                        std::vector<std::vector<EnergyTelemetrySample>>& expected)
+    {
+        Ptr<CompositeEnergyFleet> fleet = CreateObject<CompositeEnergyFleet>();
+        std::vector<Ptr<LiIonEnergySource>> sources;
+        for (int i = 0; i < 3; ++i)
+        {
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(3000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+            source->SetAttribute("PanelAreaM2", DoubleValue(1.0 + i));
+            source->SetAttribute("SunlightSeconds", DoubleValue(30.0));
+            source->SetAttribute("ShadowSeconds", DoubleValue(20.0));
+            fleet->Add(source);
+            sources.push_back(source);
+        }
+        Ptr<LiIonEnergySource> battery = CreateObject<LiIonEnergySource>();
+        battery->SetAttribute("InitialEnergyJ", DoubleValue(3000.0));
+        sources.push_back(battery);
+        for (const auto& source : sources)
+        {
+            source->Initialize();
+        }
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(battery);
+        battery->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(0.5);
+
+        Ptr<EnergyTelemetryCollector> collector = CreateObject<EnergyTelemetryCollector>();
+        collector->SetAttribute("FileName", StringValue(path));
+        collector->SetAttribute("Interval", TimeValue(Seconds(10)));
+        collector->SetAttribute("BlockRows", UintegerValue(4));
+        collector->SetAttribute("Compression",
+                                EnumValue(compressed ? EnergyTelemetryHeader::XOR_DELTA
+                                                     : EnergyTelemetryHeader::NONE));
+        for (const auto& source : sources)
+        {
+            collector->Add(source);
+        }
+        // Scheduled first, the probes run just before the samples.
+        for (int s = 0; s <= 100; s += 10)
+        {
+            Simulator::Schedule(Seconds(s), &Probe, sources, &expected);
+        }
+        collector->Start();
+
+        Simulator::Stop(Seconds(100.5));
+        Simulator::Run();
+        collector->Stop();
+        uint64_t bytes = collector->GetNBytes();
+
+        collector->Dispose();
+        load->Dispose();
+        fleet->Dispose();
+        for (const auto& source : sources)
+        {
+            source->Dispose();
+        }
+        Simulator::Destroy();
+        return bytes;
+    }
+};
+
+class CompositeEnergyFleetTestSuite : public TestSuite
+{
+  public:
+    CompositeEnergyFleetTestSuite()
+        : TestSuite("composite-energy-fleet", Type::UNIT)
+    {
+        AddTestCase(new CompositeEnergyFleetEquivalenceTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergyFleetRunTimeWindowTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergyFleetThreadsTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergyFleetTelemetryTest, TestCase::Duration::QUICK);
+    }
+};
+
+static CompositeEnergyFleetTestSuite g_compositeEnergyFleetTestSuite;
@@ -1,11 +1,29 @@
 #include "ns3/boolean.h"
 #include "ns3/callback.h"
+#include "ns3/charge-taper-table.h"
+#include "ns3/composite-energy-fleet.h"
 #include "ns3/composite-energy-source.h"
 #include "ns3/double.h"
+#include "ns3/energy-checkpoint.h"
+#include "ns3/enum.h"
+#include "ns3/invocable-solar-irradiance-model.h"
+#include "ns3/li-ion-energy-source.h"
+#include "ns3/nstime.h"
 #include "ns3/pointer.h"
+#include "ns3/simple-device-energy-model.h"
 #include "ns3/simulator.h"
 #include "ns3/solar-irradiance-model.h"
 #include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -50,15 +68,15 @@ class CompositeEnergySourceFixedWindowTest : public TestCase
         source->Dispose();
         Simulator::Destroy();
 
-        // 500 W * 10 s = 5000 J. Allow a small tolerance for fixed-point
-        // drift in the Li-Ion voltage integration.
+        // 500 W * 10 s = 5000 J, exactly: the harvested energy does not
+        // depend on the Li-Ion voltage integration.
         NS_TEST_ASSERT_MSG_EQ_TOL(remaining,
                                   2000.0 + 500.0 * 10.0,
-                                  1.0,
+                                  1e-6,
                                   "remaining energy after fixed-window harvest");
         NS_TEST_ASSERT_MSG_EQ_TOL(harvested,
                                   500.0 * 10.0,
-                                  1.0,
+                                  1e-6,
                                   "total harvested energy after fixed-window harvest");
     }
 };
@@ -106,11 +124,11 @@ class CompositeEnergySourceLeoCycleTest : public TestCase
 
         NS_TEST_ASSERT_MSG_EQ_TOL(remaining,
                                   1000.0 + expectedHarvested,
-                                  2.0,
+                                  1e-6,
                                   "remaining energy after LEO cycle");
         NS_TEST_ASSERT_MSG_EQ_TOL(harvested,
                                   expectedHarvested,
-                                  2.0,
+                                  1e-6,
                                   "total harvested energy after LEO cycle");
     }
 };
@@ -159,7 +177,7 @@ class CompositeEnergySourceIrradianceModelTest : public TestCase
         // 1000 W for 5 s = 5000 J.
         NS_TEST_ASSERT_MSG_EQ_TOL(harvested,
                                   5000.0,
-                                  1.0,
+                                  1e-6,
                                   "callback irradiance harvest amount");
     }
 };
@@ -195,7 +213,7 @@ class CompositeEnergySourceChargeEfficiencyTest : public TestCase
         // 500 W * 10 s * 0.5 = 2500 J.
         NS_TEST_ASSERT_MSG_EQ_TOL(harvested,
                                   2500.0,
-                                  1.0,
+                                  1e-6,
                                   "efficiency should halve injected energy");
     }
 };
@@ -236,6 +254,1331 @@ class CompositeEnergySourceVoltageClampTest : public TestCase
     }
 };
 
+/**
+ * EventDriven scheduling equivalence test: the LEO-cycle and fixed-window
+ * scenarios above are run under both FixedInterval and EventDriven
+ * scheduling. With no clamp in play both must inject the same energy,
+ * while EventDriven only needs one update per phase change instead of
+ * one per HarvestIntervalSeconds. A window added after the last one has
+ * closed, when EventDriven has no update pending, must still be
+ * harvested.
+ */
+class CompositeEnergySourceEventDrivenTest : public TestCase
+{
+  public:
+    CompositeEnergySourceEventDrivenTest()
+        : TestCase("CompositeEnergySource EventDriven matches FixedInterval scheduling")
+    {
+    }
+
+    void DoRun() override
+    {
+        for (bool leo : {true, false})
+        {
+            Outcome fixed = Run(leo, CompositeEnergySource::FIXED_INTERVAL);
+            Outcome event = Run(leo, CompositeEnergySource::EVENT_DRIVEN);
+
+            NS_TEST_ASSERT_MSG_EQ_TOL(event.harvested,
+                                      fixed.harvested,
+                                      1e-6,
+                                      "harvested energy differs between scheduling modes");
+            NS_TEST_ASSERT_MSG_EQ_TOL(event.remaining,
+                                      fixed.remaining,
+                                      1e-6,
+                                      "remaining energy differs between scheduling modes");
+            NS_TEST_ASSERT_MSG_LT(event.events * 5,
+                                  fixed.events,
+                                  "EventDriven should need far fewer harvest updates");
+        }
+
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+        source->SetAttribute("HarvestScheduling", EnumValue(CompositeEnergySource::EVENT_DRIVEN));
+        source->SetAttribute("UseLeoCycle", BooleanValue(false));
+        source->AddSolarPanelWindow(500.0, 20.0, 40.0);
+        source->Initialize();
+        Simulator::Schedule(Seconds(45.0),
+                            &CompositeEnergySource::AddSolarPanelWindow,
+                            source,
+                            500.0,
+                            50.0,
+                            55.0);
+        Simulator::Stop(Seconds(60.0));
+        Simulator::Run();
+        double harvested = source->GetTotalHarvestedEnergy();
+        source->Dispose();
+        Simulator::Destroy();
+        NS_TEST_ASSERT_MSG_EQ_TOL(harvested, 500.0 * 25.0, 1e-6, "window added while running");
+    }
+
+  private:
+    struct Outcome
+    {
+        double remaining;
+        double harvested;
+        uint64_t events;
+    };
+
+    static Outcome Run(bool leo, CompositeEnergySource::HarvestSchedulingMode mode)
+    {
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+        source->SetAttribute("HarvestScheduling", EnumValue(mode));
+        source->SetAttribute("UseLeoCycle", BooleanValue(leo));
+        source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.25));
+        source->SetAttribute("SunlightSeconds", DoubleValue(10.0));
+        source->SetAttribute("ShadowSeconds", DoubleValue(5.0));
+        source->AddSolarPanelWindow(500.0, 20.0, 40.0);
+        source->Initialize();
+
+        Simulator::Stop(Seconds(60.0));
+        Simulator::Run();
+        Outcome outcome{source->GetRemainingEnergy(),
+                        source->GetTotalHarvestedEnergy(),
+                        source->GetHarvestEventCount()};
+        source->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * EventDriven clamp prediction test. A 500 W window charges a cell from
+ * 2000 J towards a 4000 J cap while the harvest interval is a coarse
+ * 10 s: EventDriven must stop at the predicted crossing (t ~= 4 s)
+ * rather than at the next tick. Two more runs check the predicted
+ * MaxChargeVoltageV crossing the same way, on the supply voltage the
+ * Li-Ion source reports: without internal resistance, and with one that
+ * lifts the voltage under the charge current, which must stop the charge
+ * earlier.
+ */
+class CompositeEnergySourceEventDrivenClampTest : public TestCase
+{
+  public:
+    CompositeEnergySourceEventDrivenClampTest()
+        : TestCase("CompositeEnergySource EventDriven predicts clamp crossings")
+    {
+    }
+
+    void DoRun() override
+    {
+        {
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(4000.0));
+            source->SetAttribute("UseLeoCycle", BooleanValue(false));
+            source->SetAttribute("HarvestIntervalSeconds", DoubleValue(10.0));
+            source->SetAttribute("HarvestScheduling",
+                                 EnumValue(CompositeEnergySource::EVENT_DRIVEN));
+            source->AddSolarPanelWindow(500.0, 0.0, 20.0);
+            source->Initialize();
+
+            Simulator::Stop(Seconds(20.0));
+            Simulator::Run();
+            double remaining = source->GetRemainingEnergy();
+            double harvested = source->GetTotalHarvestedEnergy();
+            source->Dispose();
+            Simulator::Destroy();
+
+            NS_TEST_ASSERT_MSG_EQ_TOL(remaining, 4000.0, 1e-6, "cap crossing overshoot");
+            NS_TEST_ASSERT_MSG_EQ_TOL(harvested, 2000.0, 1e-6, "harvest past the cap");
+        }
+
+        const double vMax = 4.05;
+        Outcome ideal = RunVoltageClamp(0.0, 50.0);
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(ideal.peakV, vMax, "voltage clamp released too early");
+        NS_TEST_ASSERT_MSG_LT(ideal.peakV, vMax + 0.005, "voltage clamp crossing overshoot");
+        NS_TEST_ASSERT_MSG_LT(ideal.harvestedJ,
+                              50.0 * 50.0,
+                              "harvest should stop before the first polling tick");
+
+        // 10 mOhm at about 1.25 A charging: the supply voltage reaches the
+        // ceiling 12.5 mV below the open-circuit voltage it does without.
+        Outcome ideal5 = RunVoltageClamp(0.0, 5.0);
+        Outcome resistive = RunVoltageClamp(0.01, 5.0);
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(resistive.peakV,
+                                    vMax - 0.001,
+                                    "resistive voltage clamp released too early");
+        NS_TEST_ASSERT_MSG_LT(resistive.peakV,
+                              vMax + 0.001,
+                              "resistive voltage clamp crossing overshoot");
+        NS_TEST_ASSERT_MSG_GT(resistive.harvestedJ, 0.0, "resistive cell charged");
+        NS_TEST_ASSERT_MSG_LT(resistive.harvestedJ,
+                              ideal5.harvestedJ,
+                              "the charge current lifts the voltage to the ceiling earlier");
+        NS_TEST_ASSERT_MSG_LT(resistive.restV,
+                              vMax - 0.01,
+                              "the voltage drops back once the charge stops");
+    }
+
+  private:
+    /** Voltages and harvest of a MaxChargeVoltageV run. */
+    struct Outcome
+    {
+        double peakV;      //!< Highest supply voltage seen at the probes
+        double restV;      //!< Supply voltage at the end, not charging
+        double harvestedJ; //!< Energy harvested
+    };
+
+    /**
+     * Charge a cell resting at 4.0 V towards a 4.05 V ceiling with a
+     * constant \p powerW panel and a coarse 50 s interval, probing the
+     * supply voltage every second.
+     */
+    Outcome RunVoltageClamp(double resistanceOhm, double powerW)
+    {
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+        source->SetAttribute("InitialCellVoltage", DoubleValue(4.0));
+        source->SetAttribute("InternalResistance", DoubleValue(resistanceOhm));
+        source->SetAttribute("MaxChargeVoltageV", DoubleValue(4.05));
+        source->SetAttribute("UseLeoCycle", BooleanValue(false));
+        source->SetAttribute("HarvestIntervalSeconds", DoubleValue(50.0));
+        source->SetAttribute("HarvestScheduling",
+                             EnumValue(CompositeEnergySource::EVENT_DRIVEN));
+        source->AddSolarPanelWindow(powerW, 0.0, 1000.0);
+        source->Initialize();
+
+        Outcome outcome{0.0, 0.0, 0.0};
+        for (int t = 1; t < 1000; ++t)
+        {
+            Simulator::Schedule(Seconds(t),
+                                &CompositeEnergySourceEventDrivenClampTest::Probe,
+                                source,
+                                &outcome);
+        }
+        Simulator::Stop(Seconds(1000.0));
+        Simulator::Run();
+        source->GetRemainingEnergy();
+        outcome.restV = source->GetSupplyVoltage();
+        outcome.harvestedJ = source->GetTotalHarvestedEnergy();
+        source->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+
+    static void Probe(Ptr<CompositeEnergySource> source, Outcome* outcome)
+    {
+        source->GetRemainingEnergy();
+        outcome->peakV = std::max(outcome->peakV, source->GetSupplyVoltage());
+    }
+};
+
+/**
+ * EventDriven scheduling with a piecewise-constant irradiance trace: the
+ * source must wake only at the trace's value changes (t = 0, 3, 13, 20 s)
+ * and still inject exactly what FixedInterval polling does.
+ */
+class CompositeEnergySourceEventDrivenTraceTest : public TestCase
+{
+  public:
+    CompositeEnergySourceEventDrivenTraceTest()
+        : TestCase("CompositeEnergySource EventDriven follows irradiance segments")
+    {
+    }
+
+    void DoRun() override
+    {
+        Outcome fixed = Run(CompositeEnergySource::FIXED_INTERVAL);
+        Outcome event = Run(CompositeEnergySource::EVENT_DRIVEN);
+
+        // 500 W for 10 s, then 200 W for 7 s.
+        NS_TEST_ASSERT_MSG_EQ_TOL(fixed.harvested, 6400.0, 1e-6, "trace harvest amount");
+        NS_TEST_ASSERT_MSG_EQ_TOL(event.harvested,
+                                  fixed.harvested,
+                                  1e-6,
+                                  "harvested energy differs between scheduling modes");
+        NS_TEST_ASSERT_MSG_EQ_TOL(event.remaining,
+                                  fixed.remaining,
+                                  1e-6,
+                                  "remaining energy differs between scheduling modes");
+        NS_TEST_ASSERT_MSG_EQ(event.events, 4, "one update per trace value change");
+    }
+
+  private:
+    struct Outcome
+    {
+        double remaining;
+        double harvested;
+        uint64_t events;
+    };
+
+    static Outcome Run(CompositeEnergySource::HarvestSchedulingMode mode)
+    {
+        Ptr<SampledSolarIrradianceModel> model = CreateObject<SampledSolarIrradianceModel>();
+        model->AddSample(Seconds(0.0), 0.0);
+        model->AddSample(Seconds(3.0), 1000.0);
+        model->AddSample(Seconds(13.0), 1000.0);
+        model->AddSample(Seconds(13.0), 400.0);
+        model->AddSample(Seconds(20.0), 0.0);
+
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+        source->SetAttribute("HarvestScheduling", EnumValue(mode));
+        source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.5));
+        source->SetAttribute("IrradianceModel", PointerValue(model));
+        source->Initialize();
+
+        Simulator::Stop(Seconds(30.0));
+        Simulator::Run();
+        Outcome outcome{source->GetRemainingEnergy(),
+                        source->GetTotalHarvestedEnergy(),
+                        source->GetHarvestEventCount()};
+        source->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * Exact integration test: harvested energy must not depend on how coarse
+ * the harvest and Li-Ion update intervals are. A LEO cycle whose toggles
+ * fall between updates, a linear irradiance ramp, and a cap crossing
+ * between two FixedInterval ticks are each integrated to the joule.
+ */
+class CompositeEnergySourceExactIntegrationTest : public TestCase
+{
+  public:
+    CompositeEnergySourceExactIntegrationTest()
+        : TestCase("CompositeEnergySource integrates harvest exactly over coarse intervals")
+    {
+    }
+
+    void DoRun() override
+    {
+        {
+            // Sunlight [0,10) and [15,25); updates every 7 s and 4 s.
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(1000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+            source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+            source->SetAttribute("PanelEfficiency", DoubleValue(0.25));
+            source->SetAttribute("HarvestIntervalSeconds", DoubleValue(7.0));
+            source->SetAttribute("PeriodicEnergyUpdateInterval", TimeValue(Seconds(4.0)));
+            source->SetAttribute("SunlightSeconds", DoubleValue(10.0));
+            source->SetAttribute("ShadowSeconds", DoubleValue(5.0));
+            source->Initialize();
+
+            Simulator::Stop(Seconds(30.0));
+            Simulator::Run();
+            double remaining = source->GetRemainingEnergy();
+            double harvested = source->GetTotalHarvestedEnergy();
+            source->Dispose();
+            Simulator::Destroy();
+
+            const double expected = 1361.0 * 0.25 * 20.0;
+            NS_TEST_ASSERT_MSG_EQ_TOL(harvested, expected, 1e-6, "coarse LEO harvest");
+            NS_TEST_ASSERT_MSG_EQ_TOL(remaining, 1000.0 + expected, 1e-6, "coarse LEO charge");
+        }
+        {
+            // Triangle 0 -> 1000 -> 0 W/m^2 over 20 s on 1 m^2: 10 kJ.
+            Ptr<SampledSolarIrradianceModel> model = CreateObject<SampledSolarIrradianceModel>();
+            model->SetAttribute("Interpolation", EnumValue(SampledSolarIrradianceModel::LINEAR));
+            model->AddSample(Seconds(0.0), 0.0);
+            model->AddSample(Seconds(10.0), 1000.0);
+            model->AddSample(Seconds(20.0), 0.0);
+
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(1000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(100000.0));
+            source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+            source->SetAttribute("PanelEfficiency", DoubleValue(1.0));
+            source->SetAttribute("HarvestIntervalSeconds", DoubleValue(7.0));
+            source->SetAttribute("PeriodicEnergyUpdateInterval", TimeValue(Seconds(3.0)));
+            source->SetAttribute("IrradianceModel", PointerValue(model));
+            source->Initialize();
+
+            Simulator::Stop(Seconds(22.0));
+            Simulator::Run();
+            double harvested = source->GetTotalHarvestedEnergy();
+            source->Dispose();
+            Simulator::Destroy();
+
+            NS_TEST_ASSERT_MSG_EQ_TOL(harvested, 10000.0, 1e-6, "linear ramp harvest");
+        }
+        {
+            // 500 W from 2000 J towards a 4000 J cap crosses at t = 4 s,
+            // between FixedInterval ticks at 0 and 10 s.
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(4000.0));
+            source->SetAttribute("UseLeoCycle", BooleanValue(false));
+            source->SetAttribute("HarvestIntervalSeconds", DoubleValue(10.0));
+            source->SetAttribute("PeriodicEnergyUpdateInterval", TimeValue(Seconds(3.0)));
+            source->AddSolarPanelWindow(500.0, 0.0, 20.0);
+            source->Initialize();
+
+            Simulator::Stop(Seconds(20.0));
+            Simulator::Run();
+            double remaining = source->GetRemainingEnergy();
+            double harvested = source->GetTotalHarvestedEnergy();
+            source->Dispose();
+            Simulator::Destroy();
+
+            NS_TEST_ASSERT_MSG_EQ_TOL(remaining, 4000.0, 1e-6, "cap crossing between ticks");
+            NS_TEST_ASSERT_MSG_EQ_TOL(harvested, 2000.0, 1e-6, "harvest past the cap");
+        }
+    }
+};
+
+/**
+ * Profiling test: a LEO source with EnableProfiling counts its hot paths
+ * (one UpdateHarvestCurrent per harvest event, the LEO toggles, the
+ * harvester settling at the Li-Ion updates), fires the HotPath trace once
+ * per counted call and shows up in the registry dump, while a source
+ * without it holds no profile.
+ */
+class CompositeEnergySourceProfilingTest : public TestCase
+{
+  public:
+    CompositeEnergySourceProfilingTest()
+        : TestCase("CompositeEnergySource EnableProfiling counts hot paths")
+    {
+    }
+
+    void DoRun() override
+    {
+        HotPathProfileRegistry::Clear();
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(10000.0));
+        source->SetAttribute("SunlightSeconds", DoubleValue(10.0));
+        source->SetAttribute("ShadowSeconds", DoubleValue(5.0));
+        source->SetAttribute("EnableProfiling", BooleanValue(true));
+        source->TraceConnectWithoutContext(
+            "HotPath",
+            MakeCallback(&CompositeEnergySourceProfilingTest::HotPath, this));
+        Ptr<CompositeEnergySource> plain = CreateObject<CompositeEnergySource>();
+        source->Initialize();
+        plain->Initialize();
+
+        Simulator::Stop(Seconds(30.5));
+        Simulator::Run();
+
+        const HotPathProfile* profile = source->GetProfile();
+        const HotPathProfile* harvester = source->GetHarvester()->GetProfile();
+        NS_TEST_ASSERT_MSG_NE(profile, nullptr, "profiling source should hold a profile");
+        NS_TEST_ASSERT_MSG_NE(harvester, nullptr, "its harvester should hold one too");
+        NS_TEST_ASSERT_MSG_EQ(plain->GetProfile(), nullptr, "profiling is opt-in");
+        NS_TEST_ASSERT_MSG_EQ(HotPathProfileRegistry::GetN(), 2, "registered profiles");
+
+        // Harvest updates at 0..30 s; the LEO cycle schedules no events.
+        NS_TEST_ASSERT_MSG_EQ(profile->GetCalls(HotPathProfile::UPDATE_HARVEST_CURRENT),
+                              source->GetHarvestEventCount(),
+                              "one UpdateHarvestCurrent per harvest event");
+        NS_TEST_ASSERT_MSG_EQ(source->GetHarvestEventCount(), 31, "harvest updates");
+        NS_TEST_ASSERT_MSG_EQ(profile->GetCalls(HotPathProfile::GET_REMAINING_ENERGY),
+                              0,
+                              "harvest events estimate the state instead of forcing an update");
+        NS_TEST_ASSERT_MSG_EQ(harvester->GetCalls(HotPathProfile::SETTLE),
+                              profile->GetCalls(HotPathProfile::UPDATE_ENERGY_SOURCE),
+                              "the harvester settles at every Li-Ion update");
+
+        uint64_t calls = 0;
+        HotPathProfile total = HotPathProfileRegistry::GetTotal();
+        for (int p = 0; p < HotPathProfile::N_PATHS; ++p)
+        {
+            calls += profile->GetCalls(static_cast<HotPathProfile::Path>(p));
+        }
+        NS_TEST_ASSERT_MSG_EQ(m_traced, calls, "one HotPath trace per profiled source call");
+        NS_TEST_ASSERT_MSG_EQ(total.GetCalls(HotPathProfile::SETTLE),
+                              harvester->GetCalls(HotPathProfile::SETTLE),
+                              "registry total");
+
+        std::ostringstream dump;
+        HotPathProfileRegistry::Dump(dump);
+        NS_TEST_ASSERT_MSG_NE(dump.str().find("UpdateHarvestCurrent"),
+                              std::string::npos,
+                              "dump should list UpdateHarvestCurrent");
+        NS_TEST_ASSERT_MSG_EQ((dump.flags() == std::ostringstream().flags()),
+                              true,
+                              "dump should restore the stream flags");
+        NS_TEST_ASSERT_MSG_EQ(dump.precision(), 6, "dump should restore the stream precision");
+
+        source->Dispose();
+        plain->Dispose();
+        Simulator::Destroy();
+        HotPathProfileRegistry::Clear();
+    }
+
+  private:
+    void HotPath(HotPathProfile::Path /* path */, Time /* elapsed */)
+    {
+        ++m_traced;
+    }
+
+    uint64_t m_traced{0};
+};
+
+/**
+ * Estimated-state test: 10 W harvested in the sunlight of three 600 s /
+ * 300 s LEO cycles, under a load of 4.2 A over the first cycle and 0.5 A
+ * after it, so that the cell discharges, recharges and meets the
+ * MaxEnergyJ clamp. The harvest ticks every second and the Li-Ion update
+ * every 10 s. The exact path is emulated by forcing a Li-Ion update at
+ * every tick, as UpdateHarvestCurrent() used to. The estimated path must
+ * reach the same remaining energy and voltage at the end of every phase,
+ * to within the error of the coarser Li-Ion steps, with far fewer updates.
+ */
+class CompositeEnergySourceEstimatedStateTest : public TestCase
+{
+  public:
+    CompositeEnergySourceEstimatedStateTest()
+        : TestCase("CompositeEnergySource estimated cell state tracks the exact one")
+    {
+    }
+
+    void DoRun() override
+    {
+        Outcome exact = Run(true);
+        Outcome estimated = Run(false);
+        NS_TEST_ASSERT_MSG_EQ(exact.remainingJ.size(), 6, "phase ends probed");
+        NS_TEST_ASSERT_MSG_EQ(estimated.remainingJ.size(), 6, "phase ends probed");
+        NS_TEST_ASSERT_MSG_LT(exact.remainingJ[0],
+                              exact.remainingJ[5] - 1000.0,
+                              "the cell discharges and recharges");
+        for (std::size_t k = 0; k < exact.remainingJ.size(); ++k)
+        {
+            NS_TEST_ASSERT_MSG_EQ_TOL(estimated.remainingJ[k],
+                                      exact.remainingJ[k],
+                                      5.0,
+                                      "remaining energy at phase end " << k);
+            NS_TEST_ASSERT_MSG_EQ_TOL(estimated.voltageV[k],
+                                      exact.voltageV[k],
+                                      1e-3,
+                                      "supply voltage at phase end " << k);
+        }
+        NS_TEST_ASSERT_MSG_EQ_TOL(estimated.harvestedJ, exact.harvestedJ, 5.0, "harvested energy");
+        NS_TEST_ASSERT_MSG_LT(estimated.updates * 5, exact.updates, "far fewer Li-Ion updates");
+    }
+
+  private:
+    struct Outcome
+    {
+        std::vector<double> remainingJ; //!< At the end of each phase
+        std::vector<double> voltageV;   //!< At the end of each phase
+        double harvestedJ;
+        uint64_t updates;
+    };
+
+    static void Force(Ptr<CompositeEnergySource> source)
+    {
+        source->GetRemainingEnergy();
+    }
+
+    static void Probe(Outcome* outcome, Ptr<CompositeEnergySource> source)
+    {
+        outcome->remainingJ.push_back(source->GetRemainingEnergy());
+        outcome->voltageV.push_back(source->GetSupplyVoltage());
+        outcome->harvestedJ = source->GetTotalHarvestedEnergy();
+        outcome->updates =
+            source->GetProfile()->GetCalls(HotPathProfile::UPDATE_ENERGY_SOURCE);
+    }
+
+    static Outcome Run(bool exact)
+    {
+        Outcome outcome{{}, {}, 0.0, 0};
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("HarvestScheduling",
+                             EnumValue(CompositeEnergySource::FIXED_INTERVAL));
+        source->SetAttribute("HarvestIntervalSeconds", DoubleValue(1.0));
+        source->SetAttribute("PeriodicEnergyUpdateInterval", TimeValue(Seconds(10)));
+        source->SetAttribute("SolarConstantWm2", DoubleValue(1000.0));
+        source->SetAttribute("PanelAreaM2", DoubleValue(0.05));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.2));
+        source->SetAttribute("SunlightSeconds", DoubleValue(600.0));
+        source->SetAttribute("ShadowSeconds", DoubleValue(300.0));
+        source->SetAttribute("EnableProfiling", BooleanValue(true));
+        source->Initialize();
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(source);
+        source->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(4.2);
+        Simulator::Schedule(Seconds(900), &SimpleDeviceEnergyModel::SetCurrentA, load, 0.5);
+
+        if (exact)
+        {
+            for (int t = 1; t < 2700; ++t)
+            {
+                Simulator::Schedule(Seconds(t), &Force, source);
+            }
+        }
+        for (int t : {600, 900, 1500, 1800, 2400, 2700})
+        {
+            Simulator::Schedule(Seconds(t), &Probe, &outcome, source);
+        }
+        Simulator::Stop(Seconds(2701));
+        Simulator::Run();
+        source->Dispose();
+        load->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * Lookahead test: a polled propagator read through IrradianceLookahead
+ * blocks, fetched on the simulation thread or computed ahead by
+ * IrradianceWorkers, yields the same HarvestedPower trace, harvest and
+ * remaining energy as one queried sample by sample, across a cap
+ * crossing, while computing its samples in blocks. Under EventDriven,
+ * whose ticks leave the grid, the model is not wrapped.
+ */
+class CompositeEnergySourceLookaheadTest : public TestCase
+{
+  public:
+    CompositeEnergySourceLookaheadTest()
+        : TestCase("CompositeEnergySource IrradianceLookahead leaves harvesting unchanged")
+    {
+    }
+
+    void DoRun() override
+    {
+        for (auto mode :
+             {CompositeEnergySource::FIXED_INTERVAL, CompositeEnergySource::EVENT_DRIVEN})
+        {
+            Outcome direct = Run(mode, 0, 0);
+            NS_TEST_ASSERT_MSG_EQ(direct.blockCalls, 0, "queried sample by sample");
+            for (uint32_t workers : {0U, 2U})
+            {
+                Outcome ahead = Run(mode, 16, workers);
+                NS_TEST_ASSERT_MSG_EQ(ahead.trace.size(), direct.trace.size(), "trace length");
+                for (std::size_t i = 0; i < std::min(ahead.trace.size(), direct.trace.size());
+                     ++i)
+                {
+                    NS_TEST_ASSERT_MSG_EQ(ahead.trace[i].first,
+                                          direct.trace[i].first,
+                                          "trace time");
+                    NS_TEST_ASSERT_MSG_EQ(ahead.trace[i].second,
+                                          direct.trace[i].second,
+                                          "trace value");
+                }
+                NS_TEST_ASSERT_MSG_EQ(ahead.harvested, direct.harvested, "harvested energy");
+                NS_TEST_ASSERT_MSG_EQ(ahead.remaining, direct.remaining, "remaining energy");
+                if (mode == CompositeEnergySource::FIXED_INTERVAL)
+                {
+                    NS_TEST_ASSERT_MSG_GT(ahead.blockCalls, 0, "queried in blocks");
+                    NS_TEST_ASSERT_MSG_LT(ahead.scalarCalls,
+                                          direct.scalarCalls / 2,
+                                          "mostly blocks");
+                }
+                else
+                {
+                    NS_TEST_ASSERT_MSG_EQ(ahead.blockCalls, 0, "not wrapped off the grid");
+                }
+            }
+        }
+    }
+
+  private:
+    /** Propagator that computes one sample or a block per call, from any thread. */
+    struct Propagator
+    {
+        std::atomic<uint64_t>* scalarCalls;
+        std::atomic<uint64_t>* blockCalls;
+
+        double operator()(Time t) const
+        {
+            ++*scalarCalls;
+            return Value(t);
+        }
+
+        void operator()(const Time* times, double* wm2, std::size_t n) const
+        {
+            ++*blockCalls;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                wm2[i] = Value(times[i]);
+            }
+        }
+
+        static double Value(Time t)
+        {
+            return 600.0 + 400.0 * std::sin(t.GetSeconds() / 3.0);
+        }
+    };
+
+    struct Outcome
+    {
+        std::vector<std::pair<Time, double>> trace;
+        double harvested;
+        double remaining;
+        uint64_t scalarCalls;
+        uint64_t blockCalls;
+    };
+
+    static void Record(std::vector<std::pair<Time, double>>* trace, double, double power)
+    {
+        trace->emplace_back(Simulator::Now(), power);
+    }
+
+    static Outcome Run(CompositeEnergySource::HarvestSchedulingMode mode,
+                       uint32_t lookahead,
+                       uint32_t workers)
+    {
+        Outcome outcome{{}, 0.0, 0.0, 0, 0};
+        std::atomic<uint64_t> scalarCalls{0};
+        std::atomic<uint64_t> blockCalls{0};
+        auto model = CreateInvocableSolarIrradianceModel(Propagator{&scalarCalls, &blockCalls});
+
+        // 500 W average from 2000 J reaches the 20 kJ cap after ~36 s.
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(2000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(20000.0));
+        source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.5));
+        source->SetAttribute("HarvestScheduling", EnumValue(mode));
+        source->SetAttribute("PeriodicEnergyUpdateInterval", TimeValue(Seconds(3.5)));
+        source->SetAttribute("IrradianceModel", PointerValue(model));
+        source->SetAttribute("IrradianceLookahead", UintegerValue(lookahead));
+        source->SetAttribute("IrradianceWorkers", UintegerValue(workers));
+        source->TraceConnectWithoutContext("HarvestedPower",
+                                           MakeBoundCallback(&Record, &outcome.trace));
+        source->Initialize();
+
+        Simulator::Stop(Seconds(60.0));
+        Simulator::Run();
+        outcome.remaining = source->GetRemainingEnergy();
+        outcome.harvested = source->GetTotalHarvestedEnergy();
+        source->Dispose();
+        Simulator::Destroy();
+        outcome.scalarCalls = scalarCalls.load();
+        outcome.blockCalls = blockCalls.load();
+        return outcome;
+    }
+};
+
+/**
+ * Harvested-power trace test: HarvestedPowerBinned reports aligned bins
+ * whose energies add up to the harvested total and whose extremes follow
+ * the eclipses, stand-alone and as a fleet member; a dead-band mutes
+ * HarvestedPower ripple but not starts and stops, and leaves the bins
+ * unchanged.
+ */
+class CompositeEnergySourceHarvestedPowerBinTest : public TestCase
+{
+  public:
+    CompositeEnergySourceHarvestedPowerBinTest()
+        : TestCase("CompositeEnergySource HarvestedPower dead-band and bins")
+    {
+    }
+
+    void DoRun() override
+    {
+        // 680.5 W lit in [0, 30), [50, 80) and from 100 s, in shadow
+        // otherwise.
+        const double p = 1361.0 * 0.5;
+        for (bool useFleet : {false, true})
+        {
+            std::vector<CompositeEnergySource::HarvestedPowerBin> bins;
+            Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+            source->SetAttribute("InitialEnergyJ", DoubleValue(1000.0));
+            source->SetAttribute("MaxEnergyJ", DoubleValue(1e6));
+            source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+            source->SetAttribute("PanelEfficiency", DoubleValue(0.5));
+            source->SetAttribute("SunlightSeconds", DoubleValue(30.0));
+            source->SetAttribute("ShadowSeconds", DoubleValue(20.0));
+            source->SetAttribute("HarvestedPowerBin", TimeValue(Seconds(10)));
+            source->TraceConnectWithoutContext("HarvestedPowerBinned",
+                                               MakeBoundCallback(&RecordBin, &bins));
+            Ptr<CompositeEnergyFleet> fleet;
+            if (useFleet)
+            {
+                fleet = CreateObject<CompositeEnergyFleet>();
+                fleet->Add(source);
+            }
+            source->Initialize();
+
+            // Flushed between two harvest ticks, 4.5 s into a lit bin.
+            Simulator::Schedule(Seconds(104.5), &Flush, source);
+            Simulator::Stop(Seconds(104.5));
+            Simulator::Run();
+
+            NS_TEST_ASSERT_MSG_EQ(bins.size(), 11, "eleven bins, the last one flushed");
+            double totalJ = 0.0;
+            for (std::size_t k = 0; k < bins.size(); ++k)
+            {
+                bool lit = (k < 3) || (k >= 5 && k < 8) || k == 10;
+                double seconds = (bins[k].end - bins[k].start).GetSeconds();
+                NS_TEST_ASSERT_MSG_EQ(bins[k].start, Seconds(10 * k), "aligned start");
+                NS_TEST_ASSERT_MSG_EQ(bins[k].minW, lit ? p : 0.0, "bin minimum");
+                NS_TEST_ASSERT_MSG_EQ(bins[k].maxW, lit ? p : 0.0, "bin maximum");
+                NS_TEST_ASSERT_MSG_EQ_TOL(bins[k].energyJ, lit ? seconds * p : 0.0, 1e-6, "energy");
+                NS_TEST_ASSERT_MSG_EQ_TOL(bins[k].meanW,
+                                          bins[k].energyJ / seconds,
+                                          1e-9,
+                                          "mean");
+                totalJ += bins[k].energyJ;
+            }
+            NS_TEST_ASSERT_MSG_EQ(bins.back().end, Seconds(104.5), "flushed up to now");
+            NS_TEST_ASSERT_MSG_EQ_TOL(totalJ,
+                                      source->GetTotalHarvestedEnergy(),
+                                      1e-6,
+                                      "bins add up to the harvest");
+
+            if (fleet)
+            {
+                fleet->Dispose();
+            }
+            source->Dispose();
+            Simulator::Destroy();
+        }
+
+        // Ripple of +-5 W around 500 W, and a shadow in [20, 30).
+        Outcome all = Run(0.0);
+        Outcome coarse = Run(20.0);
+        NS_TEST_ASSERT_MSG_GT(all.changes, 30, "every change reported");
+        NS_TEST_ASSERT_MSG_EQ(coarse.changes, 3, "start, stop and restart only");
+        NS_TEST_ASSERT_MSG_EQ(coarse.bins.size(), all.bins.size(), "same bins");
+        for (std::size_t k = 0; k < std::min(coarse.bins.size(), all.bins.size()); ++k)
+        {
+            NS_TEST_ASSERT_MSG_EQ(coarse.bins[k].energyJ, all.bins[k].energyJ, "bin energy");
+            NS_TEST_ASSERT_MSG_EQ(coarse.bins[k].minW, all.bins[k].minW, "bin minimum");
+            NS_TEST_ASSERT_MSG_EQ(coarse.bins[k].maxW, all.bins[k].maxW, "bin maximum");
+        }
+        NS_TEST_ASSERT_MSG_EQ(coarse.bins[2].minW, 0.0, "shadow bin");
+        NS_TEST_ASSERT_MSG_GT(coarse.bins[1].maxW, coarse.bins[1].minW, "ripple in the bin");
+    }
+
+  private:
+    struct Outcome
+    {
+        uint32_t changes;
+        std::vector<CompositeEnergySource::HarvestedPowerBin> bins;
+    };
+
+    static double Ripple(Time t)
+    {
+        double s = t.GetSeconds();
+        return (s >= 20.0 && s < 30.0) ? 0.0 : 1000.0 + 10.0 * std::sin(s);
+    }
+
+    static void Flush(Ptr<CompositeEnergySource> source)
+    {
+        source->FlushHarvestedPowerBin();
+        source->GetRemainingEnergy();
+    }
+
+    static void RecordBin(std::vector<CompositeEnergySource::HarvestedPowerBin>* bins,
+                          const CompositeEnergySource::HarvestedPowerBin& bin)
+    {
+        bins->push_back(bin);
+    }
+
+    static void CountChange(uint32_t* changes, double, double)
+    {
+        ++*changes;
+    }
+
+    static Outcome Run(double deadBandW)
+    {
+        Outcome outcome{0, {}};
+        Ptr<CallbackSolarIrradianceModel> model = CreateObject<CallbackSolarIrradianceModel>();
+        model->SetCallback(MakeCallback(&Ripple));
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(1000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(1e6));
+        source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.5));
+        source->SetAttribute("IrradianceModel", PointerValue(model));
+        source->SetAttribute("HarvestedPowerDeadBandW", DoubleValue(deadBandW));
+        source->SetAttribute("HarvestedPowerBin", TimeValue(Seconds(10)));
+        source->TraceConnectWithoutContext("HarvestedPower",
+                                           MakeBoundCallback(&CountChange, &outcome.changes));
+        source->TraceConnectWithoutContext("HarvestedPowerBinned",
+                                           MakeBoundCallback(&RecordBin, &outcome.bins));
+        source->Initialize();
+
+        Simulator::Stop(Seconds(40.5));
+        Simulator::Run();
+        source->Dispose();
+        model->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * Checkpoint test: a composite source (LEO cycle of 30 s sunlight and
+ * 20 s shadow, no load) and a loaded plain Li-Ion battery run for 70 s
+ * and are saved from an event then (the Li-Ion base class no longer
+ * updates once the simulator has stopped). A new run restored from the checkpoint at t0 starts
+ * from the saved energies 20 s into a sunlight phase, and after 60 s
+ * the composite source has harvested and holds what a continuous run
+ * of 130 s gives. Run standalone and as a fleet member.
+ */
+class CompositeEnergySourceCheckpointTest : public TestCase
+{
+  public:
+    CompositeEnergySourceCheckpointTest()
+        : TestCase("CompositeEnergySource checkpoint and restore")
+    {
+    }
+
+    void DoRun() override
+    {
+        std::string path = CreateTempDirFilename("energy-checkpoint-test.bin");
+        for (bool useFleet : {false, true})
+        {
+            Outcome continuous = Run(useFleet, "", "", Seconds(130));
+            Outcome saved = Run(useFleet, "", path, Seconds(70));
+            Outcome restored = Run(useFleet, path, "", Seconds(60));
+
+            // 680.5 W lit in [0, 30) and [50, 70) before the checkpoint
+            const double p = 1361.0 * 0.5;
+            NS_TEST_ASSERT_MSG_EQ_TOL(saved.end.harvestedJ, 50.0 * p, 1e-6, "harvest saved");
+            NS_TEST_ASSERT_MSG_EQ(restored.savedAt, Seconds(70), "checkpoint time");
+            NS_TEST_ASSERT_MSG_EQ(restored.start.remainingJ,
+                                  saved.end.remainingJ,
+                                  "composite energy restored");
+            NS_TEST_ASSERT_MSG_EQ(restored.start.harvestedJ,
+                                  saved.end.harvestedJ,
+                                  "harvest restored");
+            NS_TEST_ASSERT_MSG_EQ(restored.start.cyclePosition,
+                                  Seconds(20),
+                                  "cycle position restored");
+            NS_TEST_ASSERT_MSG_EQ(restored.startBatteryJ,
+                                  saved.endBatteryJ,
+                                  "battery energy restored");
+            NS_TEST_ASSERT_MSG_LT(saved.endBatteryJ, 3000.0, "battery drained before saving");
+            NS_TEST_ASSERT_MSG_EQ_TOL(restored.end.harvestedJ,
+                                      continuous.end.harvestedJ,
+                                      1e-6,
+                                      "harvest as in a continuous run");
+            NS_TEST_ASSERT_MSG_EQ_TOL(restored.end.remainingJ,
+                                      continuous.end.remainingJ,
+                                      1e-6,
+                                      "energy as in a continuous run");
+        }
+    }
+
+  private:
+    struct Outcome
+    {
+        CompositeEnergySource::EnergyState start; //!< After the restore
+        CompositeEnergySource::EnergyState end;
+        double startBatteryJ;
+        double endBatteryJ;
+        Time savedAt;
+    };
+
+    /** Record the final state, and save it to \p path if set. */
+    static void Finish(const EnergyCheckpoint* checkpoint,
+                       std::string path,
+                       Outcome* outcome,
+                       Ptr<CompositeEnergySource> source,
+                       Ptr<LiIonEnergySource> battery)
+    {
+        if (!path.empty())
+        {
+            checkpoint->Save(path);
+        }
+        outcome->end = source->GetEnergyState();
+        outcome->endBatteryJ = battery->GetRemainingEnergy();
+    }
+
+    /**
+     * Run until \p end, restoring \p restorePath at t0 and saving to
+     * \p savePath at \p end, if set.
+     */
+    static Outcome Run(bool useFleet,
+                       const std::string& restorePath,
+                       const std::string& savePath,
+                       Time end)
+    {
+        Outcome outcome;
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(1000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(1e6));
+        source->SetAttribute("PanelAreaM2", DoubleValue(1.0));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.5));
+        source->SetAttribute("SunlightSeconds", DoubleValue(30.0));
+        source->SetAttribute("ShadowSeconds", DoubleValue(20.0));
+        Ptr<CompositeEnergyFleet> fleet;
+        if (useFleet)
+        {
+            fleet = CreateObject<CompositeEnergyFleet>();
+            fleet->Add(source);
+        }
+        Ptr<LiIonEnergySource> battery = CreateObject<LiIonEnergySource>();
+        battery->SetAttribute("InitialEnergyJ", DoubleValue(3000.0));
+
+        EnergyCheckpoint checkpoint;
+        checkpoint.Add(source);
+        checkpoint.Add(battery);
+        outcome.savedAt = Seconds(0);
+        if (!restorePath.empty())
+        {
+            outcome.savedAt = checkpoint.Restore(restorePath);
+        }
+        source->Initialize();
+        battery->Initialize();
+        outcome.start = source->GetEnergyState();
+        outcome.startBatteryJ = battery->GetRemainingEnergy();
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(battery);
+        battery->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(0.5);
+
+        Simulator::Schedule(end, &Finish, &checkpoint, savePath, &outcome, source, battery);
+        Simulator::Stop(end + Seconds(1));
+        Simulator::Run();
+
+        if (fleet)
+        {
+            fleet->Dispose();
+        }
+        source->Dispose();
+        load->Dispose();
+        battery->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * FastForward test: a cell under a load of 1 A, 0.3 A in [700, 1500) s,
+ * with 2 W harvested in the sunlight of a 30 s / 20 s LEO cycle. Against
+ * FixedInterval with a 0.1 s Li-Ion update interval, FastForward must
+ * reach the same energy and voltage with a small fraction of the Li-Ion
+ * updates, and with LiIonEnergyLowBatteryThreshold raised it must hit
+ * the threshold at its crossing rather than at the next update.
+ */
+class CompositeEnergySourceFastForwardTest : public TestCase
+{
+  public:
+    CompositeEnergySourceFastForwardTest()
+        : TestCase("CompositeEnergySource FastForward jumps between state changes")
+    {
+    }
+
+    void DoRun() override
+    {
+        Outcome stepped = Run(CompositeEnergySource::FIXED_INTERVAL, 0.0);
+        Outcome fast = Run(CompositeEnergySource::FAST_FORWARD, 0.0);
+        NS_TEST_ASSERT_MSG_LT(stepped.remainingJ, 28000.0, "the cell discharges");
+        NS_TEST_ASSERT_MSG_EQ_TOL(fast.harvestedJ,
+                                  stepped.harvestedJ,
+                                  1e-6,
+                                  "harvested energy");
+        // The stepped run charges each 0.1 s at the voltage of its start.
+        NS_TEST_ASSERT_MSG_EQ_TOL(fast.remainingJ, stepped.remainingJ, 0.1, "remaining energy");
+        NS_TEST_ASSERT_MSG_EQ_TOL(fast.voltageV, stepped.voltageV, 1e-4, "supply voltage");
+        NS_TEST_ASSERT_MSG_LT(fast.updates * 100, stepped.updates, "far fewer Li-Ion updates");
+
+        // About 3.2 kJ into the run
+        stepped = Run(CompositeEnergySource::FIXED_INTERVAL, 0.9);
+        fast = Run(CompositeEnergySource::FAST_FORWARD, 0.9);
+        NS_TEST_ASSERT_MSG_GT(stepped.lowBattery, Seconds(0), "threshold reached");
+        NS_TEST_ASSERT_MSG_LT(stepped.lowBattery, Seconds(2400), "threshold reached");
+        NS_TEST_ASSERT_MSG_EQ_TOL(fast.lowBattery.GetSeconds(),
+                                  stepped.lowBattery.GetSeconds(),
+                                  0.1,
+                                  "threshold crossing");
+        NS_TEST_ASSERT_MSG_EQ_TOL(fast.lowBatteryJ, fast.lowJ, 1e-6, "update at the crossing");
+    }
+
+  private:
+    struct Outcome
+    {
+        double remainingJ;
+        double voltageV;
+        double harvestedJ;
+        uint64_t updates;
+        double lowJ;        //!< Low-battery threshold
+        Time lowBattery;    //!< First update at or below it
+        double lowBatteryJ; //!< Energy then
+    };
+
+    static void RecordEnergy(Outcome* outcome, double, double remainingJ)
+    {
+        if (remainingJ <= outcome->lowJ && outcome->lowBattery.IsZero())
+        {
+            outcome->lowBattery = Simulator::Now();
+            outcome->lowBatteryJ = remainingJ;
+        }
+    }
+
+    static void Finish(Outcome* outcome, Ptr<CompositeEnergySource> source)
+    {
+        outcome->remainingJ = source->GetRemainingEnergy();
+        outcome->voltageV = source->GetSupplyVoltage();
+        outcome->harvestedJ = source->GetTotalHarvestedEnergy();
+        outcome->updates =
+            source->GetProfile()->GetCalls(HotPathProfile::UPDATE_ENERGY_SOURCE);
+    }
+
+    static Outcome Run(CompositeEnergySource::HarvestSchedulingMode mode, double lowFraction)
+    {
+        Outcome outcome{0.0, 0.0, 0.0, 0, 0.0, Seconds(0), 0.0};
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("HarvestScheduling", EnumValue(mode));
+        source->SetAttribute("PeriodicEnergyUpdateInterval", TimeValue(Seconds(0.1)));
+        source->SetAttribute("LiIonEnergyLowBatteryThreshold", DoubleValue(lowFraction));
+        source->SetAttribute("SolarConstantWm2", DoubleValue(1000.0));
+        source->SetAttribute("PanelAreaM2", DoubleValue(0.01));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.2));
+        source->SetAttribute("SunlightSeconds", DoubleValue(30.0));
+        source->SetAttribute("ShadowSeconds", DoubleValue(20.0));
+        source->SetAttribute("EnableProfiling", BooleanValue(true));
+        outcome.lowJ = lowFraction * source->GetInitialEnergy();
+        source->TraceConnectWithoutContext("RemainingEnergy",
+                                           MakeBoundCallback(&RecordEnergy, &outcome));
+        source->Initialize();
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(source);
+        source->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(1.0);
+        Simulator::Schedule(Seconds(700), &SimpleDeviceEnergyModel::SetCurrentA, load, 0.3);
+        Simulator::Schedule(Seconds(1500), &SimpleDeviceEnergyModel::SetCurrentA, load, 1.0);
+
+        Simulator::Schedule(Seconds(2400), &Finish, &outcome, source);
+        Simulator::Stop(Seconds(2401));
+        Simulator::Run();
+        source->Dispose();
+        load->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * Adaptive test: 10 W harvested in the sunlight of three 600 s / 300 s
+ * LEO cycles, under a load of 4.2 A over the first cycle and 0.5 A
+ * after it, so that the cell refills to the MaxEnergyJ clamp late in the
+ * third. Against the FixedInterval baseline at 1 s, Adaptive must harvest
+ * the same energy and end in the same state (to within the load over one
+ * interval, by which the cell on the clamp dips between updates in
+ * both) with an order of magnitude fewer harvest updates, and report the
+ * same HarvestedPower levels.
+ */
+class CompositeEnergySourceAdaptiveTest : public TestCase
+{
+  public:
+    CompositeEnergySourceAdaptiveTest()
+        : TestCase("CompositeEnergySource Adaptive scheduling follows the rate of change")
+    {
+    }
+
+    void DoRun() override
+    {
+        Outcome stepped = Run(CompositeEnergySource::FIXED_INTERVAL);
+        Outcome adaptive = Run(CompositeEnergySource::ADAPTIVE);
+        NS_TEST_ASSERT_MSG_GT(stepped.clampedS, 10.0, "the clamp is reached");
+        NS_TEST_ASSERT_MSG_EQ_TOL(adaptive.harvestedJ,
+                                  stepped.harvestedJ,
+                                  1.0,
+                                  "harvested energy");
+        NS_TEST_ASSERT_MSG_EQ_TOL(adaptive.remainingJ,
+                                  stepped.remainingJ,
+                                  1.0,
+                                  "remaining energy");
+        NS_TEST_ASSERT_MSG_EQ_TOL(adaptive.voltageV, stepped.voltageV, 1e-4, "supply voltage");
+        NS_TEST_ASSERT_MSG_EQ_TOL(adaptive.clampedS,
+                                  stepped.clampedS,
+                                  1.0,
+                                  "time spent on the clamp");
+        NS_TEST_ASSERT_MSG_LT(adaptive.updates * 10, stepped.updates, "far fewer harvest updates");
+        NS_TEST_ASSERT_MSG_EQ(adaptive.levels.size(), 2, "harvesting on and off only");
+        NS_TEST_ASSERT_MSG_EQ((adaptive.levels == stepped.levels), true, "same power levels");
+    }
+
+  private:
+    struct Outcome
+    {
+        double remainingJ;
+        double voltageV;
+        double harvestedJ;
+        uint64_t updates;
+        double clampedS;         //!< Time spent on the clamp in sunlight
+        std::set<double> levels; //!< HarvestedPower values reported
+    };
+
+    static void RecordPower(Outcome* outcome, double, double powerW)
+    {
+        outcome->levels.insert(powerW);
+    }
+
+    static void Finish(Outcome* outcome, Ptr<CompositeEnergySource> source)
+    {
+        outcome->remainingJ = source->GetRemainingEnergy();
+        outcome->voltageV = source->GetSupplyVoltage();
+        outcome->harvestedJ = source->GetTotalHarvestedEnergy();
+        outcome->updates =
+            source->GetProfile()->GetCalls(HotPathProfile::UPDATE_HARVEST_CURRENT);
+        // 10 W over 1800 s of sunlight, less what the clamp held off
+        outcome->clampedS = 1800.0 - outcome->harvestedJ / 10.0;
+    }
+
+    static Outcome Run(CompositeEnergySource::HarvestSchedulingMode mode)
+    {
+        Outcome outcome{0.0, 0.0, 0.0, 0, 0.0, {}};
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("HarvestScheduling", EnumValue(mode));
+        source->SetAttribute("SolarConstantWm2", DoubleValue(1000.0));
+        source->SetAttribute("PanelAreaM2", DoubleValue(0.05));
+        source->SetAttribute("PanelEfficiency", DoubleValue(0.2));
+        source->SetAttribute("SunlightSeconds", DoubleValue(600.0));
+        source->SetAttribute("ShadowSeconds", DoubleValue(300.0));
+        source->SetAttribute("EnableProfiling", BooleanValue(true));
+        source->TraceConnectWithoutContext("HarvestedPower",
+                                           MakeBoundCallback(&RecordPower, &outcome));
+        source->Initialize();
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(source);
+        source->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(4.2);
+        Simulator::Schedule(Seconds(900), &SimpleDeviceEnergyModel::SetCurrentA, load, 0.5);
+
+        Simulator::Schedule(Seconds(2700), &Finish, &outcome, source);
+        Simulator::Stop(Seconds(2701));
+        Simulator::Run();
+        source->Dispose();
+        load->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
+/**
+ * CC-CV taper test. The tables must follow their closed form and end at
+ * the termination current. A 10 mOhm cell drained at 2 A for 600 s is
+ * then charged at 20 W against a 0.2 A load, with MaxChargeVoltageV =
+ * 3.95 V.
+ * Under the hard clamp the harvest is switched back on at every update
+ * and cut off again at the ceiling, so HarvestedPower reports the full
+ * 20 W while a trickle gets through. With the NMC taper the harvest must
+ * fall off smoothly instead, as reported, fill the cell further, and
+ * settle where the taper current meets the load.
+ */
+class CompositeEnergySourceChargeTaperTest : public TestCase
+{
+  public:
+    CompositeEnergySourceChargeTaperTest()
+        : TestCase("CompositeEnergySource ChargeTaper replaces the hard voltage clamp")
+    {
+    }
+
+    void DoRun() override
+    {
+        const struct
+        {
+            ChargeTaperTable::Chemistry chemistry;
+            double termination;
+            double shape;
+        } chemistries[] = {
+            {ChargeTaperTable::NMC, 0.05, 1.0},
+            {ChargeTaperTable::LFP, 0.05, 0.5},
+            {ChargeTaperTable::LCO, 0.10, 1.5},
+        };
+        for (const auto& c : chemistries)
+        {
+            const ChargeTaperTable& table = ChargeTaperTable::Get(c.chemistry);
+            NS_TEST_ASSERT_MSG_EQ_TOL(table.GetCurrentFraction(0.0), 1.0, 1e-12, "onset");
+            NS_TEST_ASSERT_MSG_EQ_TOL(table.GetCurrentFraction(1.0),
+                                      c.termination,
+                                      1e-12,
+                                      "termination");
+            NS_TEST_ASSERT_MSG_EQ(table.GetTerminationFraction(), c.termination, "termination");
+            for (int i = 1; i < 100; ++i)
+            {
+                double p = (i + 0.5) / 100.0;
+                double exact = std::pow(c.termination, std::pow(p, c.shape));
+                NS_TEST_ASSERT_MSG_EQ_TOL(table.GetCurrentFraction(p),
+                                          exact,
+                                          1e-3,
+                                          "interpolated taper");
+            }
+        }
+
+        Outcome clamp = Run(CompositeEnergySource::HARD_CLAMP);
+        Outcome taper = Run(CompositeEnergySource::TAPER_NMC);
+        NS_TEST_ASSERT_MSG_GT(clamp.reportedW, 10.0 * clamp.meanW, "the hard clamp misreports");
+        NS_TEST_ASSERT_MSG_EQ(taper.stops, 0, "the taper does not stop harvesting");
+        // Still closing in on the load as the cell fills
+        NS_TEST_ASSERT_MSG_EQ_TOL(taper.reportedW,
+                                  taper.meanW,
+                                  0.05 * taper.meanW,
+                                  "the taper reports the harvested power");
+        NS_TEST_ASSERT_MSG_EQ_TOL(taper.reportedW,
+                                  0.2 * taper.voltageV,
+                                  0.05 * 0.2 * taper.voltageV,
+                                  "taper current settles at the load");
+        NS_TEST_ASSERT_MSG_GT(taper.voltageV, clamp.voltageV, "the taper fills the cell further");
+    }
+
+  private:
+    struct Outcome
+    {
+        double voltageV;
+        double meanW;     //!< Harvested power over [3999, 4999) s
+        uint32_t stops;   //!< Times HarvestedPower fell to zero
+        double reportedW; //!< Last HarvestedPower reported
+    };
+
+    static void RecordPower(Outcome* outcome, double, double powerW)
+    {
+        if (powerW == 0.0 && outcome->reportedW != 0.0)
+        {
+            ++outcome->stops;
+        }
+        outcome->reportedW = powerW;
+    }
+
+    static void Start(Outcome* outcome, Ptr<CompositeEnergySource> source)
+    {
+        source->GetRemainingEnergy();
+        outcome->meanW = -source->GetTotalHarvestedEnergy();
+    }
+
+    static void Finish(Outcome* outcome, Ptr<CompositeEnergySource> source)
+    {
+        outcome->voltageV = source->GetSupplyVoltage();
+        source->GetRemainingEnergy();
+        outcome->meanW = (outcome->meanW + source->GetTotalHarvestedEnergy()) / 1000.0;
+    }
+
+    static Outcome Run(CompositeEnergySource::ChargeTaperMode taper)
+    {
+        Outcome outcome{0.0, 0.0, 0, 0.0};
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("MaxEnergyJ", DoubleValue(40000.0));
+        source->SetAttribute("UseLeoCycle", BooleanValue(false));
+        source->SetAttribute("InternalResistance", DoubleValue(0.01));
+        source->SetAttribute("MaxChargeVoltageV", DoubleValue(3.95));
+        source->SetAttribute("ChargeTaper", EnumValue(taper));
+        source->AddSolarPanelWindow(20.0, 600.0, 5000.0);
+        source->TraceConnectWithoutContext("HarvestedPower",
+                                           MakeBoundCallback(&RecordPower, &outcome));
+        source->Initialize();
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(source);
+        source->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(2.0);
+        Simulator::Schedule(Seconds(600), &SimpleDeviceEnergyModel::SetCurrentA, load, 0.2);
+
+        Simulator::Schedule(Seconds(3999), &Start, &outcome, source);
+        Simulator::Schedule(Seconds(4999), &Finish, &outcome, source);
+        Simulator::Stop(Seconds(5000));
+        Simulator::Run();
+        source->Dispose();
+        load->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+};
+
 class CompositeEnergySourceTestSuite : public TestSuite
 {
   public:
@@ -247,6 +1590,18 @@ class CompositeEnergySourceTestSuite : public TestSuite
         AddTestCase(new CompositeEnergySourceIrradianceModelTest, TestCase::Duration::QUICK);
         AddTestCase(new CompositeEnergySourceChargeEfficiencyTest, TestCase::Duration::QUICK);
         AddTestCase(new CompositeEnergySourceVoltageClampTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceEventDrivenTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceEventDrivenClampTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceEventDrivenTraceTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceExactIntegrationTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceProfilingTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceEstimatedStateTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceLookaheadTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceHarvestedPowerBinTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceCheckpointTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceFastForwardTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceAdaptiveTest, TestCase::Duration::QUICK);
+        AddTestCase(new CompositeEnergySourceChargeTaperTest, TestCase::Duration::QUICK);
     }
 };
 
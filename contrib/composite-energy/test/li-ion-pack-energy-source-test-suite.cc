@@ -0,0 +1,242 @@
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/li-ion-pack-energy-source.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-device-energy-model.h"
+#include "ns3/simulator.h"
+#include "ns3/solar-irradiance-model.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Current split test: a 4S2P pack whose cell 0 has twice the resistance
+ * of the others carries a 2 A load for 600 s. In every group the cell
+ * currents must add up to the load. The stronger cell of group 0 must
+ * carry twice the current of its weaker neighbour at the start, then less
+ * as it drains faster; the charge drawn from each group must be the
+ * load's, and the remaining energy must account for it.
+ */
+class LiIonPackEnergySourceCurrentSplitTest : public TestCase
+{
+  public:
+    LiIonPackEnergySourceCurrentSplitTest()
+        : TestCase("LiIonPackEnergySource splits the group current by conductance")
+    {
+    }
+
+    void DoRun() override
+    {
+        Ptr<LiIonPackEnergySource> pack = CreateObject<LiIonPackEnergySource>();
+        pack->SetCellState(0, 1.0, 2.45, 0.1);
+        pack->Initialize();
+        NS_TEST_ASSERT_MSG_EQ(pack->GetNCells(), 8, "4S2P cell count");
+        NS_TEST_ASSERT_MSG_EQ_TOL(pack->GetSupplyVoltage(), 4 * 4.05, 1e-9, "full pack voltage");
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(pack);
+        pack->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(2.0);
+        Simulator::Schedule(Seconds(1), &LiIonPackEnergySourceCurrentSplitTest::Probe, this, pack);
+        Simulator::Stop(Seconds(600.5));
+        Simulator::Run();
+
+        NS_TEST_ASSERT_MSG_EQ_TOL(m_firstA[0], 2.0 / 3, 5e-3, "weaker cell share");
+        NS_TEST_ASSERT_MSG_EQ_TOL(m_firstA[1], 4.0 / 3, 5e-3, "stronger cell share");
+
+        double drawnAh = 2.0 * 600 / 3600;
+        double packV = 0.0;
+        double chargeAh = 0.0;
+        for (uint32_t s = 0; s < 4; ++s)
+        {
+            LiIonPackEnergySource::CellState a = pack->GetCellState(2 * s);
+            LiIonPackEnergySource::CellState b = pack->GetCellState(2 * s + 1);
+            NS_TEST_ASSERT_MSG_EQ_TOL(a.currentA + b.currentA, 2.0, 1e-9, "group current");
+            NS_TEST_ASSERT_MSG_EQ_TOL((2 - a.soc - b.soc) * 2.45, drawnAh, 1e-9, "group charge");
+            packV += a.voltageV;
+            chargeAh += (a.soc + b.soc) * 2.45;
+        }
+        NS_TEST_ASSERT_MSG_EQ_TOL(pack->GetSupplyVoltage(), packV, 1e-9, "pack voltage");
+        NS_TEST_ASSERT_MSG_EQ_TOL(pack->GetRemainingEnergy(),
+                                  chargeAh * 3600 * 3.6,
+                                  1e-6,
+                                  "remaining energy");
+
+        LiIonPackEnergySource::CellState weak = pack->GetCellState(0);
+        LiIonPackEnergySource::CellState strong = pack->GetCellState(1);
+        NS_TEST_ASSERT_MSG_GT(weak.soc, strong.soc, "the weaker cell drains slower");
+        NS_TEST_ASSERT_MSG_GT(weak.temperatureC, 25.0, "cells heat under load");
+        NS_TEST_ASSERT_MSG_GT(weak.currentA, m_firstA[0], "the fuller cell takes more load");
+        // At most 4/3 A through 50 mOhm and 5 K/W.
+        NS_TEST_ASSERT_MSG_LT(strong.temperatureC, 25.0 + 0.09 * 5.0, "bounded by steady state");
+
+        load->Dispose();
+        pack->Dispose();
+        Simulator::Destroy();
+    }
+
+  private:
+    void Probe(Ptr<LiIonPackEnergySource> pack)
+    {
+        pack->UpdateEnergySource();
+        m_firstA = {pack->GetCellState(0).currentA, pack->GetCellState(1).currentA};
+    }
+
+    std::vector<double> m_firstA;
+};
+
+/**
+ * Harvest test: a 2S1P pack of a small, nearly full cell and a large,
+ * half-empty one is charged by a constant 10 W panel. Harvesting must
+ * stop exactly when the small cell is full, having put the same charge
+ * into both cells, and must stay stopped.
+ */
+class LiIonPackEnergySourceHarvestTest : public TestCase
+{
+  public:
+    LiIonPackEnergySourceHarvestTest()
+        : TestCase("LiIonPackEnergySource harvests until the first cell is full")
+    {
+    }
+
+    void DoRun() override
+    {
+        Ptr<ConstantSolarIrradianceModel> sun = CreateObject<ConstantSolarIrradianceModel>();
+        sun->SetAttribute("PowerDensityWm2", DoubleValue(100.0));
+        Ptr<LiIonPackEnergySource> pack = CreateObject<LiIonPackEnergySource>();
+        pack->SetAttribute("SeriesCells", UintegerValue(2));
+        pack->SetAttribute("ParallelCells", UintegerValue(1));
+        pack->SetAttribute("IrradianceModel", PointerValue(sun));
+        pack->SetAttribute("PanelAreaM2", DoubleValue(0.1));
+        pack->SetAttribute("PanelEfficiency", DoubleValue(1.0));
+        pack->SetCellState(0, 0.9, 1.0, 0.05);
+        pack->SetCellState(1, 0.5, 2.45, 0.05);
+        pack->Initialize();
+
+        Simulator::Schedule(Seconds(1000), &LiIonPackEnergySourceHarvestTest::Probe, this, pack);
+        Simulator::Stop(Seconds(2000.5));
+        Simulator::Run();
+
+        LiIonPackEnergySource::CellState small = pack->GetCellState(0);
+        LiIonPackEnergySource::CellState large = pack->GetCellState(1);
+        NS_TEST_ASSERT_MSG_EQ_TOL(small.soc, 1.0, 1e-9, "small cell full");
+        NS_TEST_ASSERT_MSG_EQ_TOL(large.soc, 0.5 + 0.1 / 2.45, 1e-9, "same charge in series");
+        NS_TEST_ASSERT_MSG_GT(m_harvestedJ, 0.0, "harvested");
+        NS_TEST_ASSERT_MSG_EQ_TOL(pack->GetTotalHarvestedEnergy(),
+                                  m_harvestedJ,
+                                  1e-9,
+                                  "harvesting stays stopped");
+        // About 0.1 Ah at 7.6 to 8 V, cut off after 270 to 290 s of 10 W.
+        NS_TEST_ASSERT_MSG_GT(m_harvestedJ, 2700.0, "harvested energy");
+        NS_TEST_ASSERT_MSG_LT(m_harvestedJ, 2900.0, "harvested energy");
+
+        pack->Dispose();
+        Simulator::Destroy();
+    }
+
+  private:
+    void Probe(Ptr<LiIonPackEnergySource> pack)
+    {
+        m_harvestedJ = pack->GetTotalHarvestedEnergy();
+    }
+
+    double m_harvestedJ{0.0};
+};
+
+/**
+ * Balancing test: an idle 4S1P pack with one cell 0.1 above the others
+ * is run for four hours under each policy. Without balancing the spread
+ * must stay; both policies must bring it within BalanceThreshold, passive
+ * balancing losing all the charge it bleeds and active balancing only
+ * the share BalanceEfficiency does not deliver.
+ */
+class LiIonPackEnergySourceBalancingTest : public TestCase
+{
+  public:
+    LiIonPackEnergySourceBalancingTest()
+        : TestCase("LiIonPackEnergySource balancing policies")
+    {
+    }
+
+    void DoRun() override
+    {
+        double initialJ = (0.9 + 3 * 0.8) * 2.45 * 3600 * 3.6;
+
+        Outcome none = Run(LiIonPackEnergySource::NO_BALANCING);
+        NS_TEST_ASSERT_MSG_EQ_TOL(none.spread, 0.1, 1e-12, "unbalanced spread");
+        NS_TEST_ASSERT_MSG_EQ(none.balancedAh, 0.0, "nothing balanced");
+        NS_TEST_ASSERT_MSG_EQ_TOL(none.remainingJ, initialJ, 1e-6, "idle pack keeps its energy");
+
+        Outcome passive = Run(LiIonPackEnergySource::PASSIVE);
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(passive.spread, 0.01 + 1e-12, "passive spread");
+        NS_TEST_ASSERT_MSG_GT(passive.balancedAh, 0.0, "passive bled");
+        NS_TEST_ASSERT_MSG_EQ_TOL(initialJ - passive.remainingJ,
+                                  passive.balancedAh * 3600 * 3.6,
+                                  1e-6,
+                                  "passive loses the bled charge");
+
+        Outcome active = Run(LiIonPackEnergySource::ACTIVE);
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(active.spread, 0.01 + 1e-12, "active spread");
+        NS_TEST_ASSERT_MSG_GT(active.balancedAh, 0.0, "active moved");
+        NS_TEST_ASSERT_MSG_EQ_TOL(initialJ - active.remainingJ,
+                                  (1 - 0.9) * active.balancedAh * 3600 * 3.6,
+                                  1e-6,
+                                  "active loses the undelivered share");
+        NS_TEST_ASSERT_MSG_GT(active.remainingJ, passive.remainingJ, "active keeps more");
+    }
+
+  private:
+    /** State of the pack at the end of a run. */
+    struct Outcome
+    {
+        double spread;
+        double balancedAh;
+        double remainingJ;
+    };
+
+    Outcome Run(LiIonPackEnergySource::BalancingPolicy policy)
+    {
+        Ptr<LiIonPackEnergySource> pack = CreateObject<LiIonPackEnergySource>();
+        pack->SetAttribute("ParallelCells", UintegerValue(1));
+        pack->SetAttribute("InitialSoc", DoubleValue(0.8));
+        pack->SetAttribute("Balancing", EnumValue(policy));
+        pack->SetCellState(0, 0.9, 2.45, 0.05);
+        pack->Initialize();
+
+        Outcome outcome;
+        Simulator::Schedule(Seconds(4 * 3600),
+                            &LiIonPackEnergySourceBalancingTest::Probe,
+                            pack,
+                            &outcome);
+        Simulator::Stop(Seconds(4 * 3600 + 0.5));
+        Simulator::Run();
+
+        pack->Dispose();
+        Simulator::Destroy();
+        return outcome;
+    }
+
+    static void Probe(Ptr<LiIonPackEnergySource> pack, Outcome* outcome)
+    {
+        outcome->remainingJ = pack->GetRemainingEnergy();
+        outcome->spread = pack->GetSocSpread();
+        outcome->balancedAh = pack->GetBalancedCharge();
+    }
+};
+
+class LiIonPackEnergySourceTestSuite : public TestSuite
+{
+  public:
+    LiIonPackEnergySourceTestSuite()
+        : TestSuite("li-ion-pack-energy-source", Type::UNIT)
+    {
+        AddTestCase(new LiIonPackEnergySourceCurrentSplitTest, TestCase::Duration::QUICK);
+        AddTestCase(new LiIonPackEnergySourceHarvestTest, TestCase::Duration::QUICK);
+        AddTestCase(new LiIonPackEnergySourceBalancingTest, TestCase::Duration::QUICK);
+    }
+};
+
+static LiIonPackEnergySourceTestSuite g_liIonPackEnergySourceTestSuite;
@@ -0,0 +1,1053 @@
+#include "ns3/async-solar-irradiance-model.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/nstime.h"
+#include "ns3/invocable-solar-irradiance-model.h"
+#include "ns3/irradiance-trace.h"
+#include "ns3/lookahead-solar-irradiance-model.h"
+#include "ns3/mobility-module.h"
+#include "ns3/orbital-eclipse-solar-irradiance-model.h"
+#include "ns3/panel-attitude-solar-irradiance-model.h"
+#include "ns3/solar-irradiance-model.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/trace-solar-irradiance-model.h"
+#include "ns3/uinteger.h"
+#include "ns3/window-solar-irradiance-model.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using namespace ns3;
+
+/**
+ * Segment API of the analytic models: a constant model never changes, a
+ * LEO cycle reports its sunlight/shadow boundaries and eclipse times
+ * exactly (including a phase offset) and its cached cycle survives jumps
+ * in either direction, and a callback model reports nothing unless told
+ * how long its output is held.
+ */
+class SolarIrradianceSegmentAnalyticTest : public TestCase
+{
+  public:
+    SolarIrradianceSegmentAnalyticTest()
+        : TestCase("Constant, LEO and callback irradiance segments")
+    {
+    }
+
+    void DoRun() override
+    {
+        Ptr<ConstantSolarIrradianceModel> constant =
+            CreateObject<ConstantSolarIrradianceModel>();
+        constant->SetAttribute("PowerDensityWm2", DoubleValue(800.0));
+        SolarIrradianceSegment seg = constant->GetSegment(Seconds(12.0));
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Time::Max(), "constant model never changes");
+        NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 800.0, "constant value");
+
+        // 10 s sunlight / 5 s shadow, started 3 s into the cycle.
+        Ptr<LeoCycleSolarIrradianceModel> leo = CreateObject<LeoCycleSolarIrradianceModel>();
+        leo->SetAttribute("PeakWm2", DoubleValue(1000.0));
+        leo->SetAttribute("SunlightSeconds", DoubleValue(10.0));
+        leo->SetAttribute("ShadowSeconds", DoubleValue(5.0));
+        leo->SetAttribute("PhaseSeconds", DoubleValue(3.0));
+        seg = leo->GetSegment(Seconds(2.0));
+        NS_TEST_ASSERT_MSG_EQ(seg.start, Seconds(-3.0), "sunlight start");
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(7.0), "sunlight end");
+        NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 1000.0, "sunlight value");
+        NS_TEST_ASSERT_MSG_EQ(leo->GetNextChangeTime(Seconds(7.0)), Seconds(12.0), "shadow end");
+        NS_TEST_ASSERT_MSG_EQ(leo->GetPowerDensityWm2(Seconds(7.0)), 0.0, "shadow at boundary");
+        NS_TEST_ASSERT_MSG_EQ(leo->GetPowerDensityWm2(Seconds(12.0)),
+                              1000.0,
+                              "sunlight at boundary");
+        NS_TEST_ASSERT_MSG_EQ(leo->GetNextEclipseEntry(Seconds(2.0)), Seconds(7.0), "entry");
+        NS_TEST_ASSERT_MSG_EQ(leo->GetNextEclipseExit(Seconds(2.0)), Seconds(12.0), "exit");
+        NS_TEST_ASSERT_MSG_EQ(leo->GetNextEclipseEntry(Seconds(7.0)),
+                              Seconds(22.0),
+                              "next entry once in shadow");
+        NS_TEST_ASSERT_MSG_EQ(leo->IsInSunlight(Seconds(11.5)), false, "in shadow");
+
+        // The cached cycle must agree with the phase computed afresh, for
+        // steps within a cycle, into the next one, and jumps both ways.
+        const int64_t steps[] = {1, 7, 999, 15000, 40000, -3, -31000, 2};
+        Time t = Seconds(-40.0);
+        for (int i = 0; i < 400; ++i)
+        {
+            t += MilliSeconds(steps[i % 8]);
+            int64_t phase = (t.GetMilliSeconds() + 3000) % 15000;
+            phase += (phase < 0) ? 15000 : 0;
+            NS_TEST_ASSERT_MSG_EQ(leo->GetPowerDensityWm2(t),
+                                  phase < 10000 ? 1000.0 : 0.0,
+                                  "cached phase differs from a direct computation");
+        }
+        leo->SetAttribute("ShadowSeconds", DoubleValue(20.0));
+        NS_TEST_ASSERT_MSG_EQ(leo->GetNextEclipseExit(Seconds(2.0)),
+                              Seconds(27.0),
+                              "attribute change invalidates the cached cycle");
+        leo->SetAttribute("ShadowSeconds", DoubleValue(0.0));
+        NS_TEST_ASSERT_MSG_EQ(leo->GetNextEclipseEntry(Seconds(2.0)),
+                              Time::Max(),
+                              "no eclipse without shadow");
+
+        Ptr<CallbackSolarIrradianceModel> callback =
+            CreateObject<CallbackSolarIrradianceModel>();
+        callback->SetCallback(MakeCallback(&Ramp));
+        seg = callback->GetSegment(Seconds(2.5));
+        NS_TEST_ASSERT_MSG_EQ(seg.IsKnown(), false, "opaque callback must be polled");
+        NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 250.0, "callback value");
+        callback->SetAttribute("HoldSeconds", DoubleValue(2.0));
+        NS_TEST_ASSERT_MSG_EQ(callback->GetNextChangeTime(Seconds(2.5)),
+                              Seconds(4.0),
+                              "held callback changes at the next multiple of HoldSeconds");
+    }
+
+  private:
+    static double Ramp(Time t)
+    {
+        return 100.0 * t.GetSeconds();
+    }
+};
+
+/**
+ * SampledSolarIrradianceModel: sample-and-hold segments merge runs of
+ * equal values, equal-time samples encode a step, and linear
+ * interpolation reports ramps whose integral is exact.
+ */
+class SolarIrradianceSegmentSampledTest : public TestCase
+{
+  public:
+    SolarIrradianceSegmentSampledTest()
+        : TestCase("Sampled irradiance segments")
+    {
+    }
+
+    void DoRun() override
+    {
+        Ptr<SampledSolarIrradianceModel> model = CreateObject<SampledSolarIrradianceModel>();
+        NS_TEST_ASSERT_MSG_EQ(model->GetNextChangeTime(Seconds(1.0)),
+                              Time::Max(),
+                              "empty trace never changes");
+        model->AddSample(Seconds(10.0), 500.0);
+        model->AddSample(Seconds(20.0), 500.0);
+        model->AddSample(Seconds(30.0), 0.0);
+        model->AddSample(Seconds(40.0), 0.0);
+        model->AddSample(Seconds(40.0), 1000.0);
+        model->AddSample(Seconds(50.0), 1000.0);
+
+        NS_TEST_ASSERT_MSG_EQ(model->GetPowerDensityWm2(Seconds(5.0)), 500.0, "before first");
+        NS_TEST_ASSERT_MSG_EQ(model->GetNextChangeTime(Seconds(5.0)),
+                              Seconds(30.0),
+                              "run of equal values is one segment");
+        NS_TEST_ASSERT_MSG_EQ(model->GetNextChangeTime(Seconds(30.0)), Seconds(40.0), "zeros");
+        NS_TEST_ASSERT_MSG_EQ(model->GetPowerDensityWm2(Seconds(40.0)), 1000.0, "step");
+        NS_TEST_ASSERT_MSG_EQ(model->GetNextChangeTime(Seconds(40.0)),
+                              Time::Max(),
+                              "last value is held forever");
+
+        model->SetAttribute("Interpolation", EnumValue(SampledSolarIrradianceModel::LINEAR));
+        NS_TEST_ASSERT_MSG_EQ(model->GetNextChangeTime(Seconds(5.0)),
+                              Seconds(20.0),
+                              "flat until the ramp starts");
+        SolarIrradianceSegment seg = model->GetSegment(Seconds(25.0));
+        NS_TEST_ASSERT_MSG_EQ(seg.start, Seconds(20.0), "ramp start");
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(30.0), "ramp end");
+        NS_TEST_ASSERT_MSG_EQ_TOL(seg.slopeWm2PerS, -50.0, 1e-12, "ramp slope");
+        NS_TEST_ASSERT_MSG_EQ_TOL(model->GetPowerDensityWm2(Seconds(25.0)),
+                                  250.0,
+                                  1e-9,
+                                  "interpolated value");
+        NS_TEST_ASSERT_MSG_EQ_TOL(seg.Integrate(Seconds(20.0), Seconds(30.0)),
+                                  2500.0,
+                                  1e-9,
+                                  "ramp integral");
+        NS_TEST_ASSERT_MSG_EQ(model->GetNextChangeTime(Seconds(32.0)),
+                              Seconds(40.0),
+                              "flat zeros before the step");
+    }
+};
+
+/**
+ * TraceSolarIrradianceModel: a two-column trace spanning several blocks
+ * is written with IrradianceTraceWriter and read back through two models
+ * that must share one mapping. Forward and backward lookups, the step
+ * encoded by equal-time rows and run merging across block boundaries
+ * are checked.
+ */
+class SolarIrradianceTraceModelTest : public TestCase
+{
+  public:
+    SolarIrradianceTraceModelTest()
+        : TestCase("Memory-mapped binary irradiance trace")
+    {
+    }
+
+    void DoRun() override
+    {
+        std::string path = CreateTempDirFilename("irradiance-trace-test.bin");
+        {
+            // Column 0: 0 W/m^2 until 4 s, 1000 from 4 s (step), 250 from 7 s.
+            // Column 1: a 100 W/m^2 per second ramp.
+            IrradianceTraceWriter writer(path, 2, 3);
+            for (int s = 0; s <= 9; ++s)
+            {
+                double col0 = s < 4 ? 0.0 : (s < 7 ? 1000.0 : 250.0);
+                if (s == 4)
+                {
+                    writer.AddRow(Seconds(s), {0.0, 100.0 * s});
+                }
+                writer.AddRow(Seconds(s), {col0, 100.0 * s});
+            }
+            NS_TEST_ASSERT_MSG_EQ(writer.GetNRows(), 11, "rows written");
+        }
+
+        Ptr<TraceSolarIrradianceModel> sat0 = CreateObject<TraceSolarIrradianceModel>();
+        sat0->SetAttribute("FileName", StringValue(path));
+        Ptr<TraceSolarIrradianceModel> sat1 = CreateObject<TraceSolarIrradianceModel>();
+        sat1->SetAttribute("Column", UintegerValue(1));
+        sat1->SetAttribute("FileName", StringValue(path));
+        sat1->SetAttribute("Interpolation", EnumValue(SampledSolarIrradianceModel::LINEAR));
+
+        NS_TEST_ASSERT_MSG_EQ((sat0->GetTrace() == sat1->GetTrace()),
+                              true,
+                              "models reading one file must share its mapping");
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetTrace()->GetHeader().blockCount, 4, "block count");
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetNSamples(), 11, "row count");
+
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetNextChangeTime(Seconds(0.5)),
+                              Seconds(4.0),
+                              "zeros merged across blocks");
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetPowerDensityWm2(Seconds(4.0)), 1000.0, "step at 4 s");
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetNextChangeTime(Seconds(4.0)), Seconds(7.0), "plateau");
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetPowerDensityWm2(Seconds(8.5)), 250.0, "last plateau");
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetPowerDensityWm2(Seconds(2.0)), 0.0, "backward lookup");
+        NS_TEST_ASSERT_MSG_EQ(sat0->GetNextChangeTime(Seconds(9.0)),
+                              Time::Max(),
+                              "held after the last row");
+
+        for (double t = 0.0; t < 9.0; t += 0.25)
+        {
+            NS_TEST_ASSERT_MSG_EQ_TOL(sat1->GetPowerDensityWm2(Seconds(t)),
+                                      100.0 * t,
+                                      1e-9,
+                                      "interpolated ramp");
+        }
+        NS_TEST_ASSERT_MSG_EQ_TOL(sat1->GetSegment(Seconds(5.5)).slopeWm2PerS,
+                                  100.0,
+                                  1e-9,
+                                  "ramp slope");
+
+        sat0->Dispose();
+        sat1->Dispose();
+        std::remove(path.c_str());
+    }
+};
+
+/**
+ * CSV conversion and streaming: a CSV with a header row, comments and
+ * mixed separators is converted with IrradianceTraceWriter::ConvertCsv
+ * and read back through both StreamingTraceSolarIrradianceModel and the
+ * mapped TraceSolarIrradianceModel, which must agree. A forward sweep by
+ * two satellites sharing the stream must read every block exactly once.
+ */
+class SolarIrradianceStreamingTraceTest : public TestCase
+{
+  public:
+    SolarIrradianceStreamingTraceTest()
+        : TestCase("CSV conversion and streaming irradiance trace")
+    {
+    }
+
+    void DoRun() override
+    {
+        std::string csvPath = CreateTempDirFilename("irradiance-trace-test.csv");
+        std::string binPath = CreateTempDirFilename("irradiance-trace-stream-test.bin");
+        {
+            std::ofstream csv(csvPath);
+            csv << "# two satellites, 1 row per minute\n";
+            csv << "time_min,sat0,sat1\n";
+            for (int m = 0; m < 50; ++m)
+            {
+                csv << m << (m % 2 ? ", " : ";") << (m % 7) * 100.0 << " " << 25.0 * m << "\n";
+            }
+        }
+        uint64_t rows = IrradianceTraceWriter::ConvertCsv(csvPath, binPath, 8, 60.0);
+        NS_TEST_ASSERT_MSG_EQ(rows, 50, "converted rows");
+
+        Ptr<StreamingTraceSolarIrradianceModel> stream0 =
+            CreateObject<StreamingTraceSolarIrradianceModel>();
+        stream0->SetAttribute("FileName", StringValue(binPath));
+        Ptr<StreamingTraceSolarIrradianceModel> stream1 =
+            CreateObject<StreamingTraceSolarIrradianceModel>();
+        stream1->SetAttribute("FileName", StringValue(binPath));
+        stream1->SetAttribute("Column", UintegerValue(1));
+        stream1->SetAttribute("Interpolation", EnumValue(SampledSolarIrradianceModel::LINEAR));
+        Ptr<TraceSolarIrradianceModel> mapped1 = CreateObject<TraceSolarIrradianceModel>();
+        mapped1->SetAttribute("FileName", StringValue(binPath));
+        mapped1->SetAttribute("Column", UintegerValue(1));
+        mapped1->SetAttribute("Interpolation", EnumValue(SampledSolarIrradianceModel::LINEAR));
+        Ptr<const IrradianceTraceStream> trace = stream0->GetTrace();
+        NS_TEST_ASSERT_MSG_EQ((trace == stream1->GetTrace()), true, "stream must be shared");
+        NS_TEST_ASSERT_MSG_EQ(trace->GetNBlockReads(), 0, "nothing read before the first query");
+
+        for (int s = 0; s < 50 * 60; s += 7)
+        {
+            Time t = Seconds(s);
+            NS_TEST_ASSERT_MSG_EQ(stream0->GetPowerDensityWm2(t),
+                                  ((s / 60) % 7) * 100.0,
+                                  "streamed hold value");
+            NS_TEST_ASSERT_MSG_EQ_TOL(stream1->GetPowerDensityWm2(t),
+                                      mapped1->GetPowerDensityWm2(t),
+                                      1e-9,
+                                      "streamed and mapped traces differ");
+        }
+        NS_TEST_ASSERT_MSG_EQ(trace->GetNBlockReads(),
+                              trace->GetHeader().blockCount,
+                              "a forward sweep reads each block once");
+
+        // A jump back is resolved through the block index.
+        uint64_t reads = trace->GetNBlockReads();
+        NS_TEST_ASSERT_MSG_EQ(stream0->GetPowerDensityWm2(Minutes(3)), 300.0, "backward jump");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(trace->GetNBlockReads(), reads + 1, "one block per jump");
+
+        stream0->Dispose();
+        stream1->Dispose();
+        mapped1->Dispose();
+        std::remove(csvPath.c_str());
+        std::remove(binPath.c_str());
+    }
+};
+
+/**
+ * Long flat runs: a streamed trace that sits at zero across many small
+ * blocks is swept sample by sample. Every query inside the run must end
+ * at the first non-zero sample, and the sweep must still read each block
+ * once rather than walking the rest of the run on every query.
+ */
+class SolarIrradianceFlatRunTest : public TestCase
+{
+  public:
+    SolarIrradianceFlatRunTest()
+        : TestCase("Long flat run in a streamed irradiance trace")
+    {
+    }
+
+    void DoRun() override
+    {
+        std::string path = CreateTempDirFilename("irradiance-trace-flat-test.bin");
+        {
+            IrradianceTraceWriter writer(path, 1, 4);
+            for (int m = 0; m < 200; ++m)
+            {
+                writer.AddRow(Minutes(m), {(m < 10 || m >= 190) ? 800.0 : 0.0});
+            }
+            writer.Close();
+        }
+
+        Ptr<StreamingTraceSolarIrradianceModel> model =
+            CreateObject<StreamingTraceSolarIrradianceModel>();
+        model->SetAttribute("FileName", StringValue(path));
+        Ptr<const IrradianceTraceStream> trace = model->GetTrace();
+
+        for (int m = 0; m < 200; ++m)
+        {
+            SolarIrradianceSegment seg = model->GetSegment(Minutes(m) + Seconds(30));
+            if (m >= 10 && m < 190)
+            {
+                NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 0.0, "inside the run");
+                NS_TEST_ASSERT_MSG_EQ(seg.end, Minutes(190), "run ends at the next change");
+            }
+        }
+        NS_TEST_ASSERT_MSG_EQ(trace->GetNBlockReads(),
+                              trace->GetHeader().blockCount,
+                              "a sweep through a long run reads each block once");
+
+        // Queries inside a run already walked read nothing.
+        NS_TEST_ASSERT_MSG_EQ(model->GetSegment(Minutes(100)).end, Minutes(190), "cached run");
+        uint64_t reads = trace->GetNBlockReads();
+        for (int m = 101; m < 190; ++m)
+        {
+            model->GetSegment(Minutes(m));
+        }
+        NS_TEST_ASSERT_MSG_EQ(trace->GetNBlockReads(), reads, "no reads inside the run");
+
+        // Switching interpolation is not served from the cached segment.
+        model->SetAttribute("Interpolation", EnumValue(SampledSolarIrradianceModel::LINEAR));
+        NS_TEST_ASSERT_MSG_EQ(model->GetSegment(Minutes(150)).end,
+                              Minutes(189),
+                              "the ramp starts at the last zero");
+
+        model->Dispose();
+        std::remove(path.c_str());
+    }
+};
+
+/**
+ * Window schedules: overlapping windows loaded out of order from a file
+ * add up, gaps between them are exactly zero, segments end at the next
+ * boundary where the total changes, and a window added after the first
+ * query rebuilds the index.
+ */
+class SolarIrradianceWindowModelTest : public TestCase
+{
+  public:
+    SolarIrradianceWindowModelTest()
+        : TestCase("Overlapping irradiance window schedule")
+    {
+    }
+
+    void DoRun() override
+    {
+        std::string path = CreateTempDirFilename("irradiance-windows-test.csv");
+        {
+            std::ofstream plan(path);
+            plan << "# mission plan\n";
+            plan << "power,start,end\n";
+            plan << "100,10,20\n";
+            plan << "50;15;30\n";
+            plan << "25 0 5\n";
+            plan << "\n";
+            plan << "100, 30, 40\n";
+            plan << "0.1,50,60\n";
+            plan << "0.2,55,65\n";
+        }
+        Ptr<WindowSolarIrradianceModel> windows = CreateObject<WindowSolarIrradianceModel>();
+        NS_TEST_ASSERT_MSG_EQ(windows->LoadWindows(path), 6, "windows read");
+        NS_TEST_ASSERT_MSG_EQ(windows->GetNWindows(), 6, "windows held");
+
+        // Forward sweep against the brute-force sum of the open windows.
+        for (int ms = -1000; ms < 70000; ms += 250)
+        {
+            Time t = MilliSeconds(ms);
+            double expected = 0.0;
+            for (std::size_t i = 0; i < windows->GetNWindows(); ++i)
+            {
+                const WindowSolarIrradianceModel::Window& w = windows->GetWindow(i);
+                if (w.start <= t && t < w.end)
+                {
+                    expected += w.value;
+                }
+            }
+            NS_TEST_ASSERT_MSG_EQ_TOL(windows->GetPowerDensityWm2(t),
+                                      expected,
+                                      1e-12,
+                                      "sum of the open windows");
+        }
+        NS_TEST_ASSERT_MSG_EQ(windows->GetPowerDensityWm2(Seconds(70)), 0.0, "exact zero gap");
+
+        SolarIrradianceSegment seg = windows->GetSegment(Seconds(7));
+        NS_TEST_ASSERT_MSG_EQ(seg.start, Seconds(5), "gap start");
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(10), "gap ends at the next window");
+        NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 0.0, "gap value");
+        seg = windows->GetSegment(Seconds(16));
+        NS_TEST_ASSERT_MSG_EQ(seg.start, Seconds(15), "overlap start");
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(20), "overlap end");
+        NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 150.0, "overlapping windows add up");
+        seg = windows->GetSegment(Seconds(-3));
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(0), "nothing before the first window");
+        NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 0.0, "zero before the first window");
+        seg = windows->GetSegment(Seconds(80));
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Time::Max(), "nothing after the last window");
+
+        // Filling [20, 30) up to 100 joins it with [30, 40).
+        windows->AddWindow(50.0, Seconds(20), Seconds(30));
+        seg = windows->GetSegment(Seconds(25));
+        NS_TEST_ASSERT_MSG_EQ(seg.start, Seconds(20), "rebuilt segment start");
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(40), "equal totals merge into one segment");
+        NS_TEST_ASSERT_MSG_EQ(seg.startWm2, 100.0, "rebuilt value");
+
+        windows->Dispose();
+        std::remove(path.c_str());
+    }
+};
+
+/**
+ * Orbital eclipses: at a zero beta angle the umbra lasts 2 asin(R/a) / n,
+ * solved transitions agree with the shadow condition sampled every
+ * second, segments end exactly where the value flips, and an orbit seen
+ * face-on by the Sun has no eclipse until its beta angle has drifted
+ * below asin(R/a).
+ */
+class SolarIrradianceOrbitalEclipseTest : public TestCase
+{
+  public:
+    SolarIrradianceOrbitalEclipseTest()
+        : TestCase("Orbital eclipse irradiance")
+    {
+    }
+
+    void DoRun() override
+    {
+        const double radiusKm = 6378.137;
+        const double aKm = radiusKm + 550.0;
+        Ptr<OrbitalEclipseSolarIrradianceModel> orbit =
+            CreateObject<OrbitalEclipseSolarIrradianceModel>();
+        orbit->SetAttribute("SemiMajorAxisKm", DoubleValue(aKm));
+        orbit->SetAttribute("InclinationDegrees", DoubleValue(53.0));
+        orbit->SetAttribute("EnableJ2", BooleanValue(false));
+        NS_TEST_ASSERT_MSG_EQ_TOL(orbit->GetBetaAngleDegrees(Seconds(0)),
+                                  0.0,
+                                  1e-9,
+                                  "node at the equinox Sun");
+        double n = std::sqrt(398600.4418 / (aKm * aKm * aKm));
+        NS_TEST_ASSERT_MSG_EQ_TOL(orbit->GetNodalPeriod().GetSeconds(),
+                                  2 * M_PI / n,
+                                  1e-6,
+                                  "Keplerian period without J2");
+
+        std::vector<Time> transitions = orbit->GetTransitions(Seconds(0), Seconds(20000));
+        NS_TEST_ASSERT_MSG_EQ(transitions.size(), 7, "three and a half orbits");
+        NS_TEST_ASSERT_MSG_EQ(orbit->IsInSunlight(transitions[0]), false, "entry first");
+        NS_TEST_ASSERT_MSG_EQ_TOL((transitions[1] - transitions[0]).GetSeconds(),
+                                  2 * std::asin(radiusKm / aKm) / n,
+                                  0.5,
+                                  "umbra length at zero beta");
+        NS_TEST_ASSERT_MSG_EQ(orbit->GetNextEclipseExit(Seconds(0)), transitions[1], "exit");
+
+        // Sampled shadow condition against the solved transitions, and
+        // segments queried in order.
+        std::size_t k = 0;
+        bool lit = orbit->IsInSunlight(Seconds(0));
+        for (int sec = 1; sec < 20000; ++sec)
+        {
+            bool now = orbit->IsInSunlight(Seconds(sec));
+            if (now != lit)
+            {
+                NS_TEST_ASSERT_MSG_LT(k, transitions.size(), "unexpected transition");
+                NS_TEST_ASSERT_MSG_EQ((transitions[k] > Seconds(sec - 1) &&
+                                       transitions[k] <= Seconds(sec)),
+                                      true,
+                                      "transition off the sampled shadow edge");
+                ++k;
+                lit = now;
+            }
+        }
+        NS_TEST_ASSERT_MSG_EQ(k, transitions.size(), "every transition sampled");
+        Time t = Seconds(0);
+        for (const Time& transition : transitions)
+        {
+            SolarIrradianceSegment seg = orbit->GetSegment(t);
+            NS_TEST_ASSERT_MSG_EQ(seg.end, transition, "segment ends at the transition");
+            NS_TEST_ASSERT_MSG_NE(orbit->GetPowerDensityWm2(seg.end),
+                                  seg.startWm2,
+                                  "value flips at the segment end");
+            t = seg.end;
+        }
+
+        // A Sun-synchronous dawn-dusk orbit is lit throughout, and enters
+        // its eclipse season once the Sun has moved on.
+        Ptr<OrbitalEclipseSolarIrradianceModel> sso =
+            CreateObject<OrbitalEclipseSolarIrradianceModel>();
+        sso->SetAttribute("SemiMajorAxisKm", DoubleValue(aKm));
+        sso->SetAttribute("InclinationDegrees", DoubleValue(97.6));
+        sso->SetAttribute("RaanDegrees", DoubleValue(90.0));
+        NS_TEST_ASSERT_MSG_GT(sso->GetBetaAngleDegrees(Seconds(0)), 70.0, "high beta");
+        SolarIrradianceSegment seg = sso->GetSegment(Seconds(0));
+        NS_TEST_ASSERT_MSG_EQ(seg.end, sso->GetNodalPeriod(), "sunlight held for one orbit");
+        Time entry = sso->GetNextEclipseEntry(Seconds(0));
+        NS_TEST_ASSERT_MSG_GT(entry, Days(1), "no eclipse at high beta");
+        NS_TEST_ASSERT_MSG_LT(entry, Days(365), "eclipse season within a year");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(sso->GetBetaAngleDegrees(entry),
+                                    std::asin(radiusKm / aKm) * 180.0 / M_PI,
+                                    "eclipses need beta below asin(R/a)");
+
+        orbit->Dispose();
+        sso->Dispose();
+    }
+};
+
+/**
+ * Plane-shared eclipse schedules: equal planes share one schedule while
+ * it is referenced, a model phase-shifted by GetPhaseOffset() follows a
+ * satellite elsewhere on the same orbit to within the drift of the Sun
+ * and the node over the shift, and models on one schedule keep
+ * independent cursors.
+ */
+class SolarIrradianceEclipseScheduleTest : public TestCase
+{
+  public:
+    SolarIrradianceEclipseScheduleTest()
+        : TestCase("Plane-shared eclipse schedule")
+    {
+    }
+
+    void DoRun() override
+    {
+        const double aKm = 6378.137 + 550.0;
+        Ptr<const EclipseSchedule> plane =
+            EclipseSchedule::ForPlane(aKm, 53.0, 10.0, 30.0, true, Days(1));
+        NS_TEST_ASSERT_MSG_EQ(EclipseSchedule::ForPlane(aKm, 53.0, 10.0, 30.0, true, Days(1)),
+                              plane,
+                              "same plane, same schedule");
+        NS_TEST_ASSERT_MSG_NE(EclipseSchedule::ForPlane(aKm, 53.0, 40.0, 30.0, true, Days(1)),
+                              plane,
+                              "other node, other schedule");
+        NS_TEST_ASSERT_MSG_EQ(plane->GetStart() + plane->GetNodalPeriod(), Time(0), "span start");
+        NS_TEST_ASSERT_MSG_EQ(plane->GetEnd(), Days(1) + plane->GetNodalPeriod(), "span end");
+        NS_TEST_ASSERT_MSG_EQ_TOL(plane->GetPhaseOffset(200.0).GetSeconds(),
+                                  -plane->GetNodalPeriod().GetSeconds() * 160.0 / 360.0,
+                                  1e-6,
+                                  "offsets wrap to the nearer way round");
+
+        const double aheadDegrees[] = {0.0, 30.0, 200.0};
+        std::vector<Ptr<ScheduledEclipseSolarIrradianceModel>> models;
+        std::vector<Ptr<OrbitalEclipseSolarIrradianceModel>> orbits;
+        std::vector<double> tolerances;
+        for (double ahead : aheadDegrees)
+        {
+            Ptr<ScheduledEclipseSolarIrradianceModel> model =
+                CreateObject<ScheduledEclipseSolarIrradianceModel>();
+            model->SetSchedule(plane);
+            model->SetAttribute("Phase", TimeValue(plane->GetPhaseOffset(ahead)));
+            models.push_back(model);
+            // About a millisecond per second of shift, see EclipseSchedule.
+            tolerances.push_back(0.01 + 1e-3 * std::abs(plane->GetPhaseOffset(ahead).GetSeconds()));
+            Ptr<OrbitalEclipseSolarIrradianceModel> orbit =
+                CreateObject<OrbitalEclipseSolarIrradianceModel>();
+            orbit->SetAttribute("SemiMajorAxisKm", DoubleValue(aKm));
+            orbit->SetAttribute("RaanDegrees", DoubleValue(10.0));
+            orbit->SetAttribute("SunLongitudeDegrees", DoubleValue(30.0));
+            orbit->SetAttribute("ArgumentOfLatitudeDegrees", DoubleValue(ahead));
+            orbits.push_back(orbit);
+        }
+
+        // Walk all satellites' segments side by side, so their cursors
+        // interleave on the shared schedule.
+        std::vector<Time> t(models.size(), Seconds(0));
+        for (int step = 0; step < 20; ++step)
+        {
+            for (std::size_t s = 0; s < models.size(); ++s)
+            {
+                SolarIrradianceSegment seg = models[s]->GetSegment(t[s]);
+                Time exact = orbits[s]->GetSegment(t[s]).end;
+                NS_TEST_ASSERT_MSG_EQ_TOL(seg.end.GetSeconds(),
+                                          exact.GetSeconds(),
+                                          tolerances[s],
+                                          "shifted schedule against the satellite's own orbit");
+                NS_TEST_ASSERT_MSG_EQ(seg.startWm2,
+                                      orbits[s]->GetPowerDensityWm2(t[s]),
+                                      "state at the segment start");
+                // Continue from the exact edge so small offsets cannot add up.
+                t[s] = std::max(seg.end, exact);
+            }
+        }
+        NS_TEST_ASSERT_MSG_EQ(models[0]->GetNSamples(), plane->GetNTransitions() + 1, "no copy");
+
+        for (std::size_t s = 0; s < models.size(); ++s)
+        {
+            models[s]->Dispose();
+            orbits[s]->Dispose();
+        }
+    }
+};
+
+/**
+ * Panel incidence: a box lit across two faces, an attitude schedule whose
+ * samples bound the segments, a source eclipse passing through, a
+ * nadir-pointing attitude from a mobility model, and a batch of mixed
+ * satellites matching each model's own evaluation.
+ */
+class SolarIrradiancePanelAttitudeTest : public TestCase
+{
+  public:
+    SolarIrradiancePanelAttitudeTest()
+        : TestCase("Panel attitude irradiance")
+    {
+    }
+
+    void DoRun() override
+    {
+        // A 1U cube with the Sun between +x and +y: two faces at 45 deg.
+        Ptr<PanelAttitudeSolarIrradianceModel> cube =
+            CreateObject<PanelAttitudeSolarIrradianceModel>();
+        cube->AddBoxPanels(0.01, 0.01, 0.01);
+        cube->SetSunDirection(Vector(1.0, 1.0, 0.0));
+        NS_TEST_ASSERT_MSG_EQ(cube->GetNPanels(), 6, "six faces");
+        NS_TEST_ASSERT_MSG_EQ_TOL(cube->GetTotalAreaM2(), 0.06, 1e-12, "total area");
+        NS_TEST_ASSERT_MSG_EQ_TOL(cube->GetPowerDensityWm2(Seconds(3)),
+                                  1361.0 * std::sqrt(2.0) / 6.0,
+                                  1e-9,
+                                  "two faces at 45 degrees");
+        NS_TEST_ASSERT_MSG_EQ(cube->GetSegment(Seconds(3)).end, Time::Max(), "fixed attitude");
+
+        // A deployable wing on +z, and an attitude schedule that turns the
+        // Sun onto it at 10 s; the source eclipses from 30 s to 40 s.
+        Ptr<LeoCycleSolarIrradianceModel> leo = CreateObject<LeoCycleSolarIrradianceModel>();
+        leo->SetAttribute("PeakWm2", DoubleValue(1000.0));
+        leo->SetAttribute("SunlightSeconds", DoubleValue(30.0));
+        leo->SetAttribute("ShadowSeconds", DoubleValue(10.0));
+        Ptr<PanelAttitudeSolarIrradianceModel> wing =
+            CreateObject<PanelAttitudeSolarIrradianceModel>();
+        wing->AddBoxPanels(0.01, 0.01, 0.01);
+        wing->AddPanel(Vector(0.0, 0.0, 2.0), 0.06);
+        wing->SetSource(leo);
+        wing->AddAttitude(Seconds(0), Vector(-1.0, 0.0, 0.0));
+        wing->AddAttitude(Seconds(10), Vector(0.0, 0.0, 1.0));
+        SolarIrradianceSegment seg = wing->GetSegment(Seconds(5));
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(10), "segment ends at the next attitude");
+        NS_TEST_ASSERT_MSG_EQ_TOL(seg.startWm2, 1000.0 * 0.01 / 0.12, 1e-9, "-x face only");
+        seg = wing->GetSegment(Seconds(12));
+        NS_TEST_ASSERT_MSG_EQ(seg.start, Seconds(10), "segment starts at the attitude");
+        NS_TEST_ASSERT_MSG_EQ(seg.end, Seconds(30), "segment ends at the eclipse");
+        NS_TEST_ASSERT_MSG_EQ_TOL(seg.startWm2, 1000.0 * 0.07 / 0.12, 1e-9, "+z face and wing");
+        NS_TEST_ASSERT_MSG_EQ(wing->GetPowerDensityWm2(Seconds(35)), 0.0, "eclipse");
+        NS_TEST_ASSERT_MSG_EQ_TOL(wing->GetPowerDensityWm2(Seconds(2)),
+                                  1000.0 * 0.01 / 0.12,
+                                  1e-9,
+                                  "backward query");
+
+        // Nadir pointing at (7000 km, 0, 0) moving along +y: body x is
+        // along-track, so a Sun along +y lights the +x face alone.
+        Ptr<ConstantVelocityMobilityModel> mobility =
+            CreateObject<ConstantVelocityMobilityModel>();
+        mobility->SetPosition(Vector(7.0e6, 0.0, 0.0));
+        mobility->SetVelocity(Vector(0.0, 7.5e3, 0.0));
+        Ptr<PanelAttitudeSolarIrradianceModel> nadir =
+            CreateObject<PanelAttitudeSolarIrradianceModel>();
+        nadir->AddBoxPanels(0.01, 0.01, 0.01);
+        nadir->SetMobilityModel(mobility);
+        nadir->SetSunDirection(Vector(0.0, 1.0, 0.0));
+        Vector s = nadir->GetSunDirectionBody(Seconds(0));
+        NS_TEST_ASSERT_MSG_EQ_TOL(s.x, 1.0, 1e-12, "Sun along-track");
+        NS_TEST_ASSERT_MSG_EQ_TOL(s.z, 0.0, 1e-12, "not towards nadir");
+        nadir->SetSunDirection(Vector(-1.0, 0.0, 0.0));
+        NS_TEST_ASSERT_MSG_EQ_TOL(nadir->GetSunDirectionBody(Seconds(0)).z,
+                                  1.0,
+                                  1e-12,
+                                  "Sun behind the Earth is towards nadir");
+        NS_TEST_ASSERT_MSG_EQ(nadir->GetSegment(Seconds(0)).IsKnown(), false, "polled");
+
+        // The batch against each model on its own.
+        PanelIncidenceBatch batch;
+        std::vector<Ptr<PanelAttitudeSolarIrradianceModel>> models{cube, wing, nadir};
+        for (uint32_t k = 0; k < 40; ++k)
+        {
+            Ptr<PanelAttitudeSolarIrradianceModel> model =
+                CreateObject<PanelAttitudeSolarIrradianceModel>();
+            model->AddBoxPanels(0.01, 0.02, 0.03);
+            for (uint32_t w = 0; w < k % 3; ++w)
+            {
+                model->AddPanel(Vector(std::cos(k), std::sin(k), 0.5 * w), 0.05);
+            }
+            model->SetSunDirection(Vector(std::sin(0.7 * k), std::cos(1.3 * k), 0.2));
+            models.push_back(model);
+        }
+        for (const auto& model : models)
+        {
+            batch.Add(model);
+        }
+        NS_TEST_ASSERT_MSG_EQ(batch.GetN(), models.size(), "every model added");
+        for (Time t : {Seconds(0), Seconds(12), Seconds(35)})
+        {
+            std::vector<double> wm2;
+            batch.Evaluate(t, wm2);
+            for (std::size_t i = 0; i < models.size(); ++i)
+            {
+                NS_TEST_ASSERT_MSG_EQ_TOL(wm2[i],
+                                          models[i]->GetPowerDensityWm2(t),
+                                          1e-9,
+                                          "batch against the model");
+            }
+        }
+
+        for (const auto& model : models)
+        {
+            model->Dispose();
+        }
+        leo->Dispose();
+        mobility->Dispose();
+    }
+};
+
+/**
+ * Invocable models: lambdas taking a Time or seconds match a callback
+ * model, HoldSeconds bounds their segments, a block functor serves a
+ * whole block in one call and single queries as blocks of one, and the
+ * default block query of other models matches their scalar one.
+ */
+class SolarIrradianceInvocableModelTest : public TestCase
+{
+  public:
+    SolarIrradianceInvocableModelTest()
+        : TestCase("Invocable irradiance model")
+    {
+    }
+
+    /** Block-only functor counting its calls. */
+    struct Propagator
+    {
+        uint32_t calls{0};
+
+        void operator()(const Time* times, double* wm2, std::size_t n)
+        {
+            ++calls;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                wm2[i] = 1000.0 + times[i].GetSeconds();
+            }
+        }
+    };
+
+    void DoRun() override
+    {
+        Ptr<CallbackSolarIrradianceModel> callback = CreateObject<CallbackSolarIrradianceModel>();
+        callback->SetCallback(MakeCallback(&Ramp));
+        auto byTime = CreateInvocableSolarIrradianceModel(&Ramp);
+        auto bySeconds = CreateInvocableSolarIrradianceModel([](double s) { return 10.0 * s; });
+        for (double s : {0.0, 1.5, 42.0})
+        {
+            NS_TEST_ASSERT_MSG_EQ(byTime->GetPowerDensityWm2(Seconds(s)),
+                                  callback->GetPowerDensityWm2(Seconds(s)),
+                                  "Time invocable against the callback");
+            NS_TEST_ASSERT_MSG_EQ(bySeconds->GetPowerDensityWm2(Seconds(s)),
+                                  callback->GetPowerDensityWm2(Seconds(s)),
+                                  "seconds invocable against the callback");
+        }
+        NS_TEST_ASSERT_MSG_EQ(byTime->GetSegment(Seconds(3)).IsKnown(), false, "polled");
+        byTime->SetAttribute("HoldSeconds", DoubleValue(2.0));
+        NS_TEST_ASSERT_MSG_EQ(byTime->GetSegment(Seconds(3)).end, Seconds(4), "held");
+
+        // A stateful invocable keeps its state across calls.
+        int calls = 0;
+        auto counting = CreateInvocableSolarIrradianceModel(
+            [calls](Time) mutable { return static_cast<double>(++calls); });
+        counting->GetPowerDensityWm2(Seconds(0));
+        NS_TEST_ASSERT_MSG_EQ(counting->GetPowerDensityWm2(Seconds(0)), 2.0, "mutable state");
+
+        // A block invocable serves a block in one call.
+        auto block = CreateInvocableSolarIrradianceModel(Propagator{});
+        std::vector<Time> times;
+        for (int i = 0; i < 100; ++i)
+        {
+            times.push_back(Seconds(i));
+        }
+        std::vector<double> wm2(times.size());
+        block->GetPowerDensitiesWm2(times.data(), wm2.data(), times.size());
+        NS_TEST_ASSERT_MSG_EQ(block->GetInvocable().calls, 1, "one call per block");
+        NS_TEST_ASSERT_MSG_EQ(wm2[99], 1099.0, "block values");
+        NS_TEST_ASSERT_MSG_EQ(block->GetPowerDensityWm2(Seconds(7)), 1007.0, "block of one");
+        NS_TEST_ASSERT_MSG_EQ(block->GetInvocable().calls, 2, "single query as a block");
+
+        // Scalar invocables and other models fill blocks point by point.
+        bySeconds->GetPowerDensitiesWm2(times.data(), wm2.data(), times.size());
+        NS_TEST_ASSERT_MSG_EQ(wm2[42], 420.0, "scalar invocable block");
+        Ptr<LeoCycleSolarIrradianceModel> leo = CreateObject<LeoCycleSolarIrradianceModel>();
+        leo->SetAttribute("SunlightSeconds", DoubleValue(30.0));
+        leo->SetAttribute("ShadowSeconds", DoubleValue(20.0));
+        leo->GetPowerDensitiesWm2(times.data(), wm2.data(), times.size());
+        for (std::size_t i = 0; i < times.size(); ++i)
+        {
+            NS_TEST_ASSERT_MSG_EQ(wm2[i], leo->GetPowerDensityWm2(times[i]), "default block");
+        }
+
+        for (Ptr<SolarIrradianceModel> model : std::vector<Ptr<SolarIrradianceModel>>{
+                 callback, byTime, bySeconds, counting, block, leo})
+        {
+            model->Dispose();
+        }
+    }
+
+  private:
+    static double Ramp(Time t)
+    {
+        return 10.0 * t.GetSeconds();
+    }
+};
+
+/**
+ * Lookahead test: the wrapper fetches polled samples in blocks, serves
+ * the polling sequence and the sample just passed from its ring, passes
+ * other times through, and returns the wrapped model's values.
+ */
+class SolarIrradianceLookaheadTest : public TestCase
+{
+  public:
+    SolarIrradianceLookaheadTest()
+        : TestCase("Lookahead irradiance model")
+    {
+    }
+
+    /** Block-only functor counting its calls. */
+    struct Propagator
+    {
+        uint32_t calls{0};
+
+        void operator()(const Time* times, double* wm2, std::size_t n)
+        {
+            ++calls;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                wm2[i] = 500.0 + 3.0 * times[i].GetSeconds();
+            }
+        }
+    };
+
+    void DoRun() override
+    {
+        auto propagator = CreateInvocableSolarIrradianceModel(Propagator{});
+        Ptr<LookaheadSolarIrradianceModel> lookahead =
+            CreateObject<LookaheadSolarIrradianceModel>();
+        lookahead->SetAttribute("Samples", UintegerValue(16));
+        lookahead->SetAttribute("Step", TimeValue(Seconds(1)));
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetPowerDensityWm2(Seconds(0)), 0.0, "no model");
+        lookahead->SetModel(propagator);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            NS_TEST_ASSERT_MSG_EQ(lookahead->GetPowerDensityWm2(Seconds(i)),
+                                  500.0 + 3.0 * i,
+                                  "wrapped value");
+        }
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetBlocks(), 7, "100 samples in blocks of 16");
+        NS_TEST_ASSERT_MSG_EQ(propagator->GetInvocable().calls, 7, "one call per block");
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetHits(), 100, "all served from the ring");
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetSegment(Seconds(98)).IsKnown(), false, "polled");
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetHits(), 101, "sample just passed");
+
+        // Off the polling grid, and before the ring, the model is asked directly.
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetPowerDensityWm2(Seconds(98.5)), 795.5, "off grid");
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetPowerDensityWm2(Seconds(3)), 509.0, "evicted");
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetMisses(), 2, "passed through");
+        NS_TEST_ASSERT_MSG_EQ(propagator->GetInvocable().calls, 9, "blocks of one");
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetBlocks(), 7, "no refetch");
+
+        // A first query off the grid fetches the block from the tick before
+        // it, so the ticks that follow are still served from the ring.
+        Ptr<LookaheadSolarIrradianceModel> shifted = CreateObject<LookaheadSolarIrradianceModel>();
+        shifted->SetAttribute("Samples", UintegerValue(16));
+        shifted->SetAttribute("Step", TimeValue(Seconds(1)));
+        shifted->SetAttribute("Origin", TimeValue(Seconds(0.5)));
+        shifted->SetModel(propagator);
+        NS_TEST_ASSERT_MSG_EQ(shifted->GetPowerDensityWm2(Seconds(3.25)), 509.75, "off grid");
+        for (int i = 3; i < 18; ++i)
+        {
+            NS_TEST_ASSERT_MSG_EQ(shifted->GetPowerDensityWm2(Seconds(i + 0.5)),
+                                  501.5 + 3.0 * i,
+                                  "tick value");
+        }
+        NS_TEST_ASSERT_MSG_EQ(shifted->GetBlocks(), 1, "block from the tick at 2.5 s");
+        NS_TEST_ASSERT_MSG_EQ(shifted->GetHits(), 15, "ticks served from the ring");
+        NS_TEST_ASSERT_MSG_EQ(shifted->GetMisses(), 1, "off grid passed through");
+        shifted->Dispose();
+
+        lookahead->Dispose();
+        NS_TEST_ASSERT_MSG_EQ(lookahead->GetModel(), nullptr, "released");
+        propagator->Dispose();
+    }
+};
+
+/**
+ * Async test: worker threads compute the polling sequence ahead in order,
+ * whatever their number; off-grid queries pass through, and a jump or a
+ * new grid restarts the workers there.
+ */
+class SolarIrradianceAsyncTest : public TestCase
+{
+  public:
+    SolarIrradianceAsyncTest()
+        : TestCase("Async irradiance model")
+    {
+    }
+
+    /** Stateless block functor counting its calls, safe on any thread. */
+    struct Propagator
+    {
+        std::atomic<uint32_t>* calls;
+
+        void operator()(const Time* times, double* wm2, std::size_t n) const
+        {
+            ++*calls;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                wm2[i] = Value(times[i]);
+            }
+        }
+
+        static double Value(Time t)
+        {
+            return 500.0 + 3.0 * t.GetSeconds();
+        }
+    };
+
+    void DoRun() override
+    {
+        for (uint32_t threads : {1U, 3U})
+        {
+            std::atomic<uint32_t> calls{0};
+            auto propagator = CreateInvocableSolarIrradianceModel(Propagator{&calls});
+            Ptr<AsyncSolarIrradianceModel> async = CreateObject<AsyncSolarIrradianceModel>();
+            async->SetAttribute("Samples", UintegerValue(16));
+            async->SetAttribute("Step", TimeValue(Seconds(1)));
+            async->SetAttribute("Threads", UintegerValue(threads));
+            async->SetAttribute("Depth", UintegerValue(2));
+            NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(0)), 0.0, "no model");
+            async->SetModel(propagator);
+
+            for (int i = 0; i < 200; ++i)
+            {
+                NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(10 + i)),
+                                      Propagator::Value(Seconds(10 + i)),
+                                      "wrapped value");
+            }
+            NS_TEST_ASSERT_MSG_EQ(async->GetBlocks(), 13, "200 samples in blocks of 16");
+            NS_TEST_ASSERT_MSG_EQ(async->GetHits(), 200, "all precomputed");
+            NS_TEST_ASSERT_MSG_EQ(async->GetSegment(Seconds(205)).IsKnown(), false, "polled");
+
+            // Off the grid within reach, and before the grid, the model is asked directly.
+            NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(209.5)),
+                                  Propagator::Value(Seconds(209.5)),
+                                  "off grid");
+            NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(5)),
+                                  Propagator::Value(Seconds(5)),
+                                  "before grid");
+            NS_TEST_ASSERT_MSG_EQ(async->GetMisses(), 2, "passed through");
+            NS_TEST_ASSERT_MSG_EQ(async->GetRestarts(), 0, "same grid");
+
+            // A jump past the blocks in flight, then a new grid, restart the workers.
+            NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(1000)),
+                                  Propagator::Value(Seconds(1000)),
+                                  "jump");
+            NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(1001)),
+                                  Propagator::Value(Seconds(1001)),
+                                  "jumped");
+            NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(1100.25)),
+                                  Propagator::Value(Seconds(1100.25)),
+                                  "new grid");
+            NS_TEST_ASSERT_MSG_EQ(async->GetPowerDensityWm2(Seconds(1101.25)),
+                                  Propagator::Value(Seconds(1101.25)),
+                                  "on the new grid");
+            NS_TEST_ASSERT_MSG_EQ(async->GetRestarts(), 2, "restarted twice");
+            NS_TEST_ASSERT_MSG_EQ(async->GetMisses(), 2, "served by the restarted workers");
+
+            async->Dispose();
+            NS_TEST_ASSERT_MSG_EQ(async->GetModel(), nullptr, "released");
+            NS_TEST_ASSERT_MSG_GT(calls.load(), 0, "computed by the workers");
+            propagator->Dispose();
+        }
+    }
+};
+
+class SolarIrradianceModelTestSuite : public TestSuite
+{
+  public:
+    SolarIrradianceModelTestSuite()
+        : TestSuite("solar-irradiance-model", Type::UNIT)
+    {
+        AddTestCase(new SolarIrradianceSegmentAnalyticTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceSegmentSampledTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceTraceModelTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceStreamingTraceTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceFlatRunTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceWindowModelTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceOrbitalEclipseTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceEclipseScheduleTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradiancePanelAttitudeTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceInvocableModelTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceLookaheadTest, TestCase::Duration::QUICK);
+        AddTestCase(new SolarIrradianceAsyncTest, TestCase::Duration::QUICK);
+    }
+};
+
+static SolarIrradianceModelTestSuite g_solarIrradianceModelTestSuite;
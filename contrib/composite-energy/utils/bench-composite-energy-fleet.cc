@@ -0,0 +1,157 @@
+/*
+ * Throughput of CompositeEnergyFleet against stand-alone
+ * CompositeEnergySource instances.
+ *
+ * Runs the same constellation of LEO-cycle sources (staggered sunlight
+ * durations, a constant device load on every node) once with every
+ * source on its own and once with all of them in one fleet, and reports
+ * wall time, events processed and events per second for each path.
+ *
+ *   bench-composite-energy-fleet --nodes=10000 --simTime=3600
+ *   bench-composite-energy-fleet --nodes=1000 --path=fleet
+ *   bench-composite-energy-fleet --nodes=100000 --path=fleet --threads=8
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/composite-energy-fleet.h"
+#include "ns3/composite-energy-source.h"
+#include "ns3/double.h"
+#include "ns3/simple-device-energy-model.h"
+#include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/uinteger.h"
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+/** What one run measured. */
+struct Result
+{
+    int64_t wallMs;
+    uint64_t events;
+    double harvestedJ;
+};
+
+Result
+Run(bool useFleet, uint32_t nodes, double simTime, double interval, uint32_t threads)
+{
+    Ptr<CompositeEnergyFleet> fleet;
+    if (useFleet)
+    {
+        fleet = CreateObject<CompositeEnergyFleet>();
+        fleet->SetAttribute("HarvestIntervalSeconds", DoubleValue(interval));
+        fleet->SetAttribute("Threads", UintegerValue(threads));
+    }
+
+    std::vector<Ptr<CompositeEnergySource>> sources;
+    std::vector<Ptr<SimpleDeviceEnergyModel>> loads;
+    sources.reserve(nodes);
+    loads.reserve(nodes);
+    for (uint32_t i = 0; i < nodes; ++i)
+    {
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(20000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(40000.0));
+        source->SetAttribute("HarvestIntervalSeconds", DoubleValue(interval));
+        source->SetAttribute("SunlightSeconds", DoubleValue(3300.0 + (i % 600)));
+        source->SetAttribute("ShadowSeconds", DoubleValue(2100.0));
+        if (fleet)
+        {
+            fleet->Add(source);
+        }
+        source->Initialize();
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(source);
+        source->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(0.05);
+        sources.push_back(source);
+        loads.push_back(load);
+    }
+
+    SystemWallClockMs clock;
+    clock.Start();
+    Simulator::Stop(Seconds(simTime));
+    Simulator::Run();
+    Result result{clock.End(), Simulator::GetEventCount(), 0.0};
+
+    for (const auto& source : sources)
+    {
+        result.harvestedJ += source->GetTotalHarvestedEnergy();
+    }
+    for (const auto& load : loads)
+    {
+        load->Dispose();
+    }
+    if (fleet)
+    {
+        fleet->Dispose();
+    }
+    for (const auto& source : sources)
+    {
+        source->Dispose();
+    }
+    Simulator::Destroy();
+    return result;
+}
+
+void
+Print(const std::string& path, uint32_t nodes, const Result& result)
+{
+    double seconds = result.wallMs / 1000.0;
+    std::cout << std::left << std::setw(8) << path << std::right << std::setw(10) << nodes
+              << std::setw(12) << result.wallMs << std::setw(14) << result.events
+              << std::setw(16) << std::fixed << std::setprecision(0)
+              << (seconds > 0 ? result.events / seconds : 0.0) << std::setw(18)
+              << std::setprecision(1) << result.harvestedJ << std::endl;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nodes = 1000;
+    double simTime = 3600.0;
+    double interval = 1.0;
+    uint32_t threads = 1;
+    std::string path = "both";
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Compare CompositeEnergyFleet with stand-alone CompositeEnergySource instances.");
+    cmd.AddValue("nodes", "Number of energy sources", nodes);
+    cmd.AddValue("simTime", "Simulated time (s)", simTime);
+    cmd.AddValue("interval", "HarvestIntervalSeconds of sources and fleet", interval);
+    cmd.AddValue("threads", "Threads of the fleet tick (0: one per hardware thread)", threads);
+    cmd.AddValue("path", "Which path to run: object, fleet or both", path);
+    cmd.Parse(argc, argv);
+
+    std::cout << std::left << std::setw(8) << "path" << std::right << std::setw(10) << "nodes"
+              << std::setw(12) << "wall(ms)" << std::setw(14) << "events" << std::setw(16)
+              << "events/s" << std::setw(18) << "harvested(J)" << std::endl;
+
+    Result object{0, 0, 0.0};
+    Result fleet{0, 0, 0.0};
+    if (path != "fleet")
+    {
+        object = Run(false, nodes, simTime, interval, threads);
+        Print("object", nodes, object);
+    }
+    if (path != "object")
+    {
+        fleet = Run(true, nodes, simTime, interval, threads);
+        Print("fleet", nodes, fleet);
+    }
+    if (path == "both" && fleet.wallMs > 0)
+    {
+        std::cout << "speedup " << std::setprecision(2)
+                  << static_cast<double>(object.wallMs) / fleet.wallMs << "x" << std::endl;
+    }
+    return 0;
+}
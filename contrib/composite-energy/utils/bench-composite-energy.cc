@@ -0,0 +1,381 @@
+/*
+ * Scaling benchmark of CompositeEnergySource.
+ *
+ * Sweeps node count, HarvestIntervalSeconds, PeriodicEnergyUpdateInterval
+ * and the kind of irradiance each source follows, runs one simulation per
+ * combination (every node a source under a constant device load) and
+ * writes wall time, events processed, events per second and peak resident
+ * memory of each run as JSON, for comparison between module versions.
+ *
+ * Lists are comma separated. Models are the built-in "leo" cycle and
+ * "window", and the "constant", "sampled", "trace" (memory-mapped) and
+ * "streaming" irradiance models; the two trace models share one binary
+ * trace written before the sweep.
+ *
+ *   bench-composite-energy --output=baseline.json
+ *   bench-composite-energy --nodes=1000,10000 --models=leo,trace --harvestIntervals=1,10
+ *   bench-composite-energy --nodes=100000 --simTime=600 --fleet=1 --threads=8
+ *
+ * Peak memory is the process high-water mark (VmHWM), reset before each
+ * run where the kernel allows it; elsewhere it is the peak since start.
+ */
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/command-line.h"
+#include "ns3/composite-energy-fleet.h"
+#include "ns3/composite-energy-source.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/irradiance-trace.h"
+#include "ns3/nstime.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-device-energy-model.h"
+#include "ns3/simulator.h"
+#include "ns3/solar-irradiance-model.h"
+#include "ns3/string.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/trace-solar-irradiance-model.h"
+#include "ns3/uinteger.h"
+
+#include <sys/resource.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+const double SOLAR_CONSTANT_WM2 = 1361.0;
+const double ORBIT_SECONDS = 5700.0;
+const uint32_t TRACE_COLUMNS = 16;
+
+/** One point of the sweep. */
+struct Config
+{
+    uint32_t nodes;
+    std::string model;
+    double harvestInterval;
+    double updateInterval;
+};
+
+/** What one run measured. */
+struct Result
+{
+    int64_t wallMs;
+    uint64_t events;
+    int64_t peakRssKb;
+    bool peakSinceStart; // the peak could not be reset before the run
+    double harvestedJ;
+};
+
+template <typename T>
+std::vector<T>
+ParseList(const std::string& list)
+{
+    std::vector<T> values;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        if (item.empty())
+        {
+            continue;
+        }
+        std::istringstream field(item);
+        T value;
+        field >> value;
+        values.push_back(value);
+    }
+    return values;
+}
+
+/** Irradiance of an orbit with the sun above the horizon half the time. */
+double
+OrbitIrradiance(double t, double phase)
+{
+    return SOLAR_CONSTANT_WM2 *
+           std::max(0.0, std::sin(2.0 * M_PI * (t + phase) / ORBIT_SECONDS));
+}
+
+/** Write the trace read by the "trace" and "streaming" models. */
+void
+WriteTrace(const std::string& path, double simTime)
+{
+    IrradianceTraceWriter writer(path, TRACE_COLUMNS);
+    std::vector<double> row(TRACE_COLUMNS);
+    for (double t = 0.0; t <= simTime + 10.0; t += 10.0)
+    {
+        for (uint32_t c = 0; c < TRACE_COLUMNS; ++c)
+        {
+            row[c] = OrbitIrradiance(t, c * ORBIT_SECONDS / TRACE_COLUMNS);
+        }
+        writer.AddRow(Seconds(t), row);
+    }
+    writer.Close();
+}
+
+/** Forget the peak RSS so far (Linux >= 4.0); false if unsupported. */
+bool
+ResetPeakRss()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail();
+}
+
+/** \return Peak resident memory (kB). */
+int64_t
+GetPeakRssKb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::stoll(line.substr(6));
+        }
+    }
+    // Not Linux: the peak since the process started.
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/** Give source \p i of the sweep its irradiance. */
+void
+ConfigureHarvest(Ptr<CompositeEnergySource> source,
+                 uint32_t i,
+                 const std::string& model,
+                 double simTime,
+                 const std::string& tracePath)
+{
+    double phase = (i % 97) * ORBIT_SECONDS / 97;
+    if (model == "leo")
+    {
+        source->SetAttribute("SunlightSeconds", DoubleValue(3300.0 + (i % 600)));
+        source->SetAttribute("ShadowSeconds", DoubleValue(2100.0));
+    }
+    else if (model == "window")
+    {
+        source->SetAttribute("UseLeoCycle", BooleanValue(false));
+        double start = i % 60;
+        source->AddSolarPanelWindow(50.0, start, start + simTime / 2);
+    }
+    else if (model == "constant")
+    {
+        Ptr<ConstantSolarIrradianceModel> irradiance =
+            CreateObject<ConstantSolarIrradianceModel>();
+        irradiance->SetAttribute("PowerDensityWm2",
+                                 DoubleValue(SOLAR_CONSTANT_WM2 * (0.5 + (i % 10) / 20.0)));
+        source->SetAttribute("IrradianceModel", PointerValue(irradiance));
+    }
+    else if (model == "sampled")
+    {
+        Ptr<SampledSolarIrradianceModel> irradiance =
+            CreateObject<SampledSolarIrradianceModel>();
+        irradiance->SetAttribute("Interpolation",
+                                 EnumValue(SampledSolarIrradianceModel::LINEAR));
+        for (double t = 0.0; t <= simTime + 60.0; t += 60.0)
+        {
+            irradiance->AddSample(Seconds(t), OrbitIrradiance(t, phase));
+        }
+        source->SetAttribute("IrradianceModel", PointerValue(irradiance));
+    }
+    else if (model == "trace" || model == "streaming")
+    {
+        Ptr<SolarIrradianceModel> irradiance;
+        if (model == "trace")
+        {
+            irradiance = CreateObject<TraceSolarIrradianceModel>();
+        }
+        else
+        {
+            irradiance = CreateObject<StreamingTraceSolarIrradianceModel>();
+        }
+        irradiance->SetAttribute("FileName", StringValue(tracePath));
+        irradiance->SetAttribute("Column", UintegerValue(i % TRACE_COLUMNS));
+        source->SetAttribute("IrradianceModel", PointerValue(irradiance));
+    }
+    else
+    {
+        NS_ABORT_MSG("unknown model \"" << model << "\"");
+    }
+}
+
+Result
+Run(const Config& config, double simTime, bool useFleet, uint32_t threads, const std::string& trace)
+{
+    bool peakReset = ResetPeakRss();
+
+    Ptr<CompositeEnergyFleet> fleet;
+    if (useFleet)
+    {
+        fleet = CreateObject<CompositeEnergyFleet>();
+        fleet->SetAttribute("HarvestIntervalSeconds", DoubleValue(config.harvestInterval));
+        fleet->SetAttribute("Threads", UintegerValue(threads));
+    }
+
+    std::vector<Ptr<CompositeEnergySource>> sources;
+    std::vector<Ptr<SimpleDeviceEnergyModel>> loads;
+    sources.reserve(config.nodes);
+    loads.reserve(config.nodes);
+    for (uint32_t i = 0; i < config.nodes; ++i)
+    {
+        Ptr<CompositeEnergySource> source = CreateObject<CompositeEnergySource>();
+        source->SetAttribute("InitialEnergyJ", DoubleValue(20000.0));
+        source->SetAttribute("MaxEnergyJ", DoubleValue(40000.0));
+        source->SetAttribute("HarvestIntervalSeconds", DoubleValue(config.harvestInterval));
+        source->SetAttribute("PeriodicEnergyUpdateInterval",
+                             TimeValue(Seconds(config.updateInterval)));
+        ConfigureHarvest(source, i, config.model, simTime, trace);
+        if (fleet)
+        {
+            fleet->Add(source);
+        }
+        source->Initialize();
+
+        Ptr<SimpleDeviceEnergyModel> load = CreateObject<SimpleDeviceEnergyModel>();
+        load->SetEnergySource(source);
+        source->AppendDeviceEnergyModel(load);
+        load->SetCurrentA(0.05);
+        sources.push_back(source);
+        loads.push_back(load);
+    }
+
+    SystemWallClockMs clock;
+    clock.Start();
+    Simulator::Stop(Seconds(simTime));
+    Simulator::Run();
+    Result result{clock.End(), Simulator::GetEventCount(), GetPeakRssKb(), !peakReset, 0.0};
+
+    for (const auto& source : sources)
+    {
+        result.harvestedJ += source->GetTotalHarvestedEnergy();
+    }
+    for (const auto& load : loads)
+    {
+        load->Dispose();
+    }
+    if (fleet)
+    {
+        fleet->Dispose();
+    }
+    for (const auto& source : sources)
+    {
+        source->Dispose();
+    }
+    Simulator::Destroy();
+    return result;
+}
+
+void
+WriteRun(std::ostream& out, const Config& config, const Result& result, bool useFleet)
+{
+    double seconds = result.wallMs / 1000.0;
+    out << "    {\"nodes\": " << config.nodes << ", \"model\": \"" << config.model
+        << "\", \"harvestIntervalSeconds\": " << config.harvestInterval
+        << ", \"periodicEnergyUpdateIntervalSeconds\": " << config.updateInterval
+        << ", \"fleet\": " << (useFleet ? "true" : "false") << ", \"wallMs\": " << result.wallMs
+        << ", \"events\": " << result.events
+        << ", \"eventsPerSecond\": " << (seconds > 0 ? result.events / seconds : 0.0)
+        << ", \"peakRssKb\": " << result.peakRssKb
+        << ", \"peakRssSinceStart\": " << (result.peakSinceStart ? "true" : "false")
+        << ", \"harvestedJ\": " << result.harvestedJ << "}";
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    std::string nodes = "10,100,1000,10000,100000";
+    std::string harvestIntervals = "1";
+    std::string updateIntervals = "1";
+    std::string models = "leo";
+    double simTime = 60.0;
+    bool useFleet = false;
+    uint32_t threads = 1;
+    std::string output;
+    std::string trace = "bench-composite-energy-trace.bin";
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Sweep CompositeEnergySource scaling and report the runs as JSON.");
+    cmd.AddValue("nodes", "Comma-separated node counts", nodes);
+    cmd.AddValue("harvestIntervals", "Comma-separated HarvestIntervalSeconds", harvestIntervals);
+    cmd.AddValue("updateIntervals",
+                 "Comma-separated PeriodicEnergyUpdateInterval (s)",
+                 updateIntervals);
+    cmd.AddValue("models",
+                 "Comma-separated irradiance: leo, window, constant, sampled, trace, streaming",
+                 models);
+    cmd.AddValue("simTime", "Simulated time of each run (s)", simTime);
+    cmd.AddValue("fleet", "Run the sources as members of a CompositeEnergyFleet", useFleet);
+    cmd.AddValue("threads", "Threads of the fleet tick (0: one per hardware thread)", threads);
+    cmd.AddValue("output", "JSON file to write (default: standard output)", output);
+    cmd.AddValue("trace", "Binary trace written for the trace models", trace);
+    cmd.Parse(argc, argv);
+
+    std::vector<Config> configs;
+    bool needTrace = false;
+    for (const auto& model : ParseList<std::string>(models))
+    {
+        needTrace |= (model == "trace" || model == "streaming");
+        for (double harvestInterval : ParseList<double>(harvestIntervals))
+        {
+            for (double updateInterval : ParseList<double>(updateIntervals))
+            {
+                for (uint32_t n : ParseList<uint32_t>(nodes))
+                {
+                    configs.push_back(Config{n, model, harvestInterval, updateInterval});
+                }
+            }
+        }
+    }
+    if (needTrace)
+    {
+        WriteTrace(trace, simTime);
+    }
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output);
+        if (!file)
+        {
+            std::cerr << "cannot write " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+
+    out << "{\n  \"benchmark\": \"composite-energy\",\n  \"simTimeSeconds\": " << simTime
+        << ",\n  \"threads\": " << threads << ",\n  \"runs\": [\n";
+    for (std::size_t k = 0; k < configs.size(); ++k)
+    {
+        const Config& config = configs[k];
+        std::cerr << "nodes=" << config.nodes << " model=" << config.model
+                  << " harvestInterval=" << config.harvestInterval
+                  << " updateInterval=" << config.updateInterval << std::endl;
+        Result result = Run(config, simTime, useFleet, threads, trace);
+        WriteRun(out, config, result, useFleet);
+        out << (k + 1 < configs.size() ? ",\n" : "\n");
+        out.flush();
+    }
+    out << "  ]\n}" << std::endl;
+
+    if (needTrace)
+    {
+        std::remove(trace.c_str());
+    }
+    return 0;
+}
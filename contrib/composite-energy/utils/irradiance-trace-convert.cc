@@ -0,0 +1,51 @@
+/*
+ * Convert CSV irradiance traces into the binary format read by
+ * TraceSolarIrradianceModel and StreamingTraceSolarIrradianceModel.
+ *
+ * Input rows are "time, wm2[, wm2...]" with one value column per
+ * satellite (commas, semicolons or whitespace as separators; '#'
+ * comments and one header row are skipped). Conversion is streamed, so
+ * multi-gigabyte CSVs are converted in constant memory, once, instead of
+ * being parsed at every simulation start.
+ *
+ *   irradiance-trace-convert --input=orbit.csv --output=orbit.bin
+ *   irradiance-trace-convert --input=orbit.csv --output=orbit.bin --timeScale=60
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/irradiance-trace.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+int
+main(int argc, char* argv[])
+{
+    std::string input;
+    std::string output;
+    uint32_t blockRows = 4096;
+    double timeScale = 1.0;
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Convert a CSV irradiance trace (time, W/m^2 per column) into the binary "
+              "format read by TraceSolarIrradianceModel.");
+    cmd.AddValue("input", "CSV file to convert", input);
+    cmd.AddValue("output", "Binary trace to write", output);
+    cmd.AddValue("blockRows", "Rows per block of the output", blockRows);
+    cmd.AddValue("timeScale", "Factor converting the CSV time column to seconds", timeScale);
+    cmd.Parse(argc, argv);
+
+    if (input.empty() || output.empty())
+    {
+        std::cerr << "Both --input and --output are required (see --help)" << std::endl;
+        return 1;
+    }
+
+    uint64_t rows = IrradianceTraceWriter::ConvertCsv(input, output, blockRows, timeScale);
+    Ptr<const IrradianceTraceStream> trace = IrradianceTraceStream::Open(output);
+    std::cout << output << ": " << rows << " rows x " << trace->GetNColumns() << " columns, "
+              << NanoSeconds(trace->GetHeader().firstTime).GetSeconds() << " s to "
+              << NanoSeconds(trace->GetHeader().lastTime).GetSeconds() << " s" << std::endl;
+    return 0;
+}